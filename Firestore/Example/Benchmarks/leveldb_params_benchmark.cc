@@ -0,0 +1,228 @@
+/*
+ * Copyright 2022 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "Firestore/core/src/credentials/user.h"
+#include "Firestore/core/src/local/leveldb_params.h"
+#include "Firestore/core/src/local/leveldb_persistence.h"
+#include "Firestore/core/src/local/remote_document_cache.h"
+#include "Firestore/core/src/model/document_key.h"
+#include "Firestore/core/src/model/field_index.h"
+#include "Firestore/core/src/model/mutable_document.h"
+#include "Firestore/core/src/util/hard_assert.h"
+#include "Firestore/core/test/unit/local/persistence_testing.h"
+#include "Firestore/core/test/unit/testutil/testutil.h"
+#include "absl/strings/str_cat.h"
+#include "benchmark/benchmark.h"
+
+namespace {
+
+using firebase::firestore::credentials::User;
+using firebase::firestore::local::LevelDbParams;
+using firebase::firestore::local::LevelDbPersistence;
+using firebase::firestore::local::LevelDbPersistenceForTesting;
+using firebase::firestore::local::RemoteDocumentCache;
+using firebase::firestore::model::DocumentKey;
+using firebase::firestore::model::IndexOffset;
+using firebase::firestore::model::MutableDocument;
+using firebase::firestore::model::ResourcePath;
+using firebase::firestore::testutil::Doc;
+using firebase::firestore::testutil::Key;
+using firebase::firestore::testutil::Map;
+using firebase::firestore::testutil::Version;
+
+/** The LevelDB tuning profiles compared by the benchmarks below. */
+enum Profile {
+  kDefault,
+  kLargeBlockCache,
+  kBloomFilter,
+  kNoChecksums,
+  kTuned,
+};
+
+const char* ProfileName(Profile profile) {
+  switch (profile) {
+    case kDefault:
+      return "default";
+    case kLargeBlockCache:
+      return "64MB block cache";
+    case kBloomFilter:
+      return "bloom filter";
+    case kNoChecksums:
+      return "no checksums";
+    case kTuned:
+      return "tuned";
+  }
+  HARD_FAIL("Unknown profile %s", profile);
+}
+
+LevelDbParams ProfileParams(Profile profile) {
+  LevelDbParams params;
+  if (profile == kLargeBlockCache || profile == kTuned) {
+    params.block_cache_size_bytes = 64 * 1024 * 1024;
+  }
+  if (profile == kBloomFilter || profile == kTuned) {
+    params.bloom_filter_bits_per_key = 10;
+  }
+  if (profile == kNoChecksums || profile == kTuned) {
+    params.verify_checksums = false;
+  }
+  if (profile == kTuned) {
+    params.write_buffer_size_bytes = 16 * 1024 * 1024;
+  }
+  return params;
+}
+
+/**
+ * Creates a LevelDB-backed remote document cache, opened with the given
+ * profile, populated with `count` documents of roughly 1 KB each in the
+ * collection "docs". The database is fully compacted afterwards so that reads
+ * go through the table files rather than the memtable.
+ */
+class ProfileFixture {
+ public:
+  ProfileFixture(Profile profile, int64_t count)
+      : persistence_(LevelDbPersistenceForTesting(ProfileParams(profile))),
+        cache_(persistence_->remote_document_cache()) {
+    cache_->SetIndexManager(
+        persistence_->GetIndexManager(User::Unauthenticated()));
+
+    std::string value(100, 'a');
+    persistence_->Run("Populate remote documents", [&] {
+      for (int64_t i = 0; i < count; i++) {
+        std::string path = absl::StrCat("docs/doc", i);
+        cache_->Add(Doc(path, 1,
+                        Map("a", value, "b", value, "c", value, "d", value,
+                            "e", value, "f", value, "g", value, "h", value,
+                            "i", value, "j", value)),
+                    Version(1));
+        keys_.push_back(Key(path));
+        missing_keys_.push_back(Key(absl::StrCat("docs/missing", i)));
+      }
+    });
+    persistence_->ptr()->CompactRange(nullptr, nullptr);
+  }
+
+  LevelDbPersistence* persistence() {
+    return persistence_.get();
+  }
+
+  RemoteDocumentCache* cache() {
+    return cache_;
+  }
+
+  const std::vector<DocumentKey>& keys() const {
+    return keys_;
+  }
+
+  const std::vector<DocumentKey>& missing_keys() const {
+    return missing_keys_;
+  }
+
+ private:
+  std::unique_ptr<LevelDbPersistence> persistence_;
+  RemoteDocumentCache* cache_ = nullptr;
+  std::vector<DocumentKey> keys_;
+  std::vector<DocumentKey> missing_keys_;
+};
+
+void ApplyProfiles(benchmark::internal::Benchmark* benchmark) {
+  for (int profile = kDefault; profile <= kTuned; ++profile) {
+    for (int64_t count : {1000, 10000, 50000}) {
+      benchmark->Args({profile, count});
+    }
+  }
+}
+
+/** Looks up every document in the collection by key. */
+void BM_LevelDbPointLookup(benchmark::State& state) {
+  auto profile = static_cast<Profile>(state.range(0));
+  int64_t count = state.range(1);
+  ProfileFixture fixture(profile, count);
+
+  for (auto _ : state) {
+    fixture.persistence()->Run("Point lookups", [&] {
+      for (const DocumentKey& key : fixture.keys()) {
+        MutableDocument doc = fixture.cache()->Get(key);
+        HARD_ASSERT(doc.is_found_document());
+        benchmark::DoNotOptimize(doc);
+      }
+    });
+  }
+
+  state.SetItemsProcessed(state.iterations() * count);
+  state.SetLabel(ProfileName(profile));
+}
+BENCHMARK(BM_LevelDbPointLookup)
+    ->Unit(benchmark::kMicrosecond)
+    ->ArgNames({"profile", "docs"})
+    ->Apply(ApplyProfiles);
+
+/**
+ * Looks up as many documents that don't exist. This is where a bloom filter
+ * helps most, since it spares reading a block from every table that might
+ * hold the key.
+ */
+void BM_LevelDbMissingLookup(benchmark::State& state) {
+  auto profile = static_cast<Profile>(state.range(0));
+  int64_t count = state.range(1);
+  ProfileFixture fixture(profile, count);
+
+  for (auto _ : state) {
+    fixture.persistence()->Run("Missing lookups", [&] {
+      for (const DocumentKey& key : fixture.missing_keys()) {
+        MutableDocument doc = fixture.cache()->Get(key);
+        HARD_ASSERT(!doc.is_found_document());
+        benchmark::DoNotOptimize(doc);
+      }
+    });
+  }
+
+  state.SetItemsProcessed(state.iterations() * count);
+  state.SetLabel(ProfileName(profile));
+}
+BENCHMARK(BM_LevelDbMissingLookup)
+    ->Unit(benchmark::kMicrosecond)
+    ->ArgNames({"profile", "docs"})
+    ->Apply(ApplyProfiles);
+
+/** Reads every document in the collection with a single scan. */
+void BM_LevelDbCollectionScan(benchmark::State& state) {
+  auto profile = static_cast<Profile>(state.range(0));
+  int64_t count = state.range(1);
+  ProfileFixture fixture(profile, count);
+  ResourcePath path = ResourcePath::FromString("docs");
+
+  for (auto _ : state) {
+    fixture.persistence()->Run("Collection scan", [&] {
+      auto docs = fixture.cache()->GetAll(path, IndexOffset::None());
+      HARD_ASSERT(static_cast<int64_t>(docs.size()) == count);
+      benchmark::DoNotOptimize(docs);
+    });
+  }
+
+  state.SetItemsProcessed(state.iterations() * count);
+  state.SetLabel(ProfileName(profile));
+}
+BENCHMARK(BM_LevelDbCollectionScan)
+    ->Unit(benchmark::kMicrosecond)
+    ->ArgNames({"profile", "docs"})
+    ->Apply(ApplyProfiles);
+
+}  // namespace
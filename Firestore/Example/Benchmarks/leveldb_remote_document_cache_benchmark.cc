@@ -0,0 +1,151 @@
+/*
+ * Copyright 2022 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "Firestore/core/src/credentials/user.h"
+#include "Firestore/core/src/local/leveldb_persistence.h"
+#include "Firestore/core/src/local/remote_document_cache.h"
+#include "Firestore/core/src/model/document_key.h"
+#include "Firestore/core/src/model/field_index.h"
+#include "Firestore/core/src/model/mutable_document.h"
+#include "Firestore/core/src/util/hard_assert.h"
+#include "Firestore/core/test/unit/local/persistence_testing.h"
+#include "Firestore/core/test/unit/testutil/testutil.h"
+#include "absl/strings/str_cat.h"
+#include "benchmark/benchmark.h"
+
+namespace {
+
+using firebase::firestore::credentials::User;
+using firebase::firestore::local::LevelDbPersistence;
+using firebase::firestore::local::LevelDbPersistenceForTesting;
+using firebase::firestore::local::RemoteDocumentCache;
+using firebase::firestore::model::DocumentKey;
+using firebase::firestore::model::IndexOffset;
+using firebase::firestore::model::MutableDocument;
+using firebase::firestore::model::ResourcePath;
+using firebase::firestore::testutil::Doc;
+using firebase::firestore::testutil::Key;
+using firebase::firestore::testutil::Map;
+using firebase::firestore::testutil::Version;
+
+/**
+ * Creates a LevelDB-backed remote document cache populated with `count`
+ * documents of roughly 1 KB each in the collection "docs".
+ */
+class RemoteDocumentCacheFixture {
+ public:
+  explicit RemoteDocumentCacheFixture(int64_t count)
+      : persistence_(LevelDbPersistenceForTesting()),
+        cache_(persistence_->remote_document_cache()) {
+    cache_->SetIndexManager(
+        persistence_->GetIndexManager(User::Unauthenticated()));
+
+    std::string value(100, 'a');
+    persistence_->Run("Populate remote documents", [&] {
+      for (int64_t i = 0; i < count; i++) {
+        std::string path = absl::StrCat("docs/doc", i);
+        cache_->Add(Doc(path, 1,
+                        Map("a", value, "b", value, "c", value, "d", value,
+                            "e", value, "f", value, "g", value, "h", value,
+                            "i", value, "j", value)),
+                    Version(1));
+        keys_.push_back(Key(path));
+      }
+    });
+  }
+
+  LevelDbPersistence* persistence() {
+    return persistence_.get();
+  }
+
+  RemoteDocumentCache* cache() {
+    return cache_;
+  }
+
+  const std::vector<DocumentKey>& keys() const {
+    return keys_;
+  }
+
+ private:
+  std::unique_ptr<LevelDbPersistence> persistence_;
+  RemoteDocumentCache* cache_ = nullptr;
+  std::vector<DocumentKey> keys_;
+};
+
+/**
+ * Reads every document in the collection with a separate point lookup per
+ * key. This is how collection scans fetched documents before they were
+ * batched into a single forward iteration.
+ */
+void BM_RemoteDocumentCachePointReads(benchmark::State& state) {
+  int64_t count = state.range(0);
+  RemoteDocumentCacheFixture fixture(count);
+
+  for (auto _ : state) {
+    fixture.persistence()->Run("Point reads", [&] {
+      for (const DocumentKey& key : fixture.keys()) {
+        MutableDocument doc = fixture.cache()->Get(key);
+        HARD_ASSERT(doc.is_found_document());
+        benchmark::DoNotOptimize(doc);
+      }
+    });
+  }
+
+  state.SetItemsProcessed(state.iterations() * count);
+  state.counters["seeks_per_scan"] = static_cast<double>(count);
+}
+BENCHMARK(BM_RemoteDocumentCachePointReads)
+    ->Unit(benchmark::kMicrosecond)
+    ->Arg(100)
+    ->Arg(1000)
+    ->Arg(10000)
+    ->Arg(50000);
+
+/**
+ * Reads every document in the collection through
+ * `RemoteDocumentCache::GetAll(path, offset)`, which streams the documents
+ * through one iterator in key order.
+ */
+void BM_RemoteDocumentCacheCollectionScan(benchmark::State& state) {
+  int64_t count = state.range(0);
+  RemoteDocumentCacheFixture fixture(count);
+  ResourcePath path = ResourcePath::FromString("docs");
+
+  for (auto _ : state) {
+    fixture.persistence()->Run("Collection scan", [&] {
+      auto docs = fixture.cache()->GetAll(path, IndexOffset::None());
+      HARD_ASSERT(static_cast<int64_t>(docs.size()) == count);
+      benchmark::DoNotOptimize(docs);
+    });
+  }
+
+  state.SetItemsProcessed(state.iterations() * count);
+  // The read time index scan and the document fetch each seek once; all other
+  // rows are reached by stepping the iterator forward.
+  state.counters["seeks_per_scan"] = 2;
+}
+BENCHMARK(BM_RemoteDocumentCacheCollectionScan)
+    ->Unit(benchmark::kMicrosecond)
+    ->Arg(100)
+    ->Arg(1000)
+    ->Arg(10000)
+    ->Arg(50000);
+
+}  // namespace
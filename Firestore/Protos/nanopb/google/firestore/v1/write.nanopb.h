@@ -50,6 +50,14 @@ typedef enum _google_firestore_v1_DocumentTransform_FieldTransform_ServerValue {
 #define _google_firestore_v1_DocumentTransform_FieldTransform_ServerValue_ARRAYSIZE ((google_firestore_v1_DocumentTransform_FieldTransform_ServerValue)(google_firestore_v1_DocumentTransform_FieldTransform_ServerValue_REQUEST_TIME+1))
 
 /* Struct definitions */
+typedef struct _google_firestore_v1_BitSequence {
+    pb_bytes_array_t *bitmap;
+    int32_t padding;
+
+    std::string ToString(int indent = 0) const;
+/* @@protoc_insertion_point(struct:google_firestore_v1_BitSequence) */
+} google_firestore_v1_BitSequence;
+
 typedef struct _google_firestore_v1_DocumentTransform {
     pb_bytes_array_t *document;
     pb_size_t field_transforms_count;
@@ -107,9 +115,19 @@ typedef struct _google_firestore_v1_DocumentTransform_FieldTransform {
 /* @@protoc_insertion_point(struct:google_firestore_v1_DocumentTransform_FieldTransform) */
 } google_firestore_v1_DocumentTransform_FieldTransform;
 
+typedef struct _google_firestore_v1_BloomFilter {
+    google_firestore_v1_BitSequence bits;
+    int32_t hash_count;
+
+    std::string ToString(int indent = 0) const;
+/* @@protoc_insertion_point(struct:google_firestore_v1_BloomFilter) */
+} google_firestore_v1_BloomFilter;
+
 typedef struct _google_firestore_v1_ExistenceFilter {
     int32_t target_id;
     int32_t count;
+    bool has_unchanged_names;
+    google_firestore_v1_BloomFilter unchanged_names;
 
     std::string ToString(int indent = 0) const;
 /* @@protoc_insertion_point(struct:google_firestore_v1_ExistenceFilter) */
@@ -154,7 +172,9 @@ typedef struct _google_firestore_v1_WriteResult {
 #define google_firestore_v1_DocumentChange_init_default {google_firestore_v1_Document_init_default, 0, NULL, 0, NULL}
 #define google_firestore_v1_DocumentDelete_init_default {NULL, false, google_protobuf_Timestamp_init_default, 0, NULL}
 #define google_firestore_v1_DocumentRemove_init_default {NULL, 0, NULL, google_protobuf_Timestamp_init_default}
-#define google_firestore_v1_ExistenceFilter_init_default {0, 0}
+#define google_firestore_v1_ExistenceFilter_init_default {0, 0, false, google_firestore_v1_BloomFilter_init_default}
+#define google_firestore_v1_BitSequence_init_default {NULL, 0}
+#define google_firestore_v1_BloomFilter_init_default {google_firestore_v1_BitSequence_init_default, 0}
 #define google_firestore_v1_Write_init_zero      {0, {google_firestore_v1_Document_init_zero}, false, google_firestore_v1_DocumentMask_init_zero, false, google_firestore_v1_Precondition_init_zero, 0, NULL}
 #define google_firestore_v1_DocumentTransform_init_zero {NULL, 0, NULL}
 #define google_firestore_v1_DocumentTransform_FieldTransform_init_zero {NULL, 0, {_google_firestore_v1_DocumentTransform_FieldTransform_ServerValue_MIN}}
@@ -162,9 +182,15 @@ typedef struct _google_firestore_v1_WriteResult {
 #define google_firestore_v1_DocumentChange_init_zero {google_firestore_v1_Document_init_zero, 0, NULL, 0, NULL}
 #define google_firestore_v1_DocumentDelete_init_zero {NULL, false, google_protobuf_Timestamp_init_zero, 0, NULL}
 #define google_firestore_v1_DocumentRemove_init_zero {NULL, 0, NULL, google_protobuf_Timestamp_init_zero}
-#define google_firestore_v1_ExistenceFilter_init_zero {0, 0}
+#define google_firestore_v1_ExistenceFilter_init_zero {0, 0, false, google_firestore_v1_BloomFilter_init_zero}
+#define google_firestore_v1_BitSequence_init_zero {NULL, 0}
+#define google_firestore_v1_BloomFilter_init_zero {google_firestore_v1_BitSequence_init_zero, 0}
 
 /* Field tags (for use in manual encoding/decoding) */
+#define google_firestore_v1_BitSequence_bitmap_tag 1
+#define google_firestore_v1_BitSequence_padding_tag 2
+#define google_firestore_v1_BloomFilter_bits_tag 1
+#define google_firestore_v1_BloomFilter_hash_count_tag 2
 #define google_firestore_v1_DocumentTransform_document_tag 1
 #define google_firestore_v1_DocumentTransform_field_transforms_tag 2
 #define google_firestore_v1_DocumentChange_document_tag 1
@@ -185,6 +211,7 @@ typedef struct _google_firestore_v1_WriteResult {
 #define google_firestore_v1_DocumentTransform_FieldTransform_field_path_tag 1
 #define google_firestore_v1_ExistenceFilter_target_id_tag 1
 #define google_firestore_v1_ExistenceFilter_count_tag 2
+#define google_firestore_v1_ExistenceFilter_unchanged_names_tag 3
 #define google_firestore_v1_Write_update_tag     1
 #define google_firestore_v1_Write_delete_tag     2
 #define google_firestore_v1_Write_verify_tag     5
@@ -203,7 +230,9 @@ extern const pb_field_t google_firestore_v1_WriteResult_fields[3];
 extern const pb_field_t google_firestore_v1_DocumentChange_fields[4];
 extern const pb_field_t google_firestore_v1_DocumentDelete_fields[4];
 extern const pb_field_t google_firestore_v1_DocumentRemove_fields[4];
-extern const pb_field_t google_firestore_v1_ExistenceFilter_fields[3];
+extern const pb_field_t google_firestore_v1_ExistenceFilter_fields[4];
+extern const pb_field_t google_firestore_v1_BitSequence_fields[3];
+extern const pb_field_t google_firestore_v1_BloomFilter_fields[3];
 
 /* Maximum encoded size of messages (where known) */
 /* google_firestore_v1_Write_size depends on runtime parameters */
@@ -213,7 +242,9 @@ extern const pb_field_t google_firestore_v1_ExistenceFilter_fields[3];
 /* google_firestore_v1_DocumentChange_size depends on runtime parameters */
 /* google_firestore_v1_DocumentDelete_size depends on runtime parameters */
 /* google_firestore_v1_DocumentRemove_size depends on runtime parameters */
-#define google_firestore_v1_ExistenceFilter_size 22
+/* google_firestore_v1_ExistenceFilter_size depends on runtime parameters */
+/* google_firestore_v1_BitSequence_size depends on runtime parameters */
+/* google_firestore_v1_BloomFilter_size depends on runtime parameters */
 
 /* Message IDs (where set with "msgid" option) */
 #ifdef PB_MSGID
@@ -74,7 +74,7 @@ size_t DocumentReference::Hash() const {
   return util::Hash(firestore_.get(), key_);
 }
 
-const std::string& DocumentReference::document_id() const {
+std::string DocumentReference::document_id() const {
   return key_.path().last_segment();
 }
 
@@ -75,7 +75,7 @@ DocumentReference DocumentSnapshot::CreateReference() const {
   return DocumentReference{internal_key_, firestore_};
 }
 
-const std::string& DocumentSnapshot::document_id() const {
+std::string DocumentSnapshot::document_id() const {
   return internal_key_.path().last_segment();
 }
 
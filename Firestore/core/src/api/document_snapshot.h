@@ -51,7 +51,7 @@ class DocumentSnapshot {
 
   bool exists() const;
   const absl::optional<model::Document>& internal_document() const;
-  const std::string& document_id() const;
+  std::string document_id() const;
 
   const SnapshotMetadata& metadata() const {
     return metadata_;
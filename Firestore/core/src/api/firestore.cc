@@ -21,6 +21,7 @@
 
 #include "Firestore/core/src/api/collection_reference.h"
 #include "Firestore/core/src/api/document_reference.h"
+#include "Firestore/core/src/api/index_backfill_listener_registration.h"
 #include "Firestore/core/src/api/listener_registration.h"
 #include "Firestore/core/src/api/settings.h"
 #include "Firestore/core/src/api/snapshots_in_sync_listener_registration.h"
@@ -30,6 +31,7 @@
 #include "Firestore/core/src/core/query.h"
 #include "Firestore/core/src/core/transaction.h"
 #include "Firestore/core/src/credentials/empty_credentials_provider.h"
+#include "Firestore/core/src/local/index_backfiller.h"
 #include "Firestore/core/src/local/leveldb_persistence.h"
 #include "Firestore/core/src/model/document_key.h"
 #include "Firestore/core/src/model/field_path.h"
@@ -54,6 +56,7 @@ using core::AsyncEventListener;
 using core::DatabaseInfo;
 using core::FirestoreClient;
 using credentials::AuthCredentialsProvider;
+using local::IndexBackfillProgress;
 using local::LevelDbPersistence;
 using model::FieldIndex;
 using model::FieldPath;
@@ -236,6 +239,16 @@ std::unique_ptr<ListenerRegistration> Firestore::AddSnapshotsInSyncListener(
       client_, std::move(async_listener));
 }
 
+std::unique_ptr<ListenerRegistration> Firestore::AddIndexBackfillListener(
+    std::unique_ptr<core::EventListener<IndexBackfillProgress>> listener) {
+  EnsureClientConfigured();
+  auto async_listener = AsyncEventListener<IndexBackfillProgress>::Create(
+      client_->user_executor(), std::move(listener));
+  client_->AddIndexBackfillListener(async_listener);
+  return absl::make_unique<IndexBackfillListenerRegistration>(
+      client_, std::move(async_listener));
+}
+
 void Firestore::EnsureClientConfigured() {
   std::lock_guard<std::mutex> lock{mutex_};
 
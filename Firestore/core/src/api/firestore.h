@@ -33,6 +33,10 @@
 namespace firebase {
 namespace firestore {
 
+namespace local {
+struct IndexBackfillProgress;
+}  // namespace local
+
 namespace remote {
 class FirebaseMetadataProvider;
 }  // namespace remote
@@ -104,6 +108,15 @@ class Firestore : public std::enable_shared_from_this<Firestore> {
   std::unique_ptr<ListenerRegistration> AddSnapshotsInSyncListener(
       std::unique_ptr<core::EventListener<util::Empty>> listener);
 
+  /**
+   * Adds a listener that is notified as documents are added to the indexes
+   * configured with `SetIndexConfiguration` and once all indexes have caught
+   * up with the local cache.
+   */
+  std::unique_ptr<ListenerRegistration> AddIndexBackfillListener(
+      std::unique_ptr<core::EventListener<local::IndexBackfillProgress>>
+          listener);
+
   void EnableNetwork(util::StatusCallback callback);
   void DisableNetwork(util::StatusCallback callback);
 
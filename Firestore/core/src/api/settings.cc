@@ -16,6 +16,7 @@
 
 #include "Firestore/core/src/api/settings.h"
 
+#include "Firestore/core/src/util/exception.h"
 #include "Firestore/core/src/util/hashing.h"
 
 namespace firebase {
@@ -27,16 +28,104 @@ constexpr bool Settings::DefaultSslEnabled;
 constexpr bool Settings::DefaultPersistenceEnabled;
 constexpr int64_t Settings::DefaultCacheSizeBytes;
 constexpr int64_t Settings::MinimumCacheSizeBytes;
+constexpr int32_t Settings::DefaultMaxPendingWrites;
+constexpr bool Settings::DefaultAdaptiveWritePipelineEnabled;
+constexpr int32_t Settings::DefaultMaxBatchesPerWriteRequest;
+constexpr int64_t Settings::DefaultLevelDbBlockCacheSizeBytes;
+constexpr int32_t Settings::DefaultLevelDbBloomFilterBitsPerKey;
+constexpr int64_t Settings::DefaultLevelDbWriteBufferSizeBytes;
+constexpr int32_t Settings::DefaultLevelDbMaxOpenFiles;
+constexpr bool Settings::DefaultLevelDbVerifyChecksums;
+constexpr int32_t Settings::DefaultMaxCachedQueryResults;
+
+void Settings::set_max_pending_writes(int32_t value) {
+  if (value < 1) {
+    util::ThrowInvalidArgument(
+        "max_pending_writes must be at least 1, but was %s", value);
+  }
+  max_pending_writes_ = value;
+}
+
+void Settings::set_max_batches_per_write_request(int32_t value) {
+  if (value < 1) {
+    util::ThrowInvalidArgument(
+        "max_batches_per_write_request must be at least 1, but was %s", value);
+  }
+  max_batches_per_write_request_ = value;
+}
+
+void Settings::set_leveldb_block_cache_size_bytes(int64_t value) {
+  if (value < 0) {
+    util::ThrowInvalidArgument(
+        "leveldb_block_cache_size_bytes must not be negative, but was %s",
+        value);
+  }
+  leveldb_block_cache_size_bytes_ = value;
+}
+
+void Settings::set_leveldb_bloom_filter_bits_per_key(int32_t value) {
+  if (value < 0) {
+    util::ThrowInvalidArgument(
+        "leveldb_bloom_filter_bits_per_key must not be negative, but was %s",
+        value);
+  }
+  leveldb_bloom_filter_bits_per_key_ = value;
+}
+
+void Settings::set_leveldb_write_buffer_size_bytes(int64_t value) {
+  if (value < 1) {
+    util::ThrowInvalidArgument(
+        "leveldb_write_buffer_size_bytes must be at least 1, but was %s",
+        value);
+  }
+  leveldb_write_buffer_size_bytes_ = value;
+}
+
+void Settings::set_leveldb_max_open_files(int32_t value) {
+  if (value < 1) {
+    util::ThrowInvalidArgument(
+        "leveldb_max_open_files must be at least 1, but was %s", value);
+  }
+  leveldb_max_open_files_ = value;
+}
+
+void Settings::set_max_cached_query_results(int32_t value) {
+  if (value < 0) {
+    util::ThrowInvalidArgument(
+        "max_cached_query_results must not be negative, but was %s", value);
+  }
+  max_cached_query_results_ = value;
+}
 
 size_t Settings::Hash() const {
   return util::Hash(host_, ssl_enabled_, persistence_enabled_,
-                    cache_size_bytes_);
+                    cache_size_bytes_, max_pending_writes_,
+                    adaptive_write_pipeline_enabled_,
+                    max_batches_per_write_request_,
+                    leveldb_block_cache_size_bytes_,
+                    leveldb_bloom_filter_bits_per_key_,
+                    leveldb_write_buffer_size_bytes_, leveldb_max_open_files_,
+                    leveldb_verify_checksums_, max_cached_query_results_);
 }
 
 bool operator==(const Settings& lhs, const Settings& rhs) {
   return lhs.host_ == rhs.host_ && lhs.ssl_enabled_ == rhs.ssl_enabled_ &&
          lhs.persistence_enabled_ == rhs.persistence_enabled_ &&
-         lhs.cache_size_bytes_ == rhs.cache_size_bytes_;
+         lhs.cache_size_bytes_ == rhs.cache_size_bytes_ &&
+         lhs.max_pending_writes_ == rhs.max_pending_writes_ &&
+         lhs.adaptive_write_pipeline_enabled_ ==
+             rhs.adaptive_write_pipeline_enabled_ &&
+         lhs.max_batches_per_write_request_ ==
+             rhs.max_batches_per_write_request_ &&
+         lhs.leveldb_block_cache_size_bytes_ ==
+             rhs.leveldb_block_cache_size_bytes_ &&
+         lhs.leveldb_bloom_filter_bits_per_key_ ==
+             rhs.leveldb_bloom_filter_bits_per_key_ &&
+         lhs.leveldb_write_buffer_size_bytes_ ==
+             rhs.leveldb_write_buffer_size_bytes_ &&
+         lhs.leveldb_max_open_files_ == rhs.leveldb_max_open_files_ &&
+         lhs.leveldb_verify_checksums_ == rhs.leveldb_verify_checksums_ &&
+         lhs.max_cached_query_results_ == rhs.max_cached_query_results_;
 }
 
 }  // namespace api
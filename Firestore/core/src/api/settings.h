@@ -18,6 +18,7 @@
 #ifndef FIRESTORE_CORE_SRC_API_SETTINGS_H_
 #define FIRESTORE_CORE_SRC_API_SETTINGS_H_
 
+#include <cstdint>
 #include <string>
 
 namespace firebase {
@@ -40,6 +41,15 @@ class Settings {
   static constexpr int64_t DefaultCacheSizeBytes = 100 * 1024 * 1024;
   static constexpr int64_t MinimumCacheSizeBytes = 1 * 1024 * 1024;
   static constexpr int64_t CacheSizeUnlimited = -1;
+  static constexpr int32_t DefaultMaxPendingWrites = 10;
+  static constexpr bool DefaultAdaptiveWritePipelineEnabled = false;
+  static constexpr int32_t DefaultMaxBatchesPerWriteRequest = 1;
+  static constexpr int64_t DefaultLevelDbBlockCacheSizeBytes = 8 * 1024 * 1024;
+  static constexpr int32_t DefaultLevelDbBloomFilterBitsPerKey = 0;
+  static constexpr int64_t DefaultLevelDbWriteBufferSizeBytes = 4 * 1024 * 1024;
+  static constexpr int32_t DefaultLevelDbMaxOpenFiles = 1000;
+  static constexpr bool DefaultLevelDbVerifyChecksums = true;
+  static constexpr int32_t DefaultMaxCachedQueryResults = 0;
 
   Settings() = default;
 
@@ -74,6 +84,105 @@ class Settings {
     return cache_size_bytes_ != CacheSizeUnlimited;
   }
 
+  /**
+   * The maximum number of mutation batches sent to the backend before any of
+   * them are acknowledged. With the adaptive write pipeline enabled this is the
+   * upper bound, and the number actually in flight grows while the backend
+   * acknowledges writes quickly and shrinks when it falls behind.
+   *
+   * Throws an invalid argument exception if `value` is less than 1.
+   */
+  void set_max_pending_writes(int32_t value);
+  int32_t max_pending_writes() const {
+    return max_pending_writes_;
+  }
+
+  void set_adaptive_write_pipeline_enabled(bool value) {
+    adaptive_write_pipeline_enabled_ = value;
+  }
+  bool adaptive_write_pipeline_enabled() const {
+    return adaptive_write_pipeline_enabled_;
+  }
+
+  /**
+   * The maximum number of consecutive pending mutation batches to send to the
+   * backend in a single write request. The backend commits them together and
+   * acknowledges them with a single response, which saves per-message
+   * overhead when many small batches are pending. The default of 1 disables
+   * coalescing.
+   *
+   * Throws an invalid argument exception if `value` is less than 1.
+   */
+  void set_max_batches_per_write_request(int32_t value);
+  int32_t max_batches_per_write_request() const {
+    return max_batches_per_write_request_;
+  }
+
+  // Tuning for the LevelDB database used when persistence is enabled. The
+  // defaults are LevelDB's own, except that checksums are always verified.
+
+  /**
+   * The size of LevelDB's cache of uncompressed table blocks.
+   *
+   * Throws an invalid argument exception if `value` is negative.
+   */
+  void set_leveldb_block_cache_size_bytes(int64_t value);
+  int64_t leveldb_block_cache_size_bytes() const {
+    return leveldb_block_cache_size_bytes_;
+  }
+
+  /**
+   * The bits per key of the bloom filter LevelDB attaches to each table to
+   * speed up point lookups, or 0 for no bloom filter.
+   *
+   * Throws an invalid argument exception if `value` is negative.
+   */
+  void set_leveldb_bloom_filter_bits_per_key(int32_t value);
+  int32_t leveldb_bloom_filter_bits_per_key() const {
+    return leveldb_bloom_filter_bits_per_key_;
+  }
+
+  /**
+   * The amount of data LevelDB buffers in memory before writing a table.
+   *
+   * Throws an invalid argument exception if `value` is less than 1.
+   */
+  void set_leveldb_write_buffer_size_bytes(int64_t value);
+  int64_t leveldb_write_buffer_size_bytes() const {
+    return leveldb_write_buffer_size_bytes_;
+  }
+
+  /**
+   * The number of table files LevelDB may keep open at once.
+   *
+   * Throws an invalid argument exception if `value` is less than 1.
+   */
+  void set_leveldb_max_open_files(int32_t value);
+  int32_t leveldb_max_open_files() const {
+    return leveldb_max_open_files_;
+  }
+
+  /** Whether LevelDB reads verify the checksums of the blocks they read. */
+  void set_leveldb_verify_checksums(bool value) {
+    leveldb_verify_checksums_ = value;
+  }
+  bool leveldb_verify_checksums() const {
+    return leveldb_verify_checksums_;
+  }
+
+  /**
+   * The number of local query results to keep in memory, so that executing
+   * the same query again while none of the documents it could match have
+   * changed doesn't have to read the local cache. The default of 0 disables
+   * this cache.
+   *
+   * Throws an invalid argument exception if `value` is negative.
+   */
+  void set_max_cached_query_results(int32_t value);
+  int32_t max_cached_query_results() const {
+    return max_cached_query_results_;
+  }
+
   friend bool operator==(const Settings& lhs, const Settings& rhs);
 
   size_t Hash() const;
@@ -83,6 +192,16 @@ class Settings {
   bool ssl_enabled_ = DefaultSslEnabled;
   bool persistence_enabled_ = DefaultPersistenceEnabled;
   int64_t cache_size_bytes_ = DefaultCacheSizeBytes;
+  int32_t max_pending_writes_ = DefaultMaxPendingWrites;
+  bool adaptive_write_pipeline_enabled_ = DefaultAdaptiveWritePipelineEnabled;
+  int32_t max_batches_per_write_request_ = DefaultMaxBatchesPerWriteRequest;
+  int64_t leveldb_block_cache_size_bytes_ = DefaultLevelDbBlockCacheSizeBytes;
+  int32_t leveldb_bloom_filter_bits_per_key_ =
+      DefaultLevelDbBloomFilterBitsPerKey;
+  int64_t leveldb_write_buffer_size_bytes_ = DefaultLevelDbWriteBufferSizeBytes;
+  int32_t leveldb_max_open_files_ = DefaultLevelDbMaxOpenFiles;
+  bool leveldb_verify_checksums_ = DefaultLevelDbVerifyChecksums;
+  int32_t max_cached_query_results_ = DefaultMaxCachedQueryResults;
 };
 
 }  // namespace api
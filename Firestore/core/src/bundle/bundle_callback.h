@@ -37,6 +37,9 @@ class BundleCallback {
    * Applies the documents from a bundle to the "ground-state" (remote)
    * documents.
    *
+   * The documents of a large bundle are applied in several calls, each of which
+   * adds to the documents applied before.
+   *
    * Local documents are re-calculated if there are remaining mutations in the
    * queue.
    */
@@ -0,0 +1,83 @@
+/*
+ * Copyright 2022 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Firestore/core/src/bundle/bundle_converter.h"
+
+#include <cstdint>
+#include <memory>
+#include <utility>
+
+#include "Firestore/Protos/nanopb/firestore/bundle.nanopb.h"
+#include "Firestore/core/src/bundle/bundle_element.h"
+#include "Firestore/core/src/bundle/bundle_metadata.h"
+#include "Firestore/core/src/nanopb/message.h"
+#include "Firestore/core/src/nanopb/writer.h"
+
+namespace firebase {
+namespace firestore {
+namespace bundle {
+
+using nanopb::Message;
+using nanopb::StringWriter;
+using util::StatusOr;
+
+namespace {
+
+/** Appends `element` to `out`, prefixed by its length as a varint. */
+void AppendElement(const Message<firestore_BundleElement>& element,
+                   std::string* out) {
+  StringWriter writer;
+  writer.Write(element.fields(), element.get());
+  std::string bytes = writer.Release();
+
+  uint64_t length = bytes.size();
+  while (length >= 0x80) {
+    out->push_back(static_cast<char>((length & 0x7f) | 0x80));
+    length >>= 7;
+  }
+  out->push_back(static_cast<char>(length));
+  out->append(bytes);
+}
+
+}  // namespace
+
+StatusOr<std::string> ConvertToBinaryBundle(
+    BundleReader& reader, const BundleSerializer& serializer) {
+  BundleMetadata metadata = reader.GetBundleMetadata();
+  if (!reader.reader_status().ok()) {
+    return reader.reader_status();
+  }
+
+  std::string elements;
+  while (std::unique_ptr<BundleElement> element = reader.GetNextElement()) {
+    AppendElement(serializer.EncodeBundleElement(*element), &elements);
+  }
+  if (!reader.reader_status().ok()) {
+    return reader.reader_status();
+  }
+
+  BundleMetadata binary_metadata(metadata.bundle_id(), metadata.version(),
+                                 metadata.create_time(),
+                                 metadata.total_documents(), elements.size());
+  std::string result(kBinaryBundleHeader, kBinaryBundleHeaderSize);
+  AppendElement(serializer.EncodeBundleElement(binary_metadata), &result);
+  result.append(elements);
+  return result;
+}
+
+}  // namespace bundle
+}  // namespace firestore
+}  // namespace firebase
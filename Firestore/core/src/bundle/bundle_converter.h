@@ -0,0 +1,44 @@
+/*
+ * Copyright 2022 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef FIRESTORE_CORE_SRC_BUNDLE_BUNDLE_CONVERTER_H_
+#define FIRESTORE_CORE_SRC_BUNDLE_BUNDLE_CONVERTER_H_
+
+#include <string>
+
+#include "Firestore/core/src/bundle/bundle_reader.h"
+#include "Firestore/core/src/bundle/bundle_serializer.h"
+#include "Firestore/core/src/util/statusor.h"
+
+namespace firebase {
+namespace firestore {
+namespace bundle {
+
+/**
+ * Reads the bundle from `reader`, which may be in either format, and returns it
+ * encoded in the binary bundle format described in `BundleReader`.
+ *
+ * The `total_bytes` of the bundle metadata is updated to match the size of the
+ * binary elements. Returns a not `ok()` status if the bundle cannot be read.
+ */
+util::StatusOr<std::string> ConvertToBinaryBundle(
+    BundleReader& reader, const BundleSerializer& serializer);
+
+}  // namespace bundle
+}  // namespace firestore
+}  // namespace firebase
+
+#endif  // FIRESTORE_CORE_SRC_BUNDLE_BUNDLE_CONVERTER_H_
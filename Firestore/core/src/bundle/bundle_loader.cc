@@ -17,6 +17,7 @@
 #include "Firestore/core/src/bundle/bundle_loader.h"
 
 #include <memory>
+#include <string>
 #include <unordered_map>
 
 #include "Firestore/core/include/firebase/firestore/firestore_errors.h"
@@ -41,6 +42,8 @@ using model::MutableDocument;
 using util::Status;
 using util::StatusOr;
 
+constexpr uint64_t BundleLoader::kMaxPendingBytes;
+
 Status BundleLoader::AddElementInternal(const BundleElement& element) {
   HARD_ASSERT(element.element_type() != BundleElement::Type::Metadata,
               "Unexpected bundle metadata element.");
@@ -55,7 +58,10 @@ Status BundleLoader::AddElementInternal(const BundleElement& element) {
       const auto& document_metadata =
           static_cast<const BundledDocumentMetadata&>(element);
       current_document_ = document_metadata.key();
-      documents_metadata_.emplace(document_metadata.key(), document_metadata);
+      for (const std::string& query : document_metadata.queries()) {
+        DocumentKeySet& keys = query_documents_[query];
+        keys = keys.insert(document_metadata.key());
+      }
 
       if (!document_metadata.exists()) {
         documents_ = documents_.insert(
@@ -103,18 +109,34 @@ StatusOr<absl::optional<LoadBundleTaskProgress>> BundleLoader::AddElement(
   }
 
   bytes_loaded_ += byte_size;
+  if (element_ptr->element_type() != BundleElement::Type::NamedQuery) {
+    pending_bytes_ += byte_size;
+  }
 
   // Document has only been partially loaded, no progress to report.
   if (before_count == documents_.size()) {
     return {absl::nullopt};
   }
 
+  ++documents_loaded_;
   LoadBundleTaskProgress progress{
-      documents_.size(), metadata_.total_documents(), bytes_loaded_,
+      documents_loaded_, metadata_.total_documents(), bytes_loaded_,
       metadata_.total_bytes(), LoadBundleTaskState::kInProgress};
   return {absl::make_optional(std::move(progress))};
 }
 
+DocumentMap BundleLoader::ApplyDocuments() {
+  pending_bytes_ = 0;
+  if (documents_.empty()) {
+    return DocumentMap{};
+  }
+
+  auto changes =
+      callback_->ApplyBundledDocuments(documents_, metadata_.bundle_id());
+  documents_ = model::MutableDocumentMap{};
+  return changes;
+}
+
 StatusOr<DocumentMap> BundleLoader::ApplyChanges() {
   if (current_document_ != absl::nullopt) {
     return StatusOr<DocumentMap>(
@@ -122,43 +144,25 @@ StatusOr<DocumentMap> BundleLoader::ApplyChanges() {
                "Bundled documents end with a document metadata "
                "element instead of a document."));
   }
-  if (metadata_.total_documents() != documents_.size()) {
+  if (metadata_.total_documents() != documents_loaded_) {
     return StatusOr<DocumentMap>(
         Status(Error::kErrorInvalidArgument,
                "Loaded documents count is not the same as in metadata."));
   }
 
-  auto changes =
-      callback_->ApplyBundledDocuments(documents_, metadata_.bundle_id());
-  auto query_document_map = GetQueryDocumentMapping();
+  auto changes = ApplyDocuments();
   for (const auto& named_query : queries_) {
-    const auto& matching_keys = query_document_map[named_query.query_name()];
+    const auto& matching_keys = query_documents_[named_query.query_name()];
     callback_->SaveNamedQuery(named_query, matching_keys);
   }
 
+  // The bundle is saved last, so that a bundle whose loading was interrupted
+  // after some of its documents were applied is loaded again.
   callback_->SaveBundle(metadata_);
 
   return changes;
 }
 
-std::unordered_map<std::string, DocumentKeySet>
-BundleLoader::GetQueryDocumentMapping() {
-  std::unordered_map<std::string, DocumentKeySet> result;
-  for (const auto& named_query : queries_) {
-    result.emplace(named_query.query_name(), DocumentKeySet{});
-  }
-
-  for (const auto& doc_metadata : documents_metadata_) {
-    const auto& metadata = doc_metadata.second;
-    for (const auto& query : doc_metadata.second.queries()) {
-      auto inserted = result[query].insert(metadata.key());
-      result[query] = std::move(inserted);
-    }
-  }
-
-  return result;
-}
-
 }  // namespace bundle
 }  // namespace firestore
 }  // namespace firebase
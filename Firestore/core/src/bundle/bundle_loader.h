@@ -50,13 +50,28 @@ inline api::LoadBundleTaskProgress InitialProgress(
           api::LoadBundleTaskState::kInProgress};
 }
 
+/**
+ * Loads the elements of a bundle into local store.
+ *
+ * Documents are held in memory only until about `max_pending_bytes` of them
+ * have been added, at which point the caller is expected to apply them with
+ * `ApplyDocuments()`. This keeps the memory needed to load a bundle bounded
+ * regardless of its size.
+ */
 class BundleLoader {
  public:
   using AddElementResult =
       util::StatusOr<absl::optional<api::LoadBundleTaskProgress>>;
 
-  BundleLoader(BundleCallback* callback, BundleMetadata metadata)
-      : callback_(callback), metadata_(std::move(metadata)) {
+  /** The default number of encoded bytes after which documents are applied. */
+  static constexpr uint64_t kMaxPendingBytes = 4 * 1024 * 1024;
+
+  BundleLoader(BundleCallback* callback,
+               BundleMetadata metadata,
+               uint64_t max_pending_bytes = kMaxPendingBytes)
+      : callback_(callback),
+        metadata_(std::move(metadata)),
+        max_pending_bytes_(max_pending_bytes) {
   }
 
   /**
@@ -70,19 +85,27 @@ class BundleLoader {
                               uint64_t byte_size);
 
   /**
-   * Applies the loaded documents and queries to local store. Returns the
-   * document view changes. If an error occurred, returns a not `ok()` status.
+   * Whether the documents added since they were last applied have reached the
+   * size at which they should be applied with `ApplyDocuments()`.
    */
-  util::StatusOr<model::DocumentMap> ApplyChanges();
+  bool HasPendingChunk() const {
+    return pending_bytes_ >= max_pending_bytes_;
+  }
 
- private:
   /**
-   * @return A map whose keys are the query names in the loading bundle, and
-   * values are matching document keys.
+   * Applies the documents added since they were last applied to local store
+   * and releases them. Returns the document view changes.
    */
-  std::unordered_map<std::string, model::DocumentKeySet>
-  GetQueryDocumentMapping();
+  model::DocumentMap ApplyDocuments();
 
+  /**
+   * Applies the remaining documents, the queries and the bundle metadata to
+   * local store. Returns the document view changes of the remaining
+   * documents. If an error occurred, returns a not `ok()` status.
+   */
+  util::StatusOr<model::DocumentMap> ApplyChanges();
+
+ private:
   /**
    * Adds the given BundleElement to the internal containers, depending on the
    * element type.
@@ -91,13 +114,17 @@ class BundleLoader {
 
   BundleCallback* callback_ = nullptr;
   BundleMetadata metadata_;
+  uint64_t max_pending_bytes_ = 0;
   std::vector<NamedQuery> queries_;
-  std::unordered_map<model::DocumentKey,
-                     BundledDocumentMetadata,
-                     model::DocumentKeyHash>
-      documents_metadata_;
+
+  /** The keys of the documents loaded so far, by the queries they match. */
+  std::unordered_map<std::string, model::DocumentKeySet> query_documents_;
+
+  /** The documents that have not been applied yet. */
   model::MutableDocumentMap documents_;
+  uint64_t pending_bytes_ = 0;
 
+  uint32_t documents_loaded_ = 0;
   uint64_t bytes_loaded_ = 0;
   absl::optional<model::DocumentKey> current_document_;
 };
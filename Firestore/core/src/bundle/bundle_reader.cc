@@ -18,6 +18,9 @@
 
 #include <algorithm>
 
+#include "Firestore/Protos/nanopb/firestore/bundle.nanopb.h"
+#include "Firestore/core/src/nanopb/message.h"
+#include "Firestore/core/src/nanopb/reader.h"
 #include "absl/memory/memory.h"
 #include "absl/strings/numbers.h"
 #include "absl/strings/string_view.h"
@@ -27,6 +30,8 @@ namespace firestore {
 namespace bundle {
 
 using nlohmann::json;
+using nanopb::Message;
+using nanopb::StringReader;
 using util::ByteStream;
 using util::StreamReadResult;
 
@@ -68,20 +73,18 @@ std::unique_ptr<BundleElement> BundleReader::GetNextElement() {
 }
 
 std::unique_ptr<BundleElement> BundleReader::ReadNextElement() {
-  auto length_prefix = ReadLengthPrefix();
-  if (!length_prefix.has_value()) {
-    return nullptr;
+  if (format_ == Format::kUnknown) {
+    ReadFormat();
   }
 
-  size_t prefix_value = 0;
-  auto ok = absl::SimpleAtoi<size_t>(length_prefix.value(), &prefix_value);
-  if (!ok) {
-    Fail("Prefix string is not a valid number");
+  size_t length = 0;
+  auto length_prefix = ReadLengthPrefix(&length);
+  if (!length_prefix.has_value()) {
     return nullptr;
   }
 
   buffer_.clear();
-  ReadJsonToBuffer(prefix_value);
+  ReadToBuffer(length);
   if (!reader_status_.ok()) {
     return nullptr;
   }
@@ -90,13 +93,66 @@ std::unique_ptr<BundleElement> BundleReader::ReadNextElement() {
   if (metadata_loaded_) {
     bytes_read_ += length_prefix.value().size() + buffer_.size();
   }
+
+  if (format_ == Format::kBinary) {
+    return DecodeBinaryBundleElementFromBuffer();
+  }
+
   auto result = DecodeBundleElementFromBuffer();
   reader_status_.Update(json_reader_.status());
 
   return result;
 }
 
-absl::optional<std::string> BundleReader::ReadLengthPrefix() {
+void BundleReader::ReadFormat() {
+  format_ = Format::kJson;
+
+  StreamReadResult result = input_->Read(1);
+  if (!result.ok()) {
+    reader_status_.Update(result.status());
+    return;
+  }
+
+  std::string first_byte = std::move(result).ValueOrDie();
+  if (first_byte.empty() || first_byte[0] != kBinaryBundleHeader[0]) {
+    json_prefix_start_ = std::move(first_byte);
+    return;
+  }
+
+  format_ = Format::kBinary;
+  result = input_->Read(kBinaryBundleHeaderSize - 1);
+  if (!result.ok()) {
+    reader_status_.Update(result.status());
+    return;
+  }
+  if (result.ValueOrDie() != kBinaryBundleHeader + 1) {
+    Fail("Bundle does not start with a valid header");
+  }
+}
+
+absl::optional<std::string> BundleReader::ReadLengthPrefix(size_t* length) {
+  if (!reader_status_.ok()) {
+    return absl::nullopt;
+  }
+
+  if (format_ == Format::kBinary) {
+    return ReadVarintLengthPrefix(length);
+  }
+
+  auto length_prefix = ReadJsonLengthPrefix();
+  if (!length_prefix.has_value()) {
+    return absl::nullopt;
+  }
+
+  auto ok = absl::SimpleAtoi<size_t>(length_prefix.value(), length);
+  if (!ok) {
+    Fail("Prefix string is not a valid number");
+    return absl::nullopt;
+  }
+  return length_prefix;
+}
+
+absl::optional<std::string> BundleReader::ReadJsonLengthPrefix() {
   // length string of size 16 indicates an element about 1PB, which is
   // impossible for valid bundles.
   StreamReadResult result = input_->ReadUntil('{', 16);
@@ -105,16 +161,55 @@ absl::optional<std::string> BundleReader::ReadLengthPrefix() {
     return absl::nullopt;
   }
 
+  std::string prefix = std::move(json_prefix_start_);
+  json_prefix_start_.clear();
+  bool eof = result.eof();
+  prefix.append(std::move(result).ValueOrDie());
+
   // Underlying stream is closed, and there happens to be no more data to
   // process.
-  if (result.eof() && result.ValueOrDie().empty()) {
+  if (eof && prefix.empty()) {
     return absl::nullopt;
   }
 
-  return absl::make_optional(std::move(result).ValueOrDie());
+  return absl::make_optional(std::move(prefix));
 }
 
-void BundleReader::ReadJsonToBuffer(size_t required_size) {
+absl::optional<std::string> BundleReader::ReadVarintLengthPrefix(
+    size_t* length) {
+  std::string prefix;
+  uint64_t value = 0;
+  // A varint holding a 64-bit value takes at most 10 bytes.
+  for (int shift = 0; shift < 70; shift += 7) {
+    StreamReadResult result = input_->Read(1);
+    if (!result.ok()) {
+      reader_status_.Update(result.status());
+      return absl::nullopt;
+    }
+
+    const std::string& byte = result.ValueOrDie();
+    if (byte.empty()) {
+      // The end of the stream is only valid in between elements.
+      if (!prefix.empty()) {
+        Fail("Bundle ends within a length prefix");
+      }
+      return absl::nullopt;
+    }
+
+    prefix.append(byte);
+    auto bits = static_cast<uint8_t>(byte[0]);
+    value |= static_cast<uint64_t>(bits & 0x7f) << shift;
+    if ((bits & 0x80) == 0) {
+      *length = static_cast<size_t>(value);
+      return absl::make_optional(std::move(prefix));
+    }
+  }
+
+  Fail("Prefix is not a valid varint");
+  return absl::nullopt;
+}
+
+void BundleReader::ReadToBuffer(size_t required_size) {
   if (!reader_status_.ok()) {
     return;
   }
@@ -166,6 +261,20 @@ std::unique_ptr<BundleElement> BundleReader::DecodeBundleElementFromBuffer() {
   }
 }
 
+std::unique_ptr<BundleElement>
+BundleReader::DecodeBinaryBundleElementFromBuffer() {
+  StringReader reader{buffer_};
+  auto element = Message<firestore_BundleElement>::TryParse(&reader);
+  if (!reader.ok()) {
+    reader_status_.Update(reader.status());
+    return nullptr;
+  }
+
+  auto result = serializer_.DecodeBundleElement(reader.context(), *element);
+  reader_status_.Update(reader.status());
+  return result;
+}
+
 }  // namespace bundle
 }  // namespace firestore
 }  // namespace firebase
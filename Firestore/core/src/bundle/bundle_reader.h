@@ -16,6 +16,7 @@
 #ifndef FIRESTORE_CORE_SRC_BUNDLE_BUNDLE_READER_H_
 #define FIRESTORE_CORE_SRC_BUNDLE_BUNDLE_READER_H_
 
+#include <cstddef>
 #include <cstdint>
 #include <memory>
 #include <string>
@@ -32,7 +33,20 @@ namespace firestore {
 namespace bundle {
 
 /**
- * Reads the length-prefixed JSON stream for Bundles.
+ * The bytes a binary bundle starts with. A JSON bundle starts with the decimal
+ * length of its first element instead, so the two can be told apart.
+ */
+constexpr char kBinaryBundleHeader[] = "\0FSB";
+constexpr size_t kBinaryBundleHeaderSize = sizeof(kBinaryBundleHeader) - 1;
+
+/**
+ * Reads the length-prefixed stream for Bundles.
+ *
+ * Two formats are accepted: in the JSON format, each element is a JSON string
+ * prefixed by its length in decimal. In the binary format, the stream starts
+ * with `kBinaryBundleHeader`, and each element is a `BundleElement` proto
+ * prefixed by its length as a varint. In both, the length prefixes count
+ * towards `bytes_read()`.
  *
  * The class takes a bundle stream and presents abstractions to read bundled
  * elements out of the underlying content.
@@ -88,6 +102,21 @@ class BundleReader {
    */
   std::unique_ptr<BundleElement> ReadNextElement();
 
+  enum class Format { kUnknown, kJson, kBinary };
+
+  /**
+   * Reads the start of the stream to tell whether it holds a JSON or a binary
+   * bundle.
+   */
+  void ReadFormat();
+
+  /**
+   * Reads the length prefix from the bundle stream and stores its value in
+   * `length`. Returns the bytes of the prefix, or `nullopt` when at the end of
+   * stream or if the prefix is not valid.
+   */
+  absl::optional<std::string> ReadLengthPrefix(size_t* length);
+
   /**
    * Reads the length prefix string from bundle stream. Returns `nullopt` when
    * at the end of stream.
@@ -96,12 +125,18 @@ class BundleReader {
    * the `input_` until the next character is a "{" (start of JSON element).
    * So calling this a second time will return an empty string.
    */
-  absl::optional<std::string> ReadLengthPrefix();
+  absl::optional<std::string> ReadJsonLengthPrefix();
+
+  /**
+   * Reads the varint length prefix of a binary bundle element from bundle
+   * stream. Returns `nullopt` when at the end of stream.
+   */
+  absl::optional<std::string> ReadVarintLengthPrefix(size_t* length);
 
   /**
    * Reads `required_size` number of chars from stream into internal `buffer_`.
    */
-  void ReadJsonToBuffer(size_t required_size);
+  void ReadToBuffer(size_t required_size);
 
   /**
    * Decodes internal `buffer_` into a `BundleElement`, returned as a unique_ptr
@@ -111,11 +146,22 @@ class BundleReader {
    */
   std::unique_ptr<BundleElement> DecodeBundleElementFromBuffer();
 
+  /**
+   * Decodes internal `buffer_`, which holds a `BundleElement` proto, like
+   * `DecodeBundleElementFromBuffer`.
+   */
+  std::unique_ptr<BundleElement> DecodeBinaryBundleElementFromBuffer();
+
   BundleSerializer serializer_;
   util::JsonReader json_reader_;
 
   // Input stream holding bundle data.
   std::unique_ptr<util::ByteStream> input_;
+  Format format_ = Format::kUnknown;
+
+  // The first byte of a JSON bundle, read by `ReadFormat` before the rest of
+  // the length prefix it belongs to.
+  std::string json_prefix_start_;
 
   // Cached bundle metadata.
   BundleMetadata metadata_;
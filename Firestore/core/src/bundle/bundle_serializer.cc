@@ -38,6 +38,7 @@
 #include "Firestore/core/src/util/statusor.h"
 #include "Firestore/core/src/util/string_format.h"
 #include "Firestore/core/src/util/string_util.h"
+#include "absl/memory/memory.h"
 #include "absl/strings/escaping.h"
 #include "absl/strings/numbers.h"
 #include "absl/time/time.h"
@@ -74,6 +75,7 @@ using nanopb::SharedMessage;
 using nlohmann::json;
 using util::JsonReader;
 using util::NoDestructor;
+using util::ReadContext;
 using util::StatusOr;
 using util::StringFormat;
 using Operator = FieldFilter::Operator;
@@ -677,6 +679,151 @@ BundleDocument BundleSerializer::DecodeDocument(JsonReader& reader,
       ObjectValue::FromMapValue(std::move(map_value))));
 }
 
+std::unique_ptr<BundleElement> BundleSerializer::DecodeBundleElement(
+    ReadContext* context, firestore_BundleElement& element) const {
+  switch (element.which_element_type) {
+    case firestore_BundleElement_metadata_tag: {
+      const firestore_BundleMetadata& metadata = element.metadata;
+      SnapshotVersion create_time =
+          rpc_serializer_.DecodeVersion(context, metadata.create_time);
+      return absl::make_unique<BundleMetadata>(
+          rpc_serializer_.DecodeString(metadata.id), metadata.version,
+          create_time, metadata.total_documents, metadata.total_bytes);
+    }
+
+    case firestore_BundleElement_named_query_tag: {
+      firestore_NamedQuery& named_query = element.named_query;
+      firestore_BundledQuery& query = named_query.bundled_query;
+      // The query_type oneof only has a single valid value.
+      if (query.which_query_type !=
+          firestore_BundledQuery_structured_query_tag) {
+        context->Fail(StringFormat("Unknown bundled query_type: %s",
+                                   query.which_query_type));
+        return nullptr;
+      }
+
+      LimitType limit_type =
+          query.limit_type == firestore_BundledQuery_LimitType_LAST
+              ? LimitType::Last
+              : LimitType::First;
+      Target target = rpc_serializer_.DecodeStructuredQuery(
+          context, query.parent, query.structured_query);
+      SnapshotVersion read_time =
+          rpc_serializer_.DecodeVersion(context, named_query.read_time);
+      if (!context->ok()) return nullptr;
+
+      return absl::make_unique<NamedQuery>(
+          rpc_serializer_.DecodeString(named_query.name),
+          BundledQuery(std::move(target), limit_type), read_time);
+    }
+
+    case firestore_BundleElement_document_metadata_tag: {
+      const firestore_BundledDocumentMetadata& metadata =
+          element.document_metadata;
+      DocumentKey key = rpc_serializer_.DecodeKey(context, metadata.name);
+      SnapshotVersion read_time =
+          rpc_serializer_.DecodeVersion(context, metadata.read_time);
+      if (!context->ok()) return nullptr;
+
+      std::vector<std::string> queries;
+      queries.reserve(metadata.queries_count);
+      for (pb_size_t i = 0; i < metadata.queries_count; ++i) {
+        queries.push_back(rpc_serializer_.DecodeString(metadata.queries[i]));
+      }
+
+      return absl::make_unique<BundledDocumentMetadata>(
+          std::move(key), read_time, metadata.exists, std::move(queries));
+    }
+
+    case firestore_BundleElement_document_tag: {
+      google_firestore_v1_Document& document = element.document;
+      DocumentKey key = rpc_serializer_.DecodeKey(context, document.name);
+      SnapshotVersion update_time =
+          rpc_serializer_.DecodeVersion(context, document.update_time);
+      if (!context->ok()) return nullptr;
+
+      return absl::make_unique<BundleDocument>(MutableDocument::FoundDocument(
+          std::move(key), update_time,
+          ObjectValue::FromFieldsEntry(document.fields,
+                                       document.fields_count)));
+    }
+
+    default:
+      context->Fail("Unrecognized BundleElement");
+      return nullptr;
+  }
+}
+
+Message<firestore_BundleElement> BundleSerializer::EncodeBundleElement(
+    const BundleElement& element) const {
+  Message<firestore_BundleElement> result;
+
+  switch (element.element_type()) {
+    case BundleElement::Type::Metadata: {
+      const auto& metadata = static_cast<const BundleMetadata&>(element);
+      result->which_element_type = firestore_BundleElement_metadata_tag;
+      result->metadata.id =
+          remote::Serializer::EncodeString(metadata.bundle_id());
+      result->metadata.create_time =
+          remote::Serializer::EncodeVersion(metadata.create_time());
+      result->metadata.version = metadata.version();
+      result->metadata.total_documents = metadata.total_documents();
+      result->metadata.total_bytes = metadata.total_bytes();
+      break;
+    }
+
+    case BundleElement::Type::NamedQuery: {
+      const auto& named_query = static_cast<const NamedQuery&>(element);
+      const BundledQuery& query = named_query.bundled_query();
+      result->which_element_type = firestore_BundleElement_named_query_tag;
+      result->named_query.name =
+          remote::Serializer::EncodeString(named_query.query_name());
+      result->named_query.read_time =
+          remote::Serializer::EncodeVersion(named_query.read_time());
+
+      firestore_BundledQuery& bundled_query = result->named_query.bundled_query;
+      auto query_target = rpc_serializer_.EncodeQueryTarget(query.target());
+      bundled_query.parent = query_target.parent;
+      bundled_query.which_query_type =
+          firestore_BundledQuery_structured_query_tag;
+      bundled_query.structured_query = query_target.structured_query;
+      bundled_query.limit_type = query.limit_type() == LimitType::Last
+                                     ? firestore_BundledQuery_LimitType_LAST
+                                     : firestore_BundledQuery_LimitType_FIRST;
+      break;
+    }
+
+    case BundleElement::Type::DocumentMetadata: {
+      const auto& metadata =
+          static_cast<const BundledDocumentMetadata&>(element);
+      result->which_element_type =
+          firestore_BundleElement_document_metadata_tag;
+      firestore_BundledDocumentMetadata& proto = result->document_metadata;
+      proto.name = rpc_serializer_.EncodeKey(metadata.key());
+      proto.read_time = remote::Serializer::EncodeVersion(metadata.read_time());
+      proto.exists = metadata.exists();
+      SetRepeatedField(&proto.queries, &proto.queries_count,
+                       metadata.queries(), [](const std::string& query) {
+                         return remote::Serializer::EncodeString(query);
+                       });
+      break;
+    }
+
+    case BundleElement::Type::Document: {
+      const MutableDocument& document =
+          static_cast<const BundleDocument&>(element).document();
+      result->which_element_type = firestore_BundleElement_document_tag;
+      result->document =
+          rpc_serializer_.EncodeDocument(document.key(), document.data());
+      result->document.update_time =
+          remote::Serializer::EncodeVersion(document.version());
+      break;
+    }
+  }
+
+  return result;
+}
+
 }  // namespace bundle
 }  // namespace firestore
 }  // namespace firebase
@@ -17,10 +17,12 @@
 #ifndef FIRESTORE_CORE_SRC_BUNDLE_BUNDLE_SERIALIZER_H_
 #define FIRESTORE_CORE_SRC_BUNDLE_BUNDLE_SERIALIZER_H_
 
+#include <memory>
 #include <string>
 #include <utility>
 #include <vector>
 
+#include "Firestore/Protos/nanopb/firestore/bundle.nanopb.h"
 #include "Firestore/core/src/bundle/bundle_document.h"
 #include "Firestore/core/src/bundle/bundle_metadata.h"
 #include "Firestore/core/src/bundle/bundled_document_metadata.h"
@@ -39,7 +41,10 @@ namespace firestore {
 
 namespace bundle {
 
-/** A JSON serializer to deserialize Firestore Bundles. */
+/**
+ * A serializer to deserialize Firestore Bundles, both from their JSON form and
+ * from the `BundleElement` protos of binary bundles.
+ */
 class BundleSerializer {
  public:
   explicit BundleSerializer(remote::Serializer serializer)
@@ -57,6 +62,19 @@ class BundleSerializer {
   BundleDocument DecodeDocument(util::JsonReader& reader,
                                 const nlohmann::json& document) const;
 
+  /**
+   * Decodes a `BundleElement` proto read from a binary bundle. Modifies the
+   * provided proto to release ownership of the document fields.
+   *
+   * Returns `nullptr` and fails `context` if the element is not valid.
+   */
+  std::unique_ptr<BundleElement> DecodeBundleElement(
+      util::ReadContext* context, firestore_BundleElement& element) const;
+
+  /** Encodes `element` as a `BundleElement` proto of a binary bundle. */
+  nanopb::Message<firestore_BundleElement> EncodeBundleElement(
+      const BundleElement& element) const;
+
  private:
   BundledQuery DecodeBundledQuery(util::JsonReader& reader,
                                   const nlohmann::json& query) const;
@@ -0,0 +1,151 @@
+/*
+ * Copyright 2022 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Firestore/core/src/core/bundle_load_pipeline.h"
+
+#include <utility>
+#include <vector>
+
+#include "Firestore/core/src/api/load_bundle_task.h"
+#include "Firestore/core/src/bundle/bundle_element.h"
+#include "Firestore/core/src/bundle/bundle_loader.h"
+#include "Firestore/core/src/bundle/bundle_reader.h"
+#include "Firestore/core/src/core/sync_engine.h"
+#include "Firestore/core/src/util/async_queue.h"
+#include "Firestore/core/src/util/executor.h"
+#include "Firestore/core/src/util/log.h"
+
+namespace firebase {
+namespace firestore {
+namespace core {
+
+using bundle::BundleElement;
+using bundle::BundleMetadata;
+using util::Status;
+
+/** Elements read from a bundle, along with their encoded sizes. */
+struct BundleLoadPipeline::Chunk {
+  std::vector<std::pair<std::unique_ptr<BundleElement>, uint64_t>> elements;
+  Status status;
+  bool finished = false;
+};
+
+constexpr uint64_t BundleLoadPipeline::kChunkBytes;
+
+BundleLoadPipeline::BundleLoadPipeline(
+    std::shared_ptr<util::AsyncQueue> worker_queue,
+    util::Executor* bundle_executor,
+    SyncEngine* sync_engine,
+    std::shared_ptr<bundle::BundleReader> reader,
+    std::shared_ptr<api::LoadBundleTask> result_task,
+    uint64_t chunk_bytes)
+    : worker_queue_(std::move(worker_queue)),
+      bundle_executor_(bundle_executor),
+      sync_engine_(sync_engine),
+      chunk_bytes_(chunk_bytes),
+      reader_(std::move(reader)),
+      result_task_(std::move(result_task)) {
+}
+
+BundleLoadPipeline::~BundleLoadPipeline() = default;
+
+void BundleLoadPipeline::Start() {
+  auto self = shared_from_this();
+  bundle_executor_->Execute([self] {
+    BundleMetadata metadata = self->reader_->GetBundleMetadata();
+    Status status = self->reader_->reader_status();
+    self->bytes_read_ = self->reader_->bytes_read();
+
+    self->worker_queue_->Enqueue(
+        [self, metadata, status] { self->StartLoading(metadata, status); });
+  });
+}
+
+void BundleLoadPipeline::StartLoading(const BundleMetadata& metadata,
+                                      const Status& status) {
+  if (!status.ok()) {
+    LOG_WARN("Failed to GetBundleMetadata() for bundle with error %s",
+             status.error_message());
+    result_task_->SetError(status);
+    return;
+  }
+
+  metadata_ = metadata;
+  loader_ = sync_engine_->StartLoadingBundle(metadata, *result_task_);
+  if (loader_) {
+    ReadChunk();
+  }
+}
+
+void BundleLoadPipeline::ReadChunk() {
+  auto self = shared_from_this();
+  bundle_executor_->Execute([self] {
+    auto chunk = std::make_shared<Chunk>();
+    uint64_t chunk_bytes = 0;
+    while (chunk_bytes < self->chunk_bytes_) {
+      auto element = self->reader_->GetNextElement();
+      if (element == nullptr || !self->reader_->reader_status().ok()) {
+        chunk->finished = true;
+        break;
+      }
+
+      int64_t bytes_read = self->reader_->bytes_read();
+      auto byte_size = static_cast<uint64_t>(bytes_read - self->bytes_read_);
+      self->bytes_read_ = bytes_read;
+      chunk_bytes += byte_size;
+      chunk->elements.emplace_back(std::move(element), byte_size);
+    }
+    chunk->status = self->reader_->reader_status();
+
+    self->worker_queue_->Enqueue([self, chunk] { self->ApplyChunk(chunk); });
+  });
+}
+
+void BundleLoadPipeline::ApplyChunk(const std::shared_ptr<Chunk>& chunk) {
+  if (failed_) return;
+
+  // Read the next chunk while this one is being applied. At most two chunks
+  // are therefore held in memory at any time.
+  if (!chunk->finished) {
+    ReadChunk();
+  }
+
+  for (auto& element : chunk->elements) {
+    if (!sync_engine_->AddBundleElement(*loader_, std::move(element.first),
+                                        element.second, *result_task_)) {
+      failed_ = true;
+      return;
+    }
+  }
+  chunk->elements.clear();
+
+  if (!chunk->status.ok()) {
+    LOG_WARN("Failed to GetNextElement() from bundle with error %s",
+             chunk->status.error_message());
+    result_task_->SetError(chunk->status);
+    failed_ = true;
+    return;
+  }
+
+  if (chunk->finished) {
+    sync_engine_->FinishLoadingBundle(*loader_, metadata_, *result_task_);
+    loader_.reset();
+  }
+}
+
+}  // namespace core
+}  // namespace firestore
+}  // namespace firebase
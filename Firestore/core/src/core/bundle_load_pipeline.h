@@ -0,0 +1,114 @@
+/*
+ * Copyright 2022 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef FIRESTORE_CORE_SRC_CORE_BUNDLE_LOAD_PIPELINE_H_
+#define FIRESTORE_CORE_SRC_CORE_BUNDLE_LOAD_PIPELINE_H_
+
+#include <cstdint>
+#include <memory>
+
+#include "Firestore/core/src/bundle/bundle_metadata.h"
+#include "Firestore/core/src/util/status.h"
+
+namespace firebase {
+namespace firestore {
+
+namespace api {
+class LoadBundleTask;
+}  // namespace api
+
+namespace bundle {
+class BundleLoader;
+class BundleReader;
+}  // namespace bundle
+
+namespace util {
+class AsyncQueue;
+class Executor;
+}  // namespace util
+
+namespace core {
+
+class SyncEngine;
+
+/**
+ * Loads a bundle into a `SyncEngine` in a pipeline: the bundle is read and
+ * decoded on a separate executor in chunks of about `chunk_bytes`, while the
+ * worker queue applies the chunk read before. At most two chunks are held in
+ * memory at any time.
+ */
+class BundleLoadPipeline
+    : public std::enable_shared_from_this<BundleLoadPipeline> {
+ public:
+  /** The default number of encoded bytes read from a bundle at a time. */
+  static constexpr uint64_t kChunkBytes = 1024 * 1024;
+
+  /**
+   * Creates a pipeline that loads the bundle read by `reader` into
+   * `sync_engine` and reports its progress to `result_task`.
+   *
+   * `sync_engine` is only used on `worker_queue`. It and `bundle_executor`
+   * must outlive all tasks the pipeline schedules on either of them.
+   */
+  BundleLoadPipeline(std::shared_ptr<util::AsyncQueue> worker_queue,
+                     util::Executor* bundle_executor,
+                     SyncEngine* sync_engine,
+                     std::shared_ptr<bundle::BundleReader> reader,
+                     std::shared_ptr<api::LoadBundleTask> result_task,
+                     uint64_t chunk_bytes = kChunkBytes);
+
+  ~BundleLoadPipeline();
+
+  /** Starts reading the bundle on `bundle_executor`. */
+  void Start();
+
+ private:
+  struct Chunk;
+
+  /** Starts loading the bundle on the worker queue with its metadata. */
+  void StartLoading(const bundle::BundleMetadata& metadata,
+                    const util::Status& status);
+
+  /**
+   * Reads the next elements of the bundle on `bundle_executor_` and hands them
+   * to `ApplyChunk` on the worker queue.
+   */
+  void ReadChunk();
+
+  /** Adds elements read from the bundle to its loader on the worker queue. */
+  void ApplyChunk(const std::shared_ptr<Chunk>& chunk);
+
+  std::shared_ptr<util::AsyncQueue> worker_queue_;
+  util::Executor* bundle_executor_ = nullptr;
+  SyncEngine* sync_engine_ = nullptr;
+  uint64_t chunk_bytes_ = 0;
+
+  // Only accessed on `bundle_executor_`.
+  std::shared_ptr<bundle::BundleReader> reader_;
+  int64_t bytes_read_ = 0;
+
+  // Only accessed on the worker queue.
+  std::shared_ptr<api::LoadBundleTask> result_task_;
+  bundle::BundleMetadata metadata_;
+  std::unique_ptr<bundle::BundleLoader> loader_;
+  bool failed_ = false;
+};
+
+}  // namespace core
+}  // namespace firestore
+}  // namespace firebase
+
+#endif  // FIRESTORE_CORE_SRC_CORE_BUNDLE_LOAD_PIPELINE_H_
@@ -21,6 +21,7 @@
 #include <memory>
 #include <string>
 #include <utility>
+#include <vector>
 
 #include "Firestore/core/src/api/document_reference.h"
 #include "Firestore/core/src/api/document_snapshot.h"
@@ -28,12 +29,14 @@
 #include "Firestore/core/src/api/query_snapshot.h"
 #include "Firestore/core/src/api/settings.h"
 #include "Firestore/core/src/bundle/bundle_reader.h"
+#include "Firestore/core/src/core/bundle_load_pipeline.h"
 #include "Firestore/core/src/core/database_info.h"
 #include "Firestore/core/src/core/event_manager.h"
 #include "Firestore/core/src/core/query_listener.h"
 #include "Firestore/core/src/core/sync_engine.h"
 #include "Firestore/core/src/core/view.h"
 #include "Firestore/core/src/credentials/credentials_provider.h"
+#include "Firestore/core/src/local/index_backfiller.h"
 #include "Firestore/core/src/local/leveldb_opener.h"
 #include "Firestore/core/src/local/leveldb_persistence.h"
 #include "Firestore/core/src/local/local_documents_view.h"
@@ -76,7 +79,9 @@ using api::SnapshotMetadata;
 using credentials::AuthCredentialsProvider;
 using credentials::User;
 using firestore::Error;
+using local::IndexBackfillProgress;
 using local::LevelDbOpener;
+using local::LevelDbParams;
 using local::LocalStore;
 using local::LruParams;
 using local::MemoryPersistence;
@@ -93,6 +98,7 @@ using remote::Datastore;
 using remote::FirebaseMetadataProvider;
 using remote::RemoteStore;
 using remote::Serializer;
+using remote::WritePipelineWindow;
 using util::AsyncQueue;
 using util::Empty;
 using util::Executor;
@@ -202,8 +208,18 @@ void FirestoreClient::Initialize(const User& user, const Settings& settings) {
   if (settings.persistence_enabled()) {
     LevelDbOpener opener(database_info_);
 
-    auto created =
-        opener.Create(LruParams::WithCacheSize(settings.cache_size_bytes()));
+    LevelDbParams leveldb_params;
+    leveldb_params.block_cache_size_bytes =
+        settings.leveldb_block_cache_size_bytes();
+    leveldb_params.bloom_filter_bits_per_key =
+        settings.leveldb_bloom_filter_bits_per_key();
+    leveldb_params.write_buffer_size_bytes =
+        settings.leveldb_write_buffer_size_bytes();
+    leveldb_params.max_open_files = settings.leveldb_max_open_files();
+    leveldb_params.verify_checksums = settings.leveldb_verify_checksums();
+
+    auto created = opener.Create(
+        LruParams::WithCacheSize(settings.cache_size_bytes()), leveldb_params);
     // If leveldb fails to start then just throw up our hands: the error is
     // unrecoverable. There's nothing an end-user can do and nearly all
     // failures indicate the developer is doing something grossly wrong so we
@@ -223,8 +239,9 @@ void FirestoreClient::Initialize(const User& user, const Settings& settings) {
   }
 
   query_engine_ = absl::make_unique<QueryEngine>();
-  local_store_ = absl::make_unique<LocalStore>(persistence_.get(),
-                                               query_engine_.get(), user);
+  local_store_ = absl::make_unique<LocalStore>(
+      persistence_.get(), query_engine_.get(), user,
+      static_cast<size_t>(settings.max_cached_query_results()));
   connectivity_monitor_ = ConnectivityMonitor::Create(worker_queue_);
   auto datastore = std::make_shared<Datastore>(
       database_info_, worker_queue_, auth_credentials_provider_,
@@ -233,9 +250,13 @@ void FirestoreClient::Initialize(const User& user, const Settings& settings) {
 
   remote_store_ = absl::make_unique<RemoteStore>(
       local_store_.get(), std::move(datastore), worker_queue_,
-      connectivity_monitor_.get(), [this](OnlineState online_state) {
+      connectivity_monitor_.get(),
+      [this](OnlineState online_state) {
         sync_engine_->HandleOnlineStateChange(online_state);
-      });
+      },
+      WritePipelineWindow(settings.max_pending_writes(),
+                          settings.adaptive_write_pipeline_enabled()),
+      settings.max_batches_per_write_request());
 
   sync_engine_ =
       absl::make_unique<SyncEngine>(local_store_.get(), remote_store_.get(),
@@ -314,6 +335,12 @@ void FirestoreClient::TerminateInternal() {
 
   backfiller_callback_.Cancel();
 
+  // Wait for any bundle that is being read; what it hands to the worker queue
+  // from now on is dropped.
+  if (bundle_executor_) {
+    bundle_executor_->Dispose();
+  }
+
   remote_store_->Shutdown();
   persistence_->Shutdown();
 
@@ -345,10 +372,28 @@ void FirestoreClient::ScheduleIndexBackfiller() {
       delay, TimerId::IndexBackfillDelay, [this] {
         local_store_->Backfill();
         backfiller_has_run_ = true;
+        RaiseIndexBackfillProgress();
         ScheduleIndexBackfiller();
       });
 }
 
+void FirestoreClient::RaiseIndexBackfillProgress() {
+  const IndexBackfillProgress& progress =
+      local_store_->index_backfill_progress();
+
+  // The backfiller runs continuously, so only report operations that did
+  // something and the moment indexes catch up.
+  bool newly_caught_up = progress.caught_up && !backfiller_caught_up_;
+  backfiller_caught_up_ = progress.caught_up;
+  if (progress.documents_processed == 0 && !newly_caught_up) {
+    return;
+  }
+
+  for (const auto& listener : index_backfill_listeners_) {
+    listener->OnEvent(progress);
+  }
+}
+
 void FirestoreClient::DisableNetwork(StatusCallback callback) {
   VerifyNotTerminated();
 
@@ -550,6 +595,25 @@ void FirestoreClient::RemoveSnapshotsInSyncListener(
   });
 }
 
+void FirestoreClient::AddIndexBackfillListener(
+    const std::shared_ptr<EventListener<IndexBackfillProgress>>&
+        user_listener) {
+  worker_queue_->Enqueue([this, user_listener] {
+    index_backfill_listeners_.insert(user_listener);
+    if (backfiller_has_run_) {
+      user_listener->OnEvent(IndexBackfillProgress{0, backfiller_caught_up_});
+    }
+  });
+}
+
+void FirestoreClient::RemoveIndexBackfillListener(
+    const std::shared_ptr<EventListener<IndexBackfillProgress>>&
+        user_listener) {
+  worker_queue_->Enqueue([this, user_listener] {
+    index_backfill_listeners_.erase(user_listener);
+  });
+}
+
 void FirestoreClient::ConfigureFieldIndexes(
     std::vector<FieldIndex> parsed_indexes) {
   VerifyNotTerminated();
@@ -567,8 +631,19 @@ void FirestoreClient::LoadBundle(
       remote::Serializer(database_info_.database_id()));
   auto reader = std::make_shared<bundle::BundleReader>(
       std::move(bundle_serializer), std::move(bundle_data));
+
+  // Reading and decoding the bundle happens on a separate executor, so that the
+  // worker queue only applies the decoded elements.
   worker_queue_->Enqueue([this, reader, result_task] {
-    sync_engine_->LoadBundle(std::move(reader), std::move(result_task));
+    if (!bundle_executor_) {
+      bundle_executor_ =
+          Executor::CreateSerial("com.google.firebase.firestore.bundle");
+    }
+
+    std::make_shared<BundleLoadPipeline>(worker_queue_, bundle_executor_.get(),
+                                         sync_engine_.get(), reader,
+                                         result_task)
+        ->Start();
   });
 }
 
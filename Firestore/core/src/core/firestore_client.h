@@ -19,6 +19,7 @@
 
 #include <memory>
 #include <string>
+#include <unordered_set>
 #include <vector>
 
 #include "Firestore/core/src/api/api_fwd.h"
@@ -40,6 +41,7 @@ namespace firebase {
 namespace firestore {
 
 namespace local {
+struct IndexBackfillProgress;
 class LocalStore;
 class LruDelegate;
 class Persistence;
@@ -163,6 +165,23 @@ class FirestoreClient : public std::enable_shared_from_this<FirestoreClient> {
   void RemoveSnapshotsInSyncListener(
       const std::shared_ptr<EventListener<util::Empty>>& listener);
 
+  /**
+   * Adds a listener to be called with the progress of backfilling indexes
+   * whenever a backfill operation indexes documents or indexes catch up with
+   * the local cache. The listener is called right away with the current state
+   * if the backfiller has already run.
+   */
+  void AddIndexBackfillListener(
+      const std::shared_ptr<EventListener<local::IndexBackfillProgress>>&
+          listener);
+
+  /**
+   * Removes a specific listener for the progress of backfilling indexes.
+   */
+  void RemoveIndexBackfillListener(
+      const std::shared_ptr<EventListener<local::IndexBackfillProgress>>&
+          listener);
+
   /** The database ID of the DatabaseInfo this client was initialized with. */
   const model::DatabaseId& database_id() const {
     return database_info_.database_id();
@@ -219,6 +238,9 @@ class FirestoreClient : public std::enable_shared_from_this<FirestoreClient> {
    */
   void ScheduleIndexBackfiller();
 
+  /** Notifies the index backfill listeners after a backfill operation. */
+  void RaiseIndexBackfillProgress();
+
   DatabaseInfo database_info_;
   std::shared_ptr<credentials::AppCheckCredentialsProvider>
       app_check_credentials_provider_;
@@ -234,6 +256,9 @@ class FirestoreClient : public std::enable_shared_from_this<FirestoreClient> {
   std::shared_ptr<util::AsyncQueue> worker_queue_;
   std::shared_ptr<util::Executor> user_executor_;
 
+  /** Reads and decodes bundles off the worker queue. Created when needed. */
+  std::unique_ptr<util::Executor> bundle_executor_;
+
   std::unique_ptr<remote::FirebaseMetadataProvider> firebase_metadata_provider_;
 
   std::unique_ptr<local::Persistence> persistence_;
@@ -246,10 +271,14 @@ class FirestoreClient : public std::enable_shared_from_this<FirestoreClient> {
 
   bool gc_has_run_ = false;
   bool backfiller_has_run_ = false;
+  bool backfiller_caught_up_ = false;
   bool credentials_initialized_ = false;
   local::LruDelegate* _Nullable lru_delegate_;
   util::DelayedOperation lru_callback_;
   util::DelayedOperation backfiller_callback_;
+  std::unordered_set<
+      std::shared_ptr<EventListener<local::IndexBackfillProgress>>>
+      index_backfill_listeners_;
 };
 
 }  // namespace core
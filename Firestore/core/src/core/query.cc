@@ -218,23 +218,22 @@ Query Query::AsCollectionQueryAtPath(ResourcePath path) const {
 // MARK: - Matching
 
 bool Query::Matches(const Document& doc) const {
-  return doc->is_found_document() && MatchesPathAndCollectionGroup(doc) &&
-         MatchesOrderBy(doc) && MatchesFilters(doc) && MatchesBounds(doc);
+  return doc->is_found_document() &&
+         MatchesPathAndCollectionGroup(doc->key()) && MatchesOrderBy(doc) &&
+         MatchesFilters(doc) && MatchesBounds(doc);
 }
 
-bool Query::MatchesPathAndCollectionGroup(const Document& doc) const {
-  const ResourcePath& doc_path = doc->key().path();
+bool Query::MatchesPathAndCollectionGroup(const DocumentKey& key) const {
   if (collection_group_) {
     // NOTE: path_ is currently always empty since we don't expose Collection
     // Group queries rooted at a document path yet.
-    return doc->key().HasCollectionGroup(*collection_group_) &&
-           path_.IsPrefixOf(doc_path);
+    return key.HasCollectionGroup(*collection_group_) && key.HasPrefix(path_);
   } else if (DocumentKey::IsDocumentKey(path_)) {
     // Exact match for document queries.
-    return path_ == doc_path;
+    return key.path_size() == path_.size() && key.HasPrefix(path_);
   } else {
     // Shallow ancestor queries by default.
-    return path_.IsImmediateParentOf(doc_path);
+    return key.path_size() == path_.size() + 1 && key.HasPrefix(path_);
   }
 }
 
@@ -229,6 +229,12 @@ class Query {
   /** Returns true if the document matches the constraints of this query. */
   bool Matches(const model::Document& doc) const;
 
+  /**
+   * Returns true if a document with the given key is in the collection (or
+   * collection group) of this query, regardless of the document's contents.
+   */
+  bool MatchesPathAndCollectionGroup(const model::DocumentKey& key) const;
+
   /**
    * Returns a comparator that will sort documents according to the order by
    * clauses in this query.
@@ -251,7 +257,6 @@ class Query {
   size_t Hash() const;
 
  private:
-  bool MatchesPathAndCollectionGroup(const model::Document& doc) const;
   bool MatchesFilters(const model::Document& doc) const;
   bool MatchesOrderBy(const model::Document& doc) const;
   bool MatchesBounds(const model::Document& doc) const;
@@ -36,6 +36,7 @@
 #include "Firestore/core/src/util/async_queue.h"
 #include "Firestore/core/src/util/log.h"
 #include "Firestore/core/src/util/status.h"
+#include "absl/memory/memory.h"
 #include "absl/strings/match.h"
 
 namespace firebase {
@@ -84,6 +85,22 @@ bool ErrorIsInteresting(const Status& error) {
   return missing_index || no_permission;
 }
 
+/**
+ * Returns the collection ID shared by all documents that `query` can match:
+ * the last segment of their parent path.
+ */
+const std::string& CollectionGroupOf(const Query& query) {
+  if (query.IsCollectionGroupQuery()) {
+    return *query.collection_group();
+  }
+
+  const model::ResourcePath& path = query.path();
+  // Matches `Query::MatchesPathAndCollectionGroup`: a query whose path names a
+  // document only matches that document, whatever its filters.
+  return DocumentKey::IsDocumentKey(path) ? path[path.size() - 2]
+                                          : path.last_segment();
+}
+
 }  // namespace
 
 SyncEngine::SyncEngine(LocalStore* local_store,
@@ -149,6 +166,8 @@ ViewSnapshot SyncEngine::InitializeViewAndComputeSnapshot(const Query& query,
   auto query_view =
       std::make_shared<QueryView>(query, target_id, std::move(view));
   query_views_by_query_[query] = query_view;
+  query_views_by_collection_group_[CollectionGroupOf(query)].push_back(
+      query_view);
 
   queries_by_target_[target_id].push_back(query);
 
@@ -164,7 +183,7 @@ void SyncEngine::StopListening(const Query& query) {
   auto query_view = query_views_by_query_[query];
   HARD_ASSERT(query_view, "Trying to stop listening to a query not found");
 
-  query_views_by_query_.erase(query);
+  RemoveQueryView(query);
 
   TargetId target_id = query_view->target_id();
   auto& queries = queries_by_target_[target_id];
@@ -180,7 +199,7 @@ void SyncEngine::StopListening(const Query& query) {
 
 void SyncEngine::RemoveAndCleanupTarget(TargetId target_id, Status status) {
   for (const Query& query : queries_by_target_.at(target_id)) {
-    query_views_by_query_.erase(query);
+    RemoveQueryView(query);
     if (!status.ok()) {
       sync_engine_callback_->OnError(query, status);
       if (ErrorIsInteresting(status)) {
@@ -201,6 +220,24 @@ void SyncEngine::RemoveAndCleanupTarget(TargetId target_id, Status status) {
   }
 }
 
+void SyncEngine::RemoveQueryView(const Query& query) {
+  auto it = query_views_by_query_.find(query);
+  if (it == query_views_by_query_.end()) {
+    return;
+  }
+
+  auto group = query_views_by_collection_group_.find(CollectionGroupOf(query));
+  auto& query_views = group->second;
+  query_views.erase(
+      std::remove(query_views.begin(), query_views.end(), it->second),
+      query_views.end());
+  if (query_views.empty()) {
+    query_views_by_collection_group_.erase(group);
+  }
+
+  query_views_by_query_.erase(it);
+}
+
 void SyncEngine::WriteMutations(std::vector<model::Mutation>&& mutations,
                                 StatusCallback callback) {
   AssertCallbackExists("WriteMutations");
@@ -469,10 +506,46 @@ void SyncEngine::EmitNewSnapshotsAndNotifyLocalStore(
   std::vector<ViewSnapshot> new_snapshots;
   std::vector<LocalViewChanges> document_changes_in_all_views;
 
+  // Hand each changed document only to the views whose queries could match
+  // it, instead of matching every change against every view.
+  std::unordered_map<const QueryView*, DocumentMap> changes_by_view;
+  for (const auto& entry : changes) {
+    const DocumentKey& key = entry.first;
+    absl::optional<std::string> collection_group = key.GetCollectionGroup();
+    if (!collection_group) continue;
+
+    auto group = query_views_by_collection_group_.find(*collection_group);
+    if (group == query_views_by_collection_group_.end()) continue;
+
+    for (const auto& query_view : group->second) {
+      if (query_view->query().MatchesPathAndCollectionGroup(key)) {
+        DocumentMap& view_changes = changes_by_view[query_view.get()];
+        view_changes = view_changes.insert(key, entry.second);
+      }
+    }
+  }
+
   for (const auto& entry : query_views_by_query_) {
     const auto& query_view = entry.second;
+
+    absl::optional<TargetChange> target_changes;
+    if (maybe_remote_event.has_value()) {
+      const RemoteEvent& remote_event = maybe_remote_event.value();
+      auto it = remote_event.target_changes().find(query_view->target_id());
+      if (it != remote_event.target_changes().end()) {
+        target_changes = it->second;
+      }
+    }
+
+    // Without document or target changes, the view can neither change nor
+    // update its limbo documents.
+    auto view_changes = changes_by_view.find(query_view.get());
+    if (view_changes == changes_by_view.end() && !target_changes) continue;
+
     View& view = query_view->view();
-    ViewDocumentChanges view_doc_changes = view.ComputeDocumentChanges(changes);
+    ViewDocumentChanges view_doc_changes = view.ComputeDocumentChanges(
+        view_changes != changes_by_view.end() ? view_changes->second
+                                              : DocumentMap{});
     if (view_doc_changes.needs_refill()) {
       // The query has a limit and some docs were removed/updated, so we need to
       // re-run the query against the local store to make sure we didn't lose
@@ -483,14 +556,6 @@ void SyncEngine::EmitNewSnapshotsAndNotifyLocalStore(
                                                      view_doc_changes);
     }
 
-    absl::optional<TargetChange> target_changes;
-    if (maybe_remote_event.has_value()) {
-      const RemoteEvent& remote_event = maybe_remote_event.value();
-      auto it = remote_event.target_changes().find(query_view->target_id());
-      if (it != remote_event.target_changes().end()) {
-        target_changes = it->second;
-      }
-    }
     ViewChange view_change =
         view.ApplyChanges(view_doc_changes, target_changes);
 
@@ -575,21 +640,29 @@ void SyncEngine::RemoveLimboTarget(const DocumentKey& key) {
   PumpEnqueuedLimboResolutions();
 }
 
-absl::optional<BundleLoader> SyncEngine::ReadIntoLoader(
-    const bundle::BundleMetadata& metadata,
-    bundle::BundleReader& reader,
-    api::LoadBundleTask& result_task) {
-  BundleLoader loader(local_store_, metadata);
+void SyncEngine::LoadBundle(std::shared_ptr<bundle::BundleReader> reader,
+                            std::shared_ptr<api::LoadBundleTask> result_task) {
+  auto bundle_metadata = reader->GetBundleMetadata();
+  if (!reader->reader_status().ok()) {
+    LOG_WARN("Failed to GetBundleMetadata() for bundle with error %s",
+             reader->reader_status().error_message());
+    result_task->SetError(reader->reader_status());
+    return;
+  }
+
+  auto loader = StartLoadingBundle(bundle_metadata, *result_task);
+  if (!loader) return;
+
   int64_t current_bytes_read = 0;
   // Breaks when either error happened, or when there is no more element to
   // read.
   while (true) {
-    auto element = reader.GetNextElement();
-    if (!reader.reader_status().ok()) {
+    auto element = reader->GetNextElement();
+    if (!reader->reader_status().ok()) {
       LOG_WARN("Failed to GetNextElement() from bundle with error %s",
-               reader.reader_status().error_message());
-      result_task.SetError(reader.reader_status());
-      return absl::nullopt;
+               reader->reader_status().error_message());
+      result_task->SetError(reader->reader_status());
+      return;
     }
 
     // No more elements from reader.
@@ -598,60 +671,68 @@ absl::optional<BundleLoader> SyncEngine::ReadIntoLoader(
     }
 
     int64_t old_bytes_read = current_bytes_read;
-    current_bytes_read = reader.bytes_read();
-    auto maybe_progress = loader.AddElement(
-        std::move(element), current_bytes_read - old_bytes_read);
-    if (!maybe_progress.ok()) {
-      LOG_WARN("Failed to AddElement() to bundle loader with error %s",
-               maybe_progress.status().error_message());
-      result_task.SetError(maybe_progress.status());
-      return absl::nullopt;
+    current_bytes_read = reader->bytes_read();
+    if (!AddBundleElement(*loader, std::move(element),
+                          current_bytes_read - old_bytes_read, *result_task)) {
+      return;
     }
+  }
 
-    if (maybe_progress.ValueOrDie().has_value()) {
-      result_task.UpdateProgress(maybe_progress.ConsumeValueOrDie().value());
-    }
+  FinishLoadingBundle(*loader, bundle_metadata, *result_task);
+}
+
+std::unique_ptr<BundleLoader> SyncEngine::StartLoadingBundle(
+    const bundle::BundleMetadata& metadata, api::LoadBundleTask& result_task) {
+  bool has_newer_bundle = local_store_->HasNewerBundle(metadata);
+  if (has_newer_bundle) {
+    result_task.SetSuccess(SuccessProgress(metadata));
+    return nullptr;
   }
 
-  return loader;
+  local_store_->ResetBundleTarget(metadata.bundle_id());
+  result_task.UpdateProgress(InitialProgress(metadata));
+  return absl::make_unique<BundleLoader>(local_store_, metadata);
 }
 
-void SyncEngine::LoadBundle(std::shared_ptr<bundle::BundleReader> reader,
-                            std::shared_ptr<api::LoadBundleTask> result_task) {
-  auto bundle_metadata = reader->GetBundleMetadata();
-  if (!reader->reader_status().ok()) {
-    LOG_WARN("Failed to GetBundleMetadata() for bundle with error %s",
-             reader->reader_status().error_message());
-    result_task->SetError(reader->reader_status());
-    return;
+bool SyncEngine::AddBundleElement(
+    BundleLoader& loader,
+    std::unique_ptr<bundle::BundleElement> element,
+    uint64_t byte_size,
+    api::LoadBundleTask& result_task) {
+  auto maybe_progress = loader.AddElement(std::move(element), byte_size);
+  if (!maybe_progress.ok()) {
+    LOG_WARN("Failed to AddElement() to bundle loader with error %s",
+             maybe_progress.status().error_message());
+    result_task.SetError(maybe_progress.status());
+    return false;
   }
 
-  bool has_newer_bundle = local_store_->HasNewerBundle(bundle_metadata);
-  if (has_newer_bundle) {
-    result_task->SetSuccess(SuccessProgress(bundle_metadata));
-    return;
+  if (loader.HasPendingChunk()) {
+    EmitNewSnapshotsAndNotifyLocalStore(loader.ApplyDocuments(),
+                                        absl::nullopt);
   }
 
-  result_task->UpdateProgress(InitialProgress(bundle_metadata));
-  auto maybe_loader = ReadIntoLoader(bundle_metadata, *reader, *result_task);
-  if (!maybe_loader.has_value()) {
-    // `ReadIntoLoader` would call `result_task.SetError` should there be an
-    // error, so we do not need set it here.
-    return;
+  if (maybe_progress.ValueOrDie().has_value()) {
+    result_task.UpdateProgress(maybe_progress.ConsumeValueOrDie().value());
   }
+  return true;
+}
 
-  util::StatusOr<DocumentMap> changes = maybe_loader.value().ApplyChanges();
+void SyncEngine::FinishLoadingBundle(BundleLoader& loader,
+                                     const bundle::BundleMetadata& metadata,
+                                     api::LoadBundleTask& result_task) {
+  util::StatusOr<DocumentMap> changes = loader.ApplyChanges();
   if (!changes.ok()) {
     LOG_WARN("Failed to ApplyChanges() for bundle elements with error %s",
              changes.status().error_message());
-    result_task->SetError(changes.status());
+    result_task.SetError(changes.status());
     return;
   }
 
   EmitNewSnapshotsAndNotifyLocalStore(changes.ConsumeValueOrDie(),
                                       absl::nullopt);
 
-  result_task->SetSuccess(SuccessProgress(bundle_metadata));
+  result_task.SetSuccess(SuccessProgress(metadata));
 }
 
 }  // namespace core
@@ -18,6 +18,7 @@
 #define FIRESTORE_CORE_SRC_CORE_SYNC_ENGINE_H_
 
 #include <cstddef>
+#include <cstdint>
 #include <deque>
 #include <map>
 #include <memory>
@@ -150,9 +151,40 @@ class SyncEngine : public remote::RemoteStoreCallback, public QueryEventSource {
   void HandleOnlineStateChange(model::OnlineState online_state) override;
   model::DocumentKeySet GetRemoteKeys(model::TargetId target_id) const override;
 
+  /** Reads the bundle from `reader` and loads it into local store. */
   void LoadBundle(std::shared_ptr<bundle::BundleReader> reader,
                   std::shared_ptr<api::LoadBundleTask> result_task);
 
+  /**
+   * Starts loading the bundle described by `metadata`.
+   *
+   * Returns a loader to which the elements of the bundle should be added with
+   * `AddBundleElement`, or `nullptr` if the bundle does not need to be loaded,
+   * in which case `result_task` is already completed.
+   */
+  std::unique_ptr<bundle::BundleLoader> StartLoadingBundle(
+      const bundle::BundleMetadata& metadata, api::LoadBundleTask& result_task);
+
+  /**
+   * Adds an element read from a bundle to `loader`, applying the documents
+   * added so far whenever enough of them have accumulated.
+   *
+   * Returns false if the element could not be added, in which case
+   * `result_task` has already failed.
+   */
+  bool AddBundleElement(bundle::BundleLoader& loader,
+                        std::unique_ptr<bundle::BundleElement> element,
+                        uint64_t byte_size,
+                        api::LoadBundleTask& result_task);
+
+  /**
+   * Applies what remains in `loader` once all elements of the bundle described
+   * by `metadata` have been added, and completes `result_task`.
+   */
+  void FinishLoadingBundle(bundle::BundleLoader& loader,
+                           const bundle::BundleMetadata& metadata,
+                           api::LoadBundleTask& result_task);
+
   // For tests only
   std::map<model::DocumentKey, model::TargetId>
   GetActiveLimboDocumentResolutions() const {
@@ -234,6 +266,9 @@ class SyncEngine : public remote::RemoteStoreCallback, public QueryEventSource {
 
   void RemoveLimboTarget(const model::DocumentKey& key);
 
+  /** Removes the view of `query`, if any, from all QueryView indexes. */
+  void RemoveQueryView(const Query& query);
+
   void EmitNewSnapshotsAndNotifyLocalStore(
       const model::DocumentMap& changes,
       const absl::optional<remote::RemoteEvent>& maybe_remote_event);
@@ -267,11 +302,6 @@ class SyncEngine : public remote::RemoteStoreCallback, public QueryEventSource {
   void TriggerPendingWriteCallbacks(model::BatchId batch_id);
   void FailOutstandingPendingWriteCallbacks(const std::string& message);
 
-  absl::optional<bundle::BundleLoader> ReadIntoLoader(
-      const bundle::BundleMetadata& metadata,
-      bundle::BundleReader& reader,
-      api::LoadBundleTask& result_task);
-
   /** The local store, used to persist mutations and cached documents. */
   local::LocalStore* local_store_ = nullptr;
 
@@ -302,6 +332,14 @@ class SyncEngine : public remote::RemoteStoreCallback, public QueryEventSource {
   /** QueryViews for all active queries, indexed by query. */
   std::unordered_map<Query, std::shared_ptr<QueryView>> query_views_by_query_;
 
+  /**
+   * QueryViews for all active queries, indexed by the collection ID of the
+   * documents they can match. Used to route document changes only to the views
+   * they can affect.
+   */
+  std::unordered_map<std::string, std::vector<std::shared_ptr<QueryView>>>
+      query_views_by_collection_group_;
+
   /** Queries mapped to Targets, indexed by target ID. */
   std::unordered_map<model::TargetId, std::vector<Query>> queries_by_target_;
 
@@ -0,0 +1,247 @@
+/*
+ * Copyright 2022 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef FIRESTORE_CORE_SRC_IMMUTABLE_BTREE_NODE_H_
+#define FIRESTORE_CORE_SRC_IMMUTABLE_BTREE_NODE_H_
+
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <utility>
+
+#include "Firestore/core/src/immutable/sorted_container.h"
+#include "Firestore/core/src/util/hard_assert.h"
+
+namespace firebase {
+namespace firestore {
+namespace immutable {
+namespace impl {
+
+/**
+ * A bounded-size array that stores its elements directly in itself, like
+ * `FixedArray`, but only constructs the elements it actually holds, so `T`
+ * doesn't need to be default constructible and unused slots cost nothing but
+ * memory.
+ */
+template <typename T, SortedContainer::size_type N>
+class InlineArray {
+ public:
+  using size_type = SortedContainer::size_type;
+
+  InlineArray() = default;
+
+  InlineArray(const InlineArray& other) {
+    for (const T& element : other) {
+      push_back(element);
+    }
+  }
+
+  InlineArray& operator=(const InlineArray&) = delete;
+
+  ~InlineArray() {
+    for (T& element : *this) {
+      element.~T();
+    }
+  }
+
+  void push_back(const T& element) {
+    HARD_ASSERT(size_ < N);
+    new (data() + size_) T(element);
+    ++size_;
+  }
+
+  void push_back(T&& element) {
+    HARD_ASSERT(size_ < N);
+    new (data() + size_) T(std::move(element));
+    ++size_;
+  }
+
+  const T& operator[](size_type index) const {
+    return data()[index];
+  }
+
+  T& operator[](size_type index) {
+    return data()[index];
+  }
+
+  const T* begin() const {
+    return data();
+  }
+  const T* end() const {
+    return data() + size_;
+  }
+  T* begin() {
+    return data();
+  }
+  T* end() {
+    return data() + size_;
+  }
+
+  size_type size() const {
+    return size_;
+  }
+
+ private:
+  const T* data() const {
+    return reinterpret_cast<const T*>(storage_);
+  }
+  T* data() {
+    return reinterpret_cast<T*>(storage_);
+  }
+
+  alignas(T) unsigned char storage_[sizeof(T) * N];
+  size_type size_ = 0;
+};
+
+template <typename K, typename V>
+class BTreeLeaf;
+
+template <typename K, typename V>
+class BTreeInner;
+
+/**
+ * BTreeNode is a node in a BTreeSortedMap: either a `BTreeLeaf`, holding the
+ * entries of the map, or a `BTreeInner`, holding up to `kMaxSlots` children.
+ *
+ * Nodes are immutable once they're part of a tree, so they can be shared
+ * between all the versions of a map that contain them.
+ */
+template <typename K, typename V>
+class BTreeNode : public SortedMapBase {
+ public:
+  using value_type = std::pair<K, V>;
+  using leaf_type = BTreeLeaf<K, V>;
+  using inner_type = BTreeInner<K, V>;
+  using pointer = std::shared_ptr<const BTreeNode>;
+
+  /**
+   * The maximum number of entries in a leaf, and of children of an inner node.
+   * Nodes are made wide so that a lookup touches few of them and iteration
+   * mostly walks over contiguous entries.
+   */
+  static constexpr size_type kMaxSlots = 32;
+
+  /**
+   * The minimum number of entries or children of any node other than the
+   * root.
+   */
+  static constexpr size_type kMinSlots = kMaxSlots / 2;
+
+  bool leaf() const {
+    return leaf_;
+  }
+
+  /** Returns the number of entries in this node and all nodes beneath it. */
+  size_type size() const {
+    return size_;
+  }
+
+  /** Returns the number of entries of a leaf or children of an inner node. */
+  size_type slot_count() const {
+    return leaf() ? as_leaf().entries().size() : as_inner().children().size();
+  }
+
+  const leaf_type& as_leaf() const {
+    return static_cast<const leaf_type&>(*this);
+  }
+
+  const inner_type& as_inner() const {
+    return static_cast<const inner_type&>(*this);
+  }
+
+  /** Returns the smallest key in this node or beneath it. */
+  const K& min_key() const {
+    return leaf() ? as_leaf().entries()[0].first
+                  : as_inner().children()[0].min_key;
+  }
+
+ protected:
+  explicit BTreeNode(bool leaf) : leaf_{leaf} {
+  }
+
+  bool leaf_ = false;
+  size_type size_ = 0;
+};
+
+template <typename K, typename V>
+constexpr SortedContainer::size_type BTreeNode<K, V>::kMaxSlots;
+
+template <typename K, typename V>
+constexpr SortedContainer::size_type BTreeNode<K, V>::kMinSlots;
+
+/** A BTreeNode holding the entries of the map, in order. */
+template <typename K, typename V>
+class BTreeLeaf : public BTreeNode<K, V> {
+ public:
+  using value_type = std::pair<K, V>;
+  using entries_type = InlineArray<value_type, BTreeNode<K, V>::kMaxSlots>;
+
+  BTreeLeaf() : BTreeNode<K, V>{true} {
+  }
+
+  const entries_type& entries() const {
+    return entries_;
+  }
+
+  void Append(const value_type& entry) {
+    entries_.push_back(entry);
+    ++this->size_;
+  }
+
+ private:
+  entries_type entries_;
+};
+
+/** A child of a BTreeInner, along with the smallest key beneath it. */
+template <typename K, typename V>
+struct BTreeChild {
+  explicit BTreeChild(typename BTreeNode<K, V>::pointer child)
+      : min_key{child->min_key()}, node{std::move(child)} {
+  }
+
+  K min_key;
+  typename BTreeNode<K, V>::pointer node;
+};
+
+/** A BTreeNode holding the subtrees beneath it, in order. */
+template <typename K, typename V>
+class BTreeInner : public BTreeNode<K, V> {
+ public:
+  using child_type = BTreeChild<K, V>;
+  using children_type = InlineArray<child_type, BTreeNode<K, V>::kMaxSlots>;
+
+  BTreeInner() : BTreeNode<K, V>{false} {
+  }
+
+  const children_type& children() const {
+    return children_;
+  }
+
+  void Append(const child_type& child) {
+    children_.push_back(child);
+    this->size_ += child.node->size();
+  }
+
+ private:
+  children_type children_;
+};
+
+}  // namespace impl
+}  // namespace immutable
+}  // namespace firestore
+}  // namespace firebase
+
+#endif  // FIRESTORE_CORE_SRC_IMMUTABLE_BTREE_NODE_H_
@@ -0,0 +1,279 @@
+/*
+ * Copyright 2022 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef FIRESTORE_CORE_SRC_IMMUTABLE_BTREE_NODE_ITERATOR_H_
+#define FIRESTORE_CORE_SRC_IMMUTABLE_BTREE_NODE_ITERATOR_H_
+
+#include <array>
+#include <cstddef>
+#include <iterator>
+
+#include "Firestore/core/src/immutable/btree_node.h"
+#include "Firestore/core/src/util/comparison.h"
+#include "Firestore/core/src/util/hard_assert.h"
+
+namespace firebase {
+namespace firestore {
+namespace immutable {
+namespace impl {
+
+/**
+ * A forward iterator for traversing BTreeNodes in key order.
+ *
+ * Like LlrbNodeIterator, it keeps an explicit path from the root because
+ * nodes are shared between versions of the map and can't point to their
+ * parents. Since every node other than the root has at least
+ * `BTreeNode::kMinSlots` children, the path is short enough to be stored
+ * inline, so creating and copying iterators never allocates. Incrementing an
+ * iterator only touches the path when it moves past the end of a leaf.
+ *
+ * Iterators compare equal if they point to the same entry of the same leaf.
+ *
+ * Note: BTreeNodeIterator does not extend the lifetime of its underlying tree.
+ */
+template <typename K, typename V>
+class BTreeNodeIterator {
+ public:
+  using node_type = BTreeNode<K, V>;
+  using size_type = typename node_type::size_type;
+
+  using iterator_category = std::forward_iterator_tag;
+  using value_type = typename node_type::value_type;
+  using pointer = const value_type*;
+  using reference = const value_type&;
+  using difference_type = std::ptrdiff_t;
+
+  /**
+   * The maximum height of a tree. With at least `kMinSlots` children per inner
+   * node, this is enough for any tree whose size fits in `size_type`.
+   */
+  static constexpr int kMaxDepth = 12;
+
+  // Default constructor to conform to the requirements of ForwardIterator
+  BTreeNodeIterator() = default;
+
+  /**
+   * Constructs an iterator pointing at the first entry of the tree with the
+   * given root, which may be null for an empty tree.
+   */
+  static BTreeNodeIterator Begin(const node_type* root) {
+    BTreeNodeIterator result;
+    if (root) {
+      result.DescendToFirst(root);
+    }
+    return result;
+  }
+
+  /** Constructs an iterator pointing at the end of the iteration sequence. */
+  static BTreeNodeIterator End() {
+    return BTreeNodeIterator{};
+  }
+
+  /**
+   * Constructs an iterator pointing at the last entry of the tree with the
+   * given root, which may be null for an empty tree.
+   */
+  static BTreeNodeIterator Last(const node_type* root) {
+    BTreeNodeIterator result;
+    const node_type* node = root;
+    while (node) {
+      size_type last = node->slot_count() - 1;
+      result.Push(node, last);
+      node = node->leaf() ? nullptr : Child(node, last);
+    }
+    return result;
+  }
+
+  /**
+   * Constructs an iterator pointing to the first entry whose key is not less
+   * than the given key, or to the end if all keys in the tree are less than
+   * it.
+   */
+  template <typename C>
+  static BTreeNodeIterator LowerBound(const node_type* root,
+                                      const K& key,
+                                      const C& comparator) {
+    BTreeNodeIterator result;
+    if (!root) {
+      return result;
+    }
+
+    const node_type* node = root;
+    while (!node->leaf()) {
+      size_type index = ChildIndex(node->as_inner(), key, comparator);
+      result.Push(node, index);
+      node = Child(node, index);
+    }
+
+    size_type index = EntryIndex(node->as_leaf(), key, comparator);
+    if (index < node->slot_count()) {
+      result.Push(node, index);
+    } else {
+      // All keys in this leaf are less than `key`, so the lower bound is the
+      // first entry of the next leaf.
+      result.Push(node, index - 1);
+      ++result;
+    }
+    return result;
+  }
+
+  /**
+   * Returns the index of the child of `inner` that would contain `key`: the
+   * last one whose smallest key is not greater than `key`, or the first one.
+   */
+  template <typename C>
+  static size_type ChildIndex(const typename node_type::inner_type& inner,
+                              const K& key,
+                              const C& comparator) {
+    const auto& children = inner.children();
+    size_type low = 1;
+    size_type high = children.size();
+    while (low < high) {
+      size_type mid = low + (high - low) / 2;
+      if (util::Ascending(comparator.Compare(key, children[mid].min_key))) {
+        high = mid;
+      } else {
+        low = mid + 1;
+      }
+    }
+    return low - 1;
+  }
+
+  /**
+   * Returns the index of the first entry of `leaf` whose key is not less than
+   * `key`, or the number of entries if there's none.
+   */
+  template <typename C>
+  static size_type EntryIndex(const typename node_type::leaf_type& leaf,
+                              const K& key,
+                              const C& comparator) {
+    const auto& entries = leaf.entries();
+    size_type low = 0;
+    size_type high = entries.size();
+    while (low < high) {
+      size_type mid = low + (high - low) / 2;
+      if (util::Ascending(comparator.Compare(entries[mid].first, key))) {
+        low = mid + 1;
+      } else {
+        high = mid;
+      }
+    }
+    return low;
+  }
+
+  /**
+   * Returns true if this iterator points at the end of the iteration sequence.
+   */
+  bool is_end() const {
+    return depth_ == 0;
+  }
+
+  /**
+   * Returns the address of the entry that this iterator points to. This can
+   * only be called if `is_end()` is false.
+   */
+  pointer get() const {
+    HARD_ASSERT(!is_end());
+    const Frame& leaf = path_[depth_ - 1];
+    return &leaf.node->as_leaf().entries()[leaf.index];
+  }
+
+  reference operator*() const {
+    return *get();
+  }
+
+  pointer operator->() const {
+    return get();
+  }
+
+  BTreeNodeIterator& operator++() {
+    HARD_ASSERT(!is_end());
+
+    Frame& leaf = path_[depth_ - 1];
+    if (++leaf.index < leaf.node->slot_count()) {
+      return *this;
+    }
+
+    // Move up to the nearest ancestor that has a next child, and then down to
+    // the first entry beneath that child.
+    --depth_;
+    while (depth_ > 0) {
+      Frame& frame = path_[depth_ - 1];
+      if (++frame.index < frame.node->slot_count()) {
+        DescendToFirst(Child(frame.node, frame.index));
+        break;
+      }
+      --depth_;
+    }
+    return *this;
+  }
+
+  BTreeNodeIterator operator++(int /*unused*/) {
+    BTreeNodeIterator result = *this;
+    ++*this;
+    return result;
+  }
+
+  friend bool operator==(const BTreeNodeIterator& a,
+                         const BTreeNodeIterator& b) {
+    if (a.is_end() || b.is_end()) {
+      return a.is_end() == b.is_end();
+    }
+    const Frame& left = a.path_[a.depth_ - 1];
+    const Frame& right = b.path_[b.depth_ - 1];
+    return left.node == right.node && left.index == right.index;
+  }
+
+  bool operator!=(const BTreeNodeIterator& b) const {
+    return !(*this == b);
+  }
+
+ private:
+  struct Frame {
+    const node_type* node;
+    size_type index;
+  };
+
+  static const node_type* Child(const node_type* inner, size_type index) {
+    return inner->as_inner().children()[index].node.get();
+  }
+
+  void Push(const node_type* node, size_type index) {
+    HARD_ASSERT(depth_ < kMaxDepth, "BTree is too deep");
+    path_[depth_++] = Frame{node, index};
+  }
+
+  void DescendToFirst(const node_type* node) {
+    Push(node, 0);
+    while (!node->leaf()) {
+      node = Child(node, 0);
+      Push(node, 0);
+    }
+  }
+
+  std::array<Frame, kMaxDepth> path_{};
+  int depth_ = 0;
+};
+
+template <typename K, typename V>
+constexpr int BTreeNodeIterator<K, V>::kMaxDepth;
+
+}  // namespace impl
+}  // namespace immutable
+}  // namespace firestore
+}  // namespace firebase
+
+#endif  // FIRESTORE_CORE_SRC_IMMUTABLE_BTREE_NODE_ITERATOR_H_
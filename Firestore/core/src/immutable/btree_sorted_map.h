@@ -0,0 +1,553 @@
+/*
+ * Copyright 2022 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef FIRESTORE_CORE_SRC_IMMUTABLE_BTREE_SORTED_MAP_H_
+#define FIRESTORE_CORE_SRC_IMMUTABLE_BTREE_SORTED_MAP_H_
+
+#include <algorithm>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "Firestore/core/src/immutable/btree_node.h"
+#include "Firestore/core/src/immutable/btree_node_iterator.h"
+#include "Firestore/core/src/immutable/keys_view.h"
+#include "Firestore/core/src/immutable/sorted_container.h"
+#include "Firestore/core/src/util/comparison.h"
+#include "Firestore/core/src/util/compressed_member.h"
+
+namespace firebase {
+namespace firestore {
+namespace immutable {
+namespace impl {
+
+/**
+ * BTreeSortedMap is a value type containing a map. It is immutable, but has
+ * methods to efficiently create new maps that are mutations of it.
+ *
+ * The map is a B+ tree: all entries live in leaves of up to
+ * `BTreeNode::kMaxSlots` entries, and inner nodes hold up to that many
+ * children along with the smallest key beneath each. Mutations copy only the
+ * nodes on the path from the root to the affected leaf and share all other
+ * nodes with the original map. Compared with an LLRB tree, this needs a
+ * fraction of the allocations and keeps neighboring entries adjacent in
+ * memory.
+ */
+template <typename K, typename V, typename C = util::Comparator<K>>
+class BTreeSortedMap : public SortedMapBase, private util::CompressedMember<C> {
+  using ComparatorMember = util::CompressedMember<C>;
+
+ public:
+  /**
+   * The type of the entries stored in the map.
+   */
+  using value_type = std::pair<K, V>;
+
+  using node_type = BTreeNode<K, V>;
+  using const_iterator = BTreeNodeIterator<K, V>;
+  using const_key_iterator = util::iterator_first<const_iterator>;
+
+  /**
+   * Creates an empty BTreeSortedMap.
+   */
+  explicit BTreeSortedMap(const C& comparator = {})
+      : ComparatorMember{comparator} {
+  }
+
+  /**
+   * Creates a BTreeSortedMap from a range of pairs to insert. If the range
+   * contains the same key more than once, the last pair wins, as if the pairs
+   * had been inserted one by one.
+   */
+  template <typename Range>
+  static BTreeSortedMap Create(const Range& range, const C& comparator) {
+    std::vector<value_type> entries;
+    for (auto&& element : range) {
+      entries.emplace_back(element.first, element.second);
+    }
+    std::stable_sort(entries.begin(), entries.end(),
+                     [&](const value_type& lhs, const value_type& rhs) {
+                       return util::Ascending(
+                           comparator.Compare(lhs.first, rhs.first));
+                     });
+
+    std::vector<value_type> unique;
+    unique.reserve(entries.size());
+    for (value_type& entry : entries) {
+      if (!unique.empty() &&
+          util::Same(comparator.Compare(unique.back().first, entry.first))) {
+        unique.back() = std::move(entry);
+      } else {
+        unique.push_back(std::move(entry));
+      }
+    }
+
+    return BTreeSortedMap{BuildFromSorted(unique), comparator};
+  }
+
+  /** Returns true if the map contains no elements. */
+  bool empty() const {
+    return root_ == nullptr;
+  }
+
+  /** Returns the number of items in this map. */
+  size_type size() const {
+    return root_ ? root_->size() : 0;
+  }
+
+  /** Returns the root node, or null if the map is empty. */
+  const node_type* root() const {
+    return root_.get();
+  }
+
+  const C& comparator() const {
+    return ComparatorMember::get();
+  }
+
+  /**
+   * Creates a new map identical to this one, but with a key-value pair added or
+   * updated.
+   *
+   * @param key The key to insert/update.
+   * @param value The value to associate with the key.
+   * @return A new dictionary with the added/updated value.
+   */
+  BTreeSortedMap insert(const K& key, const V& value) const {
+    const C& comparator = this->comparator();
+    if (!root_) {
+      auto leaf = std::make_shared<leaf_type>();
+      leaf->Append(value_type{key, value});
+      return BTreeSortedMap{std::move(leaf), comparator};
+    }
+
+    Split split = Insert(*root_, key, value, comparator);
+    if (!split.right) {
+      return BTreeSortedMap{std::move(split.left), comparator};
+    }
+
+    // The root was split, so the tree grows by one level.
+    auto root = std::make_shared<inner_type>();
+    root->Append(child_type{std::move(split.left)});
+    root->Append(child_type{std::move(split.right)});
+    return BTreeSortedMap{std::move(root), comparator};
+  }
+
+  /**
+   * Creates a new map identical to this one, but with a key removed from it.
+   *
+   * @param key The key to remove.
+   * @return A new map without that value.
+   */
+  BTreeSortedMap erase(const K& key) const {
+    const C& comparator = this->comparator();
+    if (!root_) {
+      return *this;
+    }
+
+    node_pointer root = Erase(root_, key, comparator);
+    if (root == root_) {
+      // The key wasn't found.
+      return *this;
+    }
+
+    if (root->size() == 0) {
+      return BTreeSortedMap{comparator};
+    }
+    if (!root->leaf() && root->slot_count() == 1) {
+      // The root's only child becomes the new root, shrinking the tree by one
+      // level.
+      root = root->as_inner().children()[0].node;
+    }
+    return BTreeSortedMap{std::move(root), comparator};
+  }
+
+  bool contains(const K& key) const {
+    // Descend directly rather than building up the path required to construct
+    // a full iterator.
+    const C& comparator = this->comparator();
+    const node_type* node = root_.get();
+    if (!node) {
+      return false;
+    }
+
+    while (!node->leaf()) {
+      size_type index =
+          const_iterator::ChildIndex(node->as_inner(), key, comparator);
+      node = node->as_inner().children()[index].node.get();
+    }
+
+    const auto& entries = node->as_leaf().entries();
+    size_type index = const_iterator::EntryIndex(node->as_leaf(), key,
+                                                 comparator);
+    return index < entries.size() &&
+           util::Same(comparator.Compare(key, entries[index].first));
+  }
+
+  /**
+   * Finds a value in the map.
+   *
+   * @param key The key to look up.
+   * @return An iterator pointing to the entry containing the key, or end() if
+   *     not found.
+   */
+  const_iterator find(const K& key) const {
+    const_iterator found = lower_bound(key);
+    if (!found.is_end() &&
+        util::Same(this->comparator().Compare(key, found->first))) {
+      return found;
+    } else {
+      return end();
+    }
+  }
+
+  /**
+   * Finds the index of the given key in the map.
+   *
+   * @param key The key to look up.
+   * @return The index of the entry containing the key, or npos if not found.
+   */
+  size_type find_index(const K& key) const {
+    const C& comparator = this->comparator();
+    const node_type* node = root_.get();
+    if (!node) {
+      return npos;
+    }
+
+    size_type preceding = 0;
+    while (!node->leaf()) {
+      const auto& children = node->as_inner().children();
+      size_type index =
+          const_iterator::ChildIndex(node->as_inner(), key, comparator);
+      for (size_type i = 0; i < index; ++i) {
+        preceding += children[i].node->size();
+      }
+      node = children[index].node.get();
+    }
+
+    const auto& entries = node->as_leaf().entries();
+    size_type index = const_iterator::EntryIndex(node->as_leaf(), key,
+                                                 comparator);
+    if (index < entries.size() &&
+        util::Same(comparator.Compare(key, entries[index].first))) {
+      return preceding + index;
+    }
+    return npos;
+  }
+
+  /**
+   * Finds the first entry in the map containing a key greater than or equal
+   * to the given key.
+   *
+   * @param key The key to look up.
+   * @return An iterator pointing to the entry containing the key or the next
+   *     largest key. Can return end() if all keys in the map are less than the
+   *     requested key.
+   */
+  const_iterator lower_bound(const K& key) const {
+    return const_iterator::LowerBound(root_.get(), key, this->comparator());
+  }
+
+  const_iterator min() const {
+    return begin();
+  }
+
+  const_iterator max() const {
+    return const_iterator::Last(root_.get());
+  }
+
+  /**
+   * Returns a forward iterator pointing to the first entry in the map. If there
+   * are no entries in the map, begin() == end().
+   *
+   * See BTreeNodeIterator for details
+   */
+  const_iterator begin() const {
+    return const_iterator::Begin(root_.get());
+  }
+
+  /**
+   * Returns an iterator pointing past the last entry in the map.
+   */
+  const_iterator end() const {
+    return const_iterator::End();
+  }
+
+  /**
+   * Returns a view of this SortedMap containing just the keys that have been
+   * inserted.
+   */
+  const util::range<const_key_iterator> keys() const {
+    return KeysView(*this);
+  }
+
+  /**
+   * Returns a view of this SortedMap containing just the keys that have been
+   * inserted that are greater than or equal to the given key.
+   */
+  const util::range<const_key_iterator> keys_from(const K& key) const {
+    return KeysViewFrom(*this, key);
+  }
+
+  /**
+   * Returns a view of this SortedMap containing just the keys that have been
+   * inserted that are greater than or equal to the given start_key and less
+   * than the given end_key.
+   */
+  const util::range<const_key_iterator> keys_in(const K& start_key,
+                                                const K& end_key) const {
+    return impl::KeysViewIn(*this, start_key, end_key, this->comparator());
+  }
+
+ private:
+  using node_pointer = typename node_type::pointer;
+  using leaf_type = typename node_type::leaf_type;
+  using inner_type = typename node_type::inner_type;
+  using child_type = typename inner_type::child_type;
+
+  static constexpr size_type kMaxSlots = node_type::kMaxSlots;
+  static constexpr size_type kMinSlots = node_type::kMinSlots;
+
+  /**
+   * The result of inserting into a node: the new node, and if it overflowed,
+   * the new node that follows it.
+   */
+  struct Split {
+    node_pointer left;
+    node_pointer right;
+  };
+
+  BTreeSortedMap(node_pointer root, const C& comparator) noexcept
+      : ComparatorMember{comparator}, root_{std::move(root)} {
+  }
+
+  /**
+   * Builds nodes of the given type from `count` slots obtained from
+   * `slot(i)`: a single node if they fit, otherwise two nodes of about equal
+   * size.
+   */
+  template <typename Node, typename SlotAt>
+  static Split Distribute(size_type count, const SlotAt& slot) {
+    auto first = std::make_shared<Node>();
+    if (count <= kMaxSlots) {
+      for (size_type i = 0; i < count; ++i) {
+        first->Append(slot(i));
+      }
+      return Split{std::move(first), nullptr};
+    }
+
+    auto second = std::make_shared<Node>();
+    size_type half = count / 2;
+    for (size_type i = 0; i < half; ++i) {
+      first->Append(slot(i));
+    }
+    for (size_type i = half; i < count; ++i) {
+      second->Append(slot(i));
+    }
+    return Split{std::move(first), std::move(second)};
+  }
+
+  static Split Insert(const node_type& node,
+                      const K& key,
+                      const V& value,
+                      const C& comparator) {
+    if (node.leaf()) {
+      const auto& entries = node.as_leaf().entries();
+      size_type index =
+          const_iterator::EntryIndex(node.as_leaf(), key, comparator);
+      bool replace = index < entries.size() &&
+                     util::Same(comparator.Compare(key, entries[index].first));
+
+      value_type entry{key, value};
+      size_type skip = replace ? 1 : 0;
+      size_type count = entries.size() + 1 - skip;
+      return Distribute<leaf_type>(count, [&](size_type i) -> const
+                                   value_type& {
+        if (i < index) return entries[i];
+        if (i == index) return entry;
+        return entries[i - 1 + skip];
+      });
+    }
+
+    const auto& children = node.as_inner().children();
+    size_type index =
+        const_iterator::ChildIndex(node.as_inner(), key, comparator);
+    Split split = Insert(*children[index].node, key, value, comparator);
+
+    child_type left{std::move(split.left)};
+    if (!split.right) {
+      return Distribute<inner_type>(
+          children.size(), [&](size_type i) -> const child_type& {
+            return i == index ? left : children[i];
+          });
+    }
+
+    child_type right{std::move(split.right)};
+    return Distribute<inner_type>(
+        children.size() + 1, [&](size_type i) -> const child_type& {
+          if (i < index) return children[i];
+          if (i == index) return left;
+          if (i == index + 1) return right;
+          return children[i - 1];
+        });
+  }
+
+  /**
+   * Erases `key` from beneath `node`. Returns `node` itself if the key isn't
+   * found. Otherwise, the returned node may have fewer than `kMinSlots` slots,
+   * which the caller must fix up.
+   */
+  static node_pointer Erase(const node_pointer& node,
+                            const K& key,
+                            const C& comparator) {
+    if (node->leaf()) {
+      const auto& entries = node->as_leaf().entries();
+      size_type index =
+          const_iterator::EntryIndex(node->as_leaf(), key, comparator);
+      if (index == entries.size() ||
+          !util::Same(comparator.Compare(key, entries[index].first))) {
+        return node;
+      }
+
+      auto result = std::make_shared<leaf_type>();
+      for (size_type i = 0; i < entries.size(); ++i) {
+        if (i != index) result->Append(entries[i]);
+      }
+      return result;
+    }
+
+    const auto& children = node->as_inner().children();
+    size_type index =
+        const_iterator::ChildIndex(node->as_inner(), key, comparator);
+    node_pointer erased = Erase(children[index].node, key, comparator);
+    if (erased == children[index].node) {
+      return node;
+    }
+
+    if (erased->slot_count() >= kMinSlots) {
+      child_type replacement{std::move(erased)};
+      return Distribute<inner_type>(children.size(),
+                                    [&](size_type i) -> const child_type& {
+                                      return i == index ? replacement
+                                                        : children[i];
+                                    })
+          .left;
+    }
+
+    // The child underflowed: merge it with a sibling, or if together they
+    // have too many slots for one node, spread their slots evenly over two.
+    size_type first = index > 0 ? index - 1 : index;
+    const node_type& left =
+        first == index ? *erased : *children[first].node;
+    const node_type& right =
+        first == index ? *children[index + 1].node : *erased;
+    Split merged = Merge(left, right);
+
+    auto result = std::make_shared<inner_type>();
+    for (size_type i = 0; i < first; ++i) {
+      result->Append(children[i]);
+    }
+    result->Append(child_type{std::move(merged.left)});
+    if (merged.right) {
+      result->Append(child_type{std::move(merged.right)});
+    }
+    for (size_type i = first + 2; i < children.size(); ++i) {
+      result->Append(children[i]);
+    }
+    return result;
+  }
+
+  /** Combines the slots of two adjacent nodes at the same level. */
+  static Split Merge(const node_type& left, const node_type& right) {
+    size_type left_count = left.slot_count();
+    size_type count = left_count + right.slot_count();
+    if (left.leaf()) {
+      const auto& left_entries = left.as_leaf().entries();
+      const auto& right_entries = right.as_leaf().entries();
+      return Distribute<leaf_type>(
+          count, [&](size_type i) -> const value_type& {
+            return i < left_count ? left_entries[i]
+                                  : right_entries[i - left_count];
+          });
+    }
+
+    const auto& left_children = left.as_inner().children();
+    const auto& right_children = right.as_inner().children();
+    return Distribute<inner_type>(
+        count, [&](size_type i) -> const child_type& {
+          return i < left_count ? left_children[i]
+                                : right_children[i - left_count];
+        });
+  }
+
+  /**
+   * Builds a tree from entries that are sorted and unique, filling nodes
+   * evenly level by level.
+   */
+  static node_pointer BuildFromSorted(const std::vector<value_type>& entries) {
+    if (entries.empty()) {
+      return nullptr;
+    }
+
+    std::vector<node_pointer> level;
+    FillNodes<leaf_type>(entries.size(), [&](size_type i) -> const
+                         value_type& { return entries[i]; },
+                         &level);
+
+    while (level.size() > 1) {
+      std::vector<child_type> children;
+      children.reserve(level.size());
+      for (node_pointer& node : level) {
+        children.emplace_back(std::move(node));
+      }
+
+      level.clear();
+      FillNodes<inner_type>(children.size(), [&](size_type i) -> const
+                            child_type& { return children[i]; },
+                            &level);
+    }
+    return std::move(level[0]);
+  }
+
+  /**
+   * Spreads `count` slots evenly over as few nodes as possible and appends
+   * those nodes to `result`.
+   */
+  template <typename Node, typename SlotAt>
+  static void FillNodes(size_t count,
+                        const SlotAt& slot,
+                        std::vector<node_pointer>* result) {
+    size_t node_count = (count + kMaxSlots - 1) / kMaxSlots;
+    size_t next = 0;
+    for (size_t n = 0; n < node_count; ++n) {
+      // The first `count % node_count` nodes get one extra slot.
+      size_t slots = count / node_count + (n < count % node_count ? 1 : 0);
+      auto node = std::make_shared<Node>();
+      for (size_t i = 0; i < slots; ++i) {
+        node->Append(slot(static_cast<size_type>(next++)));
+      }
+      result->push_back(std::move(node));
+    }
+  }
+
+  node_pointer root_;
+};
+
+}  // namespace impl
+}  // namespace immutable
+}  // namespace firestore
+}  // namespace firebase
+
+#endif  // FIRESTORE_CORE_SRC_IMMUTABLE_BTREE_SORTED_MAP_H_
@@ -20,10 +20,10 @@
 #include <utility>
 
 #include "Firestore/core/src/immutable/array_sorted_map.h"
+#include "Firestore/core/src/immutable/btree_sorted_map.h"
 #include "Firestore/core/src/immutable/keys_view.h"
 #include "Firestore/core/src/immutable/sorted_container.h"
 #include "Firestore/core/src/immutable/sorted_map_iterator.h"
-#include "Firestore/core/src/immutable/tree_sorted_map.h"
 #include "Firestore/core/src/util/comparison.h"
 #include "absl/base/attributes.h"
 #include "absl/types/optional.h"
@@ -44,12 +44,12 @@ class SortedMap : public SortedMapBase {
   /** The type of the entries stored in the map. */
   using value_type = std::pair<K, V>;
   using array_type = impl::ArraySortedMap<K, V, C>;
-  using tree_type = impl::TreeSortedMap<K, V, C>;
+  using tree_type = impl::BTreeSortedMap<K, V, C>;
 
   using const_iterator = impl::SortedMapIterator<
       value_type,
       typename impl::FixedArray<value_type>::const_iterator,
-      typename impl::LlrbNode<K, V>::const_iterator>;
+      typename tree_type::const_iterator>;
 
   using const_key_iterator = util::iterator_first<const_iterator>;
 
@@ -101,7 +101,7 @@ class SortedMap : public SortedMapBase {
         array_.~ArraySortedMap();
         break;
       case Tag::Tree:
-        tree_.~TreeSortedMap();
+        tree_.~BTreeSortedMap();
         break;
     }
   }
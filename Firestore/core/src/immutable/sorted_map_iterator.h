@@ -20,7 +20,7 @@
 #include <utility>
 
 #include "Firestore/core/src/immutable/array_sorted_map.h"
-#include "Firestore/core/src/immutable/tree_sorted_map.h"
+#include "Firestore/core/src/immutable/btree_sorted_map.h"
 
 namespace firebase {
 namespace firestore {
@@ -13,6 +13,8 @@
 // limitations under the License.
 
 #include <algorithm>
+#include <chrono>  // NOLINT(build/c++11)
+#include <cstdint>
 #include <unordered_set>
 #include <utility>
 
@@ -33,15 +35,27 @@ namespace {
 
 using model::IndexOffset;
 
+/**
+ * The number of documents to process the first time Backfill() is called, and
+ * the least number of documents to process each time.
+ */
+static const int kMinDocumentsToProcess = 50;
+
 /**
  * The maximum number of documents to process each time Backfill() is called.
  */
-static const int kMaxDocumentsToProcess = 50;
+static const int kMaxDocumentsToProcess = 5000;
+
+/**
+ * How long each call to Backfill() should take at most. Backfill() runs on the
+ * worker queue and delays all other operations while it runs.
+ */
+static const auto kTargetBatchDuration = std::chrono::milliseconds(20);
 
 }  // namespace
 
 IndexBackfiller::IndexBackfiller() {
-  max_documents_to_process_ = kMaxDocumentsToProcess;
+  max_documents_to_process_ = kMinDocumentsToProcess;
 }
 
 int IndexBackfiller::WriteIndexEntries(const LocalStore* local_store) {
@@ -61,7 +75,29 @@ int IndexBackfiller::WriteIndexEntries(const LocalStore* local_store) {
         local_store, collection_group.value(), documents_remaining);
     processed_collection_groups.insert(collection_group.value());
   }
-  return max_documents_to_process_ - documents_remaining;
+
+  // Every collection group was brought up to date if the cap wasn't reached.
+  progress_ = IndexBackfillProgress{
+      max_documents_to_process_ - documents_remaining, documents_remaining > 0};
+  return progress_.documents_processed;
+}
+
+void IndexBackfiller::AdjustBatchSize(std::chrono::milliseconds duration) {
+  if (!adjust_batch_size_) {
+    return;
+  }
+
+  if (duration > kTargetBatchDuration) {
+    // Scale the batch down to what would have fit into the target duration.
+    int64_t scaled = static_cast<int64_t>(max_documents_to_process_) *
+                     kTargetBatchDuration.count() / duration.count();
+    max_documents_to_process_ =
+        std::max(kMinDocumentsToProcess, static_cast<int>(scaled));
+  } else if (!progress_.caught_up && duration < kTargetBatchDuration / 2) {
+    // Only batches that hit the cap say anything about larger batches.
+    max_documents_to_process_ =
+        std::min(kMaxDocumentsToProcess, max_documents_to_process_ * 2);
+  }
 }
 
 int IndexBackfiller::WriteEntriesForCollectionGroup(
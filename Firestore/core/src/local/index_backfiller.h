@@ -15,6 +15,7 @@
 #ifndef FIRESTORE_CORE_SRC_LOCAL_INDEX_BACKFILLER_H_
 #define FIRESTORE_CORE_SRC_LOCAL_INDEX_BACKFILLER_H_
 
+#include <chrono>  // NOLINT(build/c++11)
 #include <string>
 
 namespace firebase {
@@ -34,7 +35,25 @@ class LocalStore;
 class LocalWriteResult;
 class IndexManager;
 
-/** Implements the steps for backfilling indexes. */
+/** Describes how far backfilling indexes has progressed. */
+struct IndexBackfillProgress {
+  /** The number of documents indexed by the last backfill operation. */
+  int documents_processed;
+
+  /**
+   * Whether all field indexes were up to date with the local cache after the
+   * last backfill operation.
+   */
+  bool caught_up;
+};
+
+/**
+ * Implements the steps for backfilling indexes.
+ *
+ * The number of documents processed per operation adapts to how long
+ * operations take, so that indexes catch up quickly after they are configured
+ * while each operation blocks the worker queue for a bounded time only.
+ */
 class IndexBackfiller {
  public:
   IndexBackfiller();
@@ -45,6 +64,18 @@ class IndexBackfiller {
    */
   int WriteIndexEntries(const LocalStore* local_store);
 
+  /**
+   * Adjusts the number of documents processed by the next call to
+   * `WriteIndexEntries` based on how long the last one took, including the
+   * time it took to commit its writes.
+   */
+  void AdjustBatchSize(std::chrono::milliseconds duration);
+
+  /** Returns the progress as of the last call to `WriteIndexEntries`. */
+  const IndexBackfillProgress& progress() const {
+    return progress_;
+  }
+
  private:
   friend class IndexBackfillerTest;
 
@@ -60,12 +91,19 @@ class IndexBackfiller {
   model::IndexOffset GetNewOffset(const model::IndexOffset& existing_offset,
                                   const LocalWriteResult& lookup_result) const;
 
-  // For testing
+  // For testing. Disables adjusting the batch size.
   void SetMaxDocumentsToProcess(int new_max) {
     max_documents_to_process_ = new_max;
+    adjust_batch_size_ = false;
+  }
+
+  int max_documents_to_process() const {
+    return max_documents_to_process_;
   }
 
   int max_documents_to_process_;
+  bool adjust_batch_size_ = true;
+  IndexBackfillProgress progress_{0, false};
 };
 
 }  // namespace local
@@ -17,6 +17,7 @@
 #ifndef FIRESTORE_CORE_SRC_LOCAL_INDEX_MANAGER_H_
 #define FIRESTORE_CORE_SRC_LOCAL_INDEX_MANAGER_H_
 
+#include <functional>
 #include <string>
 #include <vector>
 
@@ -142,6 +143,20 @@ class IndexManager {
   virtual absl::optional<std::vector<model::DocumentKey>>
   GetDocumentsMatchingTarget(const core::Target& target) = 0;
 
+  /**
+   * Calls `callback` with the keys of the documents that match the given
+   * target in the order in which the target sorts them, until `callback`
+   * returns false. Unlike `GetDocumentsMatchingTarget`, this reads the index
+   * only as far as the caller needs.
+   *
+   * @return false, without calling `callback`, if the target is not served by
+   *     a single range of a full index and its results can therefore not be
+   *     produced in order.
+   */
+  virtual bool ScanDocumentsMatchingTarget(
+      const core::Target& target,
+      const std::function<bool(const model::DocumentKey&)>& callback) = 0;
+
   /**
    * Returns the next collection group to update. Returns `nullopt` if no
    * group exists.
@@ -0,0 +1,150 @@
+/*
+ * Copyright 2022 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Firestore/core/src/local/leveldb_byte_sizes.h"
+
+#include <memory>
+#include <vector>
+
+#include "Firestore/core/src/local/leveldb_util.h"
+#include "Firestore/core/src/util/hard_assert.h"
+#include "Firestore/core/src/util/ordered_code.h"
+#include "Firestore/core/src/util/string_util.h"
+#include "absl/strings/str_cat.h"
+#include "leveldb/db.h"
+
+namespace firebase {
+namespace firestore {
+namespace local {
+namespace {
+
+using util::OrderedCode;
+
+const char* SubsystemName(LevelDbSubsystem subsystem) {
+  switch (subsystem) {
+    case LevelDbSubsystem::kDocuments:
+      return "documents";
+    case LevelDbSubsystem::kTargets:
+      return "targets";
+    case LevelDbSubsystem::kMutations:
+      return "mutations";
+    case LevelDbSubsystem::kIndexes:
+      return "indexes";
+    case LevelDbSubsystem::kOther:
+      return "other";
+  }
+  UNREACHABLE();
+}
+
+}  // namespace
+
+LevelDbByteSizes LevelDbByteSizes::Calculate(
+    leveldb::DB* db, const leveldb::ReadOptions& options) {
+  std::string size_key = LevelDbByteSizeKey::Key();
+
+  LevelDbByteSizes result;
+  std::unique_ptr<leveldb::Iterator> it(db->NewIterator(options));
+  for (it->SeekToFirst(); it->Valid(); it->Next()) {
+    absl::string_view key = MakeStringView(it->key());
+    if (key == size_key) {
+      continue;
+    }
+    result.Add(key, static_cast<int64_t>(key.size() + it->value().size()));
+  }
+  HARD_ASSERT(it->status().ok(), "leveldb iterator reported an error: %s",
+              it->status().ToString());
+  return result;
+}
+
+LevelDbByteSizes LevelDbByteSizes::Approximate(leveldb::DB* db) {
+  LevelDbByteSizes result;
+  for (int i = 0; i < kLevelDbSubsystemCount; ++i) {
+    std::vector<std::string> prefixes =
+        TablePrefixesForSubsystem(static_cast<LevelDbSubsystem>(i));
+    std::vector<std::string> limits;
+    std::vector<leveldb::Range> ranges;
+    limits.reserve(prefixes.size());
+    ranges.reserve(prefixes.size());
+    for (const std::string& prefix : prefixes) {
+      limits.push_back(util::PrefixSuccessor(prefix));
+      ranges.emplace_back(prefix, limits.back());
+    }
+
+    std::vector<uint64_t> sizes(ranges.size());
+    db->GetApproximateSizes(ranges.data(), static_cast<int>(ranges.size()),
+                            sizes.data());
+    for (uint64_t size : sizes) {
+      result.bytes_[i] += static_cast<int64_t>(size);
+    }
+  }
+  return result;
+}
+
+absl::optional<LevelDbByteSizes> LevelDbByteSizes::Decode(
+    absl::string_view encoded) {
+  int64_t count = 0;
+  if (!OrderedCode::ReadSignedNumIncreasing(&encoded, &count) ||
+      count != kLevelDbSubsystemCount) {
+    return absl::nullopt;
+  }
+
+  LevelDbByteSizes result;
+  for (int64_t& bytes : result.bytes_) {
+    if (!OrderedCode::ReadSignedNumIncreasing(&encoded, &bytes)) {
+      return absl::nullopt;
+    }
+  }
+  if (!encoded.empty()) {
+    return absl::nullopt;
+  }
+  return result;
+}
+
+std::string LevelDbByteSizes::Encode() const {
+  std::string result;
+  OrderedCode::WriteSignedNumIncreasing(&result, kLevelDbSubsystemCount);
+  for (int64_t bytes : bytes_) {
+    OrderedCode::WriteSignedNumIncreasing(&result, bytes);
+  }
+  return result;
+}
+
+int64_t LevelDbByteSizes::total_bytes() const {
+  int64_t result = 0;
+  for (int64_t bytes : bytes_) {
+    result += bytes;
+  }
+  return result;
+}
+
+void LevelDbByteSizes::Add(absl::string_view key, int64_t delta) {
+  bytes_[static_cast<size_t>(SubsystemForKey(key))] += delta;
+}
+
+std::string LevelDbByteSizes::ToString() const {
+  std::string result = absl::StrCat(total_bytes(), " bytes (");
+  for (int i = 0; i < kLevelDbSubsystemCount; ++i) {
+    absl::StrAppend(&result, i == 0 ? "" : ", ",
+                    SubsystemName(static_cast<LevelDbSubsystem>(i)), ": ",
+                    bytes_[i]);
+  }
+  absl::StrAppend(&result, ")");
+  return result;
+}
+
+}  // namespace local
+}  // namespace firestore
+}  // namespace firebase
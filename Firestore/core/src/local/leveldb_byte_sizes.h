@@ -0,0 +1,104 @@
+/*
+ * Copyright 2022 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef FIRESTORE_CORE_SRC_LOCAL_LEVELDB_BYTE_SIZES_H_
+#define FIRESTORE_CORE_SRC_LOCAL_LEVELDB_BYTE_SIZES_H_
+
+#include <array>
+#include <cstdint>
+#include <string>
+
+#include "Firestore/core/src/local/leveldb_key.h"
+#include "absl/strings/string_view.h"
+#include "absl/types/optional.h"
+
+namespace leveldb {
+class DB;
+struct ReadOptions;
+}  // namespace leveldb
+
+namespace firebase {
+namespace firestore {
+namespace local {
+
+/**
+ * The number of bytes of live data stored in LevelDB, broken down by
+ * LevelDbSubsystem. The size of a row is the size of its key plus the size of
+ * its value.
+ *
+ * A running total is kept in the row named by LevelDbByteSizeKey and is
+ * updated by every LevelDbTransaction commit, so the size of the cache can be
+ * read without walking the database or its files.
+ */
+class LevelDbByteSizes {
+ public:
+  LevelDbByteSizes() = default;
+
+  /**
+   * Walks every row in the database and computes its size from scratch. The
+   * row storing the running total is not counted.
+   */
+  static LevelDbByteSizes Calculate(leveldb::DB* db,
+                                    const leveldb::ReadOptions& options);
+
+  /**
+   * Asks LevelDB to estimate the size of each subsystem's tables from the
+   * files on disk. Data that has not yet been flushed from the write buffer
+   * is not included, and the sizes are after compression, so this is only
+   * useful as a sanity check of the running totals.
+   */
+  static LevelDbByteSizes Approximate(leveldb::DB* db);
+
+  /**
+   * Decodes sizes previously produced by `Encode()`, returning `nullopt` if
+   * the encoded form is not valid.
+   */
+  static absl::optional<LevelDbByteSizes> Decode(absl::string_view encoded);
+
+  std::string Encode() const;
+
+  int64_t bytes(LevelDbSubsystem subsystem) const {
+    return bytes_[static_cast<size_t>(subsystem)];
+  }
+
+  int64_t total_bytes() const;
+
+  /**
+   * Adjusts the size of the subsystem that owns `key` by `delta` bytes.
+   */
+  void Add(absl::string_view key, int64_t delta);
+
+  std::string ToString() const;
+
+  friend bool operator==(const LevelDbByteSizes& lhs,
+                         const LevelDbByteSizes& rhs) {
+    return lhs.bytes_ == rhs.bytes_;
+  }
+
+ private:
+  std::array<int64_t, kLevelDbSubsystemCount> bytes_{};
+};
+
+inline bool operator!=(const LevelDbByteSizes& lhs,
+                       const LevelDbByteSizes& rhs) {
+  return !(lhs == rhs);
+}
+
+}  // namespace local
+}  // namespace firestore
+}  // namespace firebase
+
+#endif  // FIRESTORE_CORE_SRC_LOCAL_LEVELDB_BYTE_SIZES_H_
@@ -16,8 +16,11 @@
 
 #include "Firestore/core/src/local/leveldb_document_overlay_cache.h"
 
+#include <algorithm>
+#include <set>
 #include <string>
 #include <utility>
+#include <vector>
 
 #include "Firestore/core/src/credentials/user.h"
 #include "Firestore/core/src/local/leveldb_key.h"
@@ -73,6 +76,26 @@ absl::optional<Overlay> LevelDbDocumentOverlayCache::GetOverlay(
   return ParseOverlay(key, it->value());
 }
 
+void LevelDbDocumentOverlayCache::GetOverlays(
+    OverlayByDocumentKeyMap& dest, const std::set<DocumentKey>& keys) const {
+  // The keys are sorted, so a single iterator only ever seeks forward.
+  auto it = db_->current_transaction()->NewIterator();
+  for (const DocumentKey& document_key : keys) {
+    const std::string key_prefix =
+        LevelDbDocumentOverlayKey::KeyPrefix(user_id_, document_key);
+    it->Seek(key_prefix);
+    if (!it->Valid() || !absl::StartsWith(it->key(), key_prefix)) {
+      continue;
+    }
+
+    LevelDbDocumentOverlayKey key;
+    HARD_ASSERT(key.Decode(it->key()));
+    if (key.document_key() == document_key) {
+      dest[document_key] = ParseOverlay(key, it->value());
+    }
+  }
+}
+
 void LevelDbDocumentOverlayCache::SaveOverlays(
     int largest_batch_id, const MutationByDocumentKeyMap& overlays) {
   for (const auto& overlays_entry : overlays) {
@@ -87,13 +110,14 @@ void LevelDbDocumentOverlayCache::RemoveOverlaysForBatchId(int batch_id) {
 
 OverlayByDocumentKeyMap LevelDbDocumentOverlayCache::GetOverlays(
     const ResourcePath& collection, int since_batch_id) const {
+  std::vector<LevelDbDocumentOverlayKey> keys;
+  ForEachKeyInCollection(collection, since_batch_id,
+                         [&](LevelDbDocumentOverlayKey&& key) {
+                           keys.push_back(std::move(key));
+                         });
+
   OverlayByDocumentKeyMap result;
-  ForEachKeyInCollection(
-      collection, since_batch_id, [&](LevelDbDocumentOverlayKey&& key) {
-        absl::optional<Overlay> overlay = GetOverlay(key);
-        HARD_ASSERT(overlay.has_value());
-        result[std::move(key).document_key()] = std::move(overlay).value();
-      });
+  GetOverlays(std::move(keys), result);
   return result;
 }
 
@@ -102,24 +126,25 @@ OverlayByDocumentKeyMap LevelDbDocumentOverlayCache::GetOverlays(
     int since_batch_id,
     std::size_t count) const {
   absl::optional<int> current_batch_id;
-  OverlayByDocumentKeyMap result;
+  std::vector<LevelDbDocumentOverlayKey> keys;
   ForEachKeyInCollectionGroup(
       collection_group, since_batch_id,
       [&](LevelDbDocumentOverlayKey&& key) -> ForEachKeyAction {
         if (!current_batch_id.has_value()) {
           current_batch_id = key.largest_batch_id();
         } else if (current_batch_id.value() != key.largest_batch_id()) {
-          if (result.size() >= count) {
+          if (keys.size() >= count) {
             return ForEachKeyAction::kStop;
           }
           current_batch_id = key.largest_batch_id();
         }
 
-        absl::optional<Overlay> overlay = GetOverlay(key);
-        HARD_ASSERT(overlay.has_value());
-        result[std::move(key).document_key()] = std::move(overlay).value();
+        keys.push_back(std::move(key));
         return ForEachKeyAction::kKeepGoing;
       });
+
+  OverlayByDocumentKeyMap result;
+  GetOverlays(std::move(keys), result);
   return result;
 }
 
@@ -287,15 +312,39 @@ void LevelDbDocumentOverlayCache::ForEachKeyInCollectionGroup(
   }
 }
 
-absl::optional<Overlay> LevelDbDocumentOverlayCache::GetOverlay(
-    const LevelDbDocumentOverlayKey& key) const {
+void LevelDbDocumentOverlayCache::GetOverlays(
+    std::vector<LevelDbDocumentOverlayKey>&& keys,
+    OverlayByDocumentKeyMap& result) const {
+  // Visit the overlays in the order in which they are stored, so that a single
+  // iterator can read all of them.
+  std::vector<std::pair<std::string, LevelDbDocumentOverlayKey>> sorted_keys;
+  sorted_keys.reserve(keys.size());
+  for (LevelDbDocumentOverlayKey& key : keys) {
+    std::string encoded_key = key.Encode();
+    sorted_keys.emplace_back(std::move(encoded_key), std::move(key));
+  }
+  std::sort(sorted_keys.begin(), sorted_keys.end(),
+            [](const std::pair<std::string, LevelDbDocumentOverlayKey>& lhs,
+               const std::pair<std::string, LevelDbDocumentOverlayKey>& rhs) {
+              return lhs.first < rhs.first;
+            });
+
   auto it = db_->current_transaction()->NewIterator();
-  const std::string encoded_key = key.Encode();
-  it->Seek(encoded_key);
-  if (!it->Valid() || it->key() != encoded_key) {
-    return absl::nullopt;
+  for (auto& entry : sorted_keys) {
+    // Overlays of documents in the same collection are mostly adjacent, so
+    // stepping to the next entry usually avoids a seek.
+    if (it->Valid()) {
+      it->Next();
+    }
+    if (!it->Valid() || it->key() != entry.first) {
+      it->Seek(entry.first);
+    }
+    HARD_ASSERT(it->Valid() && it->key() == entry.first,
+                "Overlay index entry without an overlay");
+
+    Overlay overlay = ParseOverlay(entry.second, it->value());
+    result[std::move(entry.second).document_key()] = std::move(overlay);
   }
-  return ParseOverlay(key, it->value());
 }
 
 }  // namespace local
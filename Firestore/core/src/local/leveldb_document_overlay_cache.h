@@ -19,7 +19,9 @@
 
 #include <cstdlib>
 #include <functional>
+#include <set>
 #include <string>
+#include <vector>
 
 #include "Firestore/core/src/local/document_overlay_cache.h"
 #include "absl/strings/string_view.h"
@@ -55,6 +57,9 @@ class LevelDbDocumentOverlayCache final : public DocumentOverlayCache {
   absl::optional<model::Overlay> GetOverlay(
       const model::DocumentKey&) const override;
 
+  void GetOverlays(model::OverlayByDocumentKeyMap& dest,
+                   const std::set<model::DocumentKey>& keys) const override;
+
   void SaveOverlays(int largest_batch_id,
                     const model::MutationByDocumentKeyMap& overlays) override;
 
@@ -109,8 +114,12 @@ class LevelDbDocumentOverlayCache final : public DocumentOverlayCache {
       int since_batch_id,
       std::function<ForEachKeyAction(LevelDbDocumentOverlayKey&&)>) const;
 
-  absl::optional<model::Overlay> GetOverlay(
-      const LevelDbDocumentOverlayKey& decoded_key) const;
+  /**
+   * Reads the overlays for `keys`, which are known to exist, into `result`
+   * with a single iterator.
+   */
+  void GetOverlays(std::vector<LevelDbDocumentOverlayKey>&& keys,
+                   model::OverlayByDocumentKeyMap& result) const;
 
   // The LevelDbDocumentOverlayCache instance is owned by LevelDbPersistence.
   LevelDbPersistence* db_;
@@ -18,9 +18,13 @@
 
 #include <algorithm>
 #include <functional>
+#include <iterator>
+#include <limits>
 #include <memory>
 #include <set>
 #include <string>
+#include <thread>  // NOLINT(build/c++11)
+#include <unordered_map>
 #include <unordered_set>
 #include <utility>
 #include <vector>
@@ -38,7 +42,9 @@
 #include "Firestore/core/src/model/model_fwd.h"
 #include "Firestore/core/src/model/resource_path.h"
 #include "Firestore/core/src/model/target_index_matcher.h"
+#include "Firestore/core/src/util/background_queue.h"
 #include "Firestore/core/src/util/comparison.h"
+#include "Firestore/core/src/util/executor.h"
 #include "Firestore/core/src/util/hard_assert.h"
 #include "Firestore/core/src/util/log.h"
 #include "Firestore/core/src/util/set_util.h"
@@ -65,9 +71,24 @@ using model::ResourcePath;
 using model::SnapshotVersion;
 using model::TargetIndexMatcher;
 using nlohmann::json;
+using util::BackgroundQueue;
+using util::Executor;
 
 namespace {
 
+// The number of documents from which on index entries are computed
+// concurrently, and the number of documents handled by each task.
+constexpr size_t kMinDocumentsToIndexConcurrently = 64;
+constexpr size_t kDocumentsPerIndexingTask = 16;
+
+// The number of index entries that can be scanned for the cost of reading a
+// single document, which takes a random seek and decoding the whole document.
+constexpr size_t kDocumentReadCost = 4;
+
+// Caps the number of index entries that are counted to estimate how many
+// entries an index contributes, so that estimating stays cheap.
+constexpr size_t kMaxEstimatedIndexEntries = 1000;
+
 struct DbIndexState {
   int64_t seconds;
   int32_t nanos;
@@ -84,7 +105,7 @@ void from_json(const json& j, DbIndexState& s) {
   j.at("largest_batch").get_to(s.largest_batch_id);
 }
 
-IndexState DecodeIndexState(const std::string& encoded) {
+IndexState DecodeIndexState(absl::string_view encoded) {
   auto j = json::parse(encoded.begin(), encoded.end(), /*callback=*/nullptr,
                        /*allow_exceptions=*/false);
   auto db_state = j.get<DbIndexState>();
@@ -196,6 +217,9 @@ LevelDbIndexManager::LevelDbIndexManager(const User& user,
       std::function<bool(model::FieldIndex*, model::FieldIndex*)>>(cmp);
 }
 
+// Out of line because of unique_ptrs to incomplete types.
+LevelDbIndexManager::~LevelDbIndexManager() = default;
+
 void LevelDbIndexManager::AddToCollectionParentIndex(
     const ResourcePath& collection_path) {
   HARD_ASSERT(collection_path.size() % 2 == 1, "Expected a collection path.");
@@ -463,10 +487,9 @@ const model::IndexOffset LevelDbIndexManager::GetMinOffset(
     const core::Target& target) const {
   std::vector<FieldIndex> indexes;
   for (const auto& sub_target : GetSubTargets(target)) {
-    auto index_opt = GetFieldIndex(sub_target);
-    if (index_opt.has_value()) {
-      indexes.push_back(index_opt.value());
-    }
+    std::vector<FieldIndex> sub_target_indexes = GetIndexesToScan(sub_target);
+    indexes.insert(indexes.end(), sub_target_indexes.begin(),
+                   sub_target_indexes.end());
   }
   return GetMinOffset(indexes);
 }
@@ -520,40 +543,42 @@ IndexManager::IndexType LevelDbIndexManager::GetIndexType(
 
 absl::optional<std::vector<model::DocumentKey>>
 LevelDbIndexManager::GetDocumentsMatchingTarget(const core::Target& target) {
-  std::unordered_map<core::Target, model::FieldIndex> indexes;
+  std::vector<std::pair<Target, std::vector<FieldIndex>>> plans;
   for (const auto& sub_target : GetSubTargets(target)) {
-    auto index_opt = GetFieldIndex(sub_target);
-    if (!index_opt.has_value()) {
+    std::vector<FieldIndex> indexes = GetIndexesToScan(sub_target);
+    if (indexes.empty()) {
       return absl::nullopt;
     }
 
-    indexes.insert({sub_target, index_opt.value()});
+    plans.emplace_back(sub_target, std::move(indexes));
   }
 
   std::vector<DocumentKey> result;
   std::unordered_set<std::string> existing_keys;
-  for (const auto& entry : indexes) {
-    const Target& sub_target = entry.first;
-    const FieldIndex& index = entry.second;
-
-    LOG_DEBUG("Using index %s to execute target %s", index.collection_group(),
-              sub_target.CanonicalId());
+  auto add_to_result = [&](const std::string& document_key) {
+    if (existing_keys.insert(document_key).second) {
+      result.push_back(DocumentKey::FromPathString(document_key));
+    }
+  };
 
-    auto array_values = sub_target.GetArrayValues(index);
-    auto not_in_values = sub_target.GetNotInValues(index);
-    auto lower_bound = sub_target.GetLowerBound(index);
-    auto upper_bound = sub_target.GetUpperBound(index);
+  for (const auto& plan : plans) {
+    const Target& sub_target = plan.first;
+    const std::vector<FieldIndex>& indexes = plan.second;
 
-    auto encoded_lower = EncodeBound(index, sub_target, lower_bound);
-    auto encoded_upper = EncodeBound(index, sub_target, upper_bound);
-    auto encoded_not_in = EncodeValues(index, sub_target, not_in_values);
+    if (indexes.size() > 1) {
+      for (const std::string& document_key :
+           IntersectIndexes(sub_target, indexes)) {
+        add_to_result(document_key);
+      }
+      continue;
+    }
 
-    auto index_ranges = GenerateIndexRanges(
-        index.index_id(), array_values, encoded_lower, lower_bound.inclusive,
-        encoded_upper, upper_bound.inclusive, encoded_not_in);
+    const FieldIndex& index = indexes.front();
+    LOG_DEBUG("Using index %s to execute target %s", index.collection_group(),
+              sub_target.CanonicalId());
 
     auto iter = db_->current_transaction()->NewIterator();
-    for (const auto& range : index_ranges) {
+    for (const auto& range : GetIndexRanges(sub_target, index)) {
       int32_t count = 0;
       for (iter->Seek(range.lower); iter->Valid() && count < target.limit() &&
                                     iter->key() <= range.upper;
@@ -564,12 +589,7 @@ LevelDbIndexManager::GetDocumentsMatchingTarget(const core::Target& target) {
         }
 
         ++count;
-        if (existing_keys.find(entry_key.document_key()) ==
-            existing_keys.end()) {
-          result.push_back(
-              DocumentKey::FromPathString(entry_key.document_key()));
-          existing_keys.insert(entry_key.document_key());
-        }
+        add_to_result(entry_key.document_key());
       }
     }
   }
@@ -577,6 +597,205 @@ LevelDbIndexManager::GetDocumentsMatchingTarget(const core::Target& target) {
   return result;
 }
 
+bool LevelDbIndexManager::ScanDocumentsMatchingTarget(
+    const Target& target,
+    const std::function<bool(const DocumentKey&)>& callback) {
+  std::vector<Target> sub_targets = GetSubTargets(target);
+  if (sub_targets.size() != 1) {
+    return false;
+  }
+
+  const Target& sub_target = sub_targets.front();
+  absl::optional<FieldIndex> index = GetFieldIndex(sub_target);
+  if (!index.has_value() ||
+      index->segments().size() < sub_target.GetSegmentCount()) {
+    return false;
+  }
+
+  // Index entries order documents with equal values by their key, in the
+  // direction of the index's last segment.
+  std::vector<model::Segment> segments = index->GetDirectionalSegments();
+  model::Segment::Kind key_kind =
+      segments.empty() ? model::Segment::kAscending : segments.back().kind();
+  bool key_ascending = sub_target.GetKeyOrder() == core::Direction::Ascending;
+  if ((key_kind == model::Segment::kAscending) != key_ascending) {
+    return false;
+  }
+
+  std::vector<IndexRange> ranges = GetIndexRanges(sub_target, *index);
+  if (ranges.size() != 1) {
+    return false;
+  }
+
+  LOG_DEBUG("Scanning index %s in order to execute target %s",
+            index->collection_group(), sub_target.CanonicalId());
+
+  const IndexRange& range = ranges.front();
+  auto iter = db_->current_transaction()->NewIterator();
+  for (iter->Seek(range.lower); iter->Valid() && iter->key() <= range.upper;
+       iter->Next()) {
+    LevelDbIndexEntryKey entry_key;
+    if (!entry_key.Decode(iter->key()) ||
+        !callback(DocumentKey::FromPathString(entry_key.document_key()))) {
+      break;
+    }
+  }
+
+  return true;
+}
+
+std::vector<FieldIndex> LevelDbIndexManager::GetIndexesToScan(
+    const Target& target) const {
+  absl::optional<FieldIndex> best_index = GetFieldIndex(target);
+  if (!best_index.has_value()) {
+    return {};
+  }
+
+  std::vector<FieldIndex> result{std::move(best_index).value()};
+  if (result.front().segments().size() >= target.GetSegmentCount()) {
+    return result;
+  }
+
+  // The best index only covers some of the target's fields. Every other index
+  // that serves the target and covers a field that no index chosen so far
+  // does can narrow down its results further.
+  std::set<model::FieldPath> covered_fields;
+  for (const auto& segment : result.front().segments()) {
+    covered_fields.insert(segment.field_path());
+  }
+
+  TargetIndexMatcher target_index_matcher(target);
+  for (FieldIndex& index : GetFieldIndexes(result.front().collection_group())) {
+    if (index.index_id() == result.front().index_id() ||
+        !target_index_matcher.ServedByIndex(index)) {
+      continue;
+    }
+
+    bool covers_new_field = false;
+    for (const auto& segment : index.segments()) {
+      covers_new_field |= covered_fields.insert(segment.field_path()).second;
+    }
+    if (covers_new_field) {
+      result.push_back(std::move(index));
+    }
+  }
+
+  return result;
+}
+
+std::vector<std::string> LevelDbIndexManager::IntersectIndexes(
+    const Target& target, const std::vector<FieldIndex>& indexes) {
+  struct IndexScan {
+    const FieldIndex* index;
+    std::vector<IndexRange> ranges;
+    size_t estimated_entries;
+  };
+
+  std::vector<IndexScan> scans;
+  for (const FieldIndex& index : indexes) {
+    std::vector<IndexRange> ranges = GetIndexRanges(target, index);
+    size_t estimated_entries =
+        CountIndexEntries(ranges, kMaxEstimatedIndexEntries);
+    scans.push_back(IndexScan{&index, std::move(ranges), estimated_entries});
+  }
+
+  // Start with the index with the fewest matching entries. A stable sort keeps
+  // the index that covers the most fields first when estimates are equal.
+  std::stable_sort(scans.begin(), scans.end(),
+                   [](const IndexScan& lhs, const IndexScan& rhs) {
+                     return lhs.estimated_entries < rhs.estimated_entries;
+                   });
+
+  LOG_DEBUG("Using index %s to execute target %s",
+            scans.front().index->collection_group(), target.CanonicalId());
+  std::vector<std::string> result;
+  ReadDocumentKeys(scans.front().ranges, std::numeric_limits<size_t>::max(),
+                   &result);
+
+  for (auto scan = scans.begin() + 1; scan != scans.end(); ++scan) {
+    // Intersecting with another index can at most save reading every document
+    // in `result`. Give up on it as soon as scanning it costs more than that.
+    size_t max_entries = result.size() * kDocumentReadCost;
+    if (result.empty() || scan->estimated_entries > max_entries) {
+      break;
+    }
+
+    std::vector<std::string> keys;
+    if (!ReadDocumentKeys(scan->ranges, max_entries, &keys)) {
+      continue;
+    }
+
+    LOG_DEBUG("Intersecting with index %s to execute target %s",
+              scan->index->collection_group(), target.CanonicalId());
+    std::vector<std::string> intersection;
+    std::set_intersection(result.begin(), result.end(), keys.begin(),
+                          keys.end(), std::back_inserter(intersection));
+    result = std::move(intersection);
+  }
+
+  return result;
+}
+
+std::vector<LevelDbIndexManager::IndexRange>
+LevelDbIndexManager::GetIndexRanges(const Target& target,
+                                    const FieldIndex& index) {
+  auto array_values = target.GetArrayValues(index);
+  auto not_in_values = target.GetNotInValues(index);
+  auto lower_bound = target.GetLowerBound(index);
+  auto upper_bound = target.GetUpperBound(index);
+
+  auto encoded_lower = EncodeBound(index, target, lower_bound);
+  auto encoded_upper = EncodeBound(index, target, upper_bound);
+  auto encoded_not_in = EncodeValues(index, target, not_in_values);
+
+  return GenerateIndexRanges(index.index_id(), array_values, encoded_lower,
+                             lower_bound.inclusive, encoded_upper,
+                             upper_bound.inclusive, encoded_not_in);
+}
+
+size_t LevelDbIndexManager::CountIndexEntries(
+    const std::vector<IndexRange>& ranges, size_t max_entries) {
+  size_t count = 0;
+  auto iter = db_->current_transaction()->NewIterator();
+  for (const auto& range : ranges) {
+    for (iter->Seek(range.lower); iter->Valid() && iter->key() <= range.upper;
+         iter->Next()) {
+      if (++count >= max_entries) {
+        return max_entries;
+      }
+    }
+  }
+  return count;
+}
+
+bool LevelDbIndexManager::ReadDocumentKeys(
+    const std::vector<IndexRange>& ranges,
+    size_t max_entries,
+    std::vector<std::string>* result) {
+  size_t count = 0;
+  auto iter = db_->current_transaction()->NewIterator();
+  for (const auto& range : ranges) {
+    for (iter->Seek(range.lower); iter->Valid() && iter->key() <= range.upper;
+         iter->Next()) {
+      if (++count > max_entries) {
+        return false;
+      }
+
+      LevelDbIndexEntryKey entry_key;
+      if (!entry_key.Decode(iter->key())) {
+        break;
+      }
+      result->push_back(entry_key.document_key());
+    }
+  }
+
+  // Entries are sorted by their index values, not by document key, and a
+  // document can appear in several ranges.
+  std::sort(result->begin(), result->end());
+  result->erase(std::unique(result->begin(), result->end()), result->end());
+  return true;
+}
+
 std::vector<std::string> LevelDbIndexManager::EncodeBound(
     const FieldIndex& index,
     const Target& target,
@@ -741,28 +960,89 @@ void LevelDbIndexManager::UpdateIndexEntries(
     const model::DocumentMap& documents) {
   HARD_ASSERT(started_, "IndexManager not started");
 
+  std::unordered_map<std::string, std::vector<FieldIndex>> indexes_by_group;
+  std::vector<const model::Document*> document_list;
+  std::vector<const std::vector<FieldIndex>*> indexes;
   for (const auto& kv : documents) {
     const auto group = kv.first.GetCollectionGroup();
     HARD_ASSERT(group.has_value(),
                 "Document key is expected to have a collection group");
-    std::vector<FieldIndex> indexes;
-    indexes = GetFieldIndexes(group.value());
-
-    for (const auto& index : indexes) {
-      auto existing_entries = GetExistingIndexEntries(kv.first, index);
-      auto new_entries = ComputeIndexEntries(kv.second, index);
-      if (existing_entries != new_entries) {
-        UpdateEntries(kv.second, index, existing_entries, new_entries);
+    auto it = indexes_by_group.find(group.value());
+    if (it == indexes_by_group.end()) {
+      it = indexes_by_group
+               .emplace(group.value(), GetFieldIndexes(group.value()))
+               .first;
+    }
+    document_list.push_back(&kv.second);
+    indexes.push_back(&it->second);
+  }
+
+  std::vector<std::vector<std::set<IndexEntry>>> new_entries =
+      ComputeIndexEntriesConcurrently(document_list, indexes);
+
+  // Existing entries are read and updated on the calling thread, since the
+  // transaction is not thread-safe.
+  for (size_t i = 0; i < document_list.size(); ++i) {
+    const model::Document& document = *document_list[i];
+    for (size_t j = 0; j < indexes[i]->size(); ++j) {
+      const FieldIndex& index = (*indexes[i])[j];
+      auto existing_entries = GetExistingIndexEntries(document->key(), index);
+      if (existing_entries != new_entries[i][j]) {
+        UpdateEntries(document, index, existing_entries, new_entries[i][j]);
       }
     }
   }
 }
 
+std::vector<std::vector<std::set<IndexEntry>>>
+LevelDbIndexManager::ComputeIndexEntriesConcurrently(
+    const std::vector<const model::Document*>& documents,
+    const std::vector<const std::vector<FieldIndex>*>& indexes) {
+  std::vector<std::vector<std::set<IndexEntry>>> result(documents.size());
+
+  // Each task fills in the entries of its own range of documents, so tasks
+  // never write to the same element of `result`. Reading the fields of a
+  // lazily decoded document is safe from any thread, since decoding them is
+  // guarded by a mutex.
+  auto compute = [&](size_t begin, size_t end) {
+    for (size_t i = begin; i < end; ++i) {
+      for (const FieldIndex& index : *indexes[i]) {
+        result[i].push_back(ComputeIndexEntries(*documents[i], index));
+      }
+    }
+  };
+
+  if (documents.size() < kMinDocumentsToIndexConcurrently) {
+    compute(0, documents.size());
+    return result;
+  }
+
+  if (!executor_) {
+    auto hw_concurrency = std::thread::hardware_concurrency();
+    if (hw_concurrency == 0) {
+      // If the standard library doesn't know, guess something reasonable.
+      hw_concurrency = 4;
+    }
+    executor_ =
+        Executor::CreateConcurrent("com.google.firebase.firestore.index",
+                                   static_cast<int>(hw_concurrency));
+  }
+
+  BackgroundQueue tasks(executor_.get());
+  for (size_t begin = 0; begin < documents.size();
+       begin += kDocumentsPerIndexingTask) {
+    size_t end = std::min(documents.size(), begin + kDocumentsPerIndexingTask);
+    tasks.Execute([&compute, begin, end] { compute(begin, end); });
+  }
+  tasks.AwaitAll();
+  return result;
+}
+
 std::set<IndexEntry> LevelDbIndexManager::GetExistingIndexEntries(
     const DocumentKey& key, const FieldIndex& index) {
   auto document_key_index_prefix =
       LevelDbIndexEntryDocumentKeyIndexKey::KeyPrefix(
-          index.index_id(), uid_, key.path().CanonicalString());
+          index.index_id(), uid_, key.ToString());
   LevelDbIndexEntryDocumentKeyIndexKey document_key_index_key;
   auto iter = db_->current_transaction()->NewIterator();
   std::set<IndexEntry> index_entries;
@@ -866,7 +1146,7 @@ void LevelDbIndexManager::AddIndexEntry(const model::Document& document,
       LevelDbIndexEntryDocumentKeyIndexKey::KeyPrefix(entry.index_id(), uid_,
                                                       document_key);
   std::unique_ptr<leveldb::Iterator> iter(
-      db_->ptr()->NewIterator(LevelDbTransaction::DefaultReadOptions()));
+      db_->ptr()->NewIterator(db_->read_options()));
   iter->Seek(util::PrefixSuccessor(document_key_index_prefix));
   iter->Prev();
   absl::string_view raw_key;
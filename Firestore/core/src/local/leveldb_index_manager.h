@@ -17,6 +17,7 @@
 #ifndef FIRESTORE_CORE_SRC_LOCAL_LEVELDB_INDEX_MANAGER_H_
 #define FIRESTORE_CORE_SRC_LOCAL_LEVELDB_INDEX_MANAGER_H_
 
+#include <memory>
 #include <queue>
 #include <set>
 #include <string>
@@ -40,6 +41,10 @@ namespace index {
 class IndexEntry;
 }  // namespace index
 
+namespace util {
+class Executor;
+}  // namespace util
+
 namespace local {
 
 class LevelDbPersistence;
@@ -52,6 +57,8 @@ class LevelDbIndexManager : public IndexManager {
                                LevelDbPersistence* db,
                                LocalSerializer* serializer);
 
+  ~LevelDbIndexManager() override;
+
   void Start() override;
 
   void AddToCollectionParentIndex(
@@ -83,6 +90,10 @@ class LevelDbIndexManager : public IndexManager {
   absl::optional<std::vector<model::DocumentKey>> GetDocumentsMatchingTarget(
       const core::Target& target) override;
 
+  bool ScanDocumentsMatchingTarget(
+      const core::Target& target,
+      const std::function<bool(const model::DocumentKey&)>& callback) override;
+
   absl::optional<std::string> GetNextCollectionGroupToUpdate() const override;
 
   void UpdateCollectionGroup(const std::string& collection_group,
@@ -114,6 +125,16 @@ class LevelDbIndexManager : public IndexManager {
   std::set<index::IndexEntry> GetExistingIndexEntries(
       const model::DocumentKey& key, const model::FieldIndex& index);
 
+  /**
+   * Computes the index entries of each of `documents` for each of its
+   * `indexes`, spreading the work over `executor_` if there are many
+   * documents.
+   */
+  std::vector<std::vector<std::set<index::IndexEntry>>>
+  ComputeIndexEntriesConcurrently(
+      const std::vector<const model::Document*>& documents,
+      const std::vector<const std::vector<model::FieldIndex>*>& indexes);
+
   /** Creates the index entries for the given document. */
   std::set<index::IndexEntry> ComputeIndexEntries(
       const model::Document& document, const model::FieldIndex& index);
@@ -157,6 +178,49 @@ class LevelDbIndexManager : public IndexManager {
   const std::vector<core::Target> GetSubTargets(
       const core::Target& target) const;
 
+  /**
+   * Returns the indexes to scan to execute `target`: the index that serves it
+   * best, followed by any other indexes that serve it and cover fields that
+   * the previous ones don't, if the best index doesn't serve it fully. Returns
+   * an empty vector if no index serves `target`.
+   */
+  std::vector<model::FieldIndex> GetIndexesToScan(
+      const core::Target& target) const;
+
+  /**
+   * Returns the keys of the documents that match `target` in all of the given
+   * indexes, sorted by key.
+   *
+   * Scans the index with the fewest matching entries first, then intersects
+   * the result with the entries of the others for as long as scanning them
+   * costs less than reading the documents they could rule out.
+   */
+  std::vector<std::string> IntersectIndexes(
+      const core::Target& target,
+      const std::vector<model::FieldIndex>& indexes);
+
+  /** Returns the LevelDb key ranges of `index` that `target` needs to scan. */
+  std::vector<IndexRange> GetIndexRanges(const core::Target& target,
+                                         const model::FieldIndex& index);
+
+  /**
+   * Counts the entries in `ranges`, stopping once `max_entries` have been
+   * counted.
+   */
+  size_t CountIndexEntries(const std::vector<IndexRange>& ranges,
+                           size_t max_entries);
+
+  /**
+   * Reads the document keys of the entries in `ranges` into `result`, sorted
+   * and without duplicates.
+   *
+   * @return false if `ranges` hold more than `max_entries` entries, in which
+   *     case `result` is incomplete.
+   */
+  bool ReadDocumentKeys(const std::vector<IndexRange>& ranges,
+                        size_t max_entries,
+                        std::vector<std::string>* result);
+
   const model::IndexOffset GetMinOffset(
       const std::vector<model::FieldIndex>& indexes) const;
 
@@ -235,6 +299,9 @@ class LevelDbIndexManager : public IndexManager {
   bool started_ = false;
 
   std::string uid_;
+
+  /** Computes index entries for large batches of documents. Created lazily. */
+  std::unique_ptr<util::Executor> executor_;
 };
 
 }  // namespace local
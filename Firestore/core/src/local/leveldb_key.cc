@@ -65,6 +65,44 @@ const char* kDocumentOverlaysCollectionIndexTable =
 const char* kDocumentOverlaysCollectionGroupIndexTable =
     "document_overlays_collection_group_index";
 const char* kDataMigrationTable = "data_migration";
+const char* kByteSizeGlobalTable = "byte_size";
+
+struct TableSubsystem {
+  const char* table_name;
+  LevelDbSubsystem subsystem;
+};
+
+/**
+ * Maps each logical table to the subsystem it is accounted to. Tables not
+ * listed here belong to LevelDbSubsystem::kOther.
+ */
+const TableSubsystem kTableSubsystems[] = {
+    {kRemoteDocumentsTable, LevelDbSubsystem::kDocuments},
+    {kRemoteDocumentReadTimeTable, LevelDbSubsystem::kDocuments},
+    {kCollectionParentsTable, LevelDbSubsystem::kDocuments},
+    {kTargetGlobalTable, LevelDbSubsystem::kTargets},
+    {kTargetsTable, LevelDbSubsystem::kTargets},
+    {kQueryTargetsTable, LevelDbSubsystem::kTargets},
+    {kTargetDocumentsTable, LevelDbSubsystem::kTargets},
+    {kDocumentTargetsTable, LevelDbSubsystem::kTargets},
+    {kMutationsTable, LevelDbSubsystem::kMutations},
+    {kDocumentMutationsTable, LevelDbSubsystem::kMutations},
+    {kMutationQueuesTable, LevelDbSubsystem::kMutations},
+    {kDocumentOverlaysTable, LevelDbSubsystem::kMutations},
+    {kDocumentOverlaysLargestBatchIdIndexTable, LevelDbSubsystem::kMutations},
+    {kDocumentOverlaysCollectionIndexTable, LevelDbSubsystem::kMutations},
+    {kDocumentOverlaysCollectionGroupIndexTable,
+     LevelDbSubsystem::kMutations},
+    {kIndexConfigurationTable, LevelDbSubsystem::kIndexes},
+    {kIndexStateTable, LevelDbSubsystem::kIndexes},
+    {kIndexEntriesTable, LevelDbSubsystem::kIndexes},
+    {kIndexEntriesDocumentKeyIndexTable, LevelDbSubsystem::kIndexes},
+    {kVersionGlobalTable, LevelDbSubsystem::kOther},
+    {kBundlesTable, LevelDbSubsystem::kOther},
+    {kNamedQueriesTable, LevelDbSubsystem::kOther},
+    {kDataMigrationTable, LevelDbSubsystem::kOther},
+    {kByteSizeGlobalTable, LevelDbSubsystem::kOther},
+};
 
 /**
  * Labels for the components of keys. These serve to make keys self-describing.
@@ -206,6 +244,10 @@ class Reader {
    */
   std::string Describe();
 
+  std::string ReadTableName() {
+    return ReadLabeledString(ComponentLabel::TableName);
+  }
+
   void ReadTableNameMatching(const char* expected_table_name) {
     if (!ReadLabeledStringMatching(ComponentLabel::TableName,
                                    expected_table_name)) {
@@ -774,6 +816,14 @@ class Writer {
     }
   }
 
+  /** Writes the path of `key` without rebuilding it as a `ResourcePath`. */
+  void WriteResourcePath(const DocumentKey& key) {
+    for (size_t i = 0; i < key.path_size(); ++i) {
+      WriteComponentLabel(ComponentLabel::PathSegment);
+      OrderedCode::WriteString(&dest_, key.segment(i));
+    }
+  }
+
   void WriteIndexId(int32_t id) {
     WriteLabeledInt32(ComponentLabel::IndexId, id);
   }
@@ -851,6 +901,32 @@ std::string DescribeKey(const char* key) {
   return DescribeKey(leveldb::Slice{key});
 }
 
+LevelDbSubsystem SubsystemForKey(absl::string_view key) {
+  Reader reader{key};
+  std::string table_name = reader.ReadTableName();
+  if (reader.ok()) {
+    for (const TableSubsystem& entry : kTableSubsystems) {
+      if (table_name == entry.table_name) {
+        return entry.subsystem;
+      }
+    }
+  }
+  return LevelDbSubsystem::kOther;
+}
+
+std::vector<std::string> TablePrefixesForSubsystem(
+    LevelDbSubsystem subsystem) {
+  std::vector<std::string> result;
+  for (const TableSubsystem& entry : kTableSubsystems) {
+    if (entry.subsystem == subsystem) {
+      Writer writer;
+      writer.WriteTableName(entry.table_name);
+      result.push_back(writer.result());
+    }
+  }
+  return result;
+}
+
 std::string LevelDbVersionKey::Key() {
   Writer writer;
   writer.WriteTableName(kVersionGlobalTable);
@@ -858,6 +934,13 @@ std::string LevelDbVersionKey::Key() {
   return writer.result();
 }
 
+std::string LevelDbByteSizeKey::Key() {
+  Writer writer;
+  writer.WriteTableName(kByteSizeGlobalTable);
+  writer.WriteTerminator();
+  return writer.result();
+}
+
 std::string LevelDbMutationKey::KeyPrefix() {
   Writer writer;
   writer.WriteTableName(kMutationsTable);
@@ -918,7 +1001,7 @@ std::string LevelDbDocumentMutationKey::Key(absl::string_view user_id,
   Writer writer;
   writer.WriteTableName(kDocumentMutationsTable);
   writer.WriteUserId(user_id);
-  writer.WriteResourcePath(document_key.path());
+  writer.WriteResourcePath(document_key);
   writer.WriteBatchId(batch_id);
   writer.WriteTerminator();
   return writer.result();
@@ -1042,7 +1125,7 @@ std::string LevelDbTargetDocumentKey::Key(model::TargetId target_id,
   Writer writer;
   writer.WriteTableName(kTargetDocumentsTable);
   writer.WriteTargetId(target_id);
-  writer.WriteResourcePath(document_key.path());
+  writer.WriteResourcePath(document_key);
   writer.WriteTerminator();
   return writer.result();
 }
@@ -1074,7 +1157,7 @@ std::string LevelDbDocumentTargetKey::Key(const DocumentKey& document_key,
                                           model::TargetId target_id) {
   Writer writer;
   writer.WriteTableName(kDocumentTargetsTable);
-  writer.WriteResourcePath(document_key.path());
+  writer.WriteResourcePath(document_key);
   writer.WriteTargetId(target_id);
   writer.WriteTerminator();
   return writer.result();
@@ -1127,7 +1210,7 @@ std::string LevelDbRemoteDocumentKey::KeyPrefix(
 std::string LevelDbRemoteDocumentKey::Key(const DocumentKey& key) {
   Writer writer;
   writer.WriteTableName(kRemoteDocumentsTable);
-  writer.WriteResourcePath(key.path());
+  writer.WriteResourcePath(key);
   writer.WriteTerminator();
   return writer.result();
 }
@@ -1411,7 +1494,7 @@ std::string LevelDbDocumentOverlayKey::KeyPrefix(
   Writer writer;
   writer.WriteTableName(kDocumentOverlaysTable);
   writer.WriteUserId(user_id);
-  writer.WriteResourcePath(document_key.path());
+  writer.WriteResourcePath(document_key);
   return writer.result();
 }
 
@@ -1421,7 +1504,7 @@ std::string LevelDbDocumentOverlayKey::Key(absl::string_view user_id,
   Writer writer;
   writer.WriteTableName(kDocumentOverlaysTable);
   writer.WriteUserId(user_id);
-  writer.WriteResourcePath(document_key.path());
+  writer.WriteResourcePath(document_key);
   writer.WriteBatchId(largest_batch_id);
   writer.WriteTerminator();
   return writer.result();
@@ -1462,7 +1545,7 @@ std::string LevelDbDocumentOverlayLargestBatchIdIndexKey::Key(
   writer.WriteTableName(kDocumentOverlaysLargestBatchIdIndexTable);
   writer.WriteUserId(user_id);
   writer.WriteBatchId(largest_batch_id);
-  writer.WriteResourcePath(document_key.path());
+  writer.WriteResourcePath(document_key);
   writer.WriteTerminator();
   return writer.result();
 }
@@ -1575,7 +1658,7 @@ std::string LevelDbDocumentOverlayCollectionGroupIndexKey::Key(
   writer.WriteUserId(user_id);
   writer.WriteCollectionGroup(collection_group);
   writer.WriteBatchId(largest_batch_id);
-  writer.WriteResourcePath(document_key.path());
+  writer.WriteResourcePath(document_key);
   writer.WriteTerminator();
   return writer.result();
 }
@@ -19,6 +19,7 @@
 
 #include <string>
 #include <utility>
+#include <vector>
 
 #include "Firestore/core/src/model/document_key.h"
 #include "Firestore/core/src/model/mutation_batch.h"
@@ -152,6 +153,9 @@ namespace local {
 // data_migration:
 //   - table_name: "data_migration"
 //   - migration_name: string
+//
+// byte_size:
+//   - table_name: "byte_size"
 
 /**
  * Parses the given key and returns a human readable description of its
@@ -162,6 +166,35 @@ std::string DescribeKey(absl::string_view key);
 std::string DescribeKey(const std::string& key);
 std::string DescribeKey(const char* key);
 
+/**
+ * The groups of logical tables whose sizes are accounted for separately when
+ * computing the size of the cache.
+ */
+enum class LevelDbSubsystem {
+  /** Remote documents and the indexes over them. */
+  kDocuments = 0,
+  /** Targets, target metadata and target-document associations. */
+  kTargets,
+  /** Mutation queues, mutation batches and document overlays. */
+  kMutations,
+  /** Client-side index configuration, state and entries. */
+  kIndexes,
+  /** Everything else, e.g. bundles and the schema version. */
+  kOther,
+};
+
+/** The number of distinct LevelDbSubsystem values. */
+constexpr int kLevelDbSubsystemCount = 5;
+
+/** Returns the subsystem that owns the table to which the given key belongs. */
+LevelDbSubsystem SubsystemForKey(absl::string_view key);
+
+/**
+ * Returns the key prefixes of all the logical tables owned by the given
+ * subsystem.
+ */
+std::vector<std::string> TablePrefixesForSubsystem(LevelDbSubsystem subsystem);
+
 /** A key to a singleton row storing the version of the schema. */
 class LevelDbVersionKey {
  public:
@@ -171,6 +204,18 @@ class LevelDbVersionKey {
   static std::string Key();
 };
 
+/**
+ * A key to a singleton row storing the number of bytes used by each
+ * LevelDbSubsystem.
+ */
+class LevelDbByteSizeKey {
+ public:
+  /**
+   * Returns the key pointing to the singleton row storing the byte sizes.
+   */
+  static std::string Key();
+};
+
 /** A key in the mutations table. */
 class LevelDbMutationKey {
  public:
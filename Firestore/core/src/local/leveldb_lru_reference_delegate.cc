@@ -110,6 +110,14 @@ StatusOr<int64_t> LevelDbLruReferenceDelegate::CalculateByteSize() {
   return db_->CalculateByteSize();
 }
 
+std::string LevelDbLruReferenceDelegate::DescribeByteSize() {
+  StatusOr<LevelDbByteSizes> maybe_sizes = db_->CalculateByteSizes();
+  if (!maybe_sizes.ok()) {
+    return maybe_sizes.status().ToString();
+  }
+  return maybe_sizes.ValueOrDie().ToString();
+}
+
 size_t LevelDbLruReferenceDelegate::GetSequenceNumberCount() {
   size_t total_count = db_->target_cache()->size();
   EnumerateOrphanedDocuments(
@@ -161,7 +169,7 @@ bool LevelDbLruReferenceDelegate::IsPinned(const DocumentKey& key) {
 bool LevelDbLruReferenceDelegate::MutationQueuesContainKey(
     const DocumentKey& key) {
   const std::set<std::string>& users = db_->users();
-  const ResourcePath& path = key.path();
+  ResourcePath path = key.path();
   std::string buffer;
   auto it = db_->current_transaction()->NewIterator();
   // For each user, if there is any batch that contains this document in any
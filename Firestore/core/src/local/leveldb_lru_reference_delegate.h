@@ -18,6 +18,7 @@
 #define FIRESTORE_CORE_SRC_LOCAL_LEVELDB_LRU_REFERENCE_DELEGATE_H_
 
 #include <memory>
+#include <string>
 
 #include "Firestore/core/src/local/lru_garbage_collector.h"
 
@@ -58,6 +59,7 @@ class LevelDbLruReferenceDelegate : public LruDelegate {
   LruGarbageCollector* garbage_collector() override;
 
   util::StatusOr<int64_t> CalculateByteSize() override;
+  std::string DescribeByteSize() override;
   size_t GetSequenceNumberCount() override;
 
   void EnumerateTargetSequenceNumbers(
@@ -321,8 +321,7 @@ LevelDbMutationQueue::AllMutationBatchesAffectingQuery(const Query& query) {
     // document /rooms/abc/messages/xyx.
     // TODO(mcg): we'll need a different scanner when we implement ancestor
     // queries.
-    if (row_key.document_key().path().size() !=
-        immediate_children_path_length) {
+    if (row_key.document_key().path_size() != immediate_children_path_length) {
       continue;
     }
 
@@ -374,8 +373,7 @@ LevelDbMutationQueue::NextMutationBatchAfterBatchId(model::BatchId batch_id) {
 }
 
 BatchId LevelDbMutationQueue::GetHighestUnacknowledgedBatchId() {
-  std::unique_ptr<Iterator> it(
-      db_->ptr()->NewIterator(LevelDbTransaction::DefaultReadOptions()));
+  std::unique_ptr<Iterator> it(db_->ptr()->NewIterator(db_->read_options()));
 
   std::string next_user_key =
       util::PrefixSuccessor(LevelDbMutationKey::KeyPrefix(user_id_));
@@ -0,0 +1,64 @@
+/*
+ * Copyright 2022 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef FIRESTORE_CORE_SRC_LOCAL_LEVELDB_PARAMS_H_
+#define FIRESTORE_CORE_SRC_LOCAL_LEVELDB_PARAMS_H_
+
+#include <cstdint>
+
+#include "Firestore/core/src/api/settings.h"
+
+namespace firebase {
+namespace firestore {
+namespace local {
+
+/**
+ * Tuning parameters for the LevelDB database backing `LevelDbPersistence`.
+ *
+ * The defaults are those of `api::Settings`.
+ */
+struct LevelDbParams {
+  /** The size of the LRU cache of uncompressed table blocks. */
+  int64_t block_cache_size_bytes =
+      api::Settings::DefaultLevelDbBlockCacheSizeBytes;
+
+  /**
+   * The number of bits per key in the bloom filter attached to each table,
+   * which lets point lookups skip tables that don't hold the key. 0 disables
+   * the filter; 10 gives a false positive rate of about 1%.
+   *
+   * Changing this on an existing database takes effect gradually, as tables
+   * are rewritten by compactions.
+   */
+  int32_t bloom_filter_bits_per_key =
+      api::Settings::DefaultLevelDbBloomFilterBitsPerKey;
+
+  /** The amount of data buffered in memory before it's written to a table. */
+  int64_t write_buffer_size_bytes =
+      api::Settings::DefaultLevelDbWriteBufferSizeBytes;
+
+  /** The number of table files LevelDB may keep open at once. */
+  int32_t max_open_files = api::Settings::DefaultLevelDbMaxOpenFiles;
+
+  /** Whether reads verify the checksums of the blocks they read. */
+  bool verify_checksums = api::Settings::DefaultLevelDbVerifyChecksums;
+};
+
+}  // namespace local
+}  // namespace firestore
+}  // namespace firebase
+
+#endif  // FIRESTORE_CORE_SRC_LOCAL_LEVELDB_PARAMS_H_
@@ -16,7 +16,6 @@
 
 #include "Firestore/core/src/local/leveldb_persistence.h"
 
-#include <limits>
 #include <utility>
 
 #include "Firestore/core/src/core/database_info.h"
@@ -80,7 +79,8 @@ StatusOr<std::unique_ptr<LevelDbPersistence>> LevelDbPersistence::Create(
     util::Path dir,
     LevelDbMigrations::SchemaVersion version,
     LocalSerializer serializer,
-    const LruParams& lru_params) {
+    const LruParams& lru_params,
+    const LevelDbParams& leveldb_params) {
   auto* fs = Filesystem::Default();
   Status status = EnsureDirectory(dir);
   if (!status.ok()) return status;
@@ -88,36 +88,64 @@ StatusOr<std::unique_ptr<LevelDbPersistence>> LevelDbPersistence::Create(
   status = fs->ExcludeFromBackups(dir);
   if (!status.ok()) return status;
 
-  StatusOr<std::unique_ptr<DB>> created = OpenDb(dir);
+  std::unique_ptr<leveldb::Cache> block_cache(leveldb::NewLRUCache(
+      static_cast<size_t>(leveldb_params.block_cache_size_bytes)));
+  std::unique_ptr<const leveldb::FilterPolicy> filter_policy;
+  if (leveldb_params.bloom_filter_bits_per_key > 0) {
+    filter_policy.reset(leveldb::NewBloomFilterPolicy(
+        leveldb_params.bloom_filter_bits_per_key));
+  }
+
+  leveldb::Options options;
+  options.create_if_missing = true;
+  options.block_cache = block_cache.get();
+  options.filter_policy = filter_policy.get();
+  options.write_buffer_size =
+      static_cast<size_t>(leveldb_params.write_buffer_size_bytes);
+  options.max_open_files = leveldb_params.max_open_files;
+
+  leveldb::ReadOptions read_options;
+  read_options.verify_checksums = leveldb_params.verify_checksums;
+
+  StatusOr<std::unique_ptr<DB>> created = OpenDb(dir, options);
   if (!created.ok()) return created.status();
 
   std::unique_ptr<DB> db = std::move(created).ValueOrDie();
   LevelDbMigrations::RunMigrations(db.get(), version, serializer);
 
-  LevelDbTransaction transaction(db.get(), "Start LevelDB");
+  LevelDbTransaction transaction(db.get(), "Start LevelDB", read_options);
   std::set<std::string> users = CollectUserSet(&transaction);
+  EnsureByteSizes(db.get(), &transaction);
   transaction.Commit();
 
   // Explicit conversion is required to allow the StatusOr to be created.
-  std::unique_ptr<LevelDbPersistence> result(
-      new LevelDbPersistence(std::move(db), std::move(dir), std::move(users),
-                             std::move(serializer), lru_params));
+  std::unique_ptr<LevelDbPersistence> result(new LevelDbPersistence(
+      std::move(db), std::move(block_cache), std::move(filter_policy),
+      read_options, std::move(users), std::move(serializer), lru_params));
   return {std::move(result)};
 }
 
 StatusOr<std::unique_ptr<LevelDbPersistence>> LevelDbPersistence::Create(
-    util::Path dir, LocalSerializer serializer, const LruParams& lru_params) {
+    util::Path dir,
+    LocalSerializer serializer,
+    const LruParams& lru_params,
+    const LevelDbParams& leveldb_params) {
   return Create(std::move(dir), kSchemaVersion, std::move(serializer),
-                lru_params);
+                lru_params, leveldb_params);
 }
 
-LevelDbPersistence::LevelDbPersistence(std::unique_ptr<leveldb::DB> db,
-                                       util::Path directory,
-                                       std::set<std::string> users,
-                                       LocalSerializer serializer,
-                                       const LruParams& lru_params)
-    : db_(std::move(db)),
-      directory_(std::move(directory)),
+LevelDbPersistence::LevelDbPersistence(
+    std::unique_ptr<leveldb::DB> db,
+    std::unique_ptr<leveldb::Cache> block_cache,
+    std::unique_ptr<const leveldb::FilterPolicy> filter_policy,
+    const leveldb::ReadOptions& read_options,
+    std::set<std::string> users,
+    LocalSerializer serializer,
+    const LruParams& lru_params)
+    : block_cache_(std::move(block_cache)),
+      filter_policy_(std::move(filter_policy)),
+      db_(std::move(db)),
+      read_options_(read_options),
       users_(std::move(users)),
       serializer_(std::move(serializer)) {
   target_cache_ = absl::make_unique<LevelDbTargetCache>(this, &serializer_);
@@ -150,10 +178,23 @@ Status LevelDbPersistence::EnsureDirectory(const Path& dir) {
   return Status::OK();
 }
 
-StatusOr<std::unique_ptr<DB>> LevelDbPersistence::OpenDb(const Path& dir) {
-  leveldb::Options options;
-  options.create_if_missing = true;
+void LevelDbPersistence::EnsureByteSizes(DB* db,
+                                         LevelDbTransaction* transaction) {
+  std::string encoded;
+  std::string size_key = LevelDbByteSizeKey::Key();
+  if (transaction->Get(size_key, &encoded).ok() &&
+      LevelDbByteSizes::Decode(encoded)) {
+    return;
+  }
 
+  LOG_DEBUG("Calculating the size of the LevelDB cache");
+  LevelDbByteSizes sizes = LevelDbByteSizes::Calculate(
+      db, LevelDbTransaction::DefaultReadOptions());
+  transaction->Put(std::move(size_key), sizes.Encode());
+}
+
+StatusOr<std::unique_ptr<DB>> LevelDbPersistence::OpenDb(
+    const Path& dir, const leveldb::Options& options) {
   DB* database = nullptr;
   leveldb::Status status = DB::Open(options, dir.ToUtf8String(), &database);
   if (!status.ok()) {
@@ -188,36 +229,32 @@ util::Status LevelDbPersistence::ClearPersistence(
 }
 
 StatusOr<int64_t> LevelDbPersistence::CalculateByteSize() {
-  auto* fs = Filesystem::Default();
-
-  // Accumulate the total size in an unsigned integer to avoid undefined
-  // behavior on overflow.
-  uint64_t count = 0;
-  auto iter = util::DirectoryIterator::Create(directory_);
-  for (; iter->Valid(); iter->Next()) {
-    StatusOr<int64_t> maybe_size = fs->FileSize(iter->file());
-    if (!maybe_size.ok()) {
-      return Status::FromCause("Failed to size LevelDB directory",
-                               maybe_size.status());
-    }
-
-    uint64_t old_count = count;
-    int64_t file_size = maybe_size.ValueOrDie();
-    count += file_size;
+  StatusOr<LevelDbByteSizes> maybe_sizes = CalculateByteSizes();
+  if (!maybe_sizes.ok()) {
+    return maybe_sizes.status();
+  }
+  return maybe_sizes.ValueOrDie().total_bytes();
+}
 
-    auto max_signed_value =
-        static_cast<uint64_t>(std::numeric_limits<int64_t>::max());
-    if (count < old_count || count > max_signed_value) {
-      return Status(Error::kErrorOutOfRange,
-                    "Failed to size LevelDB: count overflowed");
-    }
+StatusOr<LevelDbByteSizes> LevelDbPersistence::CalculateByteSizes() {
+  std::string encoded;
+  leveldb::Status status =
+      db_->Get(read_options_, LevelDbByteSizeKey::Key(), &encoded);
+  if (!status.ok()) {
+    return Status::FromCause("Failed to read the size of the LevelDB cache",
+                             ConvertStatus(status));
   }
 
-  if (!iter->status().ok()) {
-    return Status::FromCause("Failed to iterate over LevelDB files",
-                             iter->status());
+  absl::optional<LevelDbByteSizes> sizes = LevelDbByteSizes::Decode(encoded);
+  if (!sizes) {
+    return Status(Error::kErrorDataLoss,
+                  "Failed to decode the size of the LevelDB cache");
   }
-  return static_cast<int64_t>(count);
+  return *sizes;
+}
+
+LevelDbByteSizes LevelDbPersistence::ApproximateByteSizes() {
+  return LevelDbByteSizes::Approximate(db_.get());
 }
 
 // MARK: - Persistence
@@ -312,7 +349,8 @@ void LevelDbPersistence::RunInternal(absl::string_view label,
   HARD_ASSERT(transaction_ == nullptr,
               "Starting a transaction while one is already in progress");
 
-  transaction_ = absl::make_unique<LevelDbTransaction>(db_.get(), label);
+  transaction_ =
+      absl::make_unique<LevelDbTransaction>(db_.get(), label, read_options_);
   reference_delegate_->OnTransactionStarted(label);
 
   block();
@@ -24,12 +24,14 @@
 
 #include "Firestore/core/src/credentials/user.h"
 #include "Firestore/core/src/local/leveldb_bundle_cache.h"
+#include "Firestore/core/src/local/leveldb_byte_sizes.h"
 #include "Firestore/core/src/local/leveldb_document_overlay_cache.h"
 #include "Firestore/core/src/local/leveldb_index_manager.h"
 #include "Firestore/core/src/local/leveldb_lru_reference_delegate.h"
 #include "Firestore/core/src/local/leveldb_migrations.h"
 #include "Firestore/core/src/local/leveldb_mutation_queue.h"
 #include "Firestore/core/src/local/leveldb_overlay_migration_manager.h"
+#include "Firestore/core/src/local/leveldb_params.h"
 #include "Firestore/core/src/local/leveldb_remote_document_cache.h"
 #include "Firestore/core/src/local/leveldb_target_cache.h"
 #include "Firestore/core/src/local/leveldb_transaction.h"
@@ -37,6 +39,8 @@
 #include "Firestore/core/src/local/persistence.h"
 #include "Firestore/core/src/util/path.h"
 #include "Firestore/core/src/util/statusor.h"
+#include "leveldb/cache.h"
+#include "leveldb/filter_policy.h"
 
 namespace firebase {
 namespace firestore {
@@ -58,7 +62,10 @@ class LevelDbPersistence : public Persistence {
    * containing details of the failure.
    */
   static util::StatusOr<std::unique_ptr<LevelDbPersistence>> Create(
-      util::Path dir, LocalSerializer serializer, const LruParams& lru_params);
+      util::Path dir,
+      LocalSerializer serializer,
+      const LruParams& lru_params,
+      const LevelDbParams& leveldb_params = LevelDbParams());
 
   ~LevelDbPersistence();
 
@@ -68,14 +75,36 @@ class LevelDbPersistence : public Persistence {
     return db_.get();
   }
 
+  /** The options to read from the database with, per `LevelDbParams`. */
+  const leveldb::ReadOptions& read_options() const {
+    return read_options_;
+  }
+
   const std::set<std::string> users() const {
     return users_;
   }
 
   static util::Status ClearPersistence(const core::DatabaseInfo& database_info);
 
+  /**
+   * Returns the number of bytes of live data in the database. This reads the
+   * running total maintained by each transaction commit, so it does not need
+   * to walk the database or its files.
+   */
   util::StatusOr<int64_t> CalculateByteSize();
 
+  /**
+   * Returns the number of bytes of live data in the database, broken down by
+   * subsystem.
+   */
+  util::StatusOr<LevelDbByteSizes> CalculateByteSizes();
+
+  /**
+   * Returns LevelDB's estimate of the on-disk size of each subsystem, which can
+   * be used to sanity check the result of CalculateByteSizes().
+   */
+  LevelDbByteSizes ApproximateByteSizes();
+
   // MARK: Persistence overrides
 
   model::ListenSequenceNumber current_sequence_number() const override;
@@ -109,7 +138,9 @@ class LevelDbPersistence : public Persistence {
  private:
   friend class LevelDbOverlayMigrationManagerTest;
   LevelDbPersistence(std::unique_ptr<leveldb::DB> db,
-                     util::Path directory,
+                     std::unique_ptr<leveldb::Cache> block_cache,
+                     std::unique_ptr<const leveldb::FilterPolicy> filter_policy,
+                     const leveldb::ReadOptions& read_options,
                      std::set<std::string> users,
                      LocalSerializer serializer,
                      const LruParams& lru_params);
@@ -119,19 +150,31 @@ class LevelDbPersistence : public Persistence {
    */
   static util::Status EnsureDirectory(const util::Path& dir);
 
+  /**
+   * Computes the byte sizes of the database from scratch if they are not
+   * already being tracked, e.g. because the database was created by an older
+   * version of the SDK.
+   */
+  static void EnsureByteSizes(leveldb::DB* db, LevelDbTransaction* transaction);
+
   /** Opens the database within the given directory. */
   static util::StatusOr<std::unique_ptr<leveldb::DB>> OpenDb(
-      const util::Path& dir);
+      const util::Path& dir, const leveldb::Options& options);
 
   static util::StatusOr<std::unique_ptr<LevelDbPersistence>> Create(
       util::Path dir,
       LevelDbMigrations::SchemaVersion schema_version,
       LocalSerializer serializer,
-      const LruParams& lru_params);
+      const LruParams& lru_params,
+      const LevelDbParams& leveldb_params = LevelDbParams());
 
+  // The block cache and filter policy are referenced by the database, so they
+  // must be declared (and therefore destroyed) before it.
+  std::unique_ptr<leveldb::Cache> block_cache_;
+  std::unique_ptr<const leveldb::FilterPolicy> filter_policy_;
   std::unique_ptr<leveldb::DB> db_;
+  leveldb::ReadOptions read_options_;
 
-  util::Path directory_;
   std::set<std::string> users_;
   LocalSerializer serializer_;
   bool started_ = false;
@@ -16,9 +16,13 @@
 
 #include "Firestore/core/src/local/leveldb_remote_document_cache.h"
 
+#include <algorithm>
+#include <mutex>  // NOLINT(build/c++11)
 #include <string>
 #include <thread>  // NOLINT(build/c++11)
+#include <unordered_map>
 #include <utility>
+#include <vector>
 
 #include "Firestore/Protos/nanopb/firestore/local/maybe_document.nanopb.h"
 #include "Firestore/core/src/core/query.h"
@@ -27,7 +31,6 @@
 #include "Firestore/core/src/local/local_serializer.h"
 #include "Firestore/core/src/model/document_key_set.h"
 #include "Firestore/core/src/model/mutable_document.h"
-#include "Firestore/core/src/nanopb/message.h"
 #include "Firestore/core/src/nanopb/reader.h"
 #include "Firestore/core/src/util/background_queue.h"
 #include "Firestore/core/src/util/executor.h"
@@ -43,13 +46,13 @@ namespace {
 using core::Query;
 using leveldb::Status;
 using model::DocumentKey;
+using model::DocumentKeyHash;
 using model::DocumentKeySet;
 using model::DocumentVersionMap;
 using model::MutableDocument;
 using model::MutableDocumentMap;
 using model::ResourcePath;
 using model::SnapshotVersion;
-using nanopb::Message;
 using nanopb::StringReader;
 using util::BackgroundQueue;
 using util::Executor;
@@ -88,6 +91,37 @@ class AsyncResults {
 
 }  // namespace
 
+/** The result of scanning a single collection of a collection group. */
+struct LevelDbRemoteDocumentCache::CollectionScan {
+  /**
+   * Returns the number of documents this collection contributes to a limited
+   * read of its collection group once the collections before it have left
+   * `remaining` documents to be read: like `GetAll(path, offset, remaining)`,
+   * these are the existing documents among its first `remaining` keys. Adds
+   * them to `result` unless it's null.
+   */
+  size_t Contribute(size_t remaining, MutableDocumentMap* result) const {
+    size_t count = 0;
+    size_t end = std::min(remaining, keys.size());
+    for (size_t i = 0; i != end; ++i) {
+      auto found = documents.find(keys[i]);
+      if (found != documents.end()) {
+        ++count;
+        if (result) {
+          *result = result->insert(found->first, found->second);
+        }
+      }
+    }
+    return count;
+  }
+
+  /** The keys found in the collection's read time index, in index order. */
+  std::vector<DocumentKey> keys;
+
+  /** The documents among `keys` that exist. */
+  MutableDocumentMap documents;
+};
+
 LevelDbRemoteDocumentCache::LevelDbRemoteDocumentCache(
     LevelDbPersistence* db, LocalSerializer* serializer)
     : db_(db), serializer_(NOT_NULL(serializer)) {
@@ -106,7 +140,7 @@ LevelDbRemoteDocumentCache::~LevelDbRemoteDocumentCache() = default;
 void LevelDbRemoteDocumentCache::Add(const MutableDocument& document,
                                      const SnapshotVersion& read_time) {
   const DocumentKey& key = document.key();
-  const ResourcePath& path = key.path();
+  ResourcePath path = key.path();
 
   std::string ldb_document_key = LevelDbRemoteDocumentKey::Key(key);
   db_->current_transaction()->Put(ldb_document_key,
@@ -154,7 +188,7 @@ MutableDocumentMap LevelDbRemoteDocumentCache::GetAll(
       results.Insert(
           std::make_pair(key, MutableDocument::InvalidDocument(key)));
     } else {
-      const std::string& contents = it->value();
+      std::string contents(it->value());
       tasks.Execute([this, &results, &key, contents] {
         results.Insert(std::make_pair(key, DecodeMaybeDocument(contents, key)));
       });
@@ -174,14 +208,19 @@ MutableDocumentMap LevelDbRemoteDocumentCache::GetAllExisting(
     DocumentVersionMap&& remote_map) const {
   BackgroundQueue tasks(executor_.get());
   AsyncResults<std::pair<DocumentKey, MutableDocument>> results;
-  for (const auto& key_version : remote_map) {
-    tasks.Execute([this, &results, key_version] {
-      auto document = Get(key_version.first).WithReadTime(key_version.second);
+
+  ReadDocuments(remote_map, [&](const DocumentKey& key,
+                                const SnapshotVersion& read_time,
+                                std::string contents) {
+    tasks.Execute([this, &results, &key, &read_time, contents] {
+      MutableDocument document = DecodeMaybeDocument(contents, key);
+      document.WithReadTime(read_time);
       if (document.is_found_document()) {
-        results.Insert(std::make_pair(key_version.first, std::move(document)));
+        results.Insert(std::make_pair(key, std::move(document)));
       }
     });
-  }
+  });
+
   tasks.AwaitAll();
 
   MutableDocumentMap map;
@@ -191,6 +230,49 @@ MutableDocumentMap LevelDbRemoteDocumentCache::GetAllExisting(
   return map;
 }
 
+void LevelDbRemoteDocumentCache::ReadDocuments(
+    const DocumentVersionMap& remote_map,
+    const std::function<void(const DocumentKey&,
+                             const SnapshotVersion&,
+                             std::string)>& on_contents) const {
+  // Sort the requested documents by their encoded LevelDB key so that they can
+  // all be read in a single forward pass of one iterator, rather than issuing
+  // a separate point lookup (and seek) per document.
+  using KeyedEntry =
+      std::pair<std::string, const DocumentVersionMap::value_type*>;
+  std::vector<KeyedEntry> sorted_keys;
+  sorted_keys.reserve(remote_map.size());
+  for (const auto& key_version : remote_map) {
+    sorted_keys.emplace_back(LevelDbRemoteDocumentKey::Key(key_version.first),
+                             &key_version);
+  }
+  std::sort(sorted_keys.begin(), sorted_keys.end(),
+            [](const KeyedEntry& lhs, const KeyedEntry& rhs) {
+              return lhs.first < rhs.first;
+            });
+
+  auto it = db_->current_transaction()->NewIterator();
+  for (const auto& entry : sorted_keys) {
+    const std::string& ldb_key = entry.first;
+
+    // Documents returned by the read time index are usually dense in the
+    // remote document table, so try stepping to the next row before falling
+    // back to a full seek.
+    if (it->Valid() && it->key() < ldb_key) {
+      it->Next();
+    }
+    if (!it->Valid() || it->key() < ldb_key) {
+      it->Seek(ldb_key);
+    }
+    if (!it->Valid() || it->key() != ldb_key) {
+      continue;
+    }
+
+    on_contents(entry.second->first, entry.second->second,
+                std::string(it->value()));
+  }
+}
+
 MutableDocumentMap LevelDbRemoteDocumentCache::GetAll(
     const std::string& collection_group,
     const model::IndexOffset& offset,
@@ -204,12 +286,26 @@ MutableDocumentMap LevelDbRemoteDocumentCache::GetAll(
   }
 
   MutableDocumentMap result;
-  for (auto path = collections.cbegin();
-       path != collections.cend() && result.size() < limit; path++) {
-    const auto remote_docs = GetAll(*path, offset, limit - result.size());
-    for (const auto& doc : remote_docs) {
-      result = result.insert(doc.first, doc.second);
+  if (collections.size() <= 1) {
+    // Nothing to scan concurrently, but documents are still decoded in
+    // parallel.
+    for (auto path = collections.cbegin();
+         path != collections.cend() && result.size() < limit; path++) {
+      const auto remote_docs = GetAll(*path, offset, limit - result.size());
+      for (const auto& doc : remote_docs) {
+        result = result.insert(doc.first, doc.second);
+      }
     }
+    return result;
+  }
+
+  std::vector<CollectionScan> scans =
+      ScanCollections(collections, offset, limit);
+  for (const CollectionScan& scan : scans) {
+    if (result.size() >= limit) {
+      break;
+    }
+    scan.Contribute(limit - result.size(), &result);
   }
   return result;
 }
@@ -218,6 +314,37 @@ MutableDocumentMap LevelDbRemoteDocumentCache::GetAll(
     const model::ResourcePath& path,
     const model::IndexOffset& offset,
     const absl::optional<size_t> limit) const {
+  DocumentVersionMap remote_map;
+  for (auto& entry : ScanReadTimeIndex(path, offset, limit)) {
+    remote_map[std::move(entry.first)] = entry.second;
+  }
+  return LevelDbRemoteDocumentCache::GetAllExisting(std::move(remote_map));
+}
+
+std::vector<MutableDocumentMap> LevelDbRemoteDocumentCache::GetAll(
+    const std::vector<ResourcePath>& collections,
+    const model::IndexOffset& offset) const {
+  std::vector<MutableDocumentMap> results;
+  results.reserve(collections.size());
+  if (collections.size() <= 1) {
+    for (const ResourcePath& path : collections) {
+      results.push_back(GetAll(path, offset));
+    }
+    return results;
+  }
+
+  for (CollectionScan& scan :
+       ScanCollections(collections, offset, absl::nullopt)) {
+    results.push_back(std::move(scan.documents));
+  }
+  return results;
+}
+
+std::vector<std::pair<DocumentKey, SnapshotVersion>>
+LevelDbRemoteDocumentCache::ScanReadTimeIndex(
+    const ResourcePath& path,
+    const model::IndexOffset& offset,
+    absl::optional<size_t> limit) const {
   // Use the query path as a prefix for testing if a document matches the query.
 
   // Execute an index-free query and filter by read time. This is safe since
@@ -229,11 +356,14 @@ MutableDocumentMap LevelDbRemoteDocumentCache::GetAll(
   auto it = db_->current_transaction()->NewIterator();
   it->Seek(util::ImmediateSuccessor(start_key));
 
-  DocumentVersionMap remote_map;
+  // A document can be in the index more than once if it was read more than
+  // once; only its latest read time counts.
+  std::vector<std::pair<DocumentKey, SnapshotVersion>> result;
+  std::unordered_map<DocumentKey, size_t, DocumentKeyHash> positions;
 
   LevelDbRemoteDocumentReadTimeKey current_key;
   for (; it->Valid() && current_key.Decode(it->key()) &&
-         (!limit.has_value() || remote_map.size() < limit);
+         (!limit.has_value() || result.size() < limit);
        it->Next()) {
     const ResourcePath& collection_path = current_key.collection_path();
     if (collection_path != path) {
@@ -241,27 +371,104 @@ MutableDocumentMap LevelDbRemoteDocumentCache::GetAll(
     }
 
     const SnapshotVersion& read_time = current_key.read_time();
-    if (read_time > offset.read_time()) {
-      DocumentKey document_key(path.Append(current_key.document_id()));
-      remote_map[document_key] = read_time;
-    } else if (read_time == offset.read_time()) {
-      DocumentKey document_key(path.Append(current_key.document_id()));
-      if (document_key > offset.document_key()) {
-        remote_map[document_key] = read_time;
-      }
+    DocumentKey document_key(path.Append(current_key.document_id()));
+    if (read_time < offset.read_time() ||
+        (read_time == offset.read_time() &&
+         document_key <= offset.document_key())) {
+      continue;
+    }
+
+    auto inserted = positions.emplace(document_key, result.size());
+    if (inserted.second) {
+      result.emplace_back(std::move(document_key), read_time);
+    } else {
+      result[inserted.first->second].second = read_time;
     }
   }
 
-  return LevelDbRemoteDocumentCache::GetAllExisting(std::move(remote_map));
+  return result;
+}
+
+LevelDbRemoteDocumentCache::CollectionScan
+LevelDbRemoteDocumentCache::ScanCollection(
+    const ResourcePath& path,
+    const model::IndexOffset& offset,
+    absl::optional<size_t> limit) const {
+  CollectionScan scan;
+  DocumentVersionMap remote_map;
+  for (auto& entry : ScanReadTimeIndex(path, offset, limit)) {
+    scan.keys.push_back(entry.first);
+    remote_map[std::move(entry.first)] = entry.second;
+  }
+
+  ReadDocuments(remote_map, [&](const DocumentKey& key,
+                                const SnapshotVersion& read_time,
+                                std::string contents) {
+    MutableDocument document = DecodeMaybeDocument(contents, key);
+    document.WithReadTime(read_time);
+    if (document.is_found_document()) {
+      scan.documents = scan.documents.insert(key, std::move(document));
+    }
+  });
+  return scan;
+}
+
+std::vector<LevelDbRemoteDocumentCache::CollectionScan>
+LevelDbRemoteDocumentCache::ScanCollections(
+    const std::vector<ResourcePath>& collections,
+    const model::IndexOffset& offset,
+    absl::optional<size_t> limit) const {
+  // Each scan only reads from the current transaction, which is safe to do
+  // from several threads as long as nothing writes to it in the meantime.
+  // Scans decode their documents themselves rather than through another
+  // `BackgroundQueue`, which could otherwise deadlock the executor.
+  std::vector<CollectionScan> scans(collections.size());
+
+  // With a limit, track how many documents the leading run of finished scans
+  // contributes. Once that reaches the limit, later scans are pointless.
+  std::mutex mutex;
+  std::vector<bool> finished(collections.size());
+  size_t merged_scans = 0;
+  size_t merged_documents = 0;
+
+  BackgroundQueue tasks(executor_.get());
+  for (size_t i = 0; i != collections.size(); ++i) {
+    tasks.Execute([&, i] {
+      if (limit) {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (merged_documents >= *limit) {
+          return;
+        }
+      }
+
+      CollectionScan scan = ScanCollection(collections[i], offset, limit);
+
+      std::lock_guard<std::mutex> lock(mutex);
+      scans[i] = std::move(scan);
+      finished[i] = true;
+      if (!limit) {
+        return;
+      }
+      while (merged_scans < scans.size() && finished[merged_scans] &&
+             merged_documents < *limit) {
+        merged_documents += scans[merged_scans].Contribute(
+            *limit - merged_documents, nullptr);
+        ++merged_scans;
+      }
+    });
+  }
+
+  tasks.AwaitAll();
+  return scans;
 }
 
 MutableDocument LevelDbRemoteDocumentCache::DecodeMaybeDocument(
     absl::string_view encoded, const DocumentKey& key) const {
-  StringReader reader{encoded};
-
-  auto message = Message<firestore_client_MaybeDocument>::TryParse(&reader);
+  // Most documents read from the cache are only checked against a query, so
+  // only decode the fields that the query looks at.
+  StringReader reader;
   MutableDocument maybe_document =
-      serializer_->DecodeMaybeDocument(&reader, *message);
+      serializer_->DecodeMaybeDocumentLazily(&reader, encoded);
 
   if (!reader.ok()) {
     HARD_FAIL("MaybeDocument proto failed to parse: %s",
@@ -17,9 +17,11 @@
 #ifndef FIRESTORE_CORE_SRC_LOCAL_LEVELDB_REMOTE_DOCUMENT_CACHE_H_
 #define FIRESTORE_CORE_SRC_LOCAL_LEVELDB_REMOTE_DOCUMENT_CACHE_H_
 
+#include <functional>
 #include <memory>
 #include <string>
 #include <thread>  // NOLINT(build/c++11)
+#include <utility>
 #include <vector>
 
 #include "Firestore/core/src/local/leveldb_index_manager.h"
@@ -66,10 +68,55 @@ class LevelDbRemoteDocumentCache : public RemoteDocumentCache {
       const model::ResourcePath& path,
       const model::IndexOffset& offset,
       absl::optional<size_t> limit = absl::nullopt) const override;
+  std::vector<model::MutableDocumentMap> GetAll(
+      const std::vector<model::ResourcePath>& collections,
+      const model::IndexOffset& offset) const override;
 
   void SetIndexManager(IndexManager* manager) override;
 
  private:
+  struct CollectionScan;
+
+  /**
+   * Returns the keys and read times of up to `limit` documents in the
+   * collection at `path` that were read after `offset`, in read time order.
+   */
+  std::vector<std::pair<model::DocumentKey, model::SnapshotVersion>>
+  ScanReadTimeIndex(const model::ResourcePath& path,
+                    const model::IndexOffset& offset,
+                    absl::optional<size_t> limit) const;
+
+  /**
+   * Scans the read time index of a collection and decodes the documents it
+   * refers to on the calling thread, so that it can run as one of several
+   * concurrent tasks.
+   */
+  CollectionScan ScanCollection(const model::ResourcePath& path,
+                                const model::IndexOffset& offset,
+                                absl::optional<size_t> limit) const;
+
+  /**
+   * Scans each of the given collections concurrently. If `limit` is set,
+   * collections are skipped once the ones before them are known to yield
+   * `limit` documents between them, following the rules of
+   * `GetAll(collection_group, offset, limit)`.
+   */
+  std::vector<CollectionScan> ScanCollections(
+      const std::vector<model::ResourcePath>& collections,
+      const model::IndexOffset& offset,
+      absl::optional<size_t> limit) const;
+
+  /**
+   * Reads the contents of the documents in `remote_map` in a single forward
+   * pass over the document table, passing each document that exists to
+   * `on_contents` along with its key and read time.
+   */
+  void ReadDocuments(
+      const model::DocumentVersionMap& remote_map,
+      const std::function<void(const model::DocumentKey&,
+                               const model::SnapshotVersion&,
+                               std::string)>& on_contents) const;
+
   /**
    * Looks up a set of entries in the cache, returning only existing entries of
    * Type::Document together with its SnapshotVersion.
@@ -18,7 +18,9 @@
 
 #include "Firestore/core/src/local/leveldb_transaction.h"
 
+#include "Firestore/core/src/local/leveldb_byte_sizes.h"
 #include "Firestore/core/src/local/leveldb_key.h"
+#include "Firestore/core/src/local/leveldb_util.h"
 #include "Firestore/core/src/util/hard_assert.h"
 #include "Firestore/core/src/util/log.h"
 #include "absl/memory/memory.h"
@@ -41,7 +43,7 @@ LevelDbTransaction::Iterator::Iterator(LevelDbTransaction* txn)
       last_version_(txn->version_),
       txn_(txn),
       mutations_iter_(txn->mutations_.begin()),
-      current_(),
+      current_mutation_(),
       is_mutation_(false),
       // Iterator doesn't really point to anything yet, so is
       // invalid
@@ -65,9 +67,7 @@ void LevelDbTransaction::Iterator::UpdateCurrent() {
       is_mutation_ = db_iter_->key().compare(mutations_iter_->first) >= 0;
     }
     if (is_mutation_) {
-      current_ = *mutations_iter_;
-    } else {
-      current_ = {db_iter_->key().ToString(), db_iter_->value().ToString()};
+      current_mutation_ = *mutations_iter_;
     }
   }
 }
@@ -85,28 +85,38 @@ void LevelDbTransaction::Iterator::Seek(const std::string& key) {
   last_version_ = txn_->version_;
 }
 
-const std::string& LevelDbTransaction::Iterator::key() const {
+absl::string_view LevelDbTransaction::Iterator::key() const {
   HARD_ASSERT(Valid(), "key() called on invalid iterator");
-  return current_.first;
+  if (is_mutation_) {
+    return current_mutation_.first;
+  }
+  return MakeStringView(db_iter_->key());
 }
 
-const std::string& LevelDbTransaction::Iterator::value() const {
+absl::string_view LevelDbTransaction::Iterator::value() const {
   HARD_ASSERT(Valid(), "value() called on invalid iterator");
-  return current_.second;
+  if (is_mutation_) {
+    return current_mutation_.second;
+  }
+  return MakeStringView(db_iter_->value());
 }
 
 bool LevelDbTransaction::Iterator::IsDeleted(leveldb::Slice slice) {
+  // Avoid copying the key in the common case of a read-only transaction.
+  if (txn_->deletions_.empty()) {
+    return false;
+  }
   return txn_->deletions_.find(slice.ToString()) != txn_->deletions_.end();
 }
 
 bool LevelDbTransaction::Iterator::SyncToTransaction() {
   if (last_version_ < txn_->version_) {
-    // Intentionally copying here since Seek() may update current_. We need the
-    // copy to do the comparison below.
-    const std::string current_key = current_.first;
+    // Intentionally copying here since Seek() moves the underlying iterators
+    // and invalidates key(). We need the copy to do the comparison below.
+    const std::string current_key(key());
     Seek(current_key);
     // If we advanced, we don't need to advance again.
-    return is_valid_ && current_.first > current_key;
+    return is_valid_ && key() > current_key;
   } else {
     return false;
   }
@@ -210,6 +220,8 @@ void LevelDbTransaction::Commit() {
     batch.Put(entry.first, entry.second);
   }
 
+  UpdateByteSizes(&batch);
+
   LOG_DEBUG("Committing transaction: %s", ToString());
 
   Status status = db_->Write(write_options_, &batch);
@@ -217,6 +229,57 @@ void LevelDbTransaction::Commit() {
               ToString(), status.ToString());
 }
 
+void LevelDbTransaction::UpdateByteSizes(WriteBatch* batch) {
+  std::string size_key = LevelDbByteSizeKey::Key();
+  if (mutations_.find(size_key) != mutations_.end() ||
+      deletions_.find(size_key) != deletions_.end()) {
+    // The transaction sets or resets the sizes explicitly.
+    return;
+  }
+
+  std::string encoded;
+  Status status = db_->Get(read_options_, size_key, &encoded);
+  if (status.IsNotFound()) {
+    return;
+  }
+  HARD_ASSERT(status.ok(), "Failed to read byte sizes: %s", status.ToString());
+
+  absl::optional<LevelDbByteSizes> maybe_sizes =
+      LevelDbByteSizes::Decode(encoded);
+  if (!maybe_sizes) {
+    LOG_WARN("Ignoring invalid byte sizes; they will be recalculated");
+    batch->Delete(size_key);
+    return;
+  }
+  LevelDbByteSizes sizes = *maybe_sizes;
+
+  // Each changed row replaces whatever was previously committed under its key,
+  // so look up the size of the committed value to compute the delta.
+  std::string previous;
+  auto subtract_previous = [&](const std::string& key) {
+    Status found = db_->Get(read_options_, key, &previous);
+    if (found.ok()) {
+      sizes.Add(key, -static_cast<int64_t>(key.size() + previous.size()));
+    } else {
+      HARD_ASSERT(found.IsNotFound(), "Failed to read %s: %s",
+                  DescribeKey(key), found.ToString());
+    }
+  };
+
+  for (const auto& deletion : deletions_) {
+    subtract_previous(deletion);
+  }
+  for (const auto& entry : mutations_) {
+    subtract_previous(entry.first);
+    sizes.Add(entry.first,
+              static_cast<int64_t>(entry.first.size() + entry.second.size()));
+  }
+
+  if (sizes != *maybe_sizes) {
+    batch->Put(size_key, sizes.Encode());
+  }
+}
+
 std::string LevelDbTransaction::ToString() {
   std::string dest = absl::StrCat("<LevelDbTransaction ", label_, ": ");
   size_t changes = deletions_.size() + mutations_.size();
@@ -71,14 +71,16 @@ class LevelDbTransaction {
     void Next();
 
     /**
-     * Returns the key of the current entry
+     * Returns the key of the current entry. The returned view is only valid
+     * until the next call to Seek() or Next().
      */
-    const std::string& key() const;
+    absl::string_view key() const;
 
     /**
-     * Returns the value of the current entry
+     * Returns the value of the current entry. The returned view is only valid
+     * until the next call to Seek() or Next().
      */
-    const std::string& value() const;
+    absl::string_view value() const;
 
    private:
     /**
@@ -102,7 +104,7 @@ class LevelDbTransaction {
 
     /**
      * Given the current state of the internal iterators, set is_valid_,
-     * is_mutation_, and current_.
+     * is_mutation_, and current_mutation_.
      */
     void UpdateCurrent();
 
@@ -113,11 +115,13 @@ class LevelDbTransaction {
     // The underlying transaction.
     LevelDbTransaction* txn_;
     Mutations::iterator mutations_iter_;
-    // We save the current key and value so that once an iterator is Valid(), it
-    // remains so at least until the next call to Seek() or Next(), even if the
-    // underlying data is deleted.
-    std::pair<std::string, std::string> current_;
-    // True if current_ represents an entry in the mutations_ map, rather than
+    // If the current entry comes from the mutations_ map, we save its key and
+    // value so that once an iterator is Valid(), it remains so at least until
+    // the next call to Seek() or Next(), even if the pending mutation is
+    // deleted. Committed entries are not copied: db_iter_ keeps them alive
+    // until it is moved.
+    std::pair<std::string, std::string> current_mutation_;
+    // True if the current entry is in the mutations_ map, rather than
     // committed data.
     bool is_mutation_;
     // True if the iterator pointed to a valid entry the last time Next() or
@@ -187,12 +191,22 @@ class LevelDbTransaction {
   /**
    * Commits the transaction. All pending changes are written. The transaction
    * should not be used after calling this method.
+   *
+   * If the database tracks its byte sizes (see LevelDbByteSizes), the running
+   * totals are adjusted by the size of the changes in the same write.
    */
   void Commit();
 
   std::string ToString();
 
  private:
+  /**
+   * Adds an update of the row storing the database's running byte sizes to
+   * the given batch, accounting for the pending changes in this transaction.
+   * Does nothing if the database does not track its byte sizes yet.
+   */
+  void UpdateByteSizes(leveldb::WriteBatch* batch);
+
   leveldb::DB* db_ = nullptr;
   Mutations mutations_;
   Deletions deletions_;
@@ -107,15 +107,24 @@ model::DocumentMap LocalDocumentsView::GetDocumentsMatchingCollectionGroupQuery(
   const std::string& collection_id = *query.collection_group();
   std::vector<ResourcePath> parents =
       index_manager_->GetCollectionParents(collection_id);
+  std::vector<ResourcePath> collections;
+  collections.reserve(parents.size());
+  for (const ResourcePath& parent : parents) {
+    collections.push_back(parent.Append(collection_id));
+  }
+
+  // Read the remote documents of all collections at once, so that the cache
+  // can scan them concurrently.
+  std::vector<MutableDocumentMap> remote_documents =
+      remote_document_cache_->GetAll(collections, offset);
   DocumentMap results;
 
   // Perform a collection query against each parent that contains the
   // collection_id and aggregate the results.
-  for (const ResourcePath& parent : parents) {
-    Query collection_query =
-        query.AsCollectionQueryAtPath(parent.Append(collection_id));
-    DocumentMap collection_results =
-        GetDocumentsMatchingCollectionQuery(collection_query, offset);
+  for (size_t i = 0; i != collections.size(); ++i) {
+    Query collection_query = query.AsCollectionQueryAtPath(collections[i]);
+    DocumentMap collection_results = GetDocumentsMatchingCollectionQuery(
+        collection_query, offset, std::move(remote_documents[i]));
     for (const auto& kv : collection_results) {
       const DocumentKey& key = kv.first;
       results = results.insert(key, Document(kv.second));
@@ -157,8 +166,14 @@ LocalWriteResult LocalDocumentsView::GetNextDocuments(
 
 DocumentMap LocalDocumentsView::GetDocumentsMatchingCollectionQuery(
     const Query& query, const IndexOffset& offset) {
-  MutableDocumentMap remote_documents =
-      remote_document_cache_->GetAll(query.path(), offset);
+  return GetDocumentsMatchingCollectionQuery(
+      query, offset, remote_document_cache_->GetAll(query.path(), offset));
+}
+
+DocumentMap LocalDocumentsView::GetDocumentsMatchingCollectionQuery(
+    const Query& query,
+    const IndexOffset& offset,
+    MutableDocumentMap remote_documents) {
   // Get locally persisted mutation batches.
   OverlayByDocumentKeyMap overlays = document_overlay_cache_->GetOverlays(
       query.path(), offset.largest_batch_id());
@@ -161,6 +161,15 @@ class LocalDocumentsView {
   model::DocumentMap GetDocumentsMatchingCollectionQuery(
       const core::Query& query, const model::IndexOffset& offset);
 
+  /**
+   * Overlays mutations on the given remote documents of the query's
+   * collection, which must have been read from `offset`.
+   */
+  model::DocumentMap GetDocumentsMatchingCollectionQuery(
+      const core::Query& query,
+      const model::IndexOffset& offset,
+      model::MutableDocumentMap remote_documents);
+
   RemoteDocumentCache* remote_document_cache() {
     return remote_document_cache_;
   }
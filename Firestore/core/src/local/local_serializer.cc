@@ -37,6 +37,8 @@
 #include "Firestore/core/src/model/mutable_document.h"
 #include "Firestore/core/src/model/mutation_batch.h"
 #include "Firestore/core/src/model/snapshot_version.h"
+#include "Firestore/core/src/nanopb/arena.h"
+#include "Firestore/core/src/nanopb/arena_decoder.h"
 #include "Firestore/core/src/nanopb/byte_string.h"
 #include "Firestore/core/src/nanopb/message.h"
 #include "Firestore/core/src/nanopb/nanopb_util.h"
@@ -63,6 +65,8 @@ using model::MutationBatch;
 using model::ObjectValue;
 using model::Segment;
 using model::SnapshotVersion;
+using nanopb::Arena;
+using nanopb::ArenaDecoder;
 using nanopb::ByteString;
 using nanopb::CheckedSize;
 using nanopb::CopyBytesArray;
@@ -112,8 +116,11 @@ MutableDocument LocalSerializer::DecodeMaybeDocument(
 
   switch (proto.which_document_type) {
     case firestore_client_MaybeDocument_document_tag:
-      return DecodeDocument(reader, proto.document,
-                            SafeReadBoolean(proto.has_committed_mutations));
+      return DecodeDocument(
+          reader, proto.document,
+          SafeReadBoolean(proto.has_committed_mutations),
+          ObjectValue::FromFieldsEntry(proto.document.fields,
+                                       proto.document.fields_count));
 
     case firestore_client_MaybeDocument_no_document_tag:
       return DecodeNoDocument(reader, proto.no_document,
@@ -135,6 +142,27 @@ MutableDocument LocalSerializer::DecodeMaybeDocument(
   UNREACHABLE();
 }
 
+MutableDocument LocalSerializer::DecodeMaybeDocumentLazily(
+    Reader* reader, absl::string_view bytes) const {
+  // Only the document's name and versions are decoded here.
+  Arena arena;
+  absl::string_view encoded_document;
+  firestore_client_MaybeDocument proto =
+      ArenaDecoder(reader->context(), &arena)
+          .DecodeMaybeDocumentWithoutFields(bytes, &encoded_document);
+  if (!reader->status().ok()) return {};
+
+  if (proto.which_document_type !=
+      firestore_client_MaybeDocument_document_tag) {
+    // Other document types have no fields to leave encoded.
+    return DecodeMaybeDocument(reader, proto);
+  }
+
+  return DecodeDocument(
+      reader, proto.document, SafeReadBoolean(proto.has_committed_mutations),
+      ObjectValue::FromEncodedDocument(std::string(encoded_document)));
+}
+
 google_firestore_v1_Document LocalSerializer::EncodeDocument(
     const MutableDocument& doc) const {
   google_firestore_v1_Document result{};
@@ -163,10 +191,9 @@ google_firestore_v1_Document LocalSerializer::EncodeDocument(
 
 MutableDocument LocalSerializer::DecodeDocument(
     Reader* reader,
-    google_firestore_v1_Document& proto,
-    bool has_committed_mutations) const {
-  ObjectValue fields =
-      ObjectValue::FromFieldsEntry(proto.fields, proto.fields_count);
+    const google_firestore_v1_Document& proto,
+    bool has_committed_mutations,
+    ObjectValue fields) const {
   SnapshotVersion version =
       rpc_serializer_.DecodeVersion(reader->context(), proto.update_time);
 
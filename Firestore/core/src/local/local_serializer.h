@@ -26,6 +26,7 @@
 #include "Firestore/core/src/model/types.h"
 #include "Firestore/core/src/remote/serializer.h"
 #include "Firestore/core/src/util/status_fwd.h"
+#include "absl/strings/string_view.h"
 
 namespace firebase {
 namespace firestore {
@@ -100,6 +101,15 @@ class LocalSerializer {
   model::MutableDocument DecodeMaybeDocument(
       nanopb::Reader* reader, firestore_client_MaybeDocument& proto) const;
 
+  /**
+   * Decodes the MaybeDocument proto encoded in `bytes` to the equivalent
+   * model. Unlike `DecodeMaybeDocument`, this leaves the fields of a document
+   * encoded until they are accessed, which is cheaper for documents that are
+   * only checked against a query.
+   */
+  model::MutableDocument DecodeMaybeDocumentLazily(
+      nanopb::Reader* reader, absl::string_view bytes) const;
+
   /**
    * @brief Encodes a TargetData to the equivalent nanopb proto, representing a
    * ::firestore::proto::Target, for local storage.
@@ -184,9 +194,15 @@ class LocalSerializer {
   google_firestore_v1_Document EncodeDocument(
       const model::MutableDocument& doc) const;
 
-  model::MutableDocument DecodeDocument(nanopb::Reader* reader,
-                                        google_firestore_v1_Document& proto,
-                                        bool has_committed_mutations) const;
+  /**
+   * Decodes a Document whose fields, which may still be encoded, have been
+   * decoded separately into `fields`.
+   */
+  model::MutableDocument DecodeDocument(
+      nanopb::Reader* reader,
+      const google_firestore_v1_Document& proto,
+      bool has_committed_mutations,
+      model::ObjectValue fields) const;
 
   firestore_client_NoDocument EncodeNoDocument(
       const model::MutableDocument& no_doc) const;
@@ -16,6 +16,7 @@
 
 #include "Firestore/core/src/local/local_store.h"
 
+#include <chrono>  // NOLINT(build/c++11)
 #include <set>
 #include <string>
 #include <unordered_set>
@@ -32,6 +33,7 @@
 #include "Firestore/core/src/local/persistence.h"
 #include "Firestore/core/src/local/query_engine.h"
 #include "Firestore/core/src/local/query_result.h"
+#include "Firestore/core/src/local/query_result_cache.h"
 #include "Firestore/core/src/local/reference_delegate.h"
 #include "Firestore/core/src/local/target_cache.h"
 #include "Firestore/core/src/model/document_key.h"
@@ -104,12 +106,15 @@ DocumentKeySet GetKeysWithTransformResults(
 
 LocalStore::LocalStore(Persistence* persistence,
                        QueryEngine* query_engine,
-                       const User& initial_user)
+                       const User& initial_user,
+                       size_t max_cached_query_results)
     : persistence_(persistence),
       remote_document_cache_(persistence->remote_document_cache()),
       target_cache_(persistence->target_cache()),
       bundle_cache_(persistence->bundle_cache()),
-      query_engine_(query_engine) {
+      query_engine_(query_engine),
+      query_results_(
+          absl::make_unique<QueryResultCache>(max_cached_query_results)) {
   index_manager_ = persistence->GetIndexManager(initial_user);
   mutation_queue_ = persistence->GetMutationQueue(initial_user, index_manager_);
   document_overlay_cache_ = persistence->GetDocumentOverlayCache(initial_user);
@@ -124,6 +129,11 @@ LocalStore::LocalStore(Persistence* persistence,
   target_id_generator_ = TargetIdGenerator::TargetCacheTargetIdGenerator(0);
   query_engine_->Initialize(local_documents_.get());
   index_backfiller_ = absl::make_unique<IndexBackfiller>();
+
+  // Without an LRU delegate, documents are garbage collected as soon as the
+  // last reference to them goes away.
+  eager_garbage_collection_ =
+      dynamic_cast<LruDelegate*>(persistence->reference_delegate()) == nullptr;
 }
 
 LocalStore::~LocalStore() = default;
@@ -157,6 +167,7 @@ DocumentMap LocalStore::HandleUserChange(const User& user) {
   mutation_queue_ = persistence_->GetMutationQueue(user, index_manager_);
   document_overlay_cache_ = persistence_->GetDocumentOverlayCache(user);
   remote_document_cache_->SetIndexManager(index_manager_);
+  query_results_->Clear();
 
   StartMutationQueue();
   StartIndexManager();
@@ -197,7 +208,7 @@ LocalWriteResult LocalStore::WriteLocally(std::vector<Mutation>&& mutations) {
     keys = keys.insert(mutation.key());
   }
 
-  return persistence_->Run("Locally write mutations", [&] {
+  LocalWriteResult result = persistence_->Run("Locally write mutations", [&] {
     // Figure out which keys do not have a remote version in the cache, this is
     // needed to create the right overlay mutation: if no remote version
     // presents, we do not need to create overlays as patch mutations.
@@ -247,11 +258,14 @@ LocalWriteResult LocalStore::WriteLocally(std::vector<Mutation>&& mutations) {
     return LocalWriteResult::FromOverlayedDocuments(
         batch.batch_id(), std::move(overlayed_documents));
   });
+
+  InvalidateQueryResults(keys);
+  return result;
 }
 
 DocumentMap LocalStore::AcknowledgeBatch(
     const MutationBatchResult& batch_result) {
-  return persistence_->Run("Acknowledge batch", [&] {
+  DocumentMap result = persistence_->Run("Acknowledge batch", [&] {
     const MutationBatch& batch = batch_result.batch();
     mutation_queue_->AcknowledgeBatch(batch, batch_result.stream_token());
     ApplyBatchResult(batch_result);
@@ -264,6 +278,9 @@ DocumentMap LocalStore::AcknowledgeBatch(
 
     return local_documents_->GetDocuments(batch.keys());
   });
+
+  InvalidateQueryResults(batch_result.batch().keys());
+  return result;
 }
 
 void LocalStore::ApplyBatchResult(const MutationBatchResult& batch_result) {
@@ -291,7 +308,8 @@ void LocalStore::ApplyBatchResult(const MutationBatchResult& batch_result) {
 }
 
 DocumentMap LocalStore::RejectBatch(BatchId batch_id) {
-  return persistence_->Run("Reject batch", [&] {
+  DocumentKeySet keys;
+  DocumentMap result = persistence_->Run("Reject batch", [&] {
     absl::optional<MutationBatch> to_reject =
         mutation_queue_->LookupMutationBatch(batch_id);
     HARD_ASSERT(to_reject.has_value(), "Attempt to reject nonexistent batch!");
@@ -302,8 +320,12 @@ DocumentMap LocalStore::RejectBatch(BatchId batch_id) {
     document_overlay_cache_->RemoveOverlaysForBatchId(batch_id);
     local_documents_->RecalculateAndSaveOverlays(to_reject.value().keys());
 
-    return local_documents_->GetDocuments(to_reject->keys());
+    keys = to_reject->keys();
+    return local_documents_->GetDocuments(keys);
   });
+
+  InvalidateQueryResults(keys);
+  return result;
 }
 
 ByteString LocalStore::GetLastStreamToken() {
@@ -324,7 +346,8 @@ model::DocumentMap LocalStore::ApplyRemoteEvent(
   const SnapshotVersion& last_remote_version =
       target_cache_->GetLastRemoteSnapshotVersion();
 
-  return persistence_->Run("Apply remote event", [&] {
+  DocumentKeySet changed_keys;
+  DocumentMap changes = persistence_->Run("Apply remote event", [&] {
     // TODO(gsoltis): move the sequence number into the reference delegate.
     ListenSequenceNumber sequence_number =
         persistence_->current_sequence_number();
@@ -347,6 +370,16 @@ model::DocumentMap LocalStore::ApplyRemoteEvent(
       target_cache_->RemoveMatchingKeys(change.removed_documents(), target_id);
       target_cache_->AddMatchingKeys(change.added_documents(), target_id);
 
+      if (!change.added_documents().empty() ||
+          !change.removed_documents().empty()) {
+        query_results_->InvalidateTarget(old_target_data.target());
+      }
+      if (eager_garbage_collection_) {
+        // Removing the documents from the target may have been the last
+        // reference to them.
+        changed_keys = changed_keys.union_with(change.removed_documents());
+      }
+
       TargetData new_target_data =
           old_target_data.WithSequenceNumber(sequence_number);
       if (remote_event.target_mismatches().find(target_id) !=
@@ -376,6 +409,7 @@ model::DocumentMap LocalStore::ApplyRemoteEvent(
       if (limbo_documents.contains(kv.first)) {
         persistence_->reference_delegate()->UpdateLimboDocument(kv.first);
       }
+      changed_keys = changed_keys.insert(kv.first);
     }
 
     auto result = PopulateDocumentChanges(remote_event.document_updates(),
@@ -398,6 +432,9 @@ model::DocumentMap LocalStore::ApplyRemoteEvent(
         std::move(result.changed_docs),
         std::move(result.existence_changed_keys));
   });
+
+  InvalidateQueryResults(changed_keys);
+  return changes;
 }
 
 bool LocalStore::ShouldPersistTargetData(const TargetData& new_target_data,
@@ -446,6 +483,9 @@ void LocalStore::NotifyLocalViewChanges(
       for (const DocumentKey& key : view_change.removed_keys()) {
         persistence_->reference_delegate()->RemoveReference(key);
       }
+      if (eager_garbage_collection_) {
+        query_results_->InvalidateDocuments(view_change.removed_keys());
+      }
       local_view_references_.AddReferences(view_change.added_keys(), target_id);
       local_view_references_.RemoveReferences(view_change.removed_keys(),
                                               target_id);
@@ -530,6 +570,13 @@ void LocalStore::ReleaseTarget(TargetId target_id) {
       persistence_->reference_delegate()->RemoveReference(key);
     }
 
+    query_results_->InvalidateTarget(target_data.target());
+    if (eager_garbage_collection_) {
+      // The documents of the target may be collected along with it.
+      query_results_->InvalidateDocuments(removed.union_with(
+          target_cache_->GetMatchingKeys(target_data.target_id())));
+    }
+
     // Note: This also updates the target cache.
     persistence_->reference_delegate()->RemoveTarget(target_data);
     target_data_by_target_.erase(target_id);
@@ -540,7 +587,20 @@ void LocalStore::ReleaseTarget(TargetId target_id) {
 QueryResult LocalStore::ExecuteQuery(const Query& query,
                                      bool use_previous_results) {
   return persistence_->Run("ExecuteQuery", [&] {
-    absl::optional<TargetData> target_data = GetTargetData(query.ToTarget());
+    const Target& target = query.ToTarget();
+    SnapshotVersion version;
+    BatchId batch_id = model::kBatchIdUnknown;
+    if (query_results_->enabled()) {
+      version = target_cache_->GetLastRemoteSnapshotVersion();
+      batch_id = mutation_queue_->GetHighestUnacknowledgedBatchId();
+      absl::optional<QueryResult> cached =
+          query_results_->Get(target, version, batch_id);
+      if (cached) {
+        return std::move(*cached);
+      }
+    }
+
+    absl::optional<TargetData> target_data = GetTargetData(target);
     SnapshotVersion last_limbo_free_snapshot_version;
     DocumentKeySet remote_keys;
 
@@ -555,7 +615,9 @@ QueryResult LocalStore::ExecuteQuery(const Query& query,
         use_previous_results ? last_limbo_free_snapshot_version
                              : SnapshotVersion::None(),
         use_previous_results ? remote_keys : DocumentKeySet{});
-    return QueryResult(std::move(documents), std::move(remote_keys));
+    QueryResult result(std::move(documents), std::move(remote_keys));
+    query_results_->Put(target, version, batch_id, result);
+    return result;
   });
 }
 
@@ -566,15 +628,28 @@ DocumentKeySet LocalStore::GetRemoteDocumentKeys(TargetId target_id) {
 }
 
 LruResults LocalStore::CollectGarbage(LruGarbageCollector* garbage_collector) {
-  return persistence_->Run("Collect garbage", [&] {
+  LruResults results = persistence_->Run("Collect garbage", [&] {
     return garbage_collector->Collect(target_data_by_target_);
   });
+  if (results.documents_removed > 0 || results.targets_removed > 0) {
+    query_results_->Clear();
+  }
+  return results;
 }
 
 int LocalStore::Backfill() const {
-  return persistence_->Run("Backfill Indexes", [&] {
+  auto start = std::chrono::steady_clock::now();
+  int documents_processed = persistence_->Run("Backfill Indexes", [&] {
     return index_backfiller_->WriteIndexEntries(this);
   });
+  index_backfiller_->AdjustBatchSize(
+      std::chrono::duration_cast<std::chrono::milliseconds>(
+          std::chrono::steady_clock::now() - start));
+  return documents_processed;
+}
+
+const IndexBackfillProgress& LocalStore::index_backfill_progress() const {
+  return index_backfiller_->progress();
 }
 
 bool LocalStore::HasNewerBundle(const bundle::BundleMetadata& metadata) {
@@ -591,12 +666,22 @@ void LocalStore::SaveBundle(const bundle::BundleMetadata& metadata) {
       "Save bundle", [&] { bundle_cache_->SaveBundleMetadata(metadata); });
 }
 
+void LocalStore::ResetBundleTarget(const std::string& bundle_id) {
+  TargetData umbrella_target = AllocateTarget(NewUmbrellaTarget(bundle_id));
+  persistence_->Run("Reset bundle target", [&] {
+    target_cache_->RemoveMatchingKeysForTarget(umbrella_target.target_id());
+  });
+}
+
 DocumentMap LocalStore::ApplyBundledDocuments(
     const MutableDocumentMap& bundled_documents, const std::string& bundle_id) {
   // Allocates a target to hold all document keys from the bundle, such that
-  // they will not get garbage collected right away.
+  // they will not get garbage collected right away. Large bundles are applied
+  // in several chunks, so keys are only added to the target here; it is reset
+  // once per load by `ResetBundleTarget`.
   TargetData umbrella_target = AllocateTarget(NewUmbrellaTarget(bundle_id));
-  return persistence_->Run("Apply bundle documents", [&] {
+  DocumentKeySet changed_keys;
+  DocumentMap changes = persistence_->Run("Apply bundle documents", [&] {
     DocumentKeySet keys;
     DocumentUpdateMap document_updates;
     DocumentVersionMap versions;
@@ -609,9 +694,9 @@ DocumentMap LocalStore::ApplyBundledDocuments(
       }
       document_updates.emplace(key, doc);
       versions.emplace(key, doc.version());
+      changed_keys = changed_keys.insert(key);
     }
 
-    target_cache_->RemoveMatchingKeysForTarget(umbrella_target.target_id());
     target_cache_->AddMatchingKeys(keys, umbrella_target.target_id());
 
     auto result = PopulateDocumentChanges(document_updates, versions,
@@ -620,6 +705,9 @@ DocumentMap LocalStore::ApplyBundledDocuments(
         std::move(result.changed_docs),
         std::move(result.existence_changed_keys));
   });
+
+  InvalidateQueryResults(changed_keys);
+  return changes;
 }
 
 void LocalStore::SaveNamedQuery(const bundle::NamedQuery& query,
@@ -643,6 +731,7 @@ void LocalStore::SaveNamedQuery(const bundle::NamedQuery& query,
       target_data_by_target_.emplace(target_id, std::move(new_target_data));
       target_cache_->RemoveMatchingKeysForTarget(target_id);
       target_cache_->AddMatchingKeys(keys, target_id);
+      query_results_->InvalidateTarget(existing.target());
     }
 
     bundle_cache_->SaveNamedQuery(query);
@@ -690,6 +779,16 @@ void LocalStore::ConfigureFieldIndexes(
   });
 }
 
+void LocalStore::InvalidateQueryResults(const DocumentKeySet& keys) {
+  if (!query_results_->enabled()) {
+    return;
+  }
+
+  query_results_->InvalidateDocuments(keys);
+  query_results_->AdvanceTo(GetLastRemoteSnapshotVersion(),
+                            GetHighestUnacknowledgedBatchId());
+}
+
 Target LocalStore::NewUmbrellaTarget(const std::string& bundle_id) {
   // It is OK that the path used for the query is not valid, because this will
   // not be read and queried.
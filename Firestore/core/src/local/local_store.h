@@ -66,10 +66,12 @@ class MutationQueue;
 class Persistence;
 class QueryEngine;
 class QueryResult;
+class QueryResultCache;
 class RemoteDocumentCache;
 class TargetCache;
 class IndexBackfiller;
 
+struct IndexBackfillProgress;
 struct LruResults;
 
 /**
@@ -114,9 +116,17 @@ struct LruResults;
  */
 class LocalStore : public bundle::BundleCallback {
  public:
+  /**
+   * Creates a new LocalStore.
+   *
+   * @param max_cached_query_results The number of `ExecuteQuery` results to
+   *     keep in memory for reuse while nothing they depend on changes. 0
+   *     disables the cache.
+   */
   LocalStore(Persistence* persistence,
              QueryEngine* query_engine,
-             const credentials::User& initial_user);
+             const credentials::User& initial_user,
+             size_t max_cached_query_results = 0);
 
   ~LocalStore();
 
@@ -256,6 +266,9 @@ class LocalStore : public bundle::BundleCallback {
    */
   int Backfill() const;
 
+  /** Returns how far backfilling indexes has progressed. */
+  const IndexBackfillProgress& index_backfill_progress() const;
+
   /**
    * Returns whether the given bundle has already been loaded and its create
    * time is newer or equal to the currently loading bundle.
@@ -265,6 +278,14 @@ class LocalStore : public bundle::BundleCallback {
   /** Saves the given `BundleMetadata` to local persistence. */
   void SaveBundle(const bundle::BundleMetadata& metadata) override;
 
+  /**
+   * Releases the documents of any earlier load of the given bundle from the
+   * target that keeps them from being garbage collected. Must be called once
+   * before the documents of the bundle are applied, since large bundles are
+   * applied in several chunks that each add to this target.
+   */
+  void ResetBundleTarget(const std::string& bundle_id);
+
   /**
    * Applies the documents from a bundle to the "ground-state" (remote)
    * documents.
@@ -288,6 +309,11 @@ class LocalStore : public bundle::BundleCallback {
 
   void ConfigureFieldIndexes(std::vector<model::FieldIndex> new_field_indexes);
 
+  /** The cache of query results, for its hit and miss counts. */
+  const QueryResultCache& query_result_cache() const {
+    return *query_results_;
+  }
+
  private:
   friend class IndexBackfiller;
   friend class IndexBackfillerTest;
@@ -366,6 +392,13 @@ class LocalStore : public bundle::BundleCallback {
       const model::DocumentVersionMap& document_versions,
       const model::SnapshotVersion& global_version);
 
+  /**
+   * Drops the cached query results that changes to the given documents may
+   * have affected, and marks all others as current. Must be called after the
+   * changes have been committed.
+   */
+  void InvalidateQueryResults(const model::DocumentKeySet& keys);
+
   // For testing
   std::vector<model::FieldIndex> GetFieldIndexes();
 
@@ -431,6 +464,15 @@ class LocalStore : public bundle::BundleCallback {
 
   /** Maps a target to its targetID. */
   std::unordered_map<core::Target, model::TargetId> target_id_by_target_;
+
+  /** Recent results of `ExecuteQuery`. */
+  std::unique_ptr<QueryResultCache> query_results_;
+
+  /**
+   * Whether documents are removed from the cache as soon as nothing references
+   * them, rather than by an LRU garbage collector.
+   */
+  bool eager_garbage_collection_ = false;
 };
 
 }  // namespace local
@@ -138,7 +138,8 @@ LruResults LruGarbageCollector::Collect(const LiveQueryMap& live_targets) {
     return LruResults::DidNotRun();
   }
 
-  LOG_DEBUG("Running garbage collection on cache of size: %s", current_size);
+  LOG_DEBUG("Running garbage collection on cache of size: %s",
+            delegate_->DescribeByteSize());
   return RunGarbageCollection(live_targets);
 }
 
@@ -17,6 +17,7 @@
 #ifndef FIRESTORE_CORE_SRC_LOCAL_LRU_GARBAGE_COLLECTOR_H_
 #define FIRESTORE_CORE_SRC_LOCAL_LRU_GARBAGE_COLLECTOR_H_
 
+#include <string>
 #include <unordered_map>
 
 #include "Firestore/core/src/local/reference_delegate.h"
@@ -74,6 +75,12 @@ class LruDelegate : public ReferenceDelegate {
 
   virtual util::StatusOr<int64_t> CalculateByteSize() = 0;
 
+  /**
+   * Returns a human readable breakdown of the bytes counted by
+   * CalculateByteSize(), suitable for logging.
+   */
+  virtual std::string DescribeByteSize() = 0;
+
   /** Returns the number of targets and orphaned documents cached. */
   virtual size_t GetSequenceNumberCount() = 0;
 
@@ -74,11 +74,11 @@ OverlayByDocumentKeyMap MemoryDocumentOverlayCache::GetOverlays(
     ++overlays_iter;
 
     const DocumentKey& key = overlay.key();
-    if (!collection.IsPrefixOf(key.path())) {
+    if (!key.HasPrefix(collection)) {
       break;
     }
     // Documents from sub-collections
-    if (key.path().size() != immediate_children_path_length) {
+    if (key.path_size() != immediate_children_path_length) {
       continue;
     }
 
@@ -116,6 +116,12 @@ MemoryIndexManager::GetDocumentsMatchingTarget(const core::Target& target) {
   return {};
 }
 
+bool MemoryIndexManager::ScanDocumentsMatchingTarget(
+    const core::Target&,
+    const std::function<bool(const model::DocumentKey&)>&) {
+  return false;
+}
+
 absl::optional<std::string> MemoryIndexManager::GetNextCollectionGroupToUpdate()
     const {
   return absl::nullopt;
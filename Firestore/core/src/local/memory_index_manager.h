@@ -17,6 +17,7 @@
 #ifndef FIRESTORE_CORE_SRC_LOCAL_MEMORY_INDEX_MANAGER_H_
 #define FIRESTORE_CORE_SRC_LOCAL_MEMORY_INDEX_MANAGER_H_
 
+#include <functional>
 #include <set>
 #include <string>
 #include <unordered_map>
@@ -79,6 +80,10 @@ class MemoryIndexManager : public IndexManager {
   absl::optional<std::vector<model::DocumentKey>> GetDocumentsMatchingTarget(
       const core::Target& target) override;
 
+  bool ScanDocumentsMatchingTarget(
+      const core::Target& target,
+      const std::function<bool(const model::DocumentKey&)>& callback) override;
+
   absl::optional<std::string> GetNextCollectionGroupToUpdate() const override;
 
   void UpdateCollectionGroup(const std::string& collection_group,
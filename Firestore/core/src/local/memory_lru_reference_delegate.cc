@@ -29,6 +29,7 @@
 #include "Firestore/core/src/local/target_data.h"
 #include "Firestore/core/src/util/statusor.h"
 #include "absl/memory/memory.h"
+#include "absl/strings/str_cat.h"
 
 namespace firebase {
 namespace firestore {
@@ -189,6 +190,19 @@ StatusOr<int64_t> MemoryLruReferenceDelegate::CalculateByteSize() {
   return count;
 }
 
+std::string MemoryLruReferenceDelegate::DescribeByteSize() {
+  int64_t targets = persistence_->target_cache()->CalculateByteSize(*sizer_);
+  int64_t documents =
+      persistence_->remote_document_cache()->CalculateByteSize(*sizer_);
+  int64_t mutations = 0;
+  for (const auto& entry : persistence_->mutation_queues()) {
+    mutations += entry.second->CalculateByteSize(*sizer_);
+  }
+  return absl::StrCat(targets + documents + mutations,
+                      " bytes (documents: ", documents, ", targets: ", targets,
+                      ", mutations: ", mutations, ")");
+}
+
 }  // namespace local
 }  // namespace firestore
 }  // namespace firebase
@@ -18,6 +18,7 @@
 #define FIRESTORE_CORE_SRC_LOCAL_MEMORY_LRU_REFERENCE_DELEGATE_H_
 
 #include <memory>
+#include <string>
 #include <unordered_map>
 #include <utility>
 
@@ -66,6 +67,7 @@ class MemoryLruReferenceDelegate : public LruDelegate {
   LruGarbageCollector* garbage_collector() override;
 
   util::StatusOr<int64_t> CalculateByteSize() override;
+  std::string DescribeByteSize() override;
   size_t GetSequenceNumberCount() override;
 
   void EnumerateTargetSequenceNumbers(
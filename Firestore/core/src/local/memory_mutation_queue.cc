@@ -187,8 +187,8 @@ MemoryMutationQueue::AllMutationBatchesAffectingQuery(const Query& query) {
   // query.
   std::set<BatchId> unique_batch_ids;
   for (const auto& reference : batches_by_document_key_.values_from(start)) {
-    const ResourcePath& row_key_path = reference.key().path();
-    if (!prefix.IsPrefixOf(row_key_path)) {
+    const DocumentKey& row_key = reference.key();
+    if (!row_key.HasPrefix(prefix)) {
       break;
     }
 
@@ -197,7 +197,7 @@ MemoryMutationQueue::AllMutationBatchesAffectingQuery(const Query& query) {
     // document /rooms/abc/messages/xyx.
     // TODO(mcg): we'll need a different scanner when we implement ancestor
     // queries.
-    if (row_key_path.size() != immediate_children_path_length) {
+    if (row_key.path_size() != immediate_children_path_length) {
       continue;
     }
 
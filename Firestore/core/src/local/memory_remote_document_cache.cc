@@ -95,11 +95,11 @@ MutableDocumentMap MemoryRemoteDocumentCache::GetAll(
   size_t immediate_children_path_length = path.size() + 1;
   for (auto it = docs_.lower_bound(prefix); it != docs_.end(); ++it) {
     const DocumentKey& key = it->first;
-    if (!path.IsPrefixOf(key.path())) {
+    if (!key.HasPrefix(path)) {
       break;
     }
     const MutableDocument& document = it->second;
-    if (key.path().size() > immediate_children_path_length) {
+    if (key.path_size() > immediate_children_path_length) {
       // Exclude entries from subcollections.
       continue;
     }
@@ -117,6 +117,17 @@ MutableDocumentMap MemoryRemoteDocumentCache::GetAll(
   return results;
 }
 
+std::vector<MutableDocumentMap> MemoryRemoteDocumentCache::GetAll(
+    const std::vector<model::ResourcePath>& collections,
+    const model::IndexOffset& offset) const {
+  std::vector<MutableDocumentMap> results;
+  results.reserve(collections.size());
+  for (const model::ResourcePath& path : collections) {
+    results.push_back(GetAll(path, offset, absl::nullopt));
+  }
+  return results;
+}
+
 std::vector<DocumentKey> MemoryRemoteDocumentCache::RemoveOrphanedDocuments(
     MemoryLruReferenceDelegate* reference_delegate,
     ListenSequenceNumber upper_bound) {
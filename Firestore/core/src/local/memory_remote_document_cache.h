@@ -54,6 +54,9 @@ class MemoryRemoteDocumentCache : public RemoteDocumentCache {
   model::MutableDocumentMap GetAll(const model::ResourcePath& path,
                                    const model::IndexOffset& offset,
                                    absl::optional<size_t>) const override;
+  std::vector<model::MutableDocumentMap> GetAll(
+      const std::vector<model::ResourcePath>& collections,
+      const model::IndexOffset& offset) const override;
   void SetIndexManager(IndexManager* manager) override;
 
   std::vector<model::DocumentKey> RemoveOrphanedDocuments(
@@ -35,6 +35,7 @@ namespace local {
 using core::LimitType;
 using core::Query;
 using model::Document;
+using model::DocumentKey;
 using model::DocumentKeySet;
 using model::DocumentMap;
 using model::DocumentSet;
@@ -98,6 +99,14 @@ const absl::optional<DocumentMap> QueryEngine::PerformQueryUsingIndex(
     return PerformQueryUsingIndex(query_with_limit);
   }
 
+  if (query.has_limit()) {
+    absl::optional<DocumentMap> limit_result =
+        PerformLimitQueryInIndexOrder(query);
+    if (limit_result.has_value()) {
+      return limit_result;
+    }
+  }
+
   auto keys = index_manager_->GetDocumentsMatchingTarget(target);
   HARD_ASSERT(
       keys.has_value(),
@@ -128,6 +137,76 @@ const absl::optional<DocumentMap> QueryEngine::PerformQueryUsingIndex(
   return AppendRemainingResults(previous_results, query, offset);
 }
 
+absl::optional<DocumentMap> QueryEngine::PerformLimitQueryInIndexOrder(
+    const Query& query) const {
+  const core::Target& target = query.ToTarget();
+  const model::IndexOffset offset = index_manager_->GetMinOffset(target);
+  const size_t limit = static_cast<size_t>(query.limit());
+
+  // Documents that were read after the index offset may still be indexed at
+  // their old position, whatever their update version is. They are all part of
+  // the results if they match, so read them up front.
+  DocumentMap remaining_results =
+      local_documents_view_->GetDocumentsMatchingQuery(query, offset);
+
+  DocumentSet results(query.Comparator());
+  size_t settled_count = 0;
+  std::vector<DocumentKey> batch;
+
+  // Loads the documents in `batch` with their local mutations applied and
+  // keeps the ones that still match. Only documents that cannot have changed
+  // since they were indexed are known to sit at their index position, so only
+  // they count towards the limit. Any other document that belongs in the
+  // results is either read here or is one of `remaining_results`.
+  auto load_batch = [&] {
+    DocumentKeySet keys;
+    for (const DocumentKey& key : batch) {
+      keys = keys.insert(key);
+    }
+    batch.clear();
+
+    for (const auto& entry : local_documents_view_->GetDocuments(keys)) {
+      const Document& doc = entry.second;
+      if (!doc->is_found_document() || !query.Matches(doc)) {
+        continue;
+      }
+
+      results = results.insert(doc);
+      if (!doc->has_pending_writes() &&
+          !remaining_results.contains(doc->key())) {
+        ++settled_count;
+      }
+    }
+  };
+
+  bool scanned = index_manager_->ScanDocumentsMatchingTarget(
+      target, [&](const DocumentKey& key) {
+        // Read documents in batches of the number still missing, which is
+        // all of them unless local changes moved some of them.
+        batch.push_back(key);
+        if (settled_count + batch.size() < limit) {
+          return true;
+        }
+        load_batch();
+        return settled_count < limit;
+      });
+  if (!scanned) {
+    return absl::nullopt;
+  }
+  if (!batch.empty()) {
+    load_batch();
+  }
+
+  LOG_DEBUG("Read %s documents from index to execute limit query: %s",
+            results.size(), query.ToString());
+
+  // If a document is in both, its contents are the same.
+  for (const Document& doc : results) {
+    remaining_results = remaining_results.insert(doc->key(), doc);
+  }
+  return remaining_results;
+}
+
 const absl::optional<DocumentMap> QueryEngine::PerformQueryUsingRemoteKeys(
     const Query& query,
     const DocumentKeySet& remote_keys,
@@ -86,6 +86,15 @@ class QueryEngine {
   const absl::optional<model::DocumentMap> PerformQueryUsingIndex(
       const core::Query& query) const;
 
+  /**
+   * Performs a limit query that a full index serves in query order by reading
+   * documents in index order until the limit is reached, so that only about
+   * `limit` documents are loaded. Returns nullopt if the index cannot produce
+   * the query's results in order.
+   */
+  absl::optional<model::DocumentMap> PerformLimitQueryInIndexOrder(
+      const core::Query& query) const;
+
   /**
    * Performs a query based on the target's persisted query mapping. Returns
    * nullopt if the mapping is not available or cannot be used.
@@ -0,0 +1,148 @@
+/*
+ * Copyright 2022 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Firestore/core/src/local/query_result_cache.h"
+
+#include <iterator>
+#include <utility>
+
+#include "Firestore/core/src/model/document_key.h"
+#include "Firestore/core/src/model/resource_path.h"
+
+namespace firebase {
+namespace firestore {
+namespace local {
+
+using core::Target;
+using model::BatchId;
+using model::DocumentKey;
+using model::DocumentKeySet;
+using model::ResourcePath;
+using model::SnapshotVersion;
+
+QueryResultCache::QueryResultCache(size_t max_entries)
+    : max_entries_(max_entries) {
+}
+
+absl::optional<QueryResult> QueryResultCache::Get(
+    const Target& target, const SnapshotVersion& version, BatchId batch_id) {
+  if (!enabled()) {
+    return absl::nullopt;
+  }
+
+  if (version != version_ || batch_id != batch_id_) {
+    // Something changed without invalidating the results it affected, so none
+    // of them can be trusted anymore.
+    Clear();
+    ++misses_;
+    return absl::nullopt;
+  }
+
+  auto found = entries_by_id_.find(target.CanonicalId());
+  if (found == entries_by_id_.end() || found->second->target != target) {
+    ++misses_;
+    return absl::nullopt;
+  }
+
+  ++hits_;
+  entries_.splice(entries_.begin(), entries_, found->second);
+  return found->second->result;
+}
+
+void QueryResultCache::Put(const Target& target,
+                           const SnapshotVersion& version,
+                           BatchId batch_id,
+                           QueryResult result) {
+  if (!enabled()) {
+    return;
+  }
+
+  if (version != version_ || batch_id != batch_id_) {
+    Clear();
+    version_ = version;
+    batch_id_ = batch_id;
+  }
+
+  auto found = entries_by_id_.find(target.CanonicalId());
+  if (found != entries_by_id_.end()) {
+    Erase(found->second);
+  }
+
+  entries_.push_front(Entry{target, std::move(result)});
+  entries_by_id_[target.CanonicalId()] = entries_.begin();
+
+  if (entries_.size() > max_entries_) {
+    Erase(std::prev(entries_.end()));
+  }
+}
+
+void QueryResultCache::InvalidateDocuments(const DocumentKeySet& keys) {
+  if (keys.empty()) {
+    return;
+  }
+
+  for (auto entry = entries_.begin(); entry != entries_.end();) {
+    auto current = entry++;
+    for (const DocumentKey& key : keys) {
+      if (MayContain(current->target, key)) {
+        Erase(current);
+        break;
+      }
+    }
+  }
+}
+
+void QueryResultCache::InvalidateTarget(const Target& target) {
+  auto found = entries_by_id_.find(target.CanonicalId());
+  if (found != entries_by_id_.end()) {
+    Erase(found->second);
+  }
+}
+
+void QueryResultCache::Clear() {
+  entries_.clear();
+  entries_by_id_.clear();
+}
+
+void QueryResultCache::AdvanceTo(const SnapshotVersion& version,
+                                 BatchId batch_id) {
+  version_ = version;
+  batch_id_ = batch_id;
+}
+
+bool QueryResultCache::MayContain(const Target& target,
+                                  const DocumentKey& key) {
+  // Mirrors `Query::MatchesPathAndCollectionGroup`. Filters are ignored since
+  // a changed document may have started or stopped matching them.
+  const ResourcePath& path = target.path();
+  if (target.collection_group()) {
+    return key.HasCollectionGroup(*target.collection_group()) &&
+           key.HasPrefix(path);
+  } else if (target.IsDocumentQuery()) {
+    return key.path_size() == path.size() && key.HasPrefix(path);
+  } else {
+    return key.path_size() == path.size() + 1 && key.HasPrefix(path);
+  }
+}
+
+void QueryResultCache::Erase(EntryList::iterator entry) {
+  entries_by_id_.erase(entry->target.CanonicalId());
+  entries_.erase(entry);
+}
+
+}  // namespace local
+}  // namespace firestore
+}  // namespace firebase
@@ -0,0 +1,146 @@
+/*
+ * Copyright 2022 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef FIRESTORE_CORE_SRC_LOCAL_QUERY_RESULT_CACHE_H_
+#define FIRESTORE_CORE_SRC_LOCAL_QUERY_RESULT_CACHE_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <string>
+#include <unordered_map>
+
+#include "Firestore/core/src/core/target.h"
+#include "Firestore/core/src/local/query_result.h"
+#include "Firestore/core/src/model/document_key_set.h"
+#include "Firestore/core/src/model/mutation_batch.h"
+#include "Firestore/core/src/model/snapshot_version.h"
+#include "Firestore/core/src/model/types.h"
+#include "absl/types/optional.h"
+
+namespace firebase {
+namespace firestore {
+namespace local {
+
+/**
+ * A bounded, in-memory cache of the results of `LocalStore::ExecuteQuery`,
+ * keyed by the canonical ID of the executed target.
+ *
+ * The cached results are stamped with the last remote snapshot version and the
+ * highest unacknowledged batch ID they were computed at, and are only returned
+ * while both still match. `LocalStore` keeps unaffected results alive across
+ * changes by dropping the ones a change might affect and then advancing the
+ * stamp of the others, so anything that changes local state without telling
+ * the cache only results in misses, never in stale results.
+ *
+ * When full, the least recently used entry is evicted.
+ */
+class QueryResultCache {
+ public:
+  /**
+   * Creates a cache holding at most `max_entries` results. A cache with no
+   * entries is disabled: it never stores anything and doesn't count lookups.
+   */
+  explicit QueryResultCache(size_t max_entries = 0);
+
+  bool enabled() const {
+    return max_entries_ > 0;
+  }
+
+  size_t size() const {
+    return entries_.size();
+  }
+
+  /** The number of lookups that returned a cached result. */
+  int64_t hits() const {
+    return hits_;
+  }
+
+  /** The number of lookups that found no usable result. */
+  int64_t misses() const {
+    return misses_;
+  }
+
+  /**
+   * Returns the cached result of `target`, provided it was computed at the
+   * given remote snapshot version and highest batch ID.
+   */
+  absl::optional<QueryResult> Get(const core::Target& target,
+                                  const model::SnapshotVersion& version,
+                                  model::BatchId batch_id);
+
+  /**
+   * Caches the result of `target`, computed at the given remote snapshot
+   * version and highest batch ID. Results computed at a different stamp are
+   * dropped.
+   */
+  void Put(const core::Target& target,
+           const model::SnapshotVersion& version,
+           model::BatchId batch_id,
+           QueryResult result);
+
+  /**
+   * Drops the results of all targets that could contain any of the given
+   * documents.
+   */
+  void InvalidateDocuments(const model::DocumentKeySet& keys);
+
+  /** Drops the result of `target`, e.g. because its remote keys changed. */
+  void InvalidateTarget(const core::Target& target);
+
+  /** Drops all results. */
+  void Clear();
+
+  /**
+   * Marks all remaining results as current at the given remote snapshot
+   * version and highest batch ID. Must only be called once all results that
+   * might have changed since they were stamped have been invalidated.
+   */
+  void AdvanceTo(const model::SnapshotVersion& version,
+                 model::BatchId batch_id);
+
+ private:
+  struct Entry {
+    core::Target target;
+    QueryResult result;
+  };
+
+  using EntryList = std::list<Entry>;
+
+  /** Whether a document with the given key could match `target`. */
+  static bool MayContain(const core::Target& target,
+                         const model::DocumentKey& key);
+
+  void Erase(EntryList::iterator entry);
+
+  size_t max_entries_ = 0;
+
+  model::SnapshotVersion version_;
+  model::BatchId batch_id_ = model::kBatchIdUnknown;
+
+  /** The cached results, most recently used first. */
+  EntryList entries_;
+  std::unordered_map<std::string, EntryList::iterator> entries_by_id_;
+
+  int64_t hits_ = 0;
+  int64_t misses_ = 0;
+};
+
+}  // namespace local
+}  // namespace firestore
+}  // namespace firebase
+
+#endif  // FIRESTORE_CORE_SRC_LOCAL_QUERY_RESULT_CACHE_H_
@@ -18,6 +18,7 @@
 #define FIRESTORE_CORE_SRC_LOCAL_REMOTE_DOCUMENT_CACHE_H_
 
 #include <string>
+#include <vector>
 
 #include "Firestore/core/src/model/model_fwd.h"
 
@@ -112,6 +113,20 @@ class RemoteDocumentCache {
       const model::IndexOffset& offset,
       absl::optional<size_t> limit = absl::nullopt) const = 0;
 
+  /**
+   * Executes `GetAll(path, offset)` for each of the given collection paths.
+   * Implementations may scan the collections concurrently.
+   *
+   * @param collections The collection paths to match documents against.
+   * @param offset The read time and document key to start scanning at
+   * (exclusive).
+   * @return The matching documents of each collection, in the same order as
+   * `collections`.
+   */
+  virtual std::vector<model::MutableDocumentMap> GetAll(
+      const std::vector<model::ResourcePath>& collections,
+      const model::IndexOffset& offset) const = 0;
+
   /**
    * Sets the index manager used by remote document cache.
    *
@@ -16,8 +16,14 @@
 
 #include "Firestore/core/src/model/document_key.h"
 
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <new>
 #include <ostream>
 #include <utility>
+#include <vector>
 
 #include "Firestore/core/src/model/resource_path.h"
 #include "Firestore/core/src/util/comparison.h"
@@ -34,19 +40,150 @@ void AssertValidPath(const ResourcePath& path) {
               path.CanonicalString());
 }
 
+size_t EmptyPathHash() {
+  static const size_t hash = ResourcePath{}.Hash();
+  return hash;
+}
+
 }  // namespace
 
-DocumentKey::DocumentKey() : path_{std::make_shared<ResourcePath>()} {
+/**
+ * The packed form of a non-empty document key path: this header is directly
+ * followed by the end offset of each segment and then by the bytes of all
+ * segments, back to back, in a single allocation.
+ */
+class DocumentKey::Rep {
+ public:
+  static Rep* Create(const ResourcePath& path) {
+    static_assert(sizeof(Rep) % alignof(uint32_t) == 0,
+                  "Segment offsets must be aligned");
+
+    size_t segment_count = path.size();
+    size_t byte_count = 0;
+    for (const std::string& segment : path) {
+      byte_count += segment.size();
+    }
+    HARD_ASSERT(byte_count <= UINT32_MAX, "Document key is too long");
+
+    void* memory = ::operator new(sizeof(Rep) +
+                                  segment_count * sizeof(uint32_t) +
+                                  byte_count);
+    Rep* rep =
+        new (memory) Rep(static_cast<uint32_t>(segment_count), path.Hash());
+
+    uint32_t* ends = rep->ends();
+    char* bytes = rep->bytes();
+    uint32_t end = 0;
+    for (size_t i = 0; i < segment_count; ++i) {
+      const std::string& segment = path[i];
+      std::memcpy(bytes + end, segment.data(), segment.size());
+      end += static_cast<uint32_t>(segment.size());
+      ends[i] = end;
+    }
+    return rep;
+  }
+
+  void Ref() {
+    ref_count_.fetch_add(1, std::memory_order_relaxed);
+  }
+
+  void Unref() {
+    if (ref_count_.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+      this->~Rep();
+      ::operator delete(this);
+    }
+  }
+
+  size_t segment_count() const {
+    return segment_count_;
+  }
+
+  size_t hash() const {
+    return hash_;
+  }
+
+  absl::string_view segment(size_t i) const {
+    uint32_t begin = i == 0 ? 0 : ends()[i - 1];
+    return absl::string_view(bytes() + begin, ends()[i] - begin);
+  }
+
+ private:
+  Rep(uint32_t segment_count, size_t hash)
+      : segment_count_(segment_count), hash_(hash) {
+  }
+
+  const uint32_t* ends() const {
+    return reinterpret_cast<const uint32_t*>(this + 1);
+  }
+  uint32_t* ends() {
+    return reinterpret_cast<uint32_t*>(this + 1);
+  }
+
+  const char* bytes() const {
+    return reinterpret_cast<const char*>(ends() + segment_count_);
+  }
+  char* bytes() {
+    return reinterpret_cast<char*>(ends() + segment_count_);
+  }
+
+  std::atomic<uint32_t> ref_count_{1};
+  uint32_t segment_count_ = 0;
+  size_t hash_ = 0;
+};
+
+DocumentKey::DocumentKey() = default;
+
+DocumentKey::DocumentKey(const ResourcePath& path) {
+  AssertValidPath(path);
+  if (!path.empty()) {
+    rep_ = Rep::Create(path);
+  }
+}
+
+DocumentKey::DocumentKey(ResourcePath&& path) {
+  ResourcePath consumed = std::move(path);
+  AssertValidPath(consumed);
+  if (!consumed.empty()) {
+    rep_ = Rep::Create(consumed);
+  }
+}
+
+DocumentKey::DocumentKey(const DocumentKey& other) : rep_(other.rep_) {
+  if (rep_) {
+    rep_->Ref();
+  }
 }
 
-DocumentKey::DocumentKey(const ResourcePath& path)
-    : path_{std::make_shared<ResourcePath>(path)} {
-  AssertValidPath(*path_);
+DocumentKey::DocumentKey(DocumentKey&& other) noexcept : rep_(other.rep_) {
+  other.rep_ = nullptr;
 }
 
-DocumentKey::DocumentKey(ResourcePath&& path)
-    : path_{std::make_shared<ResourcePath>(std::move(path))} {
-  AssertValidPath(*path_);
+DocumentKey::~DocumentKey() {
+  if (rep_) {
+    rep_->Unref();
+  }
+}
+
+DocumentKey& DocumentKey::operator=(const DocumentKey& other) {
+  if (other.rep_) {
+    other.rep_->Ref();
+  }
+  if (rep_) {
+    rep_->Unref();
+  }
+  rep_ = other.rep_;
+  return *this;
+}
+
+DocumentKey& DocumentKey::operator=(DocumentKey&& other) noexcept {
+  if (this != &other) {
+    if (rep_) {
+      rep_->Unref();
+    }
+    rep_ = other.rep_;
+    other.rep_ = nullptr;
+  }
+  return *this;
 }
 
 DocumentKey DocumentKey::FromPathString(const std::string& path) {
@@ -76,11 +213,33 @@ bool DocumentKey::IsDocumentKey(const ResourcePath& path) {
 }
 
 util::ComparisonResult DocumentKey::CompareTo(const DocumentKey& other) const {
-  return path().CompareTo(other.path());
+  if (rep_ == other.rep_) {
+    return util::ComparisonResult::Same;
+  }
+
+  // Same order as `ResourcePath::CompareTo`: segment by segment, with shorter
+  // paths first.
+  size_t size = path_size();
+  size_t other_size = other.path_size();
+  size_t common = std::min(size, other_size);
+  for (size_t i = 0; i < common; ++i) {
+    util::ComparisonResult result =
+        util::Compare(segment(i), other.segment(i));
+    if (!util::Same(result)) {
+      return result;
+    }
+  }
+  return util::DefaultComparator<size_t>().Compare(size, other_size);
 }
 
 bool operator==(const DocumentKey& lhs, const DocumentKey& rhs) {
-  return lhs.path() == rhs.path();
+  if (lhs.rep_ == rhs.rep_) {
+    return true;
+  }
+  if (lhs.Hash() != rhs.Hash() || lhs.path_size() != rhs.path_size()) {
+    return false;
+  }
+  return util::Same(lhs.CompareTo(rhs));
 }
 
 bool operator<(const DocumentKey& lhs, const DocumentKey& rhs) {
@@ -91,38 +250,75 @@ bool operator>(const DocumentKey& lhs, const DocumentKey& rhs) {
 }
 
 size_t DocumentKey::Hash() const {
-  return util::Hash(ToString());
+  return rep_ ? rep_->hash() : EmptyPathHash();
 }
 
 std::string DocumentKey::ToString() const {
-  return path().CanonicalString();
+  // Matches `ResourcePath::CanonicalString()`.
+  std::string result;
+  for (size_t i = 0; i < path_size(); ++i) {
+    if (i > 0) {
+      result += '/';
+    }
+    absl::string_view segment = this->segment(i);
+    result.append(segment.data(), segment.size());
+  }
+  return result;
 }
 
 std::ostream& operator<<(std::ostream& os, const DocumentKey& key) {
   return os << key.ToString();
 }
 
-const ResourcePath& DocumentKey::path() const {
-  return path_ ? *path_ : Empty().path();
+ResourcePath DocumentKey::path() const {
+  size_t size = path_size();
+  std::vector<std::string> segments;
+  segments.reserve(size);
+  for (size_t i = 0; i < size; ++i) {
+    absl::string_view segment = this->segment(i);
+    segments.emplace_back(segment.data(), segment.size());
+  }
+  return ResourcePath(std::move(segments));
+}
+
+size_t DocumentKey::path_size() const {
+  return rep_ ? rep_->segment_count() : 0;
+}
+
+bool DocumentKey::HasPrefix(const ResourcePath& prefix) const {
+  if (prefix.size() > path_size()) {
+    return false;
+  }
+  for (size_t i = 0; i < prefix.size(); ++i) {
+    if (prefix[i] != segment(i)) {
+      return false;
+    }
+  }
+  return true;
 }
 
 /** Returns true if the document is in the specified collection_id. */
 bool DocumentKey::HasCollectionGroup(absl::string_view collection_group) const {
-  const auto collection_id_opt = GetCollectionGroup();
-  return collection_id_opt.has_value() &&
-         collection_id_opt.value() == collection_group;
+  size_t size = path_size();
+  return size >= 2 && segment(size - 2) == collection_group;
 }
 
 absl::optional<std::string> DocumentKey::GetCollectionGroup() const {
-  const size_t size = path().size();
+  size_t size = path_size();
   if (size < 2) {
     return absl::nullopt;
   }
-  return path()[size - 2];
+  absl::string_view collection_group = segment(size - 2);
+  return std::string(collection_group.data(), collection_group.size());
+}
+
+absl::string_view DocumentKey::segment(size_t i) const {
+  HARD_ASSERT(i < path_size(), "Segment index %s out of bounds", i);
+  return rep_->segment(i);
 }
 
 size_t DocumentKeyHash::operator()(const DocumentKey& key) const {
-  return util::Hash(key.path());
+  return key.Hash();
 }
 
 }  // namespace model
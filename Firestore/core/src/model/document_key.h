@@ -17,10 +17,10 @@
 #ifndef FIRESTORE_CORE_SRC_MODEL_DOCUMENT_KEY_H_
 #define FIRESTORE_CORE_SRC_MODEL_DOCUMENT_KEY_H_
 
+#include <cstddef>
 #include <functional>
 #include <initializer_list>
 #include <iosfwd>
-#include <memory>
 #include <string>
 
 #include "absl/strings/string_view.h"
@@ -39,6 +39,13 @@ class ResourcePath;
 
 /**
  * DocumentKey represents the location of a document in the Firestore database.
+ *
+ * Targets and views hold sets of hundreds of thousands of keys, so keys are
+ * stored packed: the segments of the path share a single, reference counted
+ * allocation together with the precomputed hash. Comparisons and the
+ * `HasPrefix` and `HasCollectionGroup` checks work directly on that form;
+ * `path()` has to rebuild the `ResourcePath`, so hot code should walk
+ * `path_size()` and `segment()` instead.
  */
 class DocumentKey {
  public:
@@ -48,9 +55,18 @@ class DocumentKey {
   /** Creates a new document key containing a copy of the given path. */
   explicit DocumentKey(const ResourcePath& path);
 
-  /** Creates a new document key, taking ownership of the given path. */
+  /**
+   * Creates a new document key from the given path, leaving the path empty.
+   */
   explicit DocumentKey(ResourcePath&& path);
 
+  DocumentKey(const DocumentKey& other);
+  DocumentKey(DocumentKey&& other) noexcept;
+  ~DocumentKey();
+
+  DocumentKey& operator=(const DocumentKey& other);
+  DocumentKey& operator=(DocumentKey&& other) noexcept;
+
   /**
    * Creates and returns a new document key using '/' to split the string into
    * segments.
@@ -79,8 +95,17 @@ class DocumentKey {
 
   friend std::ostream& operator<<(std::ostream& os, const DocumentKey& key);
 
-  /** The path to the document. */
-  const ResourcePath& path() const;
+  /** Returns the path to the document, rebuilt from the packed segments. */
+  ResourcePath path() const;
+
+  /** The number of segments in the path to the document. */
+  size_t path_size() const;
+
+  /** Returns the i-th segment of the path. */
+  absl::string_view segment(size_t i) const;
+
+  /** Returns true if `prefix` is a prefix of the path to the document. */
+  bool HasPrefix(const ResourcePath& prefix) const;
 
   /** Returns true if the document is in the specified collection group. */
   bool HasCollectionGroup(absl::string_view collection_group) const;
@@ -89,9 +114,10 @@ class DocumentKey {
   absl::optional<std::string> GetCollectionGroup() const;
 
  private:
-  // This is an optimization to make passing DocumentKey around cheaper (it's
-  // copied often).
-  std::shared_ptr<const ResourcePath> path_;
+  class Rep;
+
+  // Copies share the same `Rep`; the empty key has none.
+  Rep* rep_ = nullptr;
 };
 
 inline bool operator!=(const DocumentKey& lhs, const DocumentKey& rhs) {
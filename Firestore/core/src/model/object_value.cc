@@ -17,14 +17,24 @@
 #include "Firestore/core/src/model/object_value.h"
 
 #include <algorithm>
+#include <cstdlib>
 #include <map>
+#include <memory>
+#include <mutex>  // NOLINT(build/c++11)
 #include <set>
+#include <string>
+#include <utility>
+#include <vector>
 
 #include "Firestore/Protos/nanopb/google/firestore/v1/document.nanopb.h"
+#include "Firestore/core/src/nanopb/arena.h"
+#include "Firestore/core/src/nanopb/arena_decoder.h"
 #include "Firestore/core/src/nanopb/fields_array.h"
 #include "Firestore/core/src/nanopb/message.h"
 #include "Firestore/core/src/nanopb/nanopb_util.h"
 #include "Firestore/core/src/util/hashing.h"
+#include "Firestore/core/src/util/read_context.h"
+#include "absl/types/optional.h"
 #include "absl/types/span.h"
 
 namespace firebase {
@@ -33,9 +43,9 @@ namespace model {
 
 namespace {
 
+using nanopb::Arena;
+using nanopb::ArenaDecoder;
 using nanopb::CheckedSize;
-using nanopb::FreeFieldsArray;
-using nanopb::FreeNanopbMessage;
 using nanopb::MakeArray;
 using nanopb::MakeBytesArray;
 using nanopb::MakeString;
@@ -78,123 +88,226 @@ google_firestore_v1_MapValue_FieldsEntry* FindEntry(
   return found.first;
 }
 
-size_t CalculateSizeOfUnion(
-    const google_firestore_v1_MapValue& map_value,
-    const std::map<std::string, Message<google_firestore_v1_Value>>& upserts,
-    const std::set<std::string>& deletes) {
-  // Compute the size of the map after applying all mutations. The final size is
-  // the number of existing entries, plus the number of new entries
-  // minus the number of deleted entries.
-  return upserts.size() +
-         std::count_if(
-             map_value.fields, map_value.fields + map_value.fields_count,
-             [&](const google_firestore_v1_MapValue_FieldsEntry& entry) {
-               std::string field = MakeString(entry.key);
-               // Don't count if entry is deleted or if it is a replacement
-               // rather than an insert.
-               return deletes.find(field) == deletes.end() &&
-                      upserts.find(field) == upserts.end();
-             });
+/**
+ * Sorts the fields of a fully decoded document, keeping only the last
+ * occurrence of a repeated key as Protobuf does for maps. This way, the
+ * document agrees with fields decoded on their own by
+ * `ArenaDecoder::FindDocumentField`.
+ */
+void SortDocumentFields(google_firestore_v1_Value& value) {
+  google_firestore_v1_MapValue& map_value = value.map_value;
+  auto* begin = map_value.fields;
+  auto* end = map_value.fields + map_value.fields_count;
+  std::stable_sort(begin, end,
+                   [](const google_firestore_v1_MapValue_FieldsEntry& lhs,
+                      const google_firestore_v1_MapValue_FieldsEntry& rhs) {
+                     return MakeStringView(lhs.key) < MakeStringView(rhs.key);
+                   });
+
+  auto* out = begin;
+  for (auto* entry = begin; entry != end; ++entry) {
+    if (entry + 1 != end &&
+        MakeStringView(entry->key) == MakeStringView((entry + 1)->key)) {
+      continue;
+    }
+    *out++ = *entry;
+  }
+  map_value.fields_count = static_cast<pb_size_t>(out - begin);
+
+  // Sorts the nested values; the top level is sorted already.
+  SortFields(value);
 }
 
+}  // namespace
+
+struct ObjectValue::MapEntry {
+  pb_bytes_array_t* key;
+
+  // Keeps `key` alive. For entries of a Protobuf map this is the map's owner.
+  std::shared_ptr<const void> key_owner;
+
+  ValueRef value;
+};
+
 /**
- * Modifies `parent_map` by adding, replacing or deleting the specified
- * entries.
+ * A map created by modifying another map. The node holds on to its entries and
+ * owns a Protobuf map whose fields are shallow copies of them, so unmodified
+ * entries are shared with the map the node was created from.
  */
-void ApplyChanges(
-    google_firestore_v1_MapValue* parent,
-    std::map<std::string, Message<google_firestore_v1_Value>> upserts,
-    std::set<std::string> deletes) {
-  // TODO(mrschmidt): Consider using `absl::btree_map` and `absl::btree_set` for
-  // potentially better performance.
-  auto source_count = parent->fields_count;
-  auto* source_fields = parent->fields;
-
-  size_t target_count = CalculateSizeOfUnion(*parent, upserts, deletes);
-  auto* target_fields = MakeArray<google_firestore_v1_MapValue_FieldsEntry>(
-      CheckedSize(target_count));
+class ObjectValue::MapNode {
+ public:
+  explicit MapNode(std::vector<MapEntry> entries)
+      : entries_(std::move(entries)) {
+    pb_size_t count = CheckedSize(entries_.size());
+    value_.which_value_type = google_firestore_v1_Value_map_value_tag;
+    value_.map_value.fields_count = count;
+    value_.map_value.fields =
+        MakeArray<google_firestore_v1_MapValue_FieldsEntry>(count);
+    for (pb_size_t i = 0; i < count; ++i) {
+      value_.map_value.fields[i].key = entries_[i].key;
+      value_.map_value.fields[i].value = *entries_[i].value.value;
+    }
+  }
 
-  auto delete_it = deletes.begin();
-  auto upsert_it = upserts.begin();
+  ~MapNode() {
+    // The keys and values are owned by the entries.
+    free(value_.map_value.fields);
+  }
 
-  // Merge the existing data with the deletes and updates
-  pb_size_t source_index = 0, target_index = 0;
-  while (target_index < target_count) {
-    auto& target_entry = target_fields[target_index];
+  MapNode(const MapNode&) = delete;
+  MapNode& operator=(const MapNode&) = delete;
 
-    if (source_index < source_count) {
-      auto& source_entry = source_fields[source_index];
-      std::string source_key = MakeString(source_entry.key);
+  const google_firestore_v1_Value& value() const {
+    return value_;
+  }
 
-      // Check if the source key is deleted
-      if (delete_it != deletes.end() && *delete_it == source_key) {
-        FreeFieldsArray(&source_entry);
+  /**
+   * Returns the entries of `map` in key order, or no entries if `map` is not a
+   * map.
+   */
+  static std::vector<MapEntry> EntriesOf(const ValueRef& map) {
+    if (map.node) {
+      return map.node->entries_;
+    }
 
-        ++delete_it;
-        ++source_index;
-        continue;
-      }
+    std::vector<MapEntry> result;
+    if (!IsMap(*map.value)) {
+      return result;
+    }
 
-      // Check if the source key is updated by the next upsert
-      if (upsert_it != upserts.end() && upsert_it->first == source_key) {
-        FreeFieldsArray(&source_entry.value);
+    const google_firestore_v1_MapValue& map_value = map.value->map_value;
+    result.reserve(map_value.fields_count);
+    for (pb_size_t i = 0; i < map_value.fields_count; ++i) {
+      const google_firestore_v1_MapValue_FieldsEntry& field =
+          map_value.fields[i];
+      result.push_back(MapEntry{field.key, map.owner,
+                                ValueRef{map.owner, &field.value, nullptr}});
+    }
+    return result;
+  }
 
-        target_entry.key = source_entry.key;
-        target_entry.value = *(upsert_it->second.release());
-        SortFields(target_entry.value);
+  static ValueRef Create(std::vector<MapEntry> entries) {
+    auto node = std::make_shared<const MapNode>(std::move(entries));
+    return ValueRef{node, &node->value(), node.get()};
+  }
 
-        ++upsert_it;
-        ++source_index;
-        ++target_index;
-        continue;
-      }
+  /** Takes ownership of `value`. */
+  static ValueRef Adopt(Message<google_firestore_v1_Value> value) {
+    SortFields(*value);
+    auto owner =
+        std::make_shared<Message<google_firestore_v1_Value>>(std::move(value));
+    return ValueRef{owner, owner->get(), nullptr};
+  }
+
+  static MapEntry MakeEntry(const std::string& key, ValueRef value) {
+    pb_bytes_array_t* bytes = MakeBytesArray(key);
+    std::shared_ptr<const void> owner(bytes,
+                                      [](pb_bytes_array_t* b) { free(b); });
+    return MapEntry{bytes, std::move(owner), std::move(value)};
+  }
+
+ private:
+  std::vector<MapEntry> entries_;
+  google_firestore_v1_Value value_{};
+};
+
+/**
+ * The encoded fields of a document, which are decoded on demand. Shared by the
+ * copies of an ObjectValue, possibly across threads, until they are modified.
+ */
+class ObjectValue::EncodedFields {
+ public:
+  explicit EncodedFields(std::string document)
+      : document_(std::move(document)) {
+  }
+
+  /** Returns the fields of the document, decoding all of them if necessary. */
+  const ValueRef& Root() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!root_) {
+      auto arena = std::make_shared<Arena>(
+          ArenaDecoder::EstimateArenaSize(document_.size()));
+      util::ReadContext context;
+      auto* value = arena->MakeArray<google_firestore_v1_Value>(1);
+      value->which_value_type = google_firestore_v1_Value_map_value_tag;
+      value->map_value =
+          ArenaDecoder(&context, arena.get()).DecodeDocumentFields(document_);
+      HARD_ASSERT(context.ok(), "Document fields failed to parse: %s",
+                  context.status().ToString());
+      SortDocumentFields(*value);
+      root_ = ValueRef{std::move(arena), value, nullptr};
+
+      // Fields that were decoded on their own are still referenced; only the
+      // encoded document can go.
+      std::string().swap(document_);
+    }
+    return *root_;
+  }
 
-      // Check if the source key comes before the next upsert
-      if (upsert_it == upserts.end() || upsert_it->first > source_key) {
-        target_entry = source_entry;
+  /**
+   * Returns the top-level field `key`, or null if the document has no such
+   * field. Only decodes that field unless the whole document is decoded
+   * already.
+   */
+  const google_firestore_v1_Value* Field(const std::string& key) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (root_) {
+      google_firestore_v1_MapValue_FieldsEntry* entry =
+          FindEntry(*root_->value, key);
+      return entry ? &entry->value : nullptr;
+    }
 
-        ++source_index;
-        ++target_index;
-        continue;
+    for (const auto& field : fields_) {
+      if (field.first == key) {
+        return field.second;
       }
     }
 
-    // Otherwise, insert the next upsert.
-    target_entry.key = MakeBytesArray(upsert_it->first);
-    target_entry.value = *(upsert_it->second.release());
-    SortFields(target_entry.value);
+    util::ReadContext context;
+    absl::string_view encoded_value;
+    bool exists = ArenaDecoder(&context, /* arena= */ nullptr)
+                      .FindDocumentField(document_, key, &encoded_value);
+    google_firestore_v1_Value* value = nullptr;
+    if (exists) {
+      if (!field_arena_) {
+        // Usually only a few small fields of a document are looked up, so
+        // size the arena for this one rather than for the whole document.
+        field_arena_.emplace(
+            sizeof(google_firestore_v1_Value) +
+            ArenaDecoder::EstimateArenaSize(encoded_value.size()));
+      }
+      value = field_arena_->MakeArray<google_firestore_v1_Value>(1);
+      ArenaDecoder(&context, &*field_arena_).DecodeValue(encoded_value, value);
+      SortFields(*value);
+    }
+    HARD_ASSERT(context.ok(), "Document field failed to parse: %s",
+                context.status().ToString());
 
-    ++upsert_it;
-    ++target_index;
+    fields_.emplace_back(key, value);
+    return value;
   }
 
-  // Delete any remaining fields in the original map. This only includes fields
-  // that were deleted.
-  for (; source_index < source_count; ++source_index) {
-    FreeFieldsArray(&source_fields[source_index]);
-  }
+ private:
+  std::mutex mutex_;
+  std::string document_;
+  absl::optional<ValueRef> root_;
 
-  free(parent->fields);
-  parent->fields = target_fields;
-  parent->fields_count = CheckedSize(target_count);
-}
+  // The top-level fields that were looked up before the whole document was
+  // decoded, or null for fields that don't exist. Only a few fields are
+  // looked up per document, so a linear search is cheapest.
+  std::vector<std::pair<std::string, const google_firestore_v1_Value*>>
+      fields_;
 
-}  // namespace
+  // Created by the first lookup of an existing field.
+  absl::optional<Arena> field_arena_;
+};
 
-ObjectValue::ObjectValue() {
-  value_->which_value_type = google_firestore_v1_Value_map_value_tag;
-  value_->map_value = {};
-}
+ObjectValue::ObjectValue() = default;
 
-ObjectValue::ObjectValue(Message<google_firestore_v1_Value> value)
-    : value_(std::move(value)) {
-  HARD_ASSERT(value_ && IsMap(*value_),
+ObjectValue::ObjectValue(Message<google_firestore_v1_Value> value) {
+  HARD_ASSERT(value && IsMap(*value),
               "ObjectValues should be backed by a MapValue");
-  SortFields(*value_);
-}
-
-ObjectValue::ObjectValue(const ObjectValue& other)
-    : value_(DeepClone(*other.value_)) {
+  root_ = MapNode::Adopt(std::move(value));
 }
 
 ObjectValue ObjectValue::FromMapValue(
@@ -221,8 +334,14 @@ ObjectValue ObjectValue::FromFieldsEntry(
   return ObjectValue{std::move(value)};
 }
 
+ObjectValue ObjectValue::FromEncodedDocument(std::string document) {
+  ObjectValue result;
+  result.encoded_fields_ = std::make_shared<EncodedFields>(std::move(document));
+  return result;
+}
+
 FieldMask ObjectValue::ToFieldMask() const {
-  return ExtractFieldMask(value_->map_value);
+  return ExtractFieldMask(root().value->map_value);
 }
 
 FieldMask ObjectValue::ExtractFieldMask(
@@ -256,13 +375,24 @@ FieldMask ObjectValue::ExtractFieldMask(
 absl::optional<google_firestore_v1_Value> ObjectValue::Get(
     const FieldPath& path) const {
   if (path.empty()) {
-    return *value_;
+    return *root().value;
+  }
+
+  auto segment = path.begin();
+  google_firestore_v1_Value nested_value;
+  if (encoded_fields_) {
+    // Avoid decoding fields that aren't on the path.
+    const google_firestore_v1_Value* field = encoded_fields_->Field(*segment);
+    if (!field) return absl::nullopt;
+    nested_value = *field;
+    ++segment;
+  } else {
+    nested_value = *root_.value;
   }
 
-  google_firestore_v1_Value nested_value = *value_;
-  for (const std::string& segment : path) {
+  for (; segment != path.end(); ++segment) {
     google_firestore_v1_MapValue_FieldsEntry* entry =
-        FindEntry(nested_value, segment);
+        FindEntry(nested_value, *segment);
     if (!entry) return absl::nullopt;
     nested_value = entry->value;
   }
@@ -270,26 +400,27 @@ absl::optional<google_firestore_v1_Value> ObjectValue::Get(
 }
 
 google_firestore_v1_Value ObjectValue::Get() const {
-  return *value_;
+  return *root().value;
 }
 
 void ObjectValue::Set(const FieldPath& path,
                       Message<google_firestore_v1_Value> value) {
   HARD_ASSERT(!path.empty(), "Cannot set field for empty path on ObjectValue");
+  Materialize();
 
-  google_firestore_v1_MapValue* parent_map = ParentMap(path.PopLast());
-
-  std::map<std::string, Message<google_firestore_v1_Value>> upserts;
+  Upserts upserts;
   upserts[path.last_segment()] = std::move(value);
 
-  ApplyChanges(parent_map, std::move(upserts), /*deletes=*/{});
+  root_ = ApplyChanges(root_, path.PopLast(), 0, std::move(upserts),
+                       /*deletes=*/{});
 }
 
 void ObjectValue::SetAll(TransformMap data) {
+  Materialize();
   FieldPath parent;
 
-  std::map<std::string, Message<google_firestore_v1_Value>> upserts;
-  std::set<std::string> deletes;
+  Upserts upserts;
+  Deletes deletes;
 
   for (auto& it : data) {
     const FieldPath& path = it.first;
@@ -298,8 +429,10 @@ void ObjectValue::SetAll(TransformMap data) {
 
     if (!parent.IsImmediateParentOf(path)) {
       // Insert the accumulated changes at this parent location
-      google_firestore_v1_MapValue* parent_map = ParentMap(parent);
-      ApplyChanges(parent_map, std::move(upserts), std::move(deletes));
+      if (!upserts.empty() || !deletes.empty()) {
+        root_ = ApplyChanges(root_, parent, 0, std::move(upserts),
+                             std::move(deletes));
+      }
       upserts.clear();
       deletes.clear();
       parent = path.PopLast();
@@ -312,70 +445,120 @@ void ObjectValue::SetAll(TransformMap data) {
     }
   }
 
-  google_firestore_v1_MapValue* parent_map = ParentMap(parent);
-  ApplyChanges(parent_map, std::move(upserts), std::move(deletes));
+  if (!upserts.empty() || !deletes.empty()) {
+    root_ = ApplyChanges(root_, parent, 0, std::move(upserts),
+                         std::move(deletes));
+  }
 }
 
 void ObjectValue::Delete(const FieldPath& path) {
   HARD_ASSERT(!path.empty(), "Cannot delete field with empty path");
-
-  google_firestore_v1_Value* nested_value = value_.get();
-  for (const std::string& segment : path.PopLast()) {
-    auto* entry = FindEntry(*nested_value, segment);
-    // If the entry is not found, exit early. There is nothing to delete.
-    if (!entry) return;
-    nested_value = &entry->value;
+  Materialize();
+
+  // If the parent doesn't exist, isn't a map or doesn't contain the field,
+  // there is nothing to delete.
+  FieldPath parent = path.PopLast();
+  absl::optional<google_firestore_v1_Value> parent_value = Get(parent);
+  if (!parent_value || !FindEntry(*parent_value, path.last_segment())) {
+    return;
   }
 
-  // We can only delete a leaf entry if its parent is a map.
-  if (IsMap(*nested_value)) {
-    std::set<std::string> deletes{path.last_segment()};
-    ApplyChanges(&nested_value->map_value, /*upserts=*/{}, deletes);
-  }
+  root_ = ApplyChanges(root_, parent, 0, /*upserts=*/{},
+                       Deletes{path.last_segment()});
 }
 
 std::string ObjectValue::ToString() const {
-  return CanonicalId(*value_);
+  return CanonicalId(*root().value);
 }
 
 size_t ObjectValue::Hash() const {
-  return util::Hash(CanonicalId(*value_));
+  return util::Hash(CanonicalId(*root().value));
 }
 
-google_firestore_v1_MapValue* ObjectValue::ParentMap(const FieldPath& path) {
-  google_firestore_v1_Value* parent = value_.get();
+const ObjectValue::ValueRef& ObjectValue::root() const {
+  return encoded_fields_ ? encoded_fields_->Root() : root_;
+}
 
-  // Find a or create a parent map entry for `path`.
-  for (const std::string& segment : path) {
-    google_firestore_v1_MapValue_FieldsEntry* entry =
-        FindEntry(*parent, segment);
-
-    if (entry) {
-      if (entry->value.which_value_type !=
-          google_firestore_v1_Value_map_value_tag) {
-        // Since the element is not a map value, free all existing data and
-        // change it to a map type.
-        FreeFieldsArray(&entry->value);
-        entry->value.which_value_type = google_firestore_v1_Value_map_value_tag;
-        entry->value.map_value = {};
-      }
+void ObjectValue::Materialize() {
+  if (encoded_fields_) {
+    root_ = encoded_fields_->Root();
+    encoded_fields_.reset();
+  }
+}
+
+ObjectValue::ValueRef ObjectValue::EmptyMap() {
+  static const google_firestore_v1_Value empty_map = [] {
+    google_firestore_v1_Value value{};
+    value.which_value_type = google_firestore_v1_Value_map_value_tag;
+    return value;
+  }();
+  return ValueRef{nullptr, &empty_map, nullptr};
+}
 
-      parent = &entry->value;
+ObjectValue::ValueRef ObjectValue::ApplyChanges(const ValueRef& map,
+                                                const FieldPath& parent,
+                                                size_t depth,
+                                                Upserts upserts,
+                                                Deletes deletes) {
+  std::vector<MapEntry> entries = MapNode::EntriesOf(map);
+  auto key_less = [](const MapEntry& entry, absl::string_view segment) {
+    return MakeStringView(entry.key) < segment;
+  };
+
+  // Copy the map on the way down to the parent, creating the parent entries
+  // that are missing.
+  if (depth < parent.size()) {
+    const std::string& segment = parent[depth];
+    auto found =
+        std::lower_bound(entries.begin(), entries.end(), segment, key_less);
+    bool exists =
+        found != entries.end() && MakeStringView(found->key) == segment;
+
+    ValueRef child = exists ? found->value : EmptyMap();
+    MapEntry updated = MapNode::MakeEntry(
+        segment, ApplyChanges(child, parent, depth + 1, std::move(upserts),
+                              std::move(deletes)));
+    if (exists) {
+      *found = std::move(updated);
     } else {
-      // Create a new map value for the current segment.
-      Message<google_firestore_v1_Value> new_entry;
-      new_entry->which_value_type = google_firestore_v1_Value_map_value_tag;
-      new_entry->map_value = {};
+      entries.insert(found, std::move(updated));
+    }
+    return MapNode::Create(std::move(entries));
+  }
+
+  // Merge the existing entries with the deletes and updates. All three are
+  // sorted by key.
+  std::vector<MapEntry> result;
+  result.reserve(entries.size() + upserts.size());
 
-      std::map<std::string, Message<google_firestore_v1_Value>> upserts;
-      upserts[segment] = std::move(new_entry);
-      ApplyChanges(&parent->map_value, std::move(upserts), /*deletes=*/{});
+  auto upsert_it = upserts.begin();
+  auto delete_it = deletes.begin();
+  auto insert_upsert = [&] {
+    result.push_back(MapNode::MakeEntry(
+        upsert_it->first, MapNode::Adopt(std::move(upsert_it->second))));
+    ++upsert_it;
+  };
 
-      parent = &(FindEntry(*parent, segment)->value);
+  for (MapEntry& entry : entries) {
+    absl::string_view key = MakeStringView(entry.key);
+    while (upsert_it != upserts.end() && upsert_it->first < key) {
+      insert_upsert();
     }
+    while (delete_it != deletes.end() && *delete_it < key) {
+      ++delete_it;
+    }
+
+    if (upsert_it != upserts.end() && upsert_it->first == key) {
+      insert_upsert();
+    } else if (delete_it == deletes.end() || *delete_it != key) {
+      result.push_back(std::move(entry));
+    }
+  }
+  while (upsert_it != upserts.end()) {
+    insert_upsert();
   }
 
-  return &parent->map_value;
+  return MapNode::Create(std::move(result));
 }
 
 }  // namespace model
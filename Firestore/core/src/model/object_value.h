@@ -18,6 +18,7 @@
 #define FIRESTORE_CORE_SRC_MODEL_OBJECT_VALUE_H_
 
 #include <map>
+#include <memory>
 #include <ostream>
 #include <set>
 #include <string>
@@ -37,7 +38,13 @@ namespace firestore {
 
 namespace model {
 
-/** A structured object value stored in Firestore. */
+/**
+ * A structured object value stored in Firestore.
+ *
+ * ObjectValues are persistent: copies share their data, and modifications
+ * only copy the maps on the path to the modified field. All other fields stay
+ * shared with the ObjectValues the data was copied from.
+ */
 class ObjectValue {
  public:
   ObjectValue();
@@ -47,7 +54,7 @@ class ObjectValue {
 
   ObjectValue(ObjectValue&& other) noexcept = default;
   ObjectValue& operator=(ObjectValue&& other) noexcept = default;
-  ObjectValue(const ObjectValue& other);
+  ObjectValue(const ObjectValue& other) = default;
 
   ObjectValue& operator=(const ObjectValue&) = delete;
 
@@ -67,6 +74,16 @@ class ObjectValue {
   static ObjectValue FromFieldsEntry(
       google_firestore_v1_Document_FieldsEntry* fields_entry, pb_size_t count);
 
+  /**
+   * Creates a new ObjectValue for the fields of the encoded
+   * `google_firestore_v1_Document` in `document`.
+   *
+   * The fields are decoded lazily: looking up a field path only decodes the
+   * top-level field the path starts with. All fields are decoded once the
+   * ObjectValue is modified or read as a whole.
+   */
+  static ObjectValue FromEncodedDocument(std::string document);
+
   /** Recursively extracts the FieldPaths that are set in this ObjectValue. */
   FieldMask ToFieldMask() const;
 
@@ -79,7 +96,8 @@ class ObjectValue {
   absl::optional<google_firestore_v1_Value> Get(const FieldPath& path) const;
 
   /**
-   * Returns the ObjectValue in its Protobuf representation.
+   * Returns the ObjectValue in its Protobuf representation. The returned proto
+   * is only valid until the ObjectValue is modified or destroyed.
    */
   google_firestore_v1_Value Get() const;
 
@@ -119,20 +137,58 @@ class ObjectValue {
                                   const ObjectValue& object_value);
 
  private:
+  class EncodedFields;
+  class MapNode;
+  struct MapEntry;
+
+  /**
+   * An immutable value in a tree that may be shared by several ObjectValues.
+   * `owner` keeps the memory that `value` points into alive.
+   */
+  struct ValueRef {
+    std::shared_ptr<const void> owner;
+    const google_firestore_v1_Value* value;
+
+    // Set if `value` is the map owned by a `MapNode`, in which case the node's
+    // entries are reused rather than referenced through the node.
+    const MapNode* node;
+  };
+
+  using Upserts =
+      std::map<std::string, nanopb::Message<google_firestore_v1_Value>>;
+  using Deletes = std::set<std::string>;
+
+  /** Returns the root map, decoding it first if necessary. */
+  const ValueRef& root() const;
+
+  /** Decodes the root map if it's still encoded, so that it can be modified. */
+  void Materialize();
+
   /** Returns the field mask for the provided map value. */
   FieldMask ExtractFieldMask(const google_firestore_v1_MapValue& value) const;
 
+  /** Returns a reference to an empty map that is never freed. */
+  static ValueRef EmptyMap();
+
   /**
-   * Returns the map that contains the leaf element of `path`. If the parent
-   * entry does not yet exist, or if it is not a map, a new map will be created.
+   * Returns a copy of `map` with the given changes applied to the map at
+   * `parent`, starting at the segment at index `depth`. Parent entries that
+   * don't exist or that aren't maps are replaced with maps.
    */
-  google_firestore_v1_MapValue* ParentMap(const FieldPath& path);
+  static ValueRef ApplyChanges(const ValueRef& map,
+                               const FieldPath& parent,
+                               size_t depth,
+                               Upserts upserts,
+                               Deletes deletes);
+
+  ValueRef root_ = EmptyMap();
 
-  nanopb::Message<google_firestore_v1_Value> value_;
+  // If set, holds the fields of this ObjectValue instead of `root_`.
+  std::shared_ptr<EncodedFields> encoded_fields_;
 };
 
 inline bool operator==(const ObjectValue& lhs, const ObjectValue& rhs) {
-  return *lhs.value_ == *rhs.value_;
+  return *lhs.root().value == *rhs.root().value;
 }
 
 inline bool operator!=(const ObjectValue& lhs, const ObjectValue& rhs) {
@@ -141,7 +197,7 @@ inline bool operator!=(const ObjectValue& lhs, const ObjectValue& rhs) {
 
 inline std::ostream& operator<<(std::ostream& out,
                                 const ObjectValue& object_value) {
-  return out << "ObjectValue(" << *object_value.value_ << ")";
+  return out << "ObjectValue(" << *object_value.root().value << ")";
 }
 
 }  // namespace model
@@ -74,7 +74,7 @@ void SetMutation::Rep::ApplyToRemoteDocument(
   // the server has accepted the mutation so the precondition must have held.
   auto transform_results = ServerTransformResults(
       document.data(), mutation_result.transform_results());
-  ObjectValue new_data{DeepClone(value_.Get())};
+  ObjectValue new_data{value_};
   new_data.SetAll(std::move(transform_results));
   document
       .ConvertToFoundDocument(mutation_result.version(), std::move(new_data))
@@ -93,7 +93,7 @@ absl::optional<FieldMask> SetMutation::Rep::ApplyToLocalView(
 
   auto transform_results =
       LocalTransformResults(document.data(), local_write_time);
-  ObjectValue new_data{DeepClone(value_.Get())};
+  ObjectValue new_data{value_};
   new_data.SetAll(std::move(transform_results));
   document.ConvertToFoundDocument(document.version(), std::move(new_data))
       .SetHasLocalMutations();
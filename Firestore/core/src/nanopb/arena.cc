@@ -0,0 +1,101 @@
+/*
+ * Copyright 2022 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Firestore/core/src/nanopb/arena.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+
+#include "Firestore/core/src/nanopb/nanopb_util.h"
+#include "Firestore/core/src/util/hard_assert.h"
+
+namespace firebase {
+namespace firestore {
+namespace nanopb {
+namespace {
+
+// Nanopb protos contain nothing that needs stricter alignment than 64-bit
+// integers, doubles and pointers.
+constexpr size_t kAlignment = 8;
+static_assert(alignof(int64_t) <= kAlignment && alignof(double) <= kAlignment &&
+                  alignof(void*) <= kAlignment,
+              "Arena alignment is too small");
+
+// The size of the first block unless the arena is given one, and the least
+// that later blocks grow to.
+constexpr size_t kMinBlockSize = 1024;
+constexpr size_t kMaxBlockSize = 1024 * 1024;
+
+size_t AlignUp(size_t size) {
+  return (size + kAlignment - 1) & ~(kAlignment - 1);
+}
+
+}  // namespace
+
+Arena::Arena(size_t initial_size)
+    : next_block_size_(initial_size > 0 ? AlignUp(initial_size)
+                                        : kMinBlockSize) {
+}
+
+Arena::~Arena() {
+  for (char* block : blocks_) {
+    std::free(block);
+  }
+}
+
+void* Arena::Allocate(size_t size) {
+  size = AlignUp(size);
+  if (static_cast<size_t>(end_ - next_) < size) {
+    AddBlock(size);
+  }
+
+  void* result = next_;
+  next_ += size;
+  return result;
+}
+
+pb_bytes_array_t* Arena::MakeBytesArray(const void* data, size_t size) {
+  pb_size_t pb_size = CheckedSize(size);
+
+  // Allocate one extra byte for the null terminator, as
+  // `nanopb::MakeBytesArray` does. The arena's memory is already zeroed.
+  auto* result = static_cast<pb_bytes_array_t*>(
+      Allocate(PB_BYTES_ARRAY_T_ALLOCSIZE(pb_size + 1)));
+  result->size = pb_size;
+  if (size > 0) {
+    std::memcpy(result->bytes, data, size);
+  }
+  return result;
+}
+
+void Arena::AddBlock(size_t min_size) {
+  size_t size = std::max(next_block_size_, min_size);
+  next_block_size_ =
+      std::min(std::max(next_block_size_ * 2, kMinBlockSize), kMaxBlockSize);
+
+  auto* block = static_cast<char*>(std::calloc(size, 1));
+  HARD_ASSERT(block, "Failed to allocate an arena block of %s bytes", size);
+
+  blocks_.push_back(block);
+  next_ = block;
+  end_ = block + size;
+}
+
+}  // namespace nanopb
+}  // namespace firestore
+}  // namespace firebase
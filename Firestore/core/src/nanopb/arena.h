@@ -0,0 +1,88 @@
+/*
+ * Copyright 2022 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef FIRESTORE_CORE_SRC_NANOPB_ARENA_H_
+#define FIRESTORE_CORE_SRC_NANOPB_ARENA_H_
+
+#include <pb.h>
+
+#include <cstddef>
+#include <vector>
+
+namespace firebase {
+namespace firestore {
+namespace nanopb {
+
+/**
+ * A region of memory that Nanopb protos can be allocated in.
+ *
+ * Allocations are carved out of a few large blocks and are never freed one by
+ * one; all of them are freed at once when the arena is destroyed. Protos
+ * allocated in an arena must therefore never be passed to
+ * `FreeNanopbMessage()` or wrapped in a `Message`.
+ *
+ * `Arena` is not thread-safe.
+ */
+class Arena {
+ public:
+  /**
+   * Creates an arena whose first block holds at least `initial_size` bytes,
+   * or a default size if `initial_size` is 0. Pass a small size for arenas
+   * that only hold a few small protos.
+   */
+  explicit Arena(size_t initial_size = 0);
+  ~Arena();
+
+  Arena(const Arena&) = delete;
+  Arena& operator=(const Arena&) = delete;
+
+  /**
+   * Returns `size` bytes of zeroed memory, suitably aligned for any Nanopb
+   * proto.
+   */
+  void* Allocate(size_t size);
+
+  /** Returns a zeroed array of `count` objects of type `T`. */
+  template <typename T>
+  T* MakeArray(size_t count) {
+    return static_cast<T*>(Allocate(sizeof(T) * count));
+  }
+
+  /**
+   * Creates a new, null-terminated byte array in the arena that's a copy of the
+   * given bytes. Unlike `nanopb::MakeBytesArray`, this never returns null.
+   */
+  pb_bytes_array_t* MakeBytesArray(const void* data, size_t size);
+
+  /** Returns the number of blocks allocated so far. */
+  size_t block_count() const {
+    return blocks_.size();
+  }
+
+ private:
+  void AddBlock(size_t min_size);
+
+  std::vector<char*> blocks_;
+  char* next_ = nullptr;
+  char* end_ = nullptr;
+  size_t next_block_size_;
+};
+
+}  // namespace nanopb
+}  // namespace firestore
+}  // namespace firebase
+
+#endif  // FIRESTORE_CORE_SRC_NANOPB_ARENA_H_
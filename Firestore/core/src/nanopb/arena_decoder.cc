@@ -0,0 +1,687 @@
+/*
+ * Copyright 2022 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Firestore/core/src/nanopb/arena_decoder.h"
+
+#include <cstring>
+
+#include "Firestore/core/src/nanopb/arena.h"
+#include "Firestore/core/src/util/read_context.h"
+
+namespace firebase {
+namespace firestore {
+namespace nanopb {
+namespace {
+
+// The wire types used by the Protobuf encoding. Groups are not supported, just
+// as in Nanopb.
+constexpr uint32_t kWireTypeVarint = 0;
+constexpr uint32_t kWireTypeFixed64 = 1;
+constexpr uint32_t kWireTypeLengthDelimited = 2;
+constexpr uint32_t kWireTypeFixed32 = 5;
+
+}  // namespace
+
+size_t ArenaDecoder::EstimateArenaSize(size_t encoded_size) {
+  // Decoded fields take up more room than their encoding: each entry in a map
+  // is a fixed-size struct and each string gains a size and a null terminator.
+  return encoded_size * 3;
+}
+
+firestore_client_MaybeDocument ArenaDecoder::DecodeMaybeDocumentWithoutFields(
+    absl::string_view bytes, absl::string_view* encoded_document) {
+  firestore_client_MaybeDocument result{};
+  *encoded_document = absl::string_view();
+  if (!context_->ok()) return result;
+
+  Input document{nullptr, nullptr};
+  if (ReadMaybeDocument(ToInput(bytes), &result, &document)) {
+    *encoded_document =
+        absl::string_view(reinterpret_cast<const char*>(document.pos),
+                          document.end - document.pos);
+  }
+  return result;
+}
+
+google_firestore_v1_MapValue ArenaDecoder::DecodeDocumentFields(
+    absl::string_view document) {
+  google_firestore_v1_MapValue result{};
+  if (!context_->ok()) return result;
+
+  ReadFields(ToInput(document), google_firestore_v1_Document_fields_tag,
+             &result.fields_count, &result.fields);
+  return result;
+}
+
+bool ArenaDecoder::DecodeDocumentField(absl::string_view document,
+                                       absl::string_view key,
+                                       google_firestore_v1_Value* result) {
+  absl::string_view encoded_value;
+  return FindDocumentField(document, key, &encoded_value) &&
+         DecodeValue(encoded_value, result);
+}
+
+bool ArenaDecoder::FindDocumentField(absl::string_view document,
+                                     absl::string_view key,
+                                     absl::string_view* encoded_value) {
+  if (!context_->ok()) return false;
+
+  bool exists = false;
+  Input in = ToInput(document);
+  while (!in.empty()) {
+    uint32_t field_number;
+    uint32_t wire_type;
+    if (!ReadTag(&in, &field_number, &wire_type)) return false;
+
+    if (field_number != google_firestore_v1_Document_fields_tag) {
+      if (!SkipField(&in, wire_type)) return false;
+      continue;
+    }
+
+    Input entry;
+    bool found = false;
+    Input value{nullptr, nullptr};
+    if (!CheckWireType(wire_type, kWireTypeLengthDelimited) ||
+        !ReadDelimited(&in, &entry) ||
+        !FindFieldsEntryValue(entry, key, &found, &value)) {
+      return false;
+    }
+    if (found) {
+      // Keep looking, since a later occurrence of the key replaces this one.
+      exists = true;
+      *encoded_value = absl::string_view(
+          reinterpret_cast<const char*>(value.pos),
+          static_cast<size_t>(value.end - value.pos));
+    }
+  }
+  return exists;
+}
+
+bool ArenaDecoder::DecodeValue(absl::string_view encoded_value,
+                               google_firestore_v1_Value* result) {
+  if (!context_->ok()) return false;
+  return ReadValue(ToInput(encoded_value), result);
+}
+
+ArenaDecoder::Input ArenaDecoder::ToInput(absl::string_view bytes) {
+  const auto* data = reinterpret_cast<const uint8_t*>(bytes.data());
+  return Input{data, data + bytes.size()};
+}
+
+/**
+ * Decodes a `firestore_client_MaybeDocument`, skipping the fields of a
+ * `document` and storing the encoded document in `encoded_document` instead.
+ */
+bool ArenaDecoder::ReadMaybeDocument(Input in,
+                                     firestore_client_MaybeDocument* result,
+                                     Input* encoded_document) {
+  while (!in.empty()) {
+    uint32_t field_number;
+    uint32_t wire_type;
+    if (!ReadTag(&in, &field_number, &wire_type)) return false;
+
+    switch (field_number) {
+      case firestore_client_MaybeDocument_no_document_tag:
+      case firestore_client_MaybeDocument_document_tag:
+      case firestore_client_MaybeDocument_unknown_document_tag: {
+        Input message;
+        if (!CheckWireType(wire_type, kWireTypeLengthDelimited) ||
+            !ReadDelimited(&in, &message)) {
+          return false;
+        }
+
+        bool ok;
+        if (field_number == firestore_client_MaybeDocument_no_document_tag) {
+          result->no_document = {};
+          ok = ReadNameAndVersion(message, &result->no_document.name,
+                                  &result->no_document.read_time);
+        } else if (field_number ==
+                   firestore_client_MaybeDocument_document_tag) {
+          result->document = {};
+          ok = ReadDocument(message, &result->document);
+          *encoded_document = message;
+        } else {
+          result->unknown_document = {};
+          ok = ReadNameAndVersion(message, &result->unknown_document.name,
+                                  &result->unknown_document.version);
+        }
+        if (!ok) return false;
+
+        // Like Nanopb, tag the oneof with the field number of its member.
+        result->which_document_type = static_cast<pb_size_t>(field_number);
+        break;
+      }
+
+      case firestore_client_MaybeDocument_has_committed_mutations_tag: {
+        uint64_t value;
+        if (!CheckWireType(wire_type, kWireTypeVarint) ||
+            !ReadVarint(&in, &value)) {
+          return false;
+        }
+        result->has_committed_mutations = value != 0;
+        break;
+      }
+
+      default:
+        if (!SkipField(&in, wire_type)) return false;
+        break;
+    }
+  }
+  return true;
+}
+
+bool ArenaDecoder::ReadDocument(Input in,
+                                google_firestore_v1_Document* result) {
+  while (!in.empty()) {
+    uint32_t field_number;
+    uint32_t wire_type;
+    if (!ReadTag(&in, &field_number, &wire_type)) return false;
+
+    switch (field_number) {
+      case google_firestore_v1_Document_name_tag:
+        if (!CheckWireType(wire_type, kWireTypeLengthDelimited) ||
+            !ReadBytes(&in, &result->name)) {
+          return false;
+        }
+        break;
+
+      case google_firestore_v1_Document_create_time_tag:
+      case google_firestore_v1_Document_update_time_tag: {
+        Input message;
+        if (!CheckWireType(wire_type, kWireTypeLengthDelimited) ||
+            !ReadDelimited(&in, &message)) {
+          return false;
+        }
+
+        if (field_number == google_firestore_v1_Document_create_time_tag) {
+          if (!ReadTimestamp(message, &result->create_time)) return false;
+        } else {
+          if (!ReadTimestamp(message, &result->update_time)) return false;
+          result->has_update_time = true;
+        }
+        break;
+      }
+
+      default:
+        // This includes the fields, which are left encoded.
+        if (!SkipField(&in, wire_type)) return false;
+        break;
+    }
+  }
+  return true;
+}
+
+// `UnknownDocument` has the same fields as `NoDocument`.
+bool ArenaDecoder::ReadNameAndVersion(Input in,
+                                      pb_bytes_array_t** name,
+                                      google_protobuf_Timestamp* version) {
+  while (!in.empty()) {
+    uint32_t field_number;
+    uint32_t wire_type;
+    if (!ReadTag(&in, &field_number, &wire_type)) return false;
+
+    switch (field_number) {
+      case firestore_client_NoDocument_name_tag:
+        if (!CheckWireType(wire_type, kWireTypeLengthDelimited) ||
+            !ReadBytes(&in, name)) {
+          return false;
+        }
+        break;
+
+      case firestore_client_NoDocument_read_time_tag: {
+        Input message;
+        if (!CheckWireType(wire_type, kWireTypeLengthDelimited) ||
+            !ReadDelimited(&in, &message) || !ReadTimestamp(message, version)) {
+          return false;
+        }
+        break;
+      }
+
+      default:
+        if (!SkipField(&in, wire_type)) return false;
+        break;
+    }
+  }
+  return true;
+}
+
+/**
+ * Decodes all occurrences of the repeated map entry field `field_number` in
+ * `in` into a single array allocated in the arena. Other fields are ignored.
+ */
+template <typename Entry>
+bool ArenaDecoder::ReadFields(Input in,
+                              uint32_t field_number,
+                              pb_size_t* count,
+                              Entry** fields) {
+  // Count the entries first so that they can be allocated as one array rather
+  // than grown one by one, as `pb_decode` does.
+  if (!CountRepeated(in, field_number, count)) return false;
+  if (*count == 0) return true;
+
+  *fields = arena_->MakeArray<Entry>(*count);
+  Entry* next = *fields;
+  while (!in.empty()) {
+    uint32_t current_field;
+    uint32_t wire_type;
+    if (!ReadTag(&in, &current_field, &wire_type)) return false;
+
+    if (current_field != field_number) {
+      if (!SkipField(&in, wire_type)) return false;
+      continue;
+    }
+
+    Input message;
+    if (!ReadDelimited(&in, &message) || !ReadFieldsEntry(message, next)) {
+      return false;
+    }
+    ++next;
+  }
+  return true;
+}
+
+template <typename Entry>
+bool ArenaDecoder::ReadFieldsEntry(Input in, Entry* result) {
+  // `Document_FieldsEntry` and `MapValue_FieldsEntry` share their field
+  // numbers.
+  while (!in.empty()) {
+    uint32_t field_number;
+    uint32_t wire_type;
+    if (!ReadTag(&in, &field_number, &wire_type)) return false;
+
+    switch (field_number) {
+      case google_firestore_v1_Document_FieldsEntry_key_tag:
+        if (!CheckWireType(wire_type, kWireTypeLengthDelimited) ||
+            !ReadBytes(&in, &result->key)) {
+          return false;
+        }
+        break;
+
+      case google_firestore_v1_Document_FieldsEntry_value_tag: {
+        Input message;
+        if (!CheckWireType(wire_type, kWireTypeLengthDelimited) ||
+            !ReadDelimited(&in, &message) ||
+            !ReadValue(message, &result->value)) {
+          return false;
+        }
+        break;
+      }
+
+      default:
+        if (!SkipField(&in, wire_type)) return false;
+        break;
+    }
+  }
+  return true;
+}
+
+/**
+ * Checks whether the map entry in `in` has the given `key`. If so, sets `found`
+ * and stores the entry's encoded value in `value`.
+ */
+bool ArenaDecoder::FindFieldsEntryValue(Input in,
+                                        absl::string_view key,
+                                        bool* found,
+                                        Input* value) {
+  bool key_matches = false;
+  while (!in.empty()) {
+    uint32_t field_number;
+    uint32_t wire_type;
+    if (!ReadTag(&in, &field_number, &wire_type)) return false;
+
+    switch (field_number) {
+      case google_firestore_v1_Document_FieldsEntry_key_tag: {
+        Input entry_key;
+        if (!CheckWireType(wire_type, kWireTypeLengthDelimited) ||
+            !ReadDelimited(&in, &entry_key)) {
+          return false;
+        }
+        key_matches =
+            absl::string_view(reinterpret_cast<const char*>(entry_key.pos),
+                              entry_key.end - entry_key.pos) == key;
+        break;
+      }
+
+      case google_firestore_v1_Document_FieldsEntry_value_tag:
+        if (!CheckWireType(wire_type, kWireTypeLengthDelimited) ||
+            !ReadDelimited(&in, value)) {
+          return false;
+        }
+        break;
+
+      default:
+        if (!SkipField(&in, wire_type)) return false;
+        break;
+    }
+  }
+
+  *found = key_matches;
+  return true;
+}
+
+bool ArenaDecoder::ReadValue(Input in, google_firestore_v1_Value* result) {
+  while (!in.empty()) {
+    uint32_t field_number;
+    uint32_t wire_type;
+    if (!ReadTag(&in, &field_number, &wire_type)) return false;
+
+    switch (field_number) {
+      case google_firestore_v1_Value_boolean_value_tag:
+      case google_firestore_v1_Value_integer_value_tag:
+      case google_firestore_v1_Value_null_value_tag: {
+        uint64_t value;
+        if (!CheckWireType(wire_type, kWireTypeVarint) ||
+            !ReadVarint(&in, &value)) {
+          return false;
+        }
+
+        if (field_number == google_firestore_v1_Value_boolean_value_tag) {
+          result->boolean_value = value != 0;
+        } else if (field_number ==
+                   google_firestore_v1_Value_integer_value_tag) {
+          result->integer_value = static_cast<int64_t>(value);
+        } else {
+          result->null_value = static_cast<google_protobuf_NullValue>(value);
+        }
+        break;
+      }
+
+      case google_firestore_v1_Value_double_value_tag:
+        if (!CheckWireType(wire_type, kWireTypeFixed64) ||
+            !ReadDouble(&in, &result->double_value)) {
+          return false;
+        }
+        break;
+
+      case google_firestore_v1_Value_reference_value_tag:
+      case google_firestore_v1_Value_string_value_tag:
+      case google_firestore_v1_Value_bytes_value_tag:
+        // All three members are a `pb_bytes_array_t*` at the same offset.
+        if (!CheckWireType(wire_type, kWireTypeLengthDelimited) ||
+            !ReadBytes(&in, &result->string_value)) {
+          return false;
+        }
+        break;
+
+      case google_firestore_v1_Value_map_value_tag:
+      case google_firestore_v1_Value_geo_point_value_tag:
+      case google_firestore_v1_Value_array_value_tag:
+      case google_firestore_v1_Value_timestamp_value_tag: {
+        Input message;
+        if (!CheckWireType(wire_type, kWireTypeLengthDelimited) ||
+            !ReadDelimited(&in, &message)) {
+          return false;
+        }
+
+        bool ok;
+        if (field_number == google_firestore_v1_Value_map_value_tag) {
+          result->map_value = {};
+          ok = ReadFields(message, google_firestore_v1_MapValue_fields_tag,
+                          &result->map_value.fields_count,
+                          &result->map_value.fields);
+        } else if (field_number ==
+                   google_firestore_v1_Value_geo_point_value_tag) {
+          result->geo_point_value = {};
+          ok = ReadLatLng(message, &result->geo_point_value);
+        } else if (field_number == google_firestore_v1_Value_array_value_tag) {
+          result->array_value = {};
+          ok = ReadArray(message, &result->array_value);
+        } else {
+          result->timestamp_value = {};
+          ok = ReadTimestamp(message, &result->timestamp_value);
+        }
+        if (!ok) return false;
+        break;
+      }
+
+      default:
+        if (!SkipField(&in, wire_type)) return false;
+        // Skipped fields are not members of the oneof.
+        continue;
+    }
+
+    result->which_value_type = static_cast<pb_size_t>(field_number);
+  }
+  return true;
+}
+
+bool ArenaDecoder::ReadArray(Input in,
+                             google_firestore_v1_ArrayValue* result) {
+  if (!CountRepeated(in, google_firestore_v1_ArrayValue_values_tag,
+                     &result->values_count)) {
+    return false;
+  }
+  if (result->values_count == 0) return true;
+
+  result->values =
+      arena_->MakeArray<google_firestore_v1_Value>(result->values_count);
+  google_firestore_v1_Value* next = result->values;
+  while (!in.empty()) {
+    uint32_t field_number;
+    uint32_t wire_type;
+    if (!ReadTag(&in, &field_number, &wire_type)) return false;
+
+    if (field_number != google_firestore_v1_ArrayValue_values_tag) {
+      if (!SkipField(&in, wire_type)) return false;
+      continue;
+    }
+
+    Input message;
+    if (!ReadDelimited(&in, &message) || !ReadValue(message, next)) {
+      return false;
+    }
+    ++next;
+  }
+  return true;
+}
+
+bool ArenaDecoder::ReadTimestamp(Input in, google_protobuf_Timestamp* result) {
+  while (!in.empty()) {
+    uint32_t field_number;
+    uint32_t wire_type;
+    if (!ReadTag(&in, &field_number, &wire_type)) return false;
+
+    uint64_t value;
+    switch (field_number) {
+      case google_protobuf_Timestamp_seconds_tag:
+        if (!CheckWireType(wire_type, kWireTypeVarint) ||
+            !ReadVarint(&in, &value)) {
+          return false;
+        }
+        result->seconds = static_cast<int64_t>(value);
+        break;
+
+      case google_protobuf_Timestamp_nanos_tag:
+        if (!CheckWireType(wire_type, kWireTypeVarint) ||
+            !ReadVarint(&in, &value)) {
+          return false;
+        }
+        result->nanos = static_cast<int32_t>(value);
+        break;
+
+      default:
+        if (!SkipField(&in, wire_type)) return false;
+        break;
+    }
+  }
+  return true;
+}
+
+bool ArenaDecoder::ReadLatLng(Input in, google_type_LatLng* result) {
+  while (!in.empty()) {
+    uint32_t field_number;
+    uint32_t wire_type;
+    if (!ReadTag(&in, &field_number, &wire_type)) return false;
+
+    switch (field_number) {
+      case google_type_LatLng_latitude_tag:
+        if (!CheckWireType(wire_type, kWireTypeFixed64) ||
+            !ReadDouble(&in, &result->latitude)) {
+          return false;
+        }
+        break;
+
+      case google_type_LatLng_longitude_tag:
+        if (!CheckWireType(wire_type, kWireTypeFixed64) ||
+            !ReadDouble(&in, &result->longitude)) {
+          return false;
+        }
+        break;
+
+      default:
+        if (!SkipField(&in, wire_type)) return false;
+        break;
+    }
+  }
+  return true;
+}
+
+/**
+ * Counts the occurrences of the repeated message field `field_number` in `in`,
+ * validating the framing of all fields along the way.
+ */
+bool ArenaDecoder::CountRepeated(Input in,
+                                 uint32_t field_number,
+                                 pb_size_t* count) {
+  size_t result = 0;
+  while (!in.empty()) {
+    uint32_t current_field;
+    uint32_t wire_type;
+    if (!ReadTag(&in, &current_field, &wire_type)) return false;
+
+    if (current_field == field_number) {
+      if (!CheckWireType(wire_type, kWireTypeLengthDelimited)) return false;
+      ++result;
+    }
+    if (!SkipField(&in, wire_type)) return false;
+  }
+
+  *count = static_cast<pb_size_t>(result);
+  if (*count != result) return Fail("array overflow");
+  return true;
+}
+
+bool ArenaDecoder::ReadTag(Input* in,
+                           uint32_t* field_number,
+                           uint32_t* wire_type) {
+  uint64_t tag;
+  if (!ReadVarint(in, &tag)) return false;
+  if (tag > UINT32_MAX) return Fail("invalid field number");
+
+  *field_number = static_cast<uint32_t>(tag >> 3);
+  *wire_type = static_cast<uint32_t>(tag & 7);
+  if (*field_number == 0) return Fail("invalid field number");
+  return true;
+}
+
+bool ArenaDecoder::ReadVarint(Input* in, uint64_t* result) {
+  uint64_t value = 0;
+  for (int shift = 0; shift < 64; shift += 7) {
+    if (in->empty()) return Fail("end-of-stream");
+
+    uint8_t byte = *in->pos++;
+    value |= static_cast<uint64_t>(byte & 0x7F) << shift;
+    if ((byte & 0x80) == 0) {
+      *result = value;
+      return true;
+    }
+  }
+  return Fail("varint overflow");
+}
+
+bool ArenaDecoder::ReadFixed64(Input* in, uint64_t* result) {
+  if (in->end - in->pos < 8) return Fail("end-of-stream");
+
+  // The encoding is little-endian regardless of the host.
+  uint64_t value = 0;
+  for (int i = 7; i >= 0; --i) {
+    value = (value << 8) | in->pos[i];
+  }
+  in->pos += 8;
+  *result = value;
+  return true;
+}
+
+bool ArenaDecoder::ReadDelimited(Input* in, Input* result) {
+  uint64_t size;
+  if (!ReadVarint(in, &size)) return false;
+  if (size > static_cast<uint64_t>(in->end - in->pos)) {
+    return Fail("end-of-stream");
+  }
+
+  result->pos = in->pos;
+  result->end = in->pos + size;
+  in->pos = result->end;
+  return true;
+}
+
+bool ArenaDecoder::ReadBytes(Input* in, pb_bytes_array_t** result) {
+  Input bytes;
+  if (!ReadDelimited(in, &bytes)) return false;
+  if (static_cast<size_t>(bytes.end - bytes.pos) > PB_SIZE_MAX) {
+    return Fail("bytes overflow");
+  }
+
+  // Like `pb_decode`, this allocates even empty strings.
+  *result = arena_->MakeBytesArray(bytes.pos, bytes.end - bytes.pos);
+  return true;
+}
+
+bool ArenaDecoder::ReadDouble(Input* in, double* result) {
+  uint64_t bits;
+  if (!ReadFixed64(in, &bits)) return false;
+
+  static_assert(sizeof(double) == sizeof(uint64_t), "Unexpected double size");
+  std::memcpy(result, &bits, sizeof(bits));
+  return true;
+}
+
+bool ArenaDecoder::SkipField(Input* in, uint32_t wire_type) {
+  switch (wire_type) {
+    case kWireTypeVarint: {
+      uint64_t ignored;
+      return ReadVarint(in, &ignored);
+    }
+    case kWireTypeFixed64: {
+      uint64_t ignored;
+      return ReadFixed64(in, &ignored);
+    }
+    case kWireTypeLengthDelimited: {
+      Input ignored;
+      return ReadDelimited(in, &ignored);
+    }
+    case kWireTypeFixed32:
+      if (in->end - in->pos < 4) return Fail("end-of-stream");
+      in->pos += 4;
+      return true;
+    default:
+      return Fail("invalid wire_type");
+  }
+}
+
+bool ArenaDecoder::CheckWireType(uint32_t actual, uint32_t expected) {
+  if (actual != expected) return Fail("wrong wire type");
+  return true;
+}
+
+bool ArenaDecoder::Fail(const char* description) {
+  context_->Fail(description);
+  return false;
+}
+
+}  // namespace nanopb
+}  // namespace firestore
+}  // namespace firebase
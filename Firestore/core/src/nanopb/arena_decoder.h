@@ -0,0 +1,167 @@
+/*
+ * Copyright 2022 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef FIRESTORE_CORE_SRC_NANOPB_ARENA_DECODER_H_
+#define FIRESTORE_CORE_SRC_NANOPB_ARENA_DECODER_H_
+
+#include <cstddef>
+#include <cstdint>
+
+#include "Firestore/Protos/nanopb/firestore/local/maybe_document.nanopb.h"
+#include "Firestore/Protos/nanopb/google/firestore/v1/document.nanopb.h"
+#include "absl/strings/string_view.h"
+
+namespace firebase {
+namespace firestore {
+
+namespace util {
+class ReadContext;
+}  // namespace util
+
+namespace nanopb {
+
+class Arena;
+
+/**
+ * Decodes the protos that make up remote documents directly into an `Arena`.
+ *
+ * The result has exactly the layout `pb_decode` would produce, so it can be
+ * passed to the serializers unchanged, but every string and repeated field
+ * lives in the arena instead of in its own heap allocation. Decoded protos must
+ * therefore not outlive the arena and must never be released with
+ * `FreeNanopbMessage()`.
+ *
+ * Decoding errors are reported through the given `ReadContext`; on failure,
+ * the returned proto is incomplete and must be discarded.
+ */
+class ArenaDecoder {
+ public:
+  ArenaDecoder(util::ReadContext* context, Arena* arena)
+      : context_(context), arena_(arena) {
+  }
+
+  /**
+   * Returns a size for an arena that most likely fits all protos decoded from
+   * `encoded_size` bytes in a single block.
+   */
+  static size_t EstimateArenaSize(size_t encoded_size);
+
+  /**
+   * Decodes a `firestore_client_MaybeDocument`, but leaves the fields of a
+   * `document` empty. Instead, `encoded_document` is set to the part of `bytes`
+   * that holds the encoded `google_firestore_v1_Document`, so that its fields
+   * can be decoded later with `DecodeDocumentFields` or `DecodeDocumentField`.
+   */
+  firestore_client_MaybeDocument DecodeMaybeDocumentWithoutFields(
+      absl::string_view bytes, absl::string_view* encoded_document);
+
+  /**
+   * Decodes all fields of the encoded `google_firestore_v1_Document` in
+   * `document` into a map, in the order in which they were encoded.
+   */
+  google_firestore_v1_MapValue DecodeDocumentFields(absl::string_view document);
+
+  /**
+   * Decodes only the top-level field `key` of the encoded
+   * `google_firestore_v1_Document` in `document` into `result`, skipping over
+   * all other fields. Like `FindDocumentField`, uses the last occurrence of a
+   * repeated key.
+   *
+   * @return Whether the field exists. Also false if decoding fails.
+   */
+  bool DecodeDocumentField(absl::string_view document,
+                           absl::string_view key,
+                           google_firestore_v1_Value* result);
+
+  /**
+   * Finds the top-level field `key` of the encoded
+   * `google_firestore_v1_Document` in `document` and sets `encoded_value` to
+   * its encoded value, which can be decoded later with `DecodeValue`. If the
+   * key occurs more than once, the last occurrence is used, as Protobuf does
+   * for maps.
+   *
+   * Nothing is allocated, so the decoder's arena may be null.
+   *
+   * @return Whether the field exists. Also false if decoding fails.
+   */
+  bool FindDocumentField(absl::string_view document,
+                         absl::string_view key,
+                         absl::string_view* encoded_value);
+
+  /** Decodes a `google_firestore_v1_Value` into `result`. */
+  bool DecodeValue(absl::string_view encoded_value,
+                   google_firestore_v1_Value* result);
+
+ private:
+  /** The yet unread part of an encoded message. */
+  struct Input {
+    bool empty() const {
+      return pos == end;
+    }
+
+    const uint8_t* pos;
+    const uint8_t* end;
+  };
+
+  static Input ToInput(absl::string_view bytes);
+
+  bool ReadMaybeDocument(Input in,
+                         firestore_client_MaybeDocument* result,
+                         Input* encoded_document);
+  bool ReadDocument(Input in, google_firestore_v1_Document* result);
+  bool ReadNameAndVersion(Input in,
+                          pb_bytes_array_t** name,
+                          google_protobuf_Timestamp* version);
+
+  template <typename Entry>
+  bool ReadFields(Input in,
+                  uint32_t field_number,
+                  pb_size_t* count,
+                  Entry** fields);
+  template <typename Entry>
+  bool ReadFieldsEntry(Input in, Entry* result);
+  bool FindFieldsEntryValue(Input in,
+                            absl::string_view key,
+                            bool* found,
+                            Input* value);
+
+  bool ReadValue(Input in, google_firestore_v1_Value* result);
+  bool ReadArray(Input in, google_firestore_v1_ArrayValue* result);
+  bool ReadTimestamp(Input in, google_protobuf_Timestamp* result);
+  bool ReadLatLng(Input in, google_type_LatLng* result);
+
+  bool CountRepeated(Input in, uint32_t field_number, pb_size_t* count);
+
+  bool ReadTag(Input* in, uint32_t* field_number, uint32_t* wire_type);
+  bool ReadVarint(Input* in, uint64_t* result);
+  bool ReadFixed64(Input* in, uint64_t* result);
+  bool ReadDelimited(Input* in, Input* result);
+  bool ReadBytes(Input* in, pb_bytes_array_t** result);
+  bool ReadDouble(Input* in, double* result);
+  bool SkipField(Input* in, uint32_t wire_type);
+  bool CheckWireType(uint32_t actual, uint32_t expected);
+
+  bool Fail(const char* description);
+
+  util::ReadContext* context_ = nullptr;
+  Arena* arena_ = nullptr;
+};
+
+}  // namespace nanopb
+}  // namespace firestore
+}  // namespace firebase
+
+#endif  // FIRESTORE_CORE_SRC_NANOPB_ARENA_DECODER_H_
@@ -180,6 +180,11 @@ inline const pb_field_t* FieldsArray<firestore_NamedQuery>() {
   return firestore_NamedQuery_fields;
 }
 
+template <>
+inline const pb_field_t* FieldsArray<firestore_BundleElement>() {
+  return firestore_BundleElement_fields;
+}
+
 template <>
 inline const pb_field_t* FieldsArray<google_firestore_admin_v1_Index>() {
   return google_firestore_admin_v1_Index_fields;
@@ -0,0 +1,143 @@
+/*
+ * Copyright 2022 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Firestore/core/src/remote/bloom_filter.h"
+
+#include <array>
+#include <utility>
+
+#include "Firestore/core/src/util/hard_assert.h"
+#include "Firestore/core/src/util/md5.h"
+#include "Firestore/core/src/util/status.h"
+#include "Firestore/core/src/util/string_format.h"
+
+namespace firebase {
+namespace firestore {
+namespace remote {
+namespace {
+
+using util::Status;
+using util::StatusOr;
+using util::StringFormat;
+
+Status ValidateParameters(size_t bitmap_size,
+                          int32_t padding,
+                          int32_t hash_count) {
+  if (padding < 0 || padding >= 8) {
+    return Status(Error::kErrorInvalidArgument,
+                  StringFormat("Invalid padding: %s", padding));
+  }
+  if (hash_count < 0) {
+    return Status(Error::kErrorInvalidArgument,
+                  StringFormat("Invalid hash count: %s", hash_count));
+  }
+  if (bitmap_size > 0 && hash_count == 0) {
+    // Only an empty bloom filter can have 0 hash count.
+    return Status(Error::kErrorInvalidArgument,
+                  StringFormat("Invalid hash count: %s", hash_count));
+  }
+  if (bitmap_size == 0 && padding != 0) {
+    // An empty bloom filter should have 0 padding.
+    return Status(Error::kErrorInvalidArgument,
+                  StringFormat("Expected padding of 0 when bitmap length is "
+                               "0, but got %s",
+                               padding));
+  }
+  if (bitmap_size > static_cast<size_t>(INT32_MAX / 8)) {
+    return Status(
+        Error::kErrorInvalidArgument,
+        StringFormat("Bitmap of %s bytes is too large", bitmap_size));
+  }
+  return Status::OK();
+}
+
+uint64_t ReadLittleEndian64(const uint8_t* bytes) {
+  uint64_t result = 0;
+  for (int i = 7; i >= 0; --i) {
+    result = (result << 8) | bytes[i];
+  }
+  return result;
+}
+
+}  // namespace
+
+BloomFilter::BloomFilter(std::vector<uint8_t> bitmap,
+                         int32_t padding,
+                         int32_t hash_count)
+    : bitmap_(std::move(bitmap)), padding_(padding), hash_count_(hash_count) {
+  Status status = ValidateParameters(bitmap_.size(), padding_, hash_count_);
+  HARD_ASSERT(status.ok(), "Invalid bloom filter: %s", status.error_message());
+  bit_count_ = static_cast<int32_t>(bitmap_.size() * 8) - padding_;
+}
+
+StatusOr<BloomFilter> BloomFilter::Create(std::vector<uint8_t> bitmap,
+                                          int32_t padding,
+                                          int32_t hash_count) {
+  Status status = ValidateParameters(bitmap.size(), padding, hash_count);
+  if (!status.ok()) {
+    return status;
+  }
+  return BloomFilter(std::move(bitmap), padding, hash_count);
+}
+
+BloomFilter::Hash BloomFilter::HashValue(absl::string_view value) {
+  std::array<uint8_t, 16> digest = util::CalculateMd5Digest(value);
+  Hash result;
+  result.h1 = ReadLittleEndian64(digest.data());
+  result.h2 = ReadLittleEndian64(digest.data() + 8);
+  return result;
+}
+
+int32_t BloomFilter::GetBitIndex(const Hash& hash, int32_t hash_index) const {
+  // Overflow is intentional: the backend computes the combined hash with
+  // wrapping unsigned 64-bit arithmetic too.
+  uint64_t combined = hash.h1 + static_cast<uint64_t>(hash_index) * hash.h2;
+  return static_cast<int32_t>(combined % static_cast<uint64_t>(bit_count_));
+}
+
+bool BloomFilter::MightContain(absl::string_view value) const {
+  if (bit_count_ == 0) {
+    return false;
+  }
+
+  Hash hash = HashValue(value);
+  for (int32_t i = 0; i < hash_count_; ++i) {
+    int32_t index = GetBitIndex(hash, i);
+    if ((bitmap_[index / 8] & (0x01 << (index % 8))) == 0) {
+      return false;
+    }
+  }
+  return true;
+}
+
+void BloomFilter::Insert(absl::string_view value) {
+  HARD_ASSERT(bit_count_ > 0, "Cannot insert into an empty bloom filter");
+
+  Hash hash = HashValue(value);
+  for (int32_t i = 0; i < hash_count_; ++i) {
+    int32_t index = GetBitIndex(hash, i);
+    bitmap_[index / 8] |= static_cast<uint8_t>(0x01 << (index % 8));
+  }
+}
+
+bool operator==(const BloomFilter& lhs, const BloomFilter& rhs) {
+  return lhs.hash_count_ == rhs.hash_count_ &&
+         lhs.bit_count_ == rhs.bit_count_ && lhs.bitmap_ == rhs.bitmap_;
+}
+
+}  // namespace remote
+}  // namespace firestore
+}  // namespace firebase
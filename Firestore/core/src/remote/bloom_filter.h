@@ -0,0 +1,114 @@
+/*
+ * Copyright 2022 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef FIRESTORE_CORE_SRC_REMOTE_BLOOM_FILTER_H_
+#define FIRESTORE_CORE_SRC_REMOTE_BLOOM_FILTER_H_
+
+#include <cstdint>
+#include <vector>
+
+#include "Firestore/core/src/util/statusor.h"
+#include "absl/strings/string_view.h"
+
+namespace firebase {
+namespace firestore {
+namespace remote {
+
+/**
+ * A bloom filter in the format sent by the backend alongside existence
+ * filters (see `google.firestore.v1.BloomFilter`).
+ *
+ * Each value is hashed with MD5, and the 128-bit digest is split into two
+ * little-endian 64-bit integers `h1` and `h2`. The `i`th of the `hash_count`
+ * bits probed for the value is `(h1 + i * h2) % bit_count`, where bit `n` is
+ * stored in `bitmap[n / 8] & (1 << (n % 8))`.
+ */
+class BloomFilter {
+ public:
+  /**
+   * Creates a bloom filter with the given bits; `padding` is the number of
+   * unused bits at the end of the last byte of `bitmap`.
+   *
+   * `bitmap`, `padding` and `hash_count` must be consistent; use `Create` to
+   * validate parameters that come from the network.
+   */
+  BloomFilter(std::vector<uint8_t> bitmap, int32_t padding, int32_t hash_count);
+
+  /**
+   * Creates a bloom filter with the given parameters, or returns an
+   * `InvalidArgument` error if they do not describe a valid bloom filter.
+   */
+  static util::StatusOr<BloomFilter> Create(std::vector<uint8_t> bitmap,
+                                            int32_t padding,
+                                            int32_t hash_count);
+
+  /**
+   * Returns false if `value` is definitely not in the filter, or true if it
+   * might be. An empty bloom filter contains nothing.
+   */
+  bool MightContain(absl::string_view value) const;
+
+  /**
+   * Adds `value` to the filter. The backend only ever sends complete filters;
+   * this exists so that tests and benchmarks can build their own.
+   */
+  void Insert(absl::string_view value);
+
+  const std::vector<uint8_t>& bitmap() const {
+    return bitmap_;
+  }
+
+  int32_t padding() const {
+    return padding_;
+  }
+
+  int32_t hash_count() const {
+    return hash_count_;
+  }
+
+  /** The number of usable bits in the filter. */
+  int32_t bit_count() const {
+    return bit_count_;
+  }
+
+  friend bool operator==(const BloomFilter& lhs, const BloomFilter& rhs);
+
+ private:
+  struct Hash {
+    uint64_t h1 = 0;
+    uint64_t h2 = 0;
+  };
+
+  static Hash HashValue(absl::string_view value);
+
+  /** Returns the bit probed by the `hash_index`th hash function. */
+  int32_t GetBitIndex(const Hash& hash, int32_t hash_index) const;
+
+  std::vector<uint8_t> bitmap_;
+  int32_t padding_ = 0;
+  int32_t hash_count_ = 0;
+  int32_t bit_count_ = 0;
+};
+
+inline bool operator!=(const BloomFilter& lhs, const BloomFilter& rhs) {
+  return !(lhs == rhs);
+}
+
+}  // namespace remote
+}  // namespace firestore
+}  // namespace firebase
+
+#endif  // FIRESTORE_CORE_SRC_REMOTE_BLOOM_FILTER_H_
@@ -26,6 +26,7 @@
 #include "Firestore/core/src/credentials/auth_token.h"
 #include "Firestore/core/src/credentials/credentials_fwd.h"
 #include "Firestore/core/src/credentials/credentials_provider.h"
+#include "Firestore/core/src/model/database_id.h"
 #include "Firestore/core/src/model/document_key.h"
 #include "Firestore/core/src/remote/grpc_call.h"
 #include "Firestore/core/src/remote/grpc_connection.h"
@@ -135,6 +136,10 @@ class Datastore : public std::enable_shared_from_this<Datastore> {
   static std::string GetAllowlistedHeadersAsString(
       const GrpcCall::Metadata& headers);
 
+  const model::DatabaseId& database_id() const {
+    return datastore_serializer_.serializer().database_id();
+  }
+
   Datastore(const Datastore& other) = delete;
   Datastore(Datastore&& other) = delete;
   Datastore& operator=(const Datastore& other) = delete;
@@ -17,6 +17,11 @@
 #ifndef FIRESTORE_CORE_SRC_REMOTE_EXISTENCE_FILTER_H_
 #define FIRESTORE_CORE_SRC_REMOTE_EXISTENCE_FILTER_H_
 
+#include <utility>
+
+#include "Firestore/core/src/remote/bloom_filter.h"
+#include "absl/types/optional.h"
+
 namespace firebase {
 namespace firestore {
 namespace remote {
@@ -26,17 +31,30 @@ class ExistenceFilter {
   ExistenceFilter() = default;
   explicit ExistenceFilter(int count) : count_{count} {
   }
+  ExistenceFilter(int count, absl::optional<BloomFilter> unchanged_names)
+      : count_{count}, unchanged_names_{std::move(unchanged_names)} {
+  }
 
   int count() const {
     return count_;
   }
 
+  /**
+   * A bloom filter of the names of the documents in the target that have not
+   * changed since the resume token, if the server sent one.
+   */
+  const absl::optional<BloomFilter>& unchanged_names() const {
+    return unchanged_names_;
+  }
+
  private:
   int count_ = 0;
+  absl::optional<BloomFilter> unchanged_names_;
 };
 
 inline bool operator==(const ExistenceFilter& lhs, const ExistenceFilter& rhs) {
-  return lhs.count() == rhs.count();
+  return lhs.count() == rhs.count() &&
+         lhs.unchanged_names() == rhs.unchanged_names();
 }
 
 }  // namespace remote
@@ -16,11 +16,15 @@
 
 #include "Firestore/core/src/remote/grpc_nanopb.h"
 
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
 #include <vector>
 
 #include "Firestore/core/include/firebase/firestore/firestore_errors.h"
 #include "Firestore/core/src/nanopb/writer.h"
 #include "Firestore/core/src/remote/grpc_util.h"
+#include "Firestore/core/src/util/hard_assert.h"
 #include "Firestore/core/src/util/status.h"
 #include "grpcpp/support/status.h"
 
@@ -28,13 +32,10 @@ namespace firebase {
 namespace firestore {
 namespace remote {
 
-using nanopb::ByteString;
-using nanopb::ByteStringWriter;
 using util::Status;
 
 ByteBufferReader::ByteBufferReader(const grpc::ByteBuffer& buffer) {
-  std::vector<grpc::Slice> slices;
-  grpc::Status status = buffer.Dump(&slices);
+  grpc::Status status = buffer.Dump(&slices_);
   // Conversion may fail if compression is used and gRPC tries to decompress an
   // ill-formed buffer.
   if (!status.ok()) {
@@ -45,14 +46,46 @@ ByteBufferReader::ByteBufferReader(const grpc::ByteBuffer& buffer) {
     return;
   }
 
-  ByteStringWriter writer;
-  writer.Reserve(buffer.Length());
-  for (const auto& slice : slices) {
-    writer.Append(slice.begin(), slice.size());
+  if (slices_.size() <= 1) {
+    // Fast path: borrow the bytes of the only slice, which stays alive as long
+    // as this reader does.
+    const uint8_t* data = slices_.empty() ? nullptr : slices_[0].begin();
+    size_t size = slices_.empty() ? 0 : slices_[0].size();
+    stream_ = pb_istream_from_buffer(data, size);
+    return;
   }
 
-  bytes_ = writer.Release();
-  stream_ = pb_istream_from_buffer(bytes_.data(), bytes_.size());
+  stream_.callback = ReadFromSlices;
+  stream_.state = this;
+  stream_.bytes_left = buffer.Length();
+}
+
+bool ByteBufferReader::ReadFromSlices(pb_istream_t* stream,
+                                      pb_byte_t* buf,
+                                      size_t count) {
+  auto reader = static_cast<ByteBufferReader*>(stream->state);
+  while (count > 0) {
+    if (reader->slice_index_ == reader->slices_.size()) {
+      PB_RETURN_ERROR(stream, "io error");
+    }
+
+    const grpc::Slice& slice = reader->slices_[reader->slice_index_];
+    size_t available = slice.size() - reader->slice_offset_;
+    size_t chunk = std::min(available, count);
+    // Nanopb skips over bytes by passing a null `buf`.
+    if (buf) {
+      std::memcpy(buf, slice.begin() + reader->slice_offset_, chunk);
+      buf += chunk;
+    }
+    count -= chunk;
+
+    reader->slice_offset_ += chunk;
+    if (reader->slice_offset_ == slice.size()) {
+      ++reader->slice_index_;
+      reader->slice_offset_ = 0;
+    }
+  }
+  return true;
 }
 
 void ByteBufferReader::Read(const pb_field_t* fields, void* dest_struct) {
@@ -65,11 +98,15 @@ void ByteBufferReader::Read(const pb_field_t* fields, void* dest_struct) {
 
 namespace {
 
+// Most messages sent to the backend are small (e.g. listen requests), so start
+// small and double the capacity as needed.
+constexpr size_t kMinBufferSize = 256;
+
 bool AppendToGrpcBuffer(pb_ostream_t* stream,
                         const pb_byte_t* buf,
                         size_t count) {
-  auto buffer = static_cast<std::vector<grpc::Slice>*>(stream->state);
-  buffer->emplace_back(buf, count);
+  auto writer = static_cast<ByteBufferWriter*>(stream->state);
+  writer->Append(buf, count);
   return true;
 }
 
@@ -77,14 +114,42 @@ bool AppendToGrpcBuffer(pb_ostream_t* stream,
 
 ByteBufferWriter::ByteBufferWriter() {
   stream_.callback = AppendToGrpcBuffer;
-  stream_.state = &buffer_;
+  stream_.state = this;
   stream_.max_size = SIZE_MAX;
 }
 
+ByteBufferWriter::~ByteBufferWriter() {
+  std::free(buffer_);
+}
+
+void ByteBufferWriter::Append(const void* data, size_t size) {
+  if (size == 0) return;
+
+  size_t required = size_ + size;
+  if (required > capacity_) {
+    size_t capacity = std::max({kMinBufferSize, capacity_ * 2, required});
+    auto grown = static_cast<uint8_t*>(std::realloc(buffer_, capacity));
+    HARD_ASSERT(grown != nullptr, "Failed to grow the gRPC message buffer");
+    buffer_ = grown;
+    capacity_ = capacity;
+  }
+
+  std::memcpy(buffer_ + size_, data, size);
+  size_ = required;
+}
+
 grpc::ByteBuffer ByteBufferWriter::Release() {
-  grpc::ByteBuffer result{buffer_.data(), buffer_.size()};
-  buffer_.clear();
-  return result;
+  if (size_ == 0) {
+    return grpc::ByteBuffer{nullptr, 0};
+  }
+
+  // The slice takes ownership of the buffer and frees it once gRPC is done
+  // with the message.
+  grpc::Slice slice{buffer_, size_, std::free};
+  buffer_ = nullptr;
+  size_ = 0;
+  capacity_ = 0;
+  return grpc::ByteBuffer{&slice, 1};
 }
 
 }  // namespace remote
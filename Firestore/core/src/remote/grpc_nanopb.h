@@ -20,6 +20,8 @@
 #include <pb.h>
 #include <pb_decode.h>
 
+#include <cstddef>
+#include <cstdint>
 #include <vector>
 
 #include "Firestore/core/src/nanopb/byte_string.h"
@@ -32,32 +34,69 @@ namespace firebase {
 namespace firestore {
 namespace remote {
 
-/** A `Reader` that reads from the given `grpc::ByteBuffer`. */
+/**
+ * A `Reader` that reads from the given `grpc::ByteBuffer` without copying it.
+ *
+ * The reader holds references to the slices of the buffer, so it doesn't
+ * depend on the lifetime of the buffer itself. A buffer made of a single slice
+ * (the common case for messages received from gRPC) is decoded in place;
+ * otherwise, Nanopb reads across the slices in order.
+ */
 class ByteBufferReader : public nanopb::Reader {
  public:
-  /**
-   * Copies the given `buffer` and associates the resulting stream with this
-   * `ByteBufferReader`.
-   */
-  // TODO(varconst): avoid copying the buffer.
   explicit ByteBufferReader(const grpc::ByteBuffer& buffer);
 
+  ByteBufferReader(const ByteBufferReader&) = delete;
+  ByteBufferReader& operator=(const ByteBufferReader&) = delete;
+
   void Read(const pb_field_t* fields, void* dest_struct) override;
 
  private:
-  nanopb::ByteString bytes_;
+  static bool ReadFromSlices(pb_istream_t* stream,
+                             pb_byte_t* buf,
+                             size_t count);
+
+  std::vector<grpc::Slice> slices_;
+  size_t slice_index_ = 0;
+  size_t slice_offset_ = 0;
   pb_istream_t stream_{};
 };
 
-/** A `Writer` that writes into a `grpc::ByteBuffer`. */
+/**
+ * A `Writer` that writes into a `grpc::ByteBuffer`.
+ *
+ * Nanopb writes each field separately, so the encoded bytes are collected in a
+ * single growable buffer whose ownership is handed over to gRPC as one slice
+ * on `Release()`, instead of creating a slice per write.
+ */
 class ByteBufferWriter : public nanopb::Writer {
  public:
   ByteBufferWriter();
+  ~ByteBufferWriter();
+
+  ByteBufferWriter(const ByteBufferWriter&) = delete;
+  ByteBufferWriter& operator=(const ByteBufferWriter&) = delete;
+
+  /**
+   * Appends the given data to the internal buffer, growing the capacity of the
+   * buffer to fit.
+   */
+  void Append(const void* data, size_t size);
 
+  /**
+   * Returns a `grpc::ByteBuffer` made of a single slice that takes ownership of
+   * the bytes backing this writer.
+   */
   grpc::ByteBuffer Release();
 
+  size_t size() const {
+    return size_;
+  }
+
  private:
-  std::vector<grpc::Slice> buffer_;
+  uint8_t* buffer_ = nullptr;
+  size_t size_ = 0;
+  size_t capacity_ = 0;
 };
 
 /**
@@ -16,9 +16,12 @@
 
 #include "Firestore/core/src/remote/remote_event.h"
 
+#include <string>
 #include <utility>
 
 #include "Firestore/core/src/local/target_data.h"
+#include "Firestore/core/src/util/log.h"
+#include "absl/strings/str_cat.h"
 
 namespace firebase {
 namespace firestore {
@@ -28,6 +31,7 @@ using core::DocumentViewChange;
 using core::Target;
 using local::QueryPurpose;
 using local::TargetData;
+using model::DatabaseId;
 using model::DocumentKey;
 using model::DocumentKeySet;
 using model::MutableDocument;
@@ -234,7 +238,8 @@ void WatchChangeAggregator::HandleExistenceFilter(
       }
     } else {
       int current_size = GetCurrentDocumentCountForTarget(target_id);
-      if (current_size != expected_count) {
+      if (current_size != expected_count &&
+          !ApplyBloomFilter(existence_filter)) {
         // Existence filter mismatch: We reset the mapping and raise a new
         // snapshot with `isFromCache:true`.
         ResetTarget(target_id);
@@ -244,6 +249,60 @@ void WatchChangeAggregator::HandleExistenceFilter(
   }
 }
 
+bool WatchChangeAggregator::ApplyBloomFilter(
+    const ExistenceFilterWatchChange& existence_filter) {
+  const absl::optional<BloomFilter>& bloom_filter =
+      existence_filter.filter().unchanged_names();
+  if (!bloom_filter || bloom_filter->bit_count() == 0) {
+    return false;
+  }
+
+  TargetId target_id = existence_filter.target_id();
+  int removed_count = FilterRemovedDocuments(*bloom_filter, target_id);
+  int current_count = GetCurrentDocumentCountForTarget(target_id);
+  int expected_count = existence_filter.filter().count();
+  if (current_count != expected_count) {
+    LOG_DEBUG(
+        "Bloom filter removed %s documents from target %s but left %s, "
+        "expected %s; resetting the target",
+        removed_count, target_id, current_count, expected_count);
+    return false;
+  }
+  return true;
+}
+
+int WatchChangeAggregator::FilterRemovedDocuments(
+    const BloomFilter& bloom_filter, TargetId target_id) {
+  const DatabaseId& database_id = target_metadata_provider_->GetDatabaseId();
+  std::string prefix =
+      absl::StrCat("projects/", database_id.project_id(), "/databases/",
+                   database_id.database_id(), "/documents/");
+
+  // The bloom filter only contains the documents that haven't changed since
+  // the resume token. Documents that changed were sent to us before the
+  // existence filter and already have a pending change that must be kept.
+  TargetChange pending_changes = EnsureTargetState(target_id).ToTargetChange();
+
+  int removed_count = 0;
+  std::string name;
+  DocumentKeySet existing_keys =
+      target_metadata_provider_->GetRemoteKeysForTarget(target_id);
+  for (const DocumentKey& key : existing_keys) {
+    if (pending_changes.modified_documents().contains(key) ||
+        pending_changes.removed_documents().contains(key)) {
+      continue;
+    }
+
+    name = prefix;
+    absl::StrAppend(&name, key.path().CanonicalString());
+    if (!bloom_filter.MightContain(name)) {
+      RemoveDocumentFromTarget(target_id, key, absl::nullopt);
+      ++removed_count;
+    }
+  }
+  return removed_count;
+}
+
 RemoteEvent WatchChangeAggregator::CreateRemoteEvent(
     const SnapshotVersion& snapshot_version) {
   std::unordered_map<TargetId, TargetChange> target_changes;
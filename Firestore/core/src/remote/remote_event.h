@@ -24,6 +24,7 @@
 #include <vector>
 
 #include "Firestore/core/src/core/view_snapshot.h"
+#include "Firestore/core/src/model/database_id.h"
 #include "Firestore/core/src/model/document_key.h"
 #include "Firestore/core/src/model/document_key_set.h"
 #include "Firestore/core/src/model/mutable_document.h"
@@ -62,6 +63,12 @@ class TargetMetadataProvider {
    */
   virtual absl::optional<local::TargetData> GetTargetDataForTarget(
       model::TargetId target_id) const = 0;
+
+  /**
+   * Returns the database that the targets belong to, which is needed to match
+   * document keys against the full resource names in bloom filters.
+   */
+  virtual const model::DatabaseId& GetDatabaseId() const = 0;
 };
 
 /**
@@ -317,8 +324,11 @@ class WatchChangeAggregator {
 
   /**
    * Handles existence filters and synthesizes deletes for filter mismatches.
-   * Targets that are invalidated by filter mismatches are added to
-   * `pending_target_resets_`.
+   *
+   * If the filter comes with a bloom filter of the unchanged documents, the
+   * documents that are definitely not in it are removed from the target. Only
+   * if that still doesn't reconcile the counts is the target invalidated and
+   * added to `pending_target_resets_`.
    */
   void HandleExistenceFilter(
       const ExistenceFilterWatchChange& existence_filter);
@@ -367,6 +377,23 @@ class WatchChangeAggregator {
       const model::DocumentKey& key,
       const absl::optional<model::MutableDocument>& updated_document);
 
+  /**
+   * Uses the bloom filter sent with an existence filter to remove the
+   * documents that no longer match the target. Returns true if the target is
+   * consistent with the server afterwards, or false if the target still has to
+   * be reset (because there is no usable bloom filter, or because false
+   * positives left too many documents in the target).
+   */
+  bool ApplyBloomFilter(const ExistenceFilterWatchChange& existence_filter);
+
+  /**
+   * Removes every document that the LocalStore considers to be part of the
+   * target but that is definitely not in `bloom_filter`. Returns the number of
+   * documents removed.
+   */
+  int FilterRemovedDocuments(const BloomFilter& bloom_filter,
+                             model::TargetId target_id);
+
   /**
    * Returns the current count of documents in the target. This includes both
    * the number of documents that the LocalStore considers to be part of the
@@ -16,8 +16,10 @@
 
 #include "Firestore/core/src/remote/remote_store.h"
 
+#include <iterator>
 #include <string>
 #include <utility>
+#include <vector>
 
 #include "Firestore/core/src/core/transaction.h"
 #include "Firestore/core/src/local/local_store.h"
@@ -40,8 +42,10 @@ using local::LocalStore;
 using local::QueryPurpose;
 using local::TargetData;
 using model::BatchId;
+using model::DatabaseId;
 using model::DocumentKeySet;
 using model::kBatchIdUnknown;
+using model::Mutation;
 using model::MutationBatch;
 using model::MutationBatchResult;
 using model::MutationResult;
@@ -53,21 +57,29 @@ using util::AsyncQueue;
 using util::Status;
 
 /**
- * The maximum number of pending writes to allow.
- * TODO(b/35853402): Negotiate this value with the backend.
+ * The most writes the backend accepts in a single commit. Batches are never
+ * coalesced past this.
  */
-constexpr int kMaxPendingWrites = 10;
+constexpr size_t kMaxWritesPerRequest = 500;
 
 RemoteStore::RemoteStore(
     LocalStore* local_store,
     std::shared_ptr<Datastore> datastore,
     const std::shared_ptr<util::AsyncQueue>& worker_queue,
     ConnectivityMonitor* connectivity_monitor,
-    std::function<void(model::OnlineState)> online_state_handler)
+    std::function<void(model::OnlineState)> online_state_handler,
+    WritePipelineWindow write_pipeline_window,
+    int max_batches_per_write_request)
     : local_store_{local_store},
       datastore_{std::move(datastore)},
       online_state_tracker_{worker_queue, std::move(online_state_handler)},
-      connectivity_monitor_{NOT_NULL(connectivity_monitor)} {
+      connectivity_monitor_{NOT_NULL(connectivity_monitor)},
+      write_pipeline_window_{std::move(write_pipeline_window)},
+      max_batches_per_write_request_{max_batches_per_write_request} {
+  HARD_ASSERT(max_batches_per_write_request_ > 0,
+              "Write requests must hold at least one batch, got %s",
+              max_batches_per_write_request_);
+
   datastore_->Start();
 
   // Create streams (but note they're not started yet)
@@ -133,6 +145,7 @@ void RemoteStore::DisableNetworkInternal() {
               write_pipeline_.size());
     write_pipeline_.clear();
   }
+  ClearSentWriteRequests();
 
   CleanUpWatchStreamState();
 }
@@ -384,13 +397,19 @@ void RemoteStore::FillWritePipeline() {
     last_batch_id_retrieved = batch->batch_id();
   }
 
+  // When coalescing, `AddToWritePipeline` leaves it to us to send the batches
+  // we just fetched, so that they can share write requests.
+  SendPendingWrites();
+
   if (ShouldStartWriteStream()) {
     StartWriteStream();
   }
 }
 
 bool RemoteStore::CanAddToWritePipeline() const {
-  return CanUseNetwork() && write_pipeline_.size() < kMaxPendingWrites;
+  return CanUseNetwork() &&
+         write_pipeline_.size() <
+             static_cast<size_t>(write_pipeline_window_.size());
 }
 
 void RemoteStore::AddToWritePipeline(const MutationBatch& batch) {
@@ -399,11 +418,63 @@ void RemoteStore::AddToWritePipeline(const MutationBatch& batch) {
 
   write_pipeline_.push_back(batch);
 
-  if (write_stream_->IsOpen() && write_stream_->handshake_complete()) {
-    write_stream_->WriteMutations(batch.mutations());
+  if (max_batches_per_write_request_ == 1) {
+    SendPendingWrites();
+  }
+}
+
+void RemoteStore::SendPendingWrites() {
+  if (!write_stream_->IsOpen() || !write_stream_->handshake_complete()) {
+    return;
+  }
+
+  auto max_batches = static_cast<size_t>(max_batches_per_write_request_);
+  auto now = WritePipelineWindow::Clock::now();
+  while (sent_write_count_ < write_pipeline_.size()) {
+    size_t begin = sent_write_count_;
+    size_t end = begin + 1;
+
+    if (writes_to_send_individually_ > 0) {
+      --writes_to_send_individually_;
+    } else {
+      size_t write_count = write_pipeline_[begin].mutations().size();
+      while (end < write_pipeline_.size() && end - begin < max_batches) {
+        size_t next_count = write_pipeline_[end].mutations().size();
+        if (write_count + next_count > kMaxWritesPerRequest) {
+          break;
+        }
+        write_count += next_count;
+        ++end;
+      }
+    }
+
+    if (end - begin == 1) {
+      write_stream_->WriteMutations(write_pipeline_[begin].mutations());
+    } else {
+      std::vector<Mutation> mutations;
+      for (size_t i = begin; i != end; ++i) {
+        const std::vector<Mutation>& batch_mutations =
+            write_pipeline_[i].mutations();
+        mutations.insert(mutations.end(), batch_mutations.begin(),
+                         batch_mutations.end());
+      }
+      write_stream_->WriteMutations(mutations);
+    }
+
+    for (size_t i = begin; i != end; ++i) {
+      write_pipeline_window_.OnWriteSent(now);
+    }
+    sent_write_requests_.push_back(end - begin);
+    sent_write_count_ = end;
   }
 }
 
+void RemoteStore::ClearSentWriteRequests() {
+  sent_write_requests_.clear();
+  sent_write_count_ = 0;
+  write_pipeline_window_.ClearInFlight();
+}
+
 bool RemoteStore::ShouldStartWriteStream() const {
   return CanUseNetwork() && !write_stream_->IsStarted() &&
          !write_pipeline_.empty();
@@ -424,25 +495,48 @@ void RemoteStore::OnWriteStreamHandshakeComplete() {
   local_store_->SetLastStreamToken(write_stream_->last_stream_token());
 
   // Send the write pipeline now that the stream is established.
-  for (const MutationBatch& write : write_pipeline_) {
-    write_stream_->WriteMutations(write.mutations());
-  }
+  SendPendingWrites();
 }
 
 void RemoteStore::OnWriteStreamMutationResult(
     SnapshotVersion commit_version,
     std::vector<MutationResult> mutation_results) {
   // This is a response to a write containing mutations and should be correlated
-  // to the first write in our write pipeline.
-  HARD_ASSERT(!write_pipeline_.empty(), "Got result for empty write pipeline");
-
-  MutationBatch batch = write_pipeline_.front();
-  write_pipeline_.erase(write_pipeline_.begin());
-
-  MutationBatchResult batch_result(std::move(batch), commit_version,
-                                   std::move(mutation_results),
-                                   write_stream_->last_stream_token());
-  sync_engine_->HandleSuccessfulWrite(std::move(batch_result));
+  // to the first write request in our write pipeline, which may hold several
+  // batches.
+  HARD_ASSERT(!sent_write_requests_.empty(),
+              "Got result for empty write pipeline");
+
+  size_t batch_count = sent_write_requests_.front();
+  sent_write_requests_.pop_front();
+  sent_write_count_ -= batch_count;
+
+  size_t write_count = 0;
+  for (size_t i = 0; i != batch_count; ++i) {
+    write_count += write_pipeline_[i].mutations().size();
+  }
+  HARD_ASSERT(write_count == mutation_results.size(),
+              "Number of mutations sent %s must equal results received %s",
+              write_count, mutation_results.size());
+
+  auto now = WritePipelineWindow::Clock::now();
+  auto results_begin = mutation_results.begin();
+  for (size_t i = 0; i != batch_count; ++i) {
+    MutationBatch batch = write_pipeline_.front();
+    write_pipeline_.erase(write_pipeline_.begin());
+    write_pipeline_window_.OnWriteAcknowledged(now);
+
+    auto results_end = results_begin + batch.mutations().size();
+    std::vector<MutationResult> batch_results(
+        std::make_move_iterator(results_begin),
+        std::make_move_iterator(results_end));
+    results_begin = results_end;
+
+    MutationBatchResult batch_result(std::move(batch), commit_version,
+                                     std::move(batch_results),
+                                     write_stream_->last_stream_token());
+    sync_engine_->HandleSuccessfulWrite(std::move(batch_result));
+  }
 
   // It's possible that with the completion of this mutation another slot has
   // freed up.
@@ -457,6 +551,17 @@ void RemoteStore::OnWriteStreamClose(const Status& status) {
                 "Write stream was stopped gracefully while still needed.");
   }
 
+  // Any writes still in flight will be sent again once the stream restarts.
+  // Unless the writes themselves were rejected, an error with writes in flight
+  // means the backend is struggling to keep up: send fewer of them next time.
+  if (!status.ok() && write_pipeline_window_.in_flight() > 0 &&
+      !Datastore::IsPermanentWriteError(status)) {
+    write_pipeline_window_.OnWriteStreamError();
+  }
+  size_t failed_request_size =
+      sent_write_requests_.empty() ? 1 : sent_write_requests_.front();
+  ClearSentWriteRequests();
+
   // If the write stream closed due to an error, invoke the error callbacks if
   // there are pending writes.
   if (!status.ok() && !write_pipeline_.empty()) {
@@ -464,7 +569,7 @@ void RemoteStore::OnWriteStreamClose(const Status& status) {
     // go/firestore-client-errors
     if (write_stream_->handshake_complete()) {
       // This error affects the actual writes.
-      HandleWriteError(status);
+      HandleWriteError(status, failed_request_size);
     } else {
       // If there was an error before the handshake finished, it's possible that
       // the server is unable to process the stream token we're sending.
@@ -501,7 +606,8 @@ void RemoteStore::HandleHandshakeError(const Status& status) {
   }
 }
 
-void RemoteStore::HandleWriteError(const Status& status) {
+void RemoteStore::HandleWriteError(const Status& status,
+                                   size_t failed_request_size) {
   HARD_ASSERT(!status.ok(), "Handling write error with status OK.");
 
   // Only handle permanent errors here. If it's transient, just let the retry
@@ -510,6 +616,19 @@ void RemoteStore::HandleWriteError(const Status& status) {
     return;
   }
 
+  if (failed_request_size > 1) {
+    // The request held several coalesced batches and there's no telling which
+    // of them the backend rejected. Resend them one at a time so that the
+    // offending batch fails on its own and the others still go through.
+    LOG_DEBUG(
+        "RemoteStore %s coalesced write of %s batches failed; retrying them "
+        "individually: error code: '%s', details: '%s'",
+        this, failed_request_size, status.code(), status.error_message());
+    writes_to_send_individually_ = failed_request_size;
+    write_stream_->InhibitBackoff();
+    return;
+  }
+
   // If this was a permanent error, the request itself was the problem so it's
   // not going to succeed if we resend it.
   MutationBatch batch = write_pipeline_.front();
@@ -547,6 +666,10 @@ absl::optional<TargetData> RemoteStore::GetTargetDataForTarget(
                                         : absl::optional<TargetData>{};
 }
 
+const DatabaseId& RemoteStore::GetDatabaseId() const {
+  return datastore_->database_id();
+}
+
 void RemoteStore::RestartNetwork() {
   is_network_enabled_ = false;
   DisableNetworkInternal();
@@ -17,6 +17,7 @@
 #ifndef FIRESTORE_CORE_SRC_REMOTE_REMOTE_STORE_H_
 #define FIRESTORE_CORE_SRC_REMOTE_REMOTE_STORE_H_
 
+#include <deque>
 #include <memory>
 #include <unordered_map>
 #include <vector>
@@ -31,6 +32,7 @@
 #include "Firestore/core/src/remote/remote_event.h"
 #include "Firestore/core/src/remote/watch_change.h"
 #include "Firestore/core/src/remote/watch_stream.h"
+#include "Firestore/core/src/remote/write_pipeline_window.h"
 #include "Firestore/core/src/remote/write_stream.h"
 #include "Firestore/core/src/util/async_queue.h"
 #include "Firestore/core/src/util/status_fwd.h"
@@ -112,7 +114,9 @@ class RemoteStore : public TargetMetadataProvider,
               std::shared_ptr<Datastore> datastore,
               const std::shared_ptr<util::AsyncQueue>& worker_queue,
               ConnectivityMonitor* connectivity_monitor,
-              std::function<void(model::OnlineState)> online_state_handler);
+              std::function<void(model::OnlineState)> online_state_handler,
+              WritePipelineWindow write_pipeline_window = {},
+              int max_batches_per_write_request = 1);
 
   void set_sync_engine(RemoteStoreCallback* sync_engine) {
     sync_engine_ = sync_engine;
@@ -180,10 +184,19 @@ class RemoteStore : public TargetMetadataProvider,
 
   /**
    * Queues additional writes to be sent to the write stream, sending them
-   * immediately if the write stream is established.
+   * immediately if the write stream is established. When batches are being
+   * coalesced they are instead sent by the next `FillWritePipeline`.
    */
   void AddToWritePipeline(const model::MutationBatch& batch);
 
+  /**
+   * The window bounding the write pipeline, along with the number of writes
+   * currently in flight and the latencies of their acks.
+   */
+  const WritePipelineWindow& write_pipeline_window() const {
+    return write_pipeline_window_;
+  }
+
   /** Returns a new transaction backed by this remote store. */
   // TODO(c++14): return a plain value when it becomes possible to move
   // `Transaction` into lambdas.
@@ -193,6 +206,7 @@ class RemoteStore : public TargetMetadataProvider,
       model::TargetId target_id) const override;
   absl::optional<local::TargetData> GetTargetDataForTarget(
       model::TargetId target_id) const override;
+  const model::DatabaseId& GetDatabaseId() const override;
 
   void OnWatchStreamOpen() override;
   void OnWatchStreamChange(
@@ -237,8 +251,29 @@ class RemoteStore : public TargetMetadataProvider,
    */
   bool ShouldStartWriteStream() const;
 
+  /**
+   * Sends the writes in the write pipeline that haven't been sent on the
+   * current stream yet, packing up to `max_batches_per_write_request_`
+   * consecutive batches into each write request. Does nothing unless the
+   * stream is established.
+   */
+  void SendPendingWrites();
+
+  /**
+   * Forgets which writes were sent on the current stream, so that they are all
+   * sent again once it is re-established.
+   */
+  void ClearSentWriteRequests();
+
   void HandleHandshakeError(const util::Status& status);
-  void HandleWriteError(const util::Status& status);
+
+  /**
+   * Handles a write stream error that affects the writes themselves.
+   * `failed_request_size` is the number of batches in the write request the
+   * error applies to.
+   */
+  void HandleWriteError(const util::Status& status,
+                        size_t failed_request_size);
 
   void StartWatchStream();
 
@@ -287,9 +322,9 @@ class RemoteStore : public TargetMetadataProvider,
   std::unique_ptr<WatchChangeAggregator> watch_change_aggregator_;
 
   /**
-   * A list of up to `kMaxPendingWrites` writes that we have fetched from the
-   * `LocalStore` via `FillWritePipeline` and have or will send to the write
-   * stream.
+   * A list of up to `write_pipeline_window_.size()` writes that we have
+   * fetched from the `LocalStore` via `FillWritePipeline` and have or will send
+   * to the write stream.
    *
    * Whenever `write_pipeline_` is not empty, the `RemoteStore` will attempt to
    * start or restart the write stream. When the stream is established, the
@@ -304,6 +339,33 @@ class RemoteStore : public TargetMetadataProvider,
    * the `write_pipeline_` as we receive responses.
    */
   std::vector<model::MutationBatch> write_pipeline_;
+
+  WritePipelineWindow write_pipeline_window_;
+
+  /**
+   * The most batches to coalesce into a single write request. Coalescing is
+   * disabled if this is 1.
+   */
+  int max_batches_per_write_request_ = 1;
+
+  /**
+   * The number of batches in each write request sent on the current stream
+   * and not acknowledged yet, oldest first. The backend acknowledges each
+   * request with a single response covering all of its batches.
+   */
+  std::deque<size_t> sent_write_requests_;
+
+  /**
+   * The total number of batches in `sent_write_requests_`; these are always
+   * the first batches in `write_pipeline_`.
+   */
+  size_t sent_write_count_ = 0;
+
+  /**
+   * The number of batches to send in write requests of their own before
+   * coalescing again, used to isolate a batch the backend rejected.
+   */
+  size_t writes_to_send_individually_ = 0;
 };
 
 }  // namespace remote
@@ -50,10 +50,12 @@
 #include "Firestore/core/src/nanopb/writer.h"
 #include "Firestore/core/src/timestamp_internal.h"
 #include "Firestore/core/src/util/hard_assert.h"
+#include "Firestore/core/src/util/log.h"
 #include "Firestore/core/src/util/status.h"
 #include "Firestore/core/src/util/statusor.h"
 #include "Firestore/core/src/util/string_format.h"
 #include "absl/algorithm/container.h"
+#include "absl/strings/str_cat.h"
 #include "absl/types/span.h"
 
 namespace firebase {
@@ -111,6 +113,7 @@ using nanopb::SafeReadBoolean;
 using nanopb::SetRepeatedField;
 using nanopb::SharedMessage;
 using nanopb::Writer;
+using remote::BloomFilter;
 using remote::WatchChange;
 using util::ReadContext;
 using util::Status;
@@ -183,7 +186,7 @@ pb_bytes_array_t* Serializer::EncodeDatabaseName() const {
 }
 
 pb_bytes_array_t* Serializer::EncodeKey(const DocumentKey& key) const {
-  return EncodeResourceName(database_id_, key.path());
+  return EncodeResourceName(database_id_, key);
 }
 
 void Serializer::ValidateDocumentKeyPath(
@@ -258,6 +261,17 @@ pb_bytes_array_t* Serializer::EncodeResourceName(
                                       .CanonicalString());
 }
 
+pb_bytes_array_t* Serializer::EncodeResourceName(
+    const DatabaseId& database_id, const DocumentKey& key) const {
+  std::string name =
+      absl::StrCat("projects/", database_id.project_id(), "/databases/",
+                   database_id.database_id(), "/documents");
+  for (size_t i = 0; i < key.path_size(); ++i) {
+    absl::StrAppend(&name, "/", key.segment(i));
+  }
+  return Serializer::EncodeString(name);
+}
+
 ResourcePath Serializer::DecodeResourceName(ReadContext* context,
                                             absl::string_view encoded) const {
   auto resource = ResourcePath::FromStringView(encoded);
@@ -1393,9 +1407,29 @@ std::unique_ptr<WatchChange> Serializer::DecodeDocumentRemove(
 
 std::unique_ptr<WatchChange> Serializer::DecodeExistenceFilterWatchChange(
     ReadContext*, const google_firestore_v1_ExistenceFilter& filter) const {
-  ExistenceFilter existence_filter{filter.count};
-  return absl::make_unique<ExistenceFilterWatchChange>(existence_filter,
-                                                       filter.target_id);
+  absl::optional<BloomFilter> unchanged_names;
+  if (filter.has_unchanged_names) {
+    const google_firestore_v1_BitSequence& bits = filter.unchanged_names.bits;
+    std::vector<uint8_t> bitmap;
+    if (bits.bitmap) {
+      bitmap.assign(bits.bitmap->bytes, bits.bitmap->bytes + bits.bitmap->size);
+    }
+
+    // A malformed bloom filter only costs us the optimization: the target is
+    // reset as if the server hadn't sent one, so don't fail the stream.
+    StatusOr<BloomFilter> maybe_filter = BloomFilter::Create(
+        std::move(bitmap), bits.padding, filter.unchanged_names.hash_count);
+    if (maybe_filter.ok()) {
+      unchanged_names = std::move(maybe_filter).ValueOrDie();
+    } else {
+      LOG_WARN("Ignoring invalid bloom filter for target %s: %s",
+               filter.target_id, maybe_filter.status().error_message());
+    }
+  }
+
+  ExistenceFilter existence_filter{filter.count, std::move(unchanged_names)};
+  return absl::make_unique<ExistenceFilterWatchChange>(
+      std::move(existence_filter), filter.target_id);
 }
 
 bool Serializer::IsLocalResourceName(const ResourcePath& path) const {
@@ -235,6 +235,13 @@ class Serializer {
   pb_bytes_array_t* EncodeResourceName(const model::DatabaseId& database_id,
                                        const model::ResourcePath& path) const;
 
+  /**
+   * Encodes a database ID and the path of `key` like the overload above,
+   * without rebuilding the path as a `ResourcePath`.
+   */
+  pb_bytes_array_t* EncodeResourceName(const model::DatabaseId& database_id,
+                                       const model::DocumentKey& key) const;
+
   bool IsLocalResourceName(const model::ResourcePath& path) const;
 
   bool IsLocalDocumentKey(absl::string_view path) const;
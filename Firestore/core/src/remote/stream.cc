@@ -260,11 +260,7 @@ void Stream::OnStreamRead(const grpc::ByteBuffer& message) {
 
   Status read_status = NotifyStreamResponse(message);
   if (!read_status.ok()) {
-    grpc_stream_->FinishImmediately();
-    // Don't expect gRPC to produce status -- since the error happened on the
-    // client, we have all the information we need.
-    OnStreamFinish(read_status);
-    return;
+    FinishWithError(read_status);
   }
 }
 
@@ -369,6 +365,15 @@ void Stream::EnsureOnQueue() const {
   worker_queue_->VerifyIsCurrentQueue();
 }
 
+void Stream::FinishWithError(const Status& status) {
+  EnsureOnQueue();
+
+  grpc_stream_->FinishImmediately();
+  // Don't expect gRPC to produce status -- since the error happened on the
+  // client, we have all the information we need.
+  OnStreamFinish(status);
+}
+
 void Stream::Write(grpc::ByteBuffer&& message) {
   EnsureOnQueue();
 
@@ -209,6 +209,20 @@ class Stream : public GrpcStreamObserver,
   void Write(grpc::ByteBuffer&& message);
   std::string GetDebugDescription() const;
 
+  /**
+   * Finishes the underlying gRPC stream and closes this stream with the given
+   * `status`, because a response from the server couldn't be handled.
+   */
+  void FinishWithError(const util::Status& status);
+
+  /**
+   * The number of times this stream has been closed. Callbacks can compare it
+   * to the value they captured to tell whether the stream was closed since.
+   */
+  int close_count() const {
+    return close_count_;
+  }
+
   ExponentialBackoff backoff_;
 
  private:
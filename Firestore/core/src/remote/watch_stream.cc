@@ -16,12 +16,14 @@
 
 #include "Firestore/core/src/remote/watch_stream.h"
 
+#include <algorithm>
 #include <utility>
 
 #include "Firestore/core/src/model/mutation.h"
 #include "Firestore/core/src/nanopb/message.h"
 #include "Firestore/core/src/nanopb/reader.h"
 #include "Firestore/core/src/remote/grpc_nanopb.h"
+#include "Firestore/core/src/util/executor.h"
 #include "Firestore/core/src/util/hard_assert.h"
 #include "Firestore/core/src/util/log.h"
 #include "Firestore/core/src/util/status.h"
@@ -36,9 +38,23 @@ using local::TargetData;
 using model::TargetId;
 using remote::ByteBufferReader;
 using util::AsyncQueue;
+using util::Executor;
 using util::Status;
 using util::TimerId;
 
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+std::chrono::microseconds Since(Clock::time_point start) {
+  return std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() -
+                                                               start);
+}
+
+}  // namespace
+
+constexpr int WatchStream::kMaxPendingResponses;
+
 WatchStream::WatchStream(
     const std::shared_ptr<AsyncQueue>& async_queue,
     std::shared_ptr<credentials::AuthCredentialsProvider>
@@ -48,6 +64,26 @@ WatchStream::WatchStream(
     Serializer serializer,
     GrpcConnection* grpc_connection,
     WatchStreamCallback* callback)
+    : WatchStream{
+          async_queue,
+          std::move(auth_credentials_provider),
+          std::move(app_check_credentials_provider),
+          std::move(serializer),
+          grpc_connection,
+          callback,
+          Executor::CreateSerial("com.google.firebase.firestore.watch")} {
+}
+
+WatchStream::WatchStream(
+    const std::shared_ptr<AsyncQueue>& async_queue,
+    std::shared_ptr<credentials::AuthCredentialsProvider>
+        auth_credentials_provider,
+    std::shared_ptr<credentials::AppCheckCredentialsProvider>
+        app_check_credentials_provider,
+    Serializer serializer,
+    GrpcConnection* grpc_connection,
+    WatchStreamCallback* callback,
+    std::unique_ptr<Executor> decoder)
     : Stream{async_queue,
              std::move(auth_credentials_provider),
              std::move(app_check_credentials_provider),
@@ -56,7 +92,9 @@ WatchStream::WatchStream(
              TimerId::ListenStreamIdle,
              TimerId::HealthCheckTimeout},
       watch_serializer_{std::move(serializer)},
-      callback_{NOT_NULL(callback)} {
+      callback_{NOT_NULL(callback)},
+      async_queue_{async_queue},
+      decoder_{std::move(decoder)} {
 }
 
 void WatchStream::WatchQuery(const TargetData& query) {
@@ -93,29 +131,106 @@ void WatchStream::NotifyStreamOpen() {
 }
 
 Status WatchStream::NotifyStreamResponse(const grpc::ByteBuffer& message) {
+  {
+    std::unique_lock<std::mutex> lock{decode_mutex_};
+    if (pending_responses_ >= kMaxPendingResponses) {
+      auto start = Clock::now();
+      decode_capacity_.wait(
+          lock, [&] { return pending_responses_ < kMaxPendingResponses; });
+      decode_stats_.wait_time += Since(start);
+    }
+    ++pending_responses_;
+    decode_stats_.max_pending_responses =
+        std::max(decode_stats_.max_pending_responses, pending_responses_);
+  }
+
+  // The decoder is disposed of before this stream is destroyed, so it's safe
+  // to use `this` on it. Only the hand-off to the worker queue, which may run
+  // after the stream is gone, needs to check that the stream is still alive.
+  std::weak_ptr<Stream> weak_this{shared_from_this()};
+  int initial_close_count = close_count();
+  decoder_->Execute([this, weak_this, initial_close_count, message] {
+    auto start = Clock::now();
+    auto response = std::make_shared<DecodedResponse>(DecodeResponse(message));
+    {
+      std::lock_guard<std::mutex> lock{decode_mutex_};
+      --pending_responses_;
+      ++decode_stats_.responses_decoded;
+      decode_stats_.decode_time += Since(start);
+    }
+    decode_capacity_.notify_one();
+
+    async_queue_->EnqueueRelaxed([weak_this, initial_close_count, response] {
+      auto strong_this =
+          std::static_pointer_cast<WatchStream>(weak_this.lock());
+      // Responses received before the stream was closed are stale.
+      if (!strong_this || strong_this->close_count() != initial_close_count) {
+        return;
+      }
+      strong_this->HandleDecodedResponse(*response);
+    });
+  });
+
+  return Status::OK();
+}
+
+WatchStream::DecodedResponse WatchStream::DecodeResponse(
+    const grpc::ByteBuffer& message) const {
+  DecodedResponse result;
+
   ByteBufferReader reader{message};
   auto response = watch_serializer_.ParseResponse(&reader);
   if (!reader.ok()) {
-    return reader.status();
+    result.status = reader.status();
+    return result;
+  }
+
+  if (util::LogIsDebugEnabled()) {
+    result.description = response.ToString();
+  }
+
+  result.change = watch_serializer_.DecodeWatchChange(&reader, *response);
+  result.version = watch_serializer_.DecodeSnapshotVersion(&reader, *response);
+  result.status = reader.status();
+  return result;
+}
+
+void WatchStream::HandleDecodedResponse(const DecodedResponse& response) {
+  EnsureOnQueue();
+
+  if (!response.status.ok()) {
+    FinishWithError(response.status);
+    return;
   }
 
-  LOG_DEBUG("%s response: %s", GetDebugDescription(), response.ToString());
+  LOG_DEBUG("%s response: %s", GetDebugDescription(), response.description);
 
   // A successful response means the stream is healthy.
   backoff_.Reset();
 
-  auto watch_change = watch_serializer_.DecodeWatchChange(&reader, *response);
-  auto version = watch_serializer_.DecodeSnapshotVersion(&reader, *response);
-  if (!reader.ok()) {
-    return reader.status();
-  }
+  auto start = Clock::now();
+  callback_->OnWatchStreamChange(*response.change, response.version);
 
-  callback_->OnWatchStreamChange(*watch_change, version);
+  std::lock_guard<std::mutex> lock{decode_mutex_};
+  decode_stats_.apply_time += Since(start);
+}
 
-  return Status::OK();
+WatchStreamDecodeStats WatchStream::decode_stats() const {
+  std::lock_guard<std::mutex> lock{decode_mutex_};
+  return decode_stats_;
 }
 
 void WatchStream::NotifyStreamClose(const Status& status) {
+  if (util::LogIsDebugEnabled()) {
+    WatchStreamDecodeStats stats = decode_stats();
+    LOG_DEBUG(
+        "%s decoded %s responses in %sus off the worker queue, applied them "
+        "in %sus, waited %sus for the decoder (at most %s pending)",
+        GetDebugDescription(), stats.responses_decoded,
+        stats.decode_time.count(), stats.apply_time.count(),
+        stats.wait_time.count(), stats.max_pending_responses);
+  }
+
   callback_->OnWatchStreamClose(status);
 }
 
@@ -17,16 +17,22 @@
 #ifndef FIRESTORE_CORE_SRC_REMOTE_WATCH_STREAM_H_
 #define FIRESTORE_CORE_SRC_REMOTE_WATCH_STREAM_H_
 
+#include <chrono>              // NOLINT(build/c++11)
+#include <condition_variable>  // NOLINT(build/c++11)
+#include <cstdint>
 #include <memory>
+#include <mutex>  // NOLINT(build/c++11)
 #include <string>
 
 #include "Firestore/core/src/model/model_fwd.h"
+#include "Firestore/core/src/model/snapshot_version.h"
 #include "Firestore/core/src/remote/grpc_connection.h"
 #include "Firestore/core/src/remote/remote_objc_bridge.h"
 #include "Firestore/core/src/remote/stream.h"
 #include "Firestore/core/src/remote/watch_change.h"
 #include "Firestore/core/src/util/async_queue.h"
-#include "Firestore/core/src/util/status_fwd.h"
+#include "Firestore/core/src/util/executor.h"
+#include "Firestore/core/src/util/status.h"
 #include "absl/strings/string_view.h"
 #include "grpcpp/support/byte_buffer.h"
 
@@ -74,15 +80,47 @@ class WatchStreamCallback {
   virtual void OnWatchStreamClose(const util::Status& status) = 0;
 };
 
+/**
+ * Statistics about decoding watch responses off the worker queue, which show
+ * how much work was taken off the worker queue and how often the worker queue
+ * had to wait for the decoder to catch up.
+ */
+struct WatchStreamDecodeStats {
+  /** The number of responses decoded. */
+  int64_t responses_decoded = 0;
+
+  /** The total time spent decoding responses on the decoder executor. */
+  std::chrono::microseconds decode_time{0};
+
+  /** The total time the worker queue spent handling decoded responses. */
+  std::chrono::microseconds apply_time{0};
+
+  /** The total time the worker queue was blocked on a full pipeline. */
+  std::chrono::microseconds wait_time{0};
+
+  /** The largest number of responses that were waiting to be decoded. */
+  int max_pending_responses = 0;
+};
+
 /**
  * A `Stream` that implements the StreamingWatch RPC.
  *
  * Once the `WatchStream` has called the `OnWatchStreamOpen` method on the
  * callback, any number of `WatchQuery` and `UnwatchTargetId` calls can be sent
  * to control what changes will be sent from the server for WatchChanges.
+ *
+ * Responses, which may contain large documents, are decoded on a serial
+ * executor of their own, so that decoding doesn't compete with local store
+ * work on the worker queue. Decoded changes are handed back to the worker
+ * queue in the order they were received. At most `kMaxPendingResponses`
+ * responses are waiting to be decoded at any time; once that many are
+ * pending, receiving another one blocks the worker queue until the decoder
+ * catches up.
  */
 class WatchStream : public Stream {
  public:
+  static constexpr int kMaxPendingResponses = 16;
+
   WatchStream(const std::shared_ptr<util::AsyncQueue>& async_queue,
               std::shared_ptr<credentials::AuthCredentialsProvider>
                   auth_credentials_provider,
@@ -108,7 +146,32 @@ class WatchStream : public Stream {
   virtual /*virtual for tests only*/ void UnwatchTargetId(
       model::TargetId target_id);
 
+  /** Returns the statistics about decoding responses so far. */
+  WatchStreamDecodeStats decode_stats() const;
+
+ protected:
+  /** Creates a stream that decodes responses on the given `decoder`. */
+  WatchStream(const std::shared_ptr<util::AsyncQueue>& async_queue,
+              std::shared_ptr<credentials::AuthCredentialsProvider>
+                  auth_credentials_provider,
+              std::shared_ptr<credentials::AppCheckCredentialsProvider>
+                  app_check_credentials_provider,
+              Serializer serializer,
+              GrpcConnection* grpc_connection,
+              WatchStreamCallback* callback,
+              std::unique_ptr<util::Executor> decoder);
+
  private:
+  struct DecodedResponse {
+    util::Status status;
+    std::unique_ptr<WatchChange> change;
+    model::SnapshotVersion version;
+    std::string description;
+  };
+
+  DecodedResponse DecodeResponse(const grpc::ByteBuffer& message) const;
+  void HandleDecodedResponse(const DecodedResponse& response);
+
   std::unique_ptr<GrpcStream> CreateGrpcStream(
       GrpcConnection* grpc_connection,
       const credentials::AuthToken& auth_token,
@@ -125,6 +188,16 @@ class WatchStream : public Stream {
 
   WatchStreamSerializer watch_serializer_;
   WatchStreamCallback* callback_;
+
+  std::shared_ptr<util::AsyncQueue> async_queue_;
+
+  mutable std::mutex decode_mutex_;
+  std::condition_variable decode_capacity_;
+  int pending_responses_ = 0;
+  WatchStreamDecodeStats decode_stats_;
+
+  // Declared last so that it's disposed of before the state it refers to.
+  std::unique_ptr<util::Executor> decoder_;
 };
 
 }  // namespace remote
@@ -0,0 +1,127 @@
+/*
+ * Copyright 2022 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Firestore/core/src/remote/write_pipeline_window.h"
+
+#include <algorithm>
+
+#include "Firestore/core/src/util/hard_assert.h"
+
+namespace firebase {
+namespace firestore {
+namespace remote {
+
+namespace chr = std::chrono;
+
+constexpr int AckLatencyHistogram::kBucketCount;
+constexpr int WritePipelineWindow::kDefaultMaxPendingWrites;
+constexpr int WritePipelineWindow::kBackpressureLatencyFactor;
+
+void AckLatencyHistogram::Record(chr::milliseconds latency) {
+  int index = 0;
+  while (index < kBucketCount - 1 && latency >= bucket_upper_bound(index)) {
+    ++index;
+  }
+  ++buckets_[index];
+  ++count_;
+}
+
+chr::milliseconds AckLatencyHistogram::bucket_upper_bound(int index) {
+  HARD_ASSERT(index >= 0 && index < kBucketCount,
+              "Histogram bucket %s out of range", index);
+  if (index == kBucketCount - 1) {
+    return chr::milliseconds::max();
+  }
+  return chr::milliseconds(int64_t{1} << index);
+}
+
+WritePipelineWindow::WritePipelineWindow(int max_pending_writes, bool adaptive)
+    : max_size_(max_pending_writes),
+      adaptive_(adaptive),
+      size_(adaptive ? std::min(kDefaultMaxPendingWrites, max_pending_writes)
+                     : max_pending_writes),
+      slow_start_threshold_(max_pending_writes) {
+  HARD_ASSERT(max_pending_writes > 0,
+              "The maximum number of pending writes must be positive, got %s",
+              max_pending_writes);
+}
+
+void WritePipelineWindow::OnWriteSent(Clock::time_point now) {
+  send_times_.push_back(now);
+}
+
+void WritePipelineWindow::OnWriteAcknowledged(Clock::time_point now) {
+  HARD_ASSERT(!send_times_.empty(), "Got an ack with no writes in flight");
+
+  Clock::duration latency = now - send_times_.front();
+  send_times_.pop_front();
+  ack_latency_.Record(chr::duration_cast<chr::milliseconds>(latency));
+
+  if (!adaptive_) {
+    return;
+  }
+
+  min_ack_latency_ = std::min(min_ack_latency_, latency);
+  bool slow = latency > min_ack_latency_ * kBackpressureLatencyFactor;
+  if (acks_until_next_shrink_ > 0) {
+    --acks_until_next_shrink_;
+  } else if (slow) {
+    Shrink();
+    return;
+  }
+
+  if (!slow) {
+    Grow();
+  }
+}
+
+void WritePipelineWindow::OnWriteStreamError() {
+  if (adaptive_) {
+    Shrink();
+  }
+}
+
+void WritePipelineWindow::ClearInFlight() {
+  send_times_.clear();
+  acks_until_next_shrink_ = 0;
+}
+
+void WritePipelineWindow::Grow() {
+  if (size_ >= max_size_) {
+    return;
+  }
+
+  if (size_ < slow_start_threshold_) {
+    ++size_;
+  } else if (++acks_since_growth_ >= size_) {
+    ++size_;
+    acks_since_growth_ = 0;
+  }
+}
+
+void WritePipelineWindow::Shrink() {
+  slow_start_threshold_ = std::max(size_ / 2, 1);
+  size_ = slow_start_threshold_;
+  acks_since_growth_ = 0;
+
+  // The writes already in flight were sent with the old window, so their acks
+  // are likely to be just as slow; don't shrink again on their account.
+  acks_until_next_shrink_ = in_flight();
+}
+
+}  // namespace remote
+}  // namespace firestore
+}  // namespace firebase
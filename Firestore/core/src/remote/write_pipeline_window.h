@@ -0,0 +1,171 @@
+/*
+ * Copyright 2022 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef FIRESTORE_CORE_SRC_REMOTE_WRITE_PIPELINE_WINDOW_H_
+#define FIRESTORE_CORE_SRC_REMOTE_WRITE_PIPELINE_WINDOW_H_
+
+#include <array>
+#include <chrono>  // NOLINT(build/c++11)
+#include <cstdint>
+#include <deque>
+
+namespace firebase {
+namespace firestore {
+namespace remote {
+
+/**
+ * A histogram of write acknowledgement latencies with exponentially sized
+ * buckets: bucket `i` counts latencies below `2^i` milliseconds, and the last
+ * bucket counts everything slower than that.
+ */
+class AckLatencyHistogram {
+ public:
+  static constexpr int kBucketCount = 16;
+
+  void Record(std::chrono::milliseconds latency);
+
+  /** The number of latencies recorded in the given bucket. */
+  int64_t bucket(int index) const {
+    return buckets_[index];
+  }
+
+  /**
+   * The exclusive upper bound of the given bucket, or `milliseconds::max()`
+   * for the last one.
+   */
+  static std::chrono::milliseconds bucket_upper_bound(int index);
+
+  /** The total number of latencies recorded. */
+  int64_t count() const {
+    return count_;
+  }
+
+ private:
+  std::array<int64_t, kBucketCount> buckets_{};
+  int64_t count_ = 0;
+};
+
+/**
+ * Decides how many mutation batches `RemoteStore` may have in its write
+ * pipeline, and keeps track of the batches that have been sent on the write
+ * stream but not yet acknowledged.
+ *
+ * With a fixed window the pipeline is simply capped at `max_pending_writes`.
+ *
+ * The adaptive window behaves like a TCP congestion window bounded by
+ * `max_pending_writes`. It starts at the fixed default; while acks come back
+ * fast it grows by one per ack ("slow start", doubling every round trip) up to
+ * a threshold and by one per round trip after that. When the backend pushes
+ * back, either by acking much more slowly than the fastest round trip seen so
+ * far or by failing the stream, the window and threshold are halved.
+ */
+class WritePipelineWindow {
+ public:
+  using Clock = std::chrono::steady_clock;
+
+  /** The default maximum number of pending writes. */
+  static constexpr int kDefaultMaxPendingWrites = 10;
+
+  /**
+   * An ack slower than this multiple of the fastest observed ack is taken as
+   * a sign that writes are queueing up on the backend.
+   */
+  static constexpr int kBackpressureLatencyFactor = 4;
+
+  /** Creates a fixed window of `kDefaultMaxPendingWrites`. */
+  WritePipelineWindow() = default;
+
+  /**
+   * @param max_pending_writes The size of a fixed window, or the upper bound
+   *     of an adaptive one. Must be positive.
+   * @param adaptive Whether the window should adapt to the observed acks.
+   */
+  WritePipelineWindow(int max_pending_writes, bool adaptive);
+
+  /** The number of writes the pipeline may currently hold. */
+  int size() const {
+    return size_;
+  }
+
+  int max_size() const {
+    return max_size_;
+  }
+
+  bool adaptive() const {
+    return adaptive_;
+  }
+
+  /** The number of writes sent on the stream and not acknowledged yet. */
+  int in_flight() const {
+    return static_cast<int>(send_times_.size());
+  }
+
+  const AckLatencyHistogram& ack_latency() const {
+    return ack_latency_;
+  }
+
+  /** Records that a write has been sent on the write stream at `now`. */
+  void OnWriteSent(Clock::time_point now);
+
+  /**
+   * Records that the oldest write in flight was acknowledged at `now`. Writes
+   * are acknowledged in the order they were sent.
+   */
+  void OnWriteAcknowledged(Clock::time_point now);
+
+  /**
+   * Records that the write stream failed with writes in flight for reasons
+   * other than the writes themselves, and shrinks an adaptive window.
+   */
+  void OnWriteStreamError();
+
+  /**
+   * Forgets about the writes in flight, e.g. because the stream was closed and
+   * they will be sent again on the next one.
+   */
+  void ClearInFlight();
+
+ private:
+  void Grow();
+  void Shrink();
+
+  int max_size_ = kDefaultMaxPendingWrites;
+  bool adaptive_ = false;
+  int size_ = kDefaultMaxPendingWrites;
+
+  /** The size below which the adaptive window grows by one per ack. */
+  int slow_start_threshold_ = kDefaultMaxPendingWrites;
+
+  /** Acks received since the window last grew in congestion avoidance. */
+  int acks_since_growth_ = 0;
+
+  /**
+   * The number of acks to receive before slow acks may shrink the window
+   * again, so that one slow round trip only shrinks it once.
+   */
+  int acks_until_next_shrink_ = 0;
+
+  Clock::duration min_ack_latency_ = Clock::duration::max();
+
+  std::deque<Clock::time_point> send_times_;
+  AckLatencyHistogram ack_latency_;
+};
+
+}  // namespace remote
+}  // namespace firestore
+}  // namespace firebase
+
+#endif  // FIRESTORE_CORE_SRC_REMOTE_WRITE_PIPELINE_WINDOW_H_
@@ -21,6 +21,7 @@
 #include <sstream>
 
 #include "Firestore/core/src/util/config.h"
+#include "Firestore/core/src/util/executor_work_stealing.h"
 #include "Firestore/core/src/util/hard_assert.h"
 #include "Firestore/core/src/util/schedule.h"
 #include "Firestore/core/src/util/task.h"
@@ -249,7 +250,7 @@ std::unique_ptr<Executor> Executor::CreateSerial(const char*) {
 }
 
 std::unique_ptr<Executor> Executor::CreateConcurrent(const char*, int threads) {
-  return absl::make_unique<ExecutorStd>(threads);
+  return absl::make_unique<ExecutorWorkStealing>(threads);
 }
 
 #endif  // !HAVE_LIBDISPATCH
@@ -0,0 +1,402 @@
+/*
+ * Copyright 2022 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Firestore/core/src/util/executor_work_stealing.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>              // NOLINT(build/c++11)
+#include <condition_variable>  // NOLINT(build/c++11)
+#include <cstdint>
+#include <deque>
+#include <future>  // NOLINT(build/c++11)
+#include <sstream>
+#include <utility>
+
+#include "Firestore/core/src/util/hard_assert.h"
+#include "Firestore/core/src/util/task.h"
+#include "absl/memory/memory.h"
+
+namespace firebase {
+namespace firestore {
+namespace util {
+namespace {
+
+// The only guarantee is that different `thread_id`s will produce different
+// values.
+std::string ThreadIdToString(const std::thread::id thread_id) {
+  std::ostringstream stream;
+  stream << thread_id;
+  return stream.str();
+}
+
+// Identifies the worker running on the current thread, if any, so that
+// operations executed from a worker can go straight to its own queue.
+struct CurrentWorker {
+  const void* state;
+  size_t index;
+};
+
+thread_local CurrentWorker current_worker = {nullptr, 0};
+
+}  // namespace
+
+class ExecutorWorkStealing::SharedState {
+ public:
+  explicit SharedState(size_t worker_count) {
+    for (size_t i = 0; i < worker_count; ++i) {
+      queues_.push_back(absl::make_unique<WorkQueue>());
+    }
+  }
+
+  ~SharedState() {
+    for (Task* task : delayed_) {
+      task->Release();
+    }
+  }
+
+  bool is_shut_down() const {
+    return shutdown_.load(std::memory_order_acquire);
+  }
+
+  bool is_current_worker() const {
+    return current_worker.state == this;
+  }
+
+  void Push(Operation&& operation) {
+    if (is_shut_down()) return;
+
+    size_t index = is_current_worker()
+                       ? current_worker.index
+                       : next_queue_.fetch_add(1, std::memory_order_relaxed) %
+                             queues_.size();
+    // Pairs with the check in `Next`: either a worker about to sleep sees the
+    // new operation, or this sees the sleeping worker and wakes it up.
+    pending_.fetch_add(1);
+
+    // Once the operation is queued it may run and destroy the executor, so
+    // everything else has to happen while the queue is still locked.
+    WorkQueue& queue = *queues_[index];
+    std::lock_guard<std::mutex> lock(queue.mutex);
+    queue.operations.push_back(std::move(operation));
+    queue.size.fetch_add(1, std::memory_order_release);
+    if (sleeping_.load() > 0) {
+      std::lock_guard<std::mutex> idle_lock(mutex_);
+      idle_.notify_one();
+    }
+  }
+
+  Id PushDelayed(TimePoint when, Tag tag, Operation&& operation) {
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    // The wrap around after ~4 billion operations is explicitly ignored, as in
+    // `ExecutorStd`.
+    Id id = next_id_++;
+    Task* task = Task::Create(nullptr, when, tag, id, std::move(operation));
+    auto insertion_point =
+        std::upper_bound(delayed_.begin(), delayed_.end(), task,
+                         [](Task* lhs, Task* rhs) {
+                           return lhs->target_time() < rhs->target_time();
+                         });
+    delayed_.insert(insertion_point, task);
+
+    // A sleeping worker may have to wake up earlier than it planned to.
+    idle_.notify_one();
+    return id;
+  }
+
+  template <typename Pred>
+  Task* RemoveDelayedIf(const Pred pred) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto found = std::find_if(delayed_.begin(), delayed_.end(),
+                              [&pred](Task* t) { return pred(*t); });
+    if (found == delayed_.end()) {
+      return nullptr;
+    }
+    Task* task = *found;
+    delayed_.erase(found);
+    return task;
+  }
+
+  template <typename Pred>
+  bool ContainsDelayed(const Pred pred) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return std::any_of(delayed_.begin(), delayed_.end(),
+                       [&pred](Task* t) { return pred(*t); });
+  }
+
+  /**
+   * Blocks until there's something for the worker with the given index to
+   * run: either an immediate operation, stored in `operation`, or a delayed
+   * task that is due, stored in `task`. Returns false once shut down.
+   */
+  bool Next(size_t index, Operation* operation, Task** task) {
+    *task = nullptr;
+    for (;;) {
+      if (is_shut_down()) return false;
+      if (TryPop(index, operation)) return true;
+
+      std::unique_lock<std::mutex> lock(mutex_);
+      if (is_shut_down()) return false;
+
+      *task = PopDueLocked();
+      if (*task) return true;
+
+      ++sleeping_;
+      if (pending_.load() == 0) {
+        if (delayed_.empty()) {
+          idle_.wait(lock);
+        } else {
+          // Workaround for Visual Studio 2015, as in `Schedule::PopBlocking`.
+          auto until = std::chrono::time_point_cast<Clock::duration>(
+              delayed_.front()->target_time());
+          idle_.wait_until(lock, until);
+        }
+      }
+      --sleeping_;
+    }
+  }
+
+  /**
+   * Makes workers exit once they finish their current operation, and drops
+   * everything that hasn't started running yet.
+   */
+  void Shutdown() {
+    std::deque<Task*> delayed;
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      shutdown_.store(true, std::memory_order_release);
+      delayed.swap(delayed_);
+      idle_.notify_all();
+    }
+
+    // Destroy the dropped operations without holding any locks, in case their
+    // destructors call back into the executor.
+    for (const std::unique_ptr<WorkQueue>& queue : queues_) {
+      std::deque<Operation> operations;
+      {
+        std::lock_guard<std::mutex> lock(queue->mutex);
+        operations.swap(queue->operations);
+        queue->size.store(0, std::memory_order_relaxed);
+      }
+      pending_.fetch_sub(static_cast<int64_t>(operations.size()));
+    }
+
+    for (Task* task : delayed) {
+      task->Release();
+    }
+  }
+
+ private:
+  struct WorkQueue {
+    std::mutex mutex;
+    std::deque<Operation> operations;
+
+    // Mirrors `operations.size()` so that empty queues can be skipped without
+    // locking them.
+    std::atomic<size_t> size{0};
+  };
+
+  /**
+   * Takes the oldest operation from the worker's own queue or, failing that,
+   * steals one from the other workers.
+   */
+  bool TryPop(size_t index, Operation* operation) {
+    size_t count = queues_.size();
+    for (size_t i = 0; i < count; ++i) {
+      WorkQueue& queue = *queues_[(index + i) % count];
+      if (queue.size.load(std::memory_order_acquire) == 0) continue;
+
+      std::lock_guard<std::mutex> lock(queue.mutex);
+      if (queue.operations.empty()) continue;
+
+      *operation = std::move(queue.operations.front());
+      queue.operations.pop_front();
+      queue.size.fetch_sub(1, std::memory_order_relaxed);
+      pending_.fetch_sub(1);
+      return true;
+    }
+    return false;
+  }
+
+  // This function expects `mutex_` to be already locked.
+  Task* PopDueLocked() {
+    if (delayed_.empty()) return nullptr;
+
+    auto now = std::chrono::time_point_cast<Milliseconds>(Clock::now());
+    if (delayed_.front()->target_time() > now) return nullptr;
+
+    Task* task = delayed_.front();
+    delayed_.pop_front();
+    return task;
+  }
+
+  std::vector<std::unique_ptr<WorkQueue>> queues_;
+  std::atomic<size_t> next_queue_{0};
+
+  // The number of operations in all queues, and the number of workers waiting
+  // for one.
+  std::atomic<int64_t> pending_{0};
+  std::atomic<int> sleeping_{0};
+
+  std::atomic<bool> shutdown_{false};
+
+  // Guards the delayed operations, and is what idle workers wait on.
+  mutable std::mutex mutex_;
+  std::condition_variable idle_;
+
+  // Delayed operations in the order they're due.
+  std::deque<Task*> delayed_;
+  Id next_id_ = 0;
+};
+
+// MARK: - ExecutorWorkStealing
+
+ExecutorWorkStealing::ExecutorWorkStealing(int threads)
+    : state_(std::make_shared<SharedState>(static_cast<size_t>(threads))) {
+  HARD_ASSERT(threads > 0);
+
+  for (int i = 0; i < threads; ++i) {
+    worker_thread_pool_.emplace_back(&ExecutorWorkStealing::WorkerThread,
+                                     state_, static_cast<size_t>(i));
+  }
+}
+
+ExecutorWorkStealing::~ExecutorWorkStealing() {
+  Dispose();
+}
+
+void ExecutorWorkStealing::Dispose() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    // Do nothing if already disposed.
+    if (disposed_) {
+      return;
+    }
+    disposed_ = true;
+  }
+
+  // Workers finish whatever operation they're currently running, and then
+  // quit.
+  state_->Shutdown();
+
+  for (std::thread& thread : worker_thread_pool_) {
+    // If the current thread is running this destructor, we can't join the
+    // thread. Instead detach it and rely on WorkerThread to exit cleanly.
+    if (std::this_thread::get_id() == thread.get_id()) {
+      thread.detach();
+    } else {
+      thread.join();
+    }
+  }
+}
+
+void ExecutorWorkStealing::Execute(Operation&& operation) {
+  state_->Push(std::move(operation));
+}
+
+void ExecutorWorkStealing::ExecuteBlocking(Operation&& operation) {
+  std::promise<void> signal_finished;
+  Execute([&] {
+    operation();
+    signal_finished.set_value();
+  });
+  signal_finished.get_future().wait();
+}
+
+DelayedOperation ExecutorWorkStealing::Schedule(const Milliseconds delay,
+                                                Tag tag,
+                                                Operation&& operation) {
+  if (state_->is_shut_down()) return {};
+
+  // While negative delay can be interpreted as a request for immediate
+  // execution, supporting it would provide a hacky way to modify FIFO ordering
+  // of immediate operations.
+  HARD_ASSERT(delay.count() >= 0, "Schedule: delay cannot be negative");
+
+  Id id = state_->PushDelayed(MakeTargetTime(delay), tag, std::move(operation));
+  return DelayedOperation(this, id);
+}
+
+void ExecutorWorkStealing::OnCompletion(Task*) {
+  // No-op in this implementation
+}
+
+void ExecutorWorkStealing::Cancel(const Id operation_id) {
+  Task* removed = state_->RemoveDelayedIf(
+      [operation_id](const Task& t) { return t.id() == operation_id; });
+
+  // As in `ExecutorStd`, a task that could still be removed hasn't been picked
+  // up by a worker, so releasing it is enough to keep it from running.
+  if (removed) {
+    removed->Release();
+  }
+}
+
+void ExecutorWorkStealing::WorkerThread(std::shared_ptr<SharedState> state,
+                                        size_t index) {
+  current_worker = CurrentWorker{state.get(), index};
+
+  Operation operation;
+  Task* task = nullptr;
+  while (state->Next(index, &operation, &task)) {
+    if (task) {
+      task->ExecuteAndRelease();
+    } else {
+      operation();
+
+      // Destroy the closure before waiting for the next operation.
+      operation = nullptr;
+    }
+  }
+
+  current_worker = CurrentWorker{nullptr, 0};
+}
+
+bool ExecutorWorkStealing::IsCurrentExecutor() const {
+  return state_->is_current_worker();
+}
+
+std::string ExecutorWorkStealing::CurrentExecutorName() const {
+  if (IsCurrentExecutor()) {
+    return Name();
+  } else {
+    return ThreadIdToString(std::this_thread::get_id());
+  }
+}
+
+std::string ExecutorWorkStealing::Name() const {
+  return ThreadIdToString(worker_thread_pool_.front().get_id());
+}
+
+bool ExecutorWorkStealing::IsTagScheduled(const Tag tag) const {
+  return state_->ContainsDelayed(
+      [&tag](const Task& t) { return t.tag() == tag; });
+}
+
+bool ExecutorWorkStealing::IsIdScheduled(const Id id) const {
+  return state_->ContainsDelayed([&id](const Task& t) { return t.id() == id; });
+}
+
+Task* ExecutorWorkStealing::PopFromSchedule() {
+  return state_->RemoveDelayedIf(
+      [](const Task& t) { return !t.is_immediate(); });
+}
+
+}  // namespace util
+}  // namespace firestore
+}  // namespace firebase
@@ -0,0 +1,97 @@
+/*
+ * Copyright 2022 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef FIRESTORE_CORE_SRC_UTIL_EXECUTOR_WORK_STEALING_H_
+#define FIRESTORE_CORE_SRC_UTIL_EXECUTOR_WORK_STEALING_H_
+
+#include <memory>
+#include <mutex>  // NOLINT(build/c++11)
+#include <string>
+#include <thread>  // NOLINT(build/c++11)
+#include <vector>
+
+#include "Firestore/core/src/util/executor.h"
+
+namespace firebase {
+namespace firestore {
+namespace util {
+
+class Task;
+
+// A concurrent executor that runs operations on a fixed pool of threads, using
+// C++11 standard library functionality.
+//
+// Unlike `ExecutorStd`, which funnels every operation through a single locked
+// schedule, each worker thread has its own queue of immediate operations.
+// Operations executed from a worker go to that worker's queue, others are
+// spread over the queues round-robin, and a worker that runs out of work
+// steals from the others. Immediate operations are stored as is, without
+// allocating a `Task` for them.
+//
+// Delayed operations are kept in a separate, much less contended schedule that
+// idle workers poll. As in `ExecutorStd`, immediate operations always run
+// before delayed operations that are due.
+//
+// Operations are not run in FIFO order across workers, so this executor is
+// only suitable for concurrent use.
+class ExecutorWorkStealing : public Executor {
+ public:
+  explicit ExecutorWorkStealing(int threads);
+  ~ExecutorWorkStealing() override;
+
+  void Dispose() override;
+
+  void Execute(Operation&& operation) override;
+  void ExecuteBlocking(Operation&& operation) override;
+
+  DelayedOperation Schedule(Milliseconds delay,
+                            Tag tag,
+                            Operation&& operation) override;
+
+  bool IsCurrentExecutor() const override;
+  std::string CurrentExecutorName() const override;
+  std::string Name() const override;
+
+  bool IsTagScheduled(Tag tag) const override;
+  bool IsIdScheduled(Id id) const override;
+  Task* PopFromSchedule() override;
+
+ private:
+  class SharedState;
+
+  void OnCompletion(Task* task) override;
+  void Cancel(Id operation_id) override;
+
+  static void WorkerThread(std::shared_ptr<SharedState> state, size_t index);
+
+  // Guards `disposed_`. Neither `Execute` nor the worker threads acquire this
+  // mutex.
+  std::mutex mutex_;
+  bool disposed_ = false;
+
+  std::vector<std::thread> worker_thread_pool_;
+
+  // State shared with workers. Note that if the Executor's destructor is called
+  // from a worker thread, this state will outlive the nominally owning
+  // Executor.
+  std::shared_ptr<SharedState> state_;
+};
+
+}  // namespace util
+}  // namespace firestore
+}  // namespace firebase
+
+#endif  // FIRESTORE_CORE_SRC_UTIL_EXECUTOR_WORK_STEALING_H_
@@ -0,0 +1,106 @@
+/*
+ * Copyright 2022 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Firestore/core/src/api/settings.h"
+
+#include <stdexcept>
+
+#include "gtest/gtest.h"
+
+namespace firebase {
+namespace firestore {
+namespace api {
+namespace {
+
+TEST(SettingsTest, AcceptsPositiveMaxPendingWrites) {
+  Settings settings;
+  EXPECT_EQ(settings.max_pending_writes(), Settings::DefaultMaxPendingWrites);
+
+  settings.set_max_pending_writes(1);
+  EXPECT_EQ(settings.max_pending_writes(), 1);
+}
+
+TEST(SettingsTest, RejectsNonPositiveMaxPendingWrites) {
+  Settings settings;
+  EXPECT_THROW(settings.set_max_pending_writes(0), std::invalid_argument);
+  EXPECT_THROW(settings.set_max_pending_writes(-1), std::invalid_argument);
+  EXPECT_EQ(settings.max_pending_writes(), Settings::DefaultMaxPendingWrites);
+}
+
+TEST(SettingsTest, AcceptsPositiveMaxBatchesPerWriteRequest) {
+  Settings settings;
+  EXPECT_EQ(settings.max_batches_per_write_request(), 1);
+
+  settings.set_max_batches_per_write_request(10);
+  EXPECT_EQ(settings.max_batches_per_write_request(), 10);
+}
+
+TEST(SettingsTest, RejectsNonPositiveMaxBatchesPerWriteRequest) {
+  Settings settings;
+  EXPECT_THROW(settings.set_max_batches_per_write_request(0),
+               std::invalid_argument);
+  EXPECT_THROW(settings.set_max_batches_per_write_request(-1),
+               std::invalid_argument);
+  EXPECT_EQ(settings.max_batches_per_write_request(), 1);
+}
+
+TEST(SettingsTest, AcceptsLevelDbTuning) {
+  Settings settings;
+  settings.set_leveldb_block_cache_size_bytes(0);
+  settings.set_leveldb_bloom_filter_bits_per_key(10);
+  settings.set_leveldb_write_buffer_size_bytes(64 * 1024);
+  settings.set_leveldb_max_open_files(100);
+
+  EXPECT_EQ(settings.leveldb_block_cache_size_bytes(), 0);
+  EXPECT_EQ(settings.leveldb_bloom_filter_bits_per_key(), 10);
+  EXPECT_EQ(settings.leveldb_write_buffer_size_bytes(), 64 * 1024);
+  EXPECT_EQ(settings.leveldb_max_open_files(), 100);
+}
+
+TEST(SettingsTest, RejectsInvalidLevelDbTuning) {
+  Settings settings;
+  EXPECT_THROW(settings.set_leveldb_block_cache_size_bytes(-1),
+               std::invalid_argument);
+  EXPECT_THROW(settings.set_leveldb_bloom_filter_bits_per_key(-1),
+               std::invalid_argument);
+  EXPECT_THROW(settings.set_leveldb_write_buffer_size_bytes(0),
+               std::invalid_argument);
+  EXPECT_THROW(settings.set_leveldb_max_open_files(0), std::invalid_argument);
+
+  EXPECT_EQ(settings, Settings());
+}
+
+TEST(SettingsTest, AcceptsNonNegativeMaxCachedQueryResults) {
+  Settings settings;
+  EXPECT_EQ(settings.max_cached_query_results(), 0);
+
+  settings.set_max_cached_query_results(100);
+  EXPECT_EQ(settings.max_cached_query_results(), 100);
+  settings.set_max_cached_query_results(0);
+  EXPECT_EQ(settings.max_cached_query_results(), 0);
+}
+
+TEST(SettingsTest, RejectsNegativeMaxCachedQueryResults) {
+  Settings settings;
+  EXPECT_THROW(settings.set_max_cached_query_results(-1),
+               std::invalid_argument);
+  EXPECT_EQ(settings.max_cached_query_results(), 0);
+}
+
+}  // namespace
+}  // namespace api
+}  // namespace firestore
+}  // namespace firebase
@@ -57,6 +57,7 @@ class BundleLoaderTest : public ::testing::Test {
         const model::MutableDocumentMap& documents,
         const std::string& bundle_id) override {
       (void)bundle_id;
+      ++parent_.apply_count_;
       for (const auto& entry : documents) {
         parent_.last_documents_ = parent_.last_documents_.insert(entry.first);
       }
@@ -102,6 +103,7 @@ class BundleLoaderTest : public ::testing::Test {
  protected:
   std::unique_ptr<BundleCallback> callback_ = nullptr;
   DocumentKeySet last_documents_;
+  int apply_count_ = 0;
   std::unordered_map<std::string, DocumentKeySet> last_queries_;
   std::unordered_map<std::string, BundleMetadata> last_bundles_;
   model::SnapshotVersion create_time_ =
@@ -208,6 +210,46 @@ TEST_F(BundleLoaderTest, AppliesNamedQueries) {
             DocumentKeySet{testutil::Key("coll/doc2")});
 }
 
+TEST_F(BundleLoaderTest, AppliesDocumentsInChunks) {
+  BundleLoader loader(callback_.get(), CreateMetadata(3),
+                      /*max_pending_bytes=*/10);
+
+  EXPECT_OK(loader.AddElement(
+      absl::make_unique<NamedQuery>(
+          "query-1",
+          BundledQuery(testutil::Query("coll").ToTarget(), LimitType::First),
+          create_time_),
+      /*byte_size=*/20));
+  EXPECT_FALSE(loader.HasPendingChunk());
+
+  for (const char* path : {"coll/doc1", "coll/doc2", "coll/doc3"}) {
+    EXPECT_OK(loader.AddElement(
+        absl::make_unique<BundledDocumentMetadata>(
+            testutil::Key(path), create_time_,
+            /*exists=*/true, std::vector<std::string>{"query-1"}),
+        /*byte_size=*/1));
+    BundleLoader::AddElementResult result = loader.AddElement(
+        absl::make_unique<BundleDocument>(testutil::Doc(path, 1)),
+        /*byte_size=*/4);
+    EXPECT_OK(result);
+    if (loader.HasPendingChunk()) loader.ApplyDocuments();
+  }
+
+  // The first two documents are applied together, the third one on its own.
+  EXPECT_EQ(apply_count_, 1);
+  EXPECT_EQ(last_documents_, (DocumentKeySet{testutil::Key("coll/doc1"),
+                                             testutil::Key("coll/doc2")}));
+
+  EXPECT_OK(loader.ApplyChanges());
+  EXPECT_EQ(apply_count_, 2);
+  DocumentKeySet all_documents{testutil::Key("coll/doc1"),
+                               testutil::Key("coll/doc2"),
+                               testutil::Key("coll/doc3")};
+  EXPECT_EQ(last_documents_, all_documents);
+  EXPECT_EQ(last_queries_["query-1"], all_documents);
+  EXPECT_EQ(last_bundles_["bundle-1"], CreateMetadata(3));
+}
+
 TEST_F(BundleLoaderTest, VerifiesDocumentMetadataSet) {
   BundleLoader loader(callback_.get(), CreateMetadata(1));
 
@@ -0,0 +1,134 @@
+/*
+ * Copyright 2022 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <cstdint>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <utility>
+
+#include "Firestore/core/src/bundle/bundle_converter.h"
+#include "Firestore/core/src/bundle/bundle_reader.h"
+#include "Firestore/core/src/bundle/bundle_serializer.h"
+#include "Firestore/core/src/model/database_id.h"
+#include "Firestore/core/src/remote/serializer.h"
+#include "Firestore/core/src/util/byte_stream_cpp.h"
+#include "Firestore/core/src/util/hard_assert.h"
+#include "absl/memory/memory.h"
+#include "absl/strings/str_cat.h"
+#include "benchmark/benchmark.h"
+
+namespace firebase {
+namespace firestore {
+namespace bundle {
+namespace {
+
+using model::DatabaseId;
+using util::ByteStreamCpp;
+
+constexpr int kFieldsPerDocument = 20;
+
+BundleSerializer MakeSerializer() {
+  return BundleSerializer(remote::Serializer(DatabaseId("p", "default")));
+}
+
+std::string LengthPrefixed(const std::string& element) {
+  return absl::StrCat(element.size(), element);
+}
+
+/**
+ * Returns a JSON bundle of `document_count` documents of about 1KB each, with
+ * strings, numbers and nested maps.
+ */
+std::string MakeJsonBundle(int64_t document_count) {
+  std::string elements;
+  for (int64_t i = 0; i < document_count; ++i) {
+    std::string name =
+        absl::StrCat("projects/p/databases/default/documents/rooms/", i);
+    elements += LengthPrefixed(
+        absl::StrCat(R"({"documentMetadata":{"name":")", name,
+                     R"(","readTime":{"seconds":"1","nanos":0},)",
+                     R"("exists":true}})"));
+
+    std::string fields;
+    for (int f = 0; f < kFieldsPerDocument; ++f) {
+      absl::StrAppend(
+          &fields, f == 0 ? "" : ",", R"("field)", f,
+          R"(":{"mapValue":{"fields":{"name":{"stringValue":"name of field )",
+          f, R"("},"count":{"integerValue":")", f,
+          R"("},"tags":{"arrayValue":{"values":[{"stringValue":"a"},)",
+          R"({"stringValue":"b"},{"stringValue":"c"}]}}}}})");
+    }
+    elements += LengthPrefixed(absl::StrCat(
+        R"({"document":{"name":")", name,
+        R"(","updateTime":{"seconds":"1","nanos":0},"fields":{)", fields,
+        "}}}"));
+  }
+
+  std::string metadata = absl::StrCat(
+      R"({"metadata":{"id":"bundle","createTime":{"seconds":"1","nanos":0},)",
+      R"("version":1,"totalDocuments":)", document_count,
+      R"(,"totalBytes":)", elements.size(), "}}");
+  return LengthPrefixed(metadata) + elements;
+}
+
+std::unique_ptr<BundleReader> MakeReader(const std::string& bundle) {
+  auto stream = absl::make_unique<ByteStreamCpp>(
+      absl::make_unique<std::stringstream>(bundle));
+  return absl::make_unique<BundleReader>(MakeSerializer(), std::move(stream));
+}
+
+/** Reads and decodes all elements of `bundle`. */
+void ReadBundle(benchmark::State& state, const std::string& bundle) {
+  for (auto _ : state) {
+    std::unique_ptr<BundleReader> reader = MakeReader(bundle);
+    int64_t elements = 0;
+    while (reader->GetNextElement()) {
+      ++elements;
+    }
+    HARD_ASSERT(reader->reader_status().ok(), "Failed to read bundle");
+    benchmark::DoNotOptimize(elements);
+  }
+
+  state.SetBytesProcessed(state.iterations() *
+                          static_cast<int64_t>(bundle.size()));
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+  state.counters["bundle_bytes"] =
+      benchmark::Counter(static_cast<double>(bundle.size()));
+}
+
+/** Decodes a JSON bundle of `state.range(0)` documents. */
+void BM_ReadJsonBundle(benchmark::State& state) {
+  ReadBundle(state, MakeJsonBundle(state.range(0)));
+}
+BENCHMARK(BM_ReadJsonBundle)->Arg(100)->Arg(1000);
+
+/** Decodes the same bundle as `BM_ReadJsonBundle` in the binary format. */
+void BM_ReadBinaryBundle(benchmark::State& state) {
+  std::unique_ptr<BundleReader> json_reader =
+      MakeReader(MakeJsonBundle(state.range(0)));
+  util::StatusOr<std::string> bundle =
+      ConvertToBinaryBundle(*json_reader, MakeSerializer());
+  HARD_ASSERT(bundle.ok(), "Failed to convert bundle");
+
+  ReadBundle(state, bundle.ValueOrDie());
+}
+BENCHMARK(BM_ReadBinaryBundle)->Arg(100)->Arg(1000);
+
+}  // namespace
+}  // namespace bundle
+}  // namespace firestore
+}  // namespace firebase
@@ -25,6 +25,7 @@
 #include "Firestore/Protos/cpp/firestore/bundle.pb.h"
 #include "Firestore/Protos/cpp/firestore/local/maybe_document.pb.h"
 #include "Firestore/Protos/cpp/google/firestore/v1/document.pb.h"
+#include "Firestore/core/src/bundle/bundle_converter.h"
 #include "Firestore/core/src/bundle/named_query.h"
 #include "Firestore/core/src/core/field_filter.h"
 #include "Firestore/core/src/local/local_serializer.h"
@@ -58,6 +59,7 @@ using model::DatabaseId;
 using nanopb::ProtobufParse;
 using util::ByteStream;
 using util::ByteStreamCpp;
+using util::StatusOr;
 
 class BundleReaderTest : public ::testing::Test {
  public:
@@ -78,6 +80,7 @@ class BundleReaderTest : public ::testing::Test {
     *element.mutable_named_query() = data;
     MessageToJsonString(element, &json);
     elements_.push_back(json);
+    binary_elements_.push_back(element.SerializeAsString());
     return json;
   }
 
@@ -87,6 +90,7 @@ class BundleReaderTest : public ::testing::Test {
     *element.mutable_document_metadata() = data;
     MessageToJsonString(element, &json);
     elements_.push_back(json);
+    binary_elements_.push_back(element.SerializeAsString());
     return json;
   }
 
@@ -96,6 +100,7 @@ class BundleReaderTest : public ::testing::Test {
     *element.mutable_document() = data;
     MessageToJsonString(element, &json);
     elements_.push_back(json);
+    binary_elements_.push_back(element.SerializeAsString());
     return json;
   }
 
@@ -127,6 +132,41 @@ class BundleReaderTest : public ::testing::Test {
     return std::to_string(metadata_str.size()) + metadata_str + bundle;
   }
 
+  /** Builds a binary bundle from the same elements as `BuildBundle`. */
+  std::string BuildBinaryBundle(const std::string& bundle_id,
+                                model::SnapshotVersion create_time,
+                                int32_t documents) {
+    std::string bundle;
+    for (const auto& element : binary_elements_) {
+      AppendVarint(element.size(), &bundle);
+      bundle.append(element);
+    }
+
+    ProtoBundleElement element;
+    ProtoBundleMetadata* metadata = element.mutable_metadata();
+    metadata->set_id(bundle_id);
+    metadata->set_version(1);
+    metadata->set_total_documents(documents);
+    metadata->mutable_create_time()->set_nanos(
+        create_time.timestamp().nanoseconds());
+    metadata->mutable_create_time()->set_seconds(
+        create_time.timestamp().seconds());
+    metadata->set_total_bytes(bundle.size());
+    std::string metadata_str = element.SerializeAsString();
+
+    std::string result(kBinaryBundleHeader, kBinaryBundleHeaderSize);
+    AppendVarint(metadata_str.size(), &result);
+    return result + metadata_str + bundle;
+  }
+
+  static void AppendVarint(size_t value, std::string* out) {
+    while (value >= 0x80) {
+      out->push_back(static_cast<char>((value & 0x7f) | 0x80));
+      value >>= 7;
+    }
+    out->push_back(static_cast<char>(value));
+  }
+
   std::unique_ptr<util::ByteStream> ToByteStream(const std::string& bundle) {
     auto bundle_istream = absl::make_unique<std::stringstream>(bundle);
     return absl::make_unique<ByteStreamCpp>(
@@ -327,6 +367,7 @@ class BundleReaderTest : public ::testing::Test {
 
  private:
   std::vector<std::string> elements_;
+  std::vector<std::string> binary_elements_;
 };
 
 TEST_F(BundleReaderTest, ReadsEmptyBundle) {
@@ -493,6 +534,91 @@ TEST_F(BundleReaderTest, ReadsLargeDocument) {
       *static_cast<BundleDocument*>(elements[1].get()), LargeDocument2());
 }
 
+TEST_F(BundleReaderTest, ReadsBinaryBundle) {
+  AddNamedQuery(LimitQuery());
+  AddNamedQuery(LimitToLastQuery());
+  AddDocumentMetadata(DocumentMetadata1());
+  AddDocument(Document1());
+  AddDocumentMetadata(DeletedDocumentMetadata());
+
+  const auto& bundle =
+      BuildBinaryBundle("bundle-1", testutil::Version(6000004000), 2);
+  BundleReader reader(bundle_serializer, ToByteStream(bundle));
+
+  std::vector<std::unique_ptr<BundleElement>> elements =
+      VerifyFullBundleParsed(reader, "bundle-1", testutil::Version(6000004000));
+
+  EXPECT_OK(reader.reader_status());
+  ASSERT_EQ(elements.size(), 5);
+  VerifyNamedQueryEncodesToOriginal(
+      *static_cast<NamedQuery*>(elements[0].get()), LimitQuery());
+  VerifyNamedQueryEncodesToOriginal(
+      *static_cast<NamedQuery*>(elements[1].get()), LimitToLastQuery());
+  VerifyDocumentMetadataEquals(
+      *static_cast<BundledDocumentMetadata*>(elements[2].get()),
+      DocumentMetadata1());
+  VerifyDocumentEncodesToOriginal(
+      *static_cast<BundleDocument*>(elements[3].get()), Document1());
+  VerifyDocumentMetadataEquals(
+      *static_cast<BundledDocumentMetadata*>(elements[4].get()),
+      DeletedDocumentMetadata());
+}
+
+TEST_F(BundleReaderTest, ConvertsJsonBundleToBinary) {
+  AddNamedQuery(LimitQuery());
+  AddDocumentMetadata(DocumentMetadata2());
+  AddDocument(LargeDocument2());
+
+  const auto& json_bundle =
+      BuildBundle("bundle-1", testutil::Version(6000004000), 1);
+  BundleReader json_reader(bundle_serializer, ToByteStream(json_bundle));
+  StatusOr<std::string> binary_bundle =
+      ConvertToBinaryBundle(json_reader, bundle_serializer);
+  ASSERT_OK(binary_bundle);
+  EXPECT_LT(binary_bundle.ValueOrDie().size(), json_bundle.size());
+
+  BundleReader reader(bundle_serializer,
+                      ToByteStream(binary_bundle.ValueOrDie()));
+  std::vector<std::unique_ptr<BundleElement>> elements =
+      VerifyFullBundleParsed(reader, "bundle-1", testutil::Version(6000004000));
+
+  EXPECT_OK(reader.reader_status());
+  ASSERT_EQ(elements.size(), 3);
+  VerifyNamedQueryEncodesToOriginal(
+      *static_cast<NamedQuery*>(elements[0].get()), LimitQuery());
+  VerifyDocumentMetadataEquals(
+      *static_cast<BundledDocumentMetadata*>(elements[1].get()),
+      DocumentMetadata2());
+  VerifyDocumentEncodesToOriginal(
+      *static_cast<BundleDocument*>(elements[2].get()), LargeDocument2());
+}
+
+TEST_F(BundleReaderTest, FailsWhenBinaryBundleIsTruncated) {
+  AddDocumentMetadata(DocumentMetadata1());
+  AddDocument(Document1());
+
+  const auto& bundle =
+      BuildBinaryBundle("bundle-1", testutil::Version(6000004000), 1);
+  // Cuts into the last element, which is larger than 16 bytes.
+  for (size_t cut = 1; cut < 16; ++cut) {
+    BundleReader reader(bundle_serializer,
+                        ToByteStream(bundle.substr(0, bundle.size() - cut)));
+    while (reader.GetNextElement() != nullptr) {
+    }
+    EXPECT_NOT_OK(reader.reader_status());
+  }
+}
+
+TEST_F(BundleReaderTest, FailsWithBadBinaryBundleHeader) {
+  std::string bundle =
+      BuildBinaryBundle("bundle-1", testutil::Version(6000004000), 0);
+  bundle[1] = 'X';
+  BundleReader reader(bundle_serializer, ToByteStream(bundle));
+
+  EXPECT_EQ(reader.GetBundleMetadata(), BundleMetadata());
+  EXPECT_NOT_OK(reader.reader_status());
+}
+
 TEST_F(BundleReaderTest, FailsWithBadLengthPrefix) {
   const auto& bundle =
       BuildBundle("bundle-1", testutil::Version(6000004000), 0);
@@ -0,0 +1,166 @@
+/*
+ * Copyright 2022 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Firestore/core/src/core/bundle_load_pipeline.h"
+
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "Firestore/core/src/api/load_bundle_task.h"
+#include "Firestore/core/src/bundle/bundle_reader.h"
+#include "Firestore/core/src/bundle/bundle_serializer.h"
+#include "Firestore/core/src/local/local_store.h"
+#include "Firestore/core/src/model/database_id.h"
+#include "Firestore/core/src/model/document.h"
+#include "Firestore/core/src/remote/serializer.h"
+#include "Firestore/core/src/util/byte_stream_cpp.h"
+#include "Firestore/core/src/util/executor.h"
+#include "Firestore/core/test/unit/core/sync_engine_testing.h"
+#include "Firestore/core/test/unit/testutil/async_testing.h"
+#include "Firestore/core/test/unit/testutil/bundle_builder.h"
+#include "Firestore/core/test/unit/testutil/testutil.h"
+#include "absl/memory/memory.h"
+#include "gtest/gtest.h"
+
+namespace firebase {
+namespace firestore {
+namespace core {
+namespace {
+
+using api::LoadBundleTask;
+using api::LoadBundleTaskProgress;
+using api::LoadBundleTaskState;
+using bundle::BundleReader;
+using bundle::BundleSerializer;
+using model::DatabaseId;
+using testutil::Expectation;
+using util::ByteStreamCpp;
+using util::Executor;
+
+class BundleLoadPipelineTest : public testing::Test,
+                               public testutil::AsyncTest {
+ public:
+  BundleLoadPipelineTest()
+      : bundle_executor_(testutil::ExecutorForTesting("bundle")),
+        result_task_(std::make_shared<LoadBundleTask>(
+            testutil::ExecutorForTesting("user"))) {
+  }
+
+  /**
+   * Loads `bundle` through a pipeline that reads chunks of `chunk_bytes`, and
+   * returns all progress updates up to the final one.
+   */
+  std::vector<LoadBundleTaskProgress> Load(const std::string& bundle,
+                                           uint64_t chunk_bytes) {
+    auto reader = std::make_shared<BundleReader>(
+        BundleSerializer(remote::Serializer(DatabaseId("p"))),
+        absl::make_unique<ByteStreamCpp>(
+            absl::make_unique<std::stringstream>(bundle)));
+
+    std::vector<LoadBundleTaskProgress> progresses;
+    Expectation done;
+    result_task_->Observe(
+        [&progresses, &done](LoadBundleTaskProgress progress) {
+          progresses.push_back(progress);
+          if (progress.state() != LoadBundleTaskState::kInProgress) {
+            done.Fulfill();
+          }
+        });
+
+    harness_.Run([&] {
+      std::make_shared<BundleLoadPipeline>(
+          harness_.worker_queue(), bundle_executor_.get(),
+          &harness_.sync_engine(), reader, result_task_, chunk_bytes)
+          ->Start();
+    });
+    Await(done);
+    return progresses;
+  }
+
+  SyncEngineHarness harness_;
+  std::unique_ptr<Executor> bundle_executor_;
+  std::shared_ptr<LoadBundleTask> result_task_;
+};
+
+TEST_F(BundleLoadPipelineTest, LoadsBundleOneElementPerChunk) {
+  std::string bundle = testutil::CreateBundle("p");
+  std::vector<LoadBundleTaskProgress> progresses =
+      Load(bundle, /*chunk_bytes=*/1);
+
+  // The initial progress, one for each document and the final one.
+  ASSERT_EQ(progresses.size(), 4u);
+  for (size_t i = 0; i != 3; ++i) {
+    EXPECT_EQ(progresses[i].state(), LoadBundleTaskState::kInProgress);
+    EXPECT_EQ(progresses[i].documents_loaded(), i);
+    EXPECT_EQ(progresses[i].total_documents(), 2u);
+  }
+  const LoadBundleTaskProgress& last = progresses.back();
+  EXPECT_EQ(last.state(), LoadBundleTaskState::kSuccess);
+  EXPECT_EQ(last.documents_loaded(), 2u);
+  EXPECT_EQ(last.bytes_loaded(), bundle.size());
+  EXPECT_EQ(last.total_bytes(), bundle.size());
+
+  harness_.Run([&] {
+    local::LocalStore& local_store = harness_.local_store();
+    EXPECT_TRUE(local_store.ReadDocument(testutil::Key("coll-1/a"))
+                    ->is_found_document());
+    EXPECT_TRUE(local_store.ReadDocument(testutil::Key("coll-1/b"))
+                    ->is_found_document());
+    EXPECT_TRUE(local_store.GetNamedQuery("limit").has_value());
+    EXPECT_TRUE(local_store.GetNamedQuery("limit-to-last").has_value());
+  });
+}
+
+TEST_F(BundleLoadPipelineTest, LoadsBundleInOneChunk) {
+  std::string bundle = testutil::CreateBundle("p");
+  std::vector<LoadBundleTaskProgress> progresses =
+      Load(bundle, BundleLoadPipeline::kChunkBytes);
+
+  ASSERT_FALSE(progresses.empty());
+  EXPECT_EQ(progresses.back().state(), LoadBundleTaskState::kSuccess);
+  EXPECT_EQ(progresses.back().documents_loaded(), 2u);
+}
+
+TEST_F(BundleLoadPipelineTest, FailsOnTruncatedBundle) {
+  std::string bundle = testutil::CreateBundle("p");
+  std::vector<LoadBundleTaskProgress> progresses =
+      Load(bundle.substr(0, bundle.size() - 10), /*chunk_bytes=*/1);
+
+  ASSERT_FALSE(progresses.empty());
+  EXPECT_EQ(progresses.back().state(), LoadBundleTaskState::kError);
+
+  // The truncated document is never applied.
+  harness_.Run([&] {
+    EXPECT_FALSE(harness_.local_store()
+                     .ReadDocument(testutil::Key("coll-1/b"))
+                     ->is_found_document());
+  });
+}
+
+TEST_F(BundleLoadPipelineTest, FailsOnInvalidMetadata) {
+  std::vector<LoadBundleTaskProgress> progresses =
+      Load("3{}", /*chunk_bytes=*/1);
+
+  ASSERT_EQ(progresses.size(), 1u);
+  EXPECT_EQ(progresses.back().state(), LoadBundleTaskState::kError);
+}
+
+}  // namespace
+}  // namespace core
+}  // namespace firestore
+}  // namespace firebase
@@ -48,6 +48,7 @@ using testutil::DbId;
 using testutil::Doc;
 using testutil::Field;
 using testutil::Filter;
+using testutil::Key;
 using testutil::Map;
 using testutil::OrderBy;
 using testutil::Ref;
@@ -113,6 +114,22 @@ TEST(QueryTest, MatchesShallowAncestorQuery) {
   EXPECT_THAT(query, Not(Matches(doc3)));
 }
 
+TEST(QueryTest, MatchesPathAndCollectionGroupIgnoringFilters) {
+  auto query =
+      testutil::Query("rooms/eros/messages").AddingFilter(Filter("a", "==", 1));
+  EXPECT_TRUE(
+      query.MatchesPathAndCollectionGroup(Key("rooms/eros/messages/1")));
+  EXPECT_FALSE(
+      query.MatchesPathAndCollectionGroup(Key("rooms/other/messages/1")));
+  EXPECT_FALSE(query.MatchesPathAndCollectionGroup(
+      Key("rooms/eros/messages/1/meta/1")));
+
+  auto group = CollectionGroupQuery("messages");
+  EXPECT_TRUE(
+      group.MatchesPathAndCollectionGroup(Key("rooms/other/messages/1")));
+  EXPECT_FALSE(group.MatchesPathAndCollectionGroup(Key("rooms/eros")));
+}
+
 TEST(QueryTest, EmptyFieldsAreAllowedForQueries) {
   auto doc1 = Doc("rooms/eros/messages/1", 0, Map("text", "msg1"));
   auto doc2 = Doc("rooms/eros/messages/2", 0, Map());
@@ -0,0 +1,82 @@
+/*
+ * Copyright 2022 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <vector>
+
+#include "Firestore/core/src/core/query.h"
+#include "Firestore/core/src/core/sync_engine.h"
+#include "Firestore/core/src/model/mutable_document.h"
+#include "Firestore/core/src/model/types.h"
+#include "Firestore/core/src/remote/remote_event.h"
+#include "Firestore/core/test/unit/core/sync_engine_testing.h"
+#include "Firestore/core/test/unit/testutil/testutil.h"
+#include "absl/strings/str_cat.h"
+#include "benchmark/benchmark.h"
+
+namespace firebase {
+namespace firestore {
+namespace core {
+namespace {
+
+using model::MutableDocument;
+using model::TargetId;
+using remote::RemoteEvent;
+
+/**
+ * Applies remote events that change `state.range(1)` documents in one
+ * collection while `state.range(0)` queries listen to distinct collections.
+ */
+void BM_SyncEngineApplyRemoteEvent(benchmark::State& state) {
+  int64_t listener_count = state.range(0);
+  int64_t change_count = state.range(1);
+  SyncEngineHarness harness;
+
+  TargetId target_id = 0;
+  harness.Run([&] {
+    for (int64_t i = 0; i < listener_count; ++i) {
+      Query query = testutil::Query(absl::StrCat("coll", i));
+      TargetId listen_id = harness.sync_engine().Listen(query);
+      if (i == 0) target_id = listen_id;
+    }
+  });
+
+  int64_t version = 0;
+  for (auto _ : state) {
+    state.PauseTiming();
+    harness.Run([&] { harness.TakeSnapshots(); });
+    ++version;
+    std::vector<MutableDocument> docs;
+    for (int64_t i = 0; i < change_count; ++i) {
+      docs.push_back(testutil::Doc(absl::StrCat("coll0/doc", i), version,
+                                   testutil::Map("version", version)));
+    }
+    RemoteEvent event = testutil::AddedRemoteEvent(docs, {target_id});
+    state.ResumeTiming();
+
+    harness.Run([&] { harness.sync_engine().ApplyRemoteEvent(event); });
+  }
+  state.SetItemsProcessed(state.iterations() * change_count);
+}
+BENCHMARK(BM_SyncEngineApplyRemoteEvent)
+    ->Args({1, 100})
+    ->Args({30, 100})
+    ->Args({300, 10})
+    ->Args({300, 100});
+
+}  // namespace
+}  // namespace core
+}  // namespace firestore
+}  // namespace firebase
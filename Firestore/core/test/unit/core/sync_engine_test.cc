@@ -0,0 +1,167 @@
+/*
+ * Copyright 2022 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Firestore/core/src/core/sync_engine.h"
+
+#include <algorithm>
+#include <utility>
+#include <vector>
+
+#include "Firestore/core/src/core/filter.h"
+#include "Firestore/core/src/core/query.h"
+#include "Firestore/core/src/core/target.h"
+#include "Firestore/core/src/core/view_snapshot.h"
+#include "Firestore/core/src/model/mutation.h"
+#include "Firestore/core/src/model/resource_path.h"
+#include "Firestore/core/src/model/set_mutation.h"
+#include "Firestore/core/src/model/types.h"
+#include "Firestore/core/src/nanopb/byte_string.h"
+#include "Firestore/core/src/remote/remote_event.h"
+#include "Firestore/core/src/util/status.h"
+#include "Firestore/core/test/unit/core/sync_engine_testing.h"
+#include "Firestore/core/test/unit/testutil/testutil.h"
+#include "absl/types/optional.h"
+#include "gtest/gtest.h"
+
+namespace firebase {
+namespace firestore {
+namespace core {
+namespace {
+
+using model::Mutation;
+using model::ResourcePath;
+using model::TargetId;
+using nanopb::ByteString;
+using remote::RemoteEvent;
+using remote::TargetChange;
+using testutil::Map;
+using util::Status;
+
+class SyncEngineTest : public testing::Test {
+ public:
+  /** Listens to `query` and discards its initial snapshot. */
+  TargetId Listen(const Query& query) {
+    TargetId target_id = 0;
+    harness_.Run([&] {
+      target_id = harness_.sync_engine().Listen(query);
+      harness_.TakeSnapshots();
+    });
+    return target_id;
+  }
+
+  /** Writes `mutation` locally and returns the queries that raised events. */
+  std::vector<Query> Write(Mutation mutation) {
+    std::vector<Query> result;
+    harness_.Run([&] {
+      std::vector<Mutation> mutations{std::move(mutation)};
+      harness_.sync_engine().WriteMutations(std::move(mutations),
+                                            [](Status) {});
+      result = QueriesOf(harness_.TakeSnapshots());
+    });
+    return result;
+  }
+
+  static std::vector<Query> QueriesOf(
+      const std::vector<ViewSnapshot>& snapshots) {
+    std::vector<Query> result;
+    for (const ViewSnapshot& snapshot : snapshots) {
+      result.push_back(snapshot.query());
+    }
+    return result;
+  }
+
+  SyncEngineHarness harness_;
+};
+
+}  // namespace
+
+TEST_F(SyncEngineTest, RoutesChangesToViewsOfTheirCollectionGroup) {
+  Query collection = testutil::Query("coll");
+  Query other_collection = testutil::Query("other");
+  Query collection_group = testutil::CollectionGroupQuery("coll");
+  Query document = testutil::Query("coll/a");
+  Query subcollection = testutil::Query("coll/a/sub");
+  Listen(collection);
+  Listen(other_collection);
+  Listen(collection_group);
+  Listen(document);
+  Listen(subcollection);
+
+  std::vector<Query> raised =
+      Write(testutil::SetMutation("coll/a", Map("v", 1)));
+  EXPECT_EQ(raised.size(), 3u);
+  EXPECT_NE(std::find(raised.begin(), raised.end(), collection), raised.end());
+  EXPECT_NE(std::find(raised.begin(), raised.end(), collection_group),
+            raised.end());
+  EXPECT_NE(std::find(raised.begin(), raised.end(), document), raised.end());
+
+  // Documents in a subcollection belong to the subcollection's group only.
+  raised = Write(testutil::SetMutation("coll/a/sub/b", Map("v", 1)));
+  EXPECT_EQ(raised, std::vector<Query>({subcollection}));
+
+  raised = Write(testutil::SetMutation("coll/b", Map("v", 1)));
+  EXPECT_EQ(raised.size(), 2u);
+  EXPECT_EQ(std::find(raised.begin(), raised.end(), document), raised.end());
+}
+
+TEST_F(SyncEngineTest, RoutesChangesToDocumentQueriesWithFilters) {
+  // A query whose path names a document only matches that document, even if
+  // it has filters.
+  Query document{ResourcePath::FromString("coll/a"),
+                 /*collection_group=*/nullptr,
+                 {testutil::Filter("v", "==", 1)},
+                 /*explicit_order_bys=*/{},
+                 Target::kNoLimit,
+                 LimitType::None,
+                 absl::nullopt,
+                 absl::nullopt};
+  Listen(document);
+
+  std::vector<Query> raised =
+      Write(testutil::SetMutation("coll/a", Map("v", 1)));
+  EXPECT_EQ(raised, std::vector<Query>({document}));
+}
+
+TEST_F(SyncEngineTest, SkipsViewsWithoutChanges) {
+  Query collection = testutil::Query("coll");
+  Query other_collection = testutil::Query("other");
+  Listen(collection);
+  TargetId other_target = Listen(other_collection);
+
+  // A remote event without document changes only updates the views of the
+  // targets it changes.
+  RemoteEvent event{
+      testutil::Version(1),
+      {{other_target,
+        TargetChange{ByteString("resume"), /*current=*/true, {}, {}, {}}}},
+      {},
+      {},
+      {}};
+  harness_.Run([&] {
+    harness_.sync_engine().ApplyRemoteEvent(event);
+    std::vector<ViewSnapshot> snapshots = harness_.TakeSnapshots();
+    ASSERT_EQ(snapshots.size(), 1u);
+    EXPECT_EQ(snapshots[0].query(), other_collection);
+    EXPECT_FALSE(snapshots[0].from_cache());
+  });
+
+  // Changes to documents that no query can match raise no events.
+  EXPECT_TRUE(Write(testutil::SetMutation("unrelated/a", Map())).empty());
+}
+
+}  // namespace core
+}  // namespace firestore
+}  // namespace firebase
@@ -0,0 +1,102 @@
+/*
+ * Copyright 2022 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Firestore/core/test/unit/core/sync_engine_testing.h"
+
+#include <utility>
+
+#include "Firestore/core/src/core/database_info.h"
+#include "Firestore/core/src/core/sync_engine.h"
+#include "Firestore/core/src/credentials/empty_credentials_provider.h"
+#include "Firestore/core/src/credentials/user.h"
+#include "Firestore/core/src/local/local_store.h"
+#include "Firestore/core/src/local/memory_persistence.h"
+#include "Firestore/core/src/model/database_id.h"
+#include "Firestore/core/src/remote/connectivity_monitor.h"
+#include "Firestore/core/src/remote/datastore.h"
+#include "Firestore/core/src/remote/firebase_metadata_provider.h"
+#include "Firestore/core/src/remote/firebase_metadata_provider_noop.h"
+#include "Firestore/core/src/remote/remote_store.h"
+#include "Firestore/core/src/util/async_queue.h"
+#include "Firestore/core/test/unit/local/persistence_testing.h"
+#include "Firestore/core/test/unit/remote/create_noop_connectivity_monitor.h"
+#include "Firestore/core/test/unit/testutil/async_testing.h"
+#include "absl/memory/memory.h"
+
+namespace firebase {
+namespace firestore {
+namespace core {
+
+using credentials::EmptyAppCheckCredentialsProvider;
+using credentials::EmptyAuthCredentialsProvider;
+using credentials::User;
+using local::LocalStore;
+using model::DatabaseId;
+using model::OnlineState;
+using remote::Datastore;
+using remote::RemoteStore;
+
+SyncEngineHarness::SyncEngineHarness()
+    : worker_queue_(testutil::AsyncQueueForTesting()) {
+  Run([&] {
+    persistence_ = local::MemoryPersistenceWithEagerGcForTesting();
+    local_store_ = absl::make_unique<LocalStore>(
+        persistence_.get(), &query_engine_, User::Unauthenticated());
+    local_store_->Start();
+
+    connectivity_monitor_ = remote::CreateNoOpConnectivityMonitor();
+    firebase_metadata_provider_ = remote::CreateFirebaseMetadataProviderNoOp();
+    auto datastore = std::make_shared<Datastore>(
+        DatabaseInfo(DatabaseId("p", "d"), "", "localhost", false),
+        worker_queue_, std::make_shared<EmptyAuthCredentialsProvider>(),
+        std::make_shared<EmptyAppCheckCredentialsProvider>(),
+        connectivity_monitor_.get(), firebase_metadata_provider_.get());
+    remote_store_ = absl::make_unique<RemoteStore>(
+        local_store_.get(), std::move(datastore), worker_queue_,
+        connectivity_monitor_.get(), [](OnlineState) {});
+
+    sync_engine_ = absl::make_unique<SyncEngine>(
+        local_store_.get(), remote_store_.get(), User::Unauthenticated(),
+        /*max_concurrent_limbo_resolutions=*/100);
+    sync_engine_->SetCallback(this);
+    remote_store_->set_sync_engine(sync_engine_.get());
+  });
+}
+
+SyncEngineHarness::~SyncEngineHarness() {
+  Run([&] { remote_store_->Shutdown(); });
+}
+
+void SyncEngineHarness::Run(const std::function<void()>& operation) {
+  worker_queue_->EnqueueBlocking(operation);
+}
+
+std::vector<ViewSnapshot> SyncEngineHarness::TakeSnapshots() {
+  std::vector<ViewSnapshot> result;
+  result.swap(snapshots_);
+  return result;
+}
+
+void SyncEngineHarness::OnViewSnapshots(
+    std::vector<ViewSnapshot>&& snapshots) {
+  for (ViewSnapshot& snapshot : snapshots) {
+    snapshots_.push_back(std::move(snapshot));
+  }
+}
+
+}  // namespace core
+}  // namespace firestore
+}  // namespace firebase
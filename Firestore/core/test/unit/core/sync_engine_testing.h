@@ -0,0 +1,103 @@
+/*
+ * Copyright 2022 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef FIRESTORE_CORE_TEST_UNIT_CORE_SYNC_ENGINE_TESTING_H_
+#define FIRESTORE_CORE_TEST_UNIT_CORE_SYNC_ENGINE_TESTING_H_
+
+#include <functional>
+#include <memory>
+#include <vector>
+
+#include "Firestore/core/src/core/sync_engine_callback.h"
+#include "Firestore/core/src/core/view_snapshot.h"
+#include "Firestore/core/src/local/query_engine.h"
+
+namespace firebase {
+namespace firestore {
+
+namespace local {
+class LocalStore;
+class MemoryPersistence;
+}  // namespace local
+
+namespace remote {
+class ConnectivityMonitor;
+class FirebaseMetadataProvider;
+class RemoteStore;
+}  // namespace remote
+
+namespace util {
+class AsyncQueue;
+}  // namespace util
+
+namespace core {
+
+class SyncEngine;
+
+/**
+ * A `SyncEngine` backed by an in-memory `LocalStore` and a `RemoteStore` whose
+ * network is never enabled, so that remote events can be fed to it directly.
+ * The view snapshots it raises are recorded.
+ */
+class SyncEngineHarness : public SyncEngineCallback {
+ public:
+  SyncEngineHarness();
+  ~SyncEngineHarness();
+
+  SyncEngine& sync_engine() {
+    return *sync_engine_;
+  }
+
+  local::LocalStore& local_store() {
+    return *local_store_;
+  }
+
+  const std::shared_ptr<util::AsyncQueue>& worker_queue() const {
+    return worker_queue_;
+  }
+
+  /** Runs `operation` on the worker queue, as the client does. */
+  void Run(const std::function<void()>& operation);
+
+  /**
+   * Returns the view snapshots raised since the last call and forgets them.
+   * Must be called on the worker queue.
+   */
+  std::vector<ViewSnapshot> TakeSnapshots();
+
+  void HandleOnlineStateChange(model::OnlineState) override {
+  }
+  void OnViewSnapshots(std::vector<ViewSnapshot>&& snapshots) override;
+  void OnError(const Query&, const util::Status&) override {
+  }
+
+ private:
+  std::shared_ptr<util::AsyncQueue> worker_queue_;
+  std::unique_ptr<local::MemoryPersistence> persistence_;
+  local::QueryEngine query_engine_;
+  std::unique_ptr<local::LocalStore> local_store_;
+  std::unique_ptr<remote::ConnectivityMonitor> connectivity_monitor_;
+  std::unique_ptr<remote::FirebaseMetadataProvider> firebase_metadata_provider_;
+  std::unique_ptr<remote::RemoteStore> remote_store_;
+  std::unique_ptr<SyncEngine> sync_engine_;
+  std::vector<ViewSnapshot> snapshots_;
+};
+
+}  // namespace core
+}  // namespace firestore
+}  // namespace firebase
+
+#endif  // FIRESTORE_CORE_TEST_UNIT_CORE_SYNC_ENGINE_TESTING_H_
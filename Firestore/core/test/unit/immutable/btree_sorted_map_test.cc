@@ -0,0 +1,179 @@
+/*
+ * Copyright 2022 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Firestore/core/src/immutable/btree_sorted_map.h"
+
+#include <map>
+#include <random>
+#include <utility>
+#include <vector>
+
+#include "Firestore/core/test/unit/immutable/testing.h"
+#include "gtest/gtest.h"
+
+namespace firebase {
+namespace firestore {
+namespace immutable {
+namespace impl {
+
+using IntMap = BTreeSortedMap<int, int>;
+using Node = IntMap::node_type;
+
+/**
+ * Verifies the invariants of the subtree at `node`: all leaves are at the same
+ * depth, nodes other than the root aren't underfull, and the cached sizes and
+ * smallest keys are accurate. Returns the depth of the subtree's leaves.
+ */
+int CheckNode(const Node& node, bool is_root) {
+  EXPECT_LE(node.slot_count(), Node::kMaxSlots);
+  if (!is_root) {
+    EXPECT_GE(node.slot_count(), Node::kMinSlots);
+  }
+
+  if (node.leaf()) {
+    const auto& entries = node.as_leaf().entries();
+    EXPECT_EQ(node.size(), entries.size());
+    for (size_t i = 1; i < entries.size(); ++i) {
+      EXPECT_LT(entries[i - 1].first, entries[i].first);
+    }
+    return 1;
+  }
+
+  const auto& children = node.as_inner().children();
+  EXPECT_GE(children.size(), 2u);
+  int depth = -1;
+  SortedContainer::size_type size = 0;
+  for (const auto& child : children) {
+    EXPECT_EQ(child.min_key, child.node->min_key());
+    int child_depth = CheckNode(*child.node, false);
+    if (depth == -1) depth = child_depth;
+    EXPECT_EQ(depth, child_depth);
+    size += child.node->size();
+  }
+  EXPECT_EQ(node.size(), size);
+  return depth + 1;
+}
+
+void CheckInvariants(const IntMap& map) {
+  if (map.root()) {
+    CheckNode(*map.root(), true);
+  }
+}
+
+std::vector<std::pair<int, int>> Entries(const std::map<int, int>& map) {
+  return {map.begin(), map.end()};
+}
+
+TEST(BTreeSortedMap, EmptyHasNoRoot) {
+  IntMap map;
+  EXPECT_EQ(map.root(), nullptr);
+  EXPECT_EQ(map.begin(), map.end());
+  EXPECT_EQ(map.insert(1, 1).erase(1).root(), nullptr);
+}
+
+TEST(BTreeSortedMap, MatchesStdMapUnderRandomOperations) {
+  std::mt19937 rand;
+  std::uniform_int_distribution<int> keys(0, 5000);
+
+  std::map<int, int> expected;
+  IntMap map;
+  for (int i = 0; i < 20000; ++i) {
+    int key = keys(rand);
+    // Insert a bit more often than erasing so that the tree grows and shrinks
+    // over time.
+    if (rand() % 5 < 3) {
+      expected[key] = i;
+      map = map.insert(key, i);
+    } else {
+      expected.erase(key);
+      map = map.erase(key);
+    }
+
+    ASSERT_EQ(expected.size(), map.size());
+    if (i % 1000 == 0) {
+      CheckInvariants(map);
+      ASSERT_EQ(Entries(expected), Collect(map));
+    }
+  }
+  CheckInvariants(map);
+  ASSERT_EQ(Entries(expected), Collect(map));
+
+  for (const auto& entry : expected) {
+    map = map.erase(entry.first);
+  }
+  EXPECT_TRUE(map.empty());
+}
+
+TEST(BTreeSortedMap, MutationsDoNotAffectOriginal) {
+  std::vector<int> keys = Sequence(1000);
+  IntMap original = ToMap<IntMap>(keys);
+
+  IntMap inserted = original.insert(1000, 1000).insert(-1, -1);
+  IntMap erased = original;
+  for (int key : Shuffled(keys)) {
+    if (key % 3 == 0) erased = erased.erase(key);
+  }
+
+  ASSERT_SEQ_EQ(Pairs(keys), original);
+  EXPECT_EQ(1002u, inserted.size());
+  EXPECT_EQ(666u, erased.size());
+  CheckInvariants(original);
+  CheckInvariants(inserted);
+  CheckInvariants(erased);
+}
+
+TEST(BTreeSortedMap, CreateSortsAndKeepsLastDuplicate) {
+  std::vector<std::pair<int, int>> entries;
+  for (int i : Shuffled(Sequence(500))) {
+    entries.emplace_back(i, 0);
+    entries.emplace_back(i, i);
+  }
+
+  IntMap map = IntMap::Create(entries, {});
+  CheckInvariants(map);
+  ASSERT_SEQ_EQ(Pairs(Sequence(500)), map);
+}
+
+TEST(BTreeSortedMap, FindsIndexesAndBoundsAcrossLeaves) {
+  std::vector<int> keys = Sequence(0, 4000, 2);
+  IntMap map = ToMap<IntMap>(Shuffled(keys));
+  CheckInvariants(map);
+
+  for (int i = 0; i < 4000; ++i) {
+    auto found = map.lower_bound(i);
+    int expected = i % 2 == 0 ? i : i + 1;
+    if (expected >= 4000) {
+      EXPECT_EQ(map.end(), found);
+    } else {
+      ASSERT_NE(map.end(), found);
+      EXPECT_EQ(expected, found->first);
+    }
+
+    if (i % 2 == 0) {
+      EXPECT_EQ(static_cast<SortedContainer::size_type>(i / 2),
+                map.find_index(i));
+    } else {
+      EXPECT_EQ(IntMap::npos, map.find_index(i));
+    }
+  }
+
+  EXPECT_EQ(3998, map.max()->first);
+}
+
+}  // namespace impl
+}  // namespace immutable
+}  // namespace firestore
+}  // namespace firebase
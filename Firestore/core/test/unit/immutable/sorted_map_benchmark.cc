@@ -0,0 +1,130 @@
+/*
+ * Copyright 2022 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <algorithm>
+#include <cstdint>
+#include <random>
+#include <utility>
+#include <vector>
+
+#include "Firestore/core/src/immutable/btree_sorted_map.h"
+#include "Firestore/core/src/immutable/tree_sorted_map.h"
+#include "benchmark/benchmark.h"
+
+namespace firebase {
+namespace firestore {
+namespace immutable {
+namespace impl {
+namespace {
+
+using LlrbMap = TreeSortedMap<int, int>;
+using BTreeMap = BTreeSortedMap<int, int>;
+
+/**
+ * Returns the keys 0, 2, 4, ... up to `2 * (count - 1)` in random order, so
+ * that odd keys are known to be absent from a map built from them.
+ */
+std::vector<int> ShuffledEvenKeys(int64_t count) {
+  std::vector<int> keys;
+  keys.reserve(count);
+  for (int64_t i = 0; i < count; ++i) {
+    keys.push_back(static_cast<int>(i * 2));
+  }
+  std::shuffle(keys.begin(), keys.end(), std::mt19937{});
+  return keys;
+}
+
+template <typename Map>
+Map BuildMap(const std::vector<int>& keys) {
+  Map map;
+  for (int key : keys) {
+    map = map.insert(key, key);
+  }
+  return map;
+}
+
+/** Inserts keys that are absent from a map of `state.range(0)` entries. */
+template <typename Map>
+void BM_SortedMapInsert(benchmark::State& state) {
+  std::vector<int> keys = ShuffledEvenKeys(state.range(0));
+  Map map = BuildMap<Map>(keys);
+
+  size_t i = 0;
+  for (auto _ : state) {
+    int key = keys[i++ % keys.size()] + 1;
+    benchmark::DoNotOptimize(map.insert(key, key));
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+
+/** Erases keys that are present in a map of `state.range(0)` entries. */
+template <typename Map>
+void BM_SortedMapErase(benchmark::State& state) {
+  std::vector<int> keys = ShuffledEvenKeys(state.range(0));
+  Map map = BuildMap<Map>(keys);
+
+  size_t i = 0;
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(map.erase(keys[i++ % keys.size()]));
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+
+/** Looks up keys that are present in a map of `state.range(0)` entries. */
+template <typename Map>
+void BM_SortedMapFind(benchmark::State& state) {
+  std::vector<int> keys = ShuffledEvenKeys(state.range(0));
+  Map map = BuildMap<Map>(keys);
+
+  size_t i = 0;
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(map.find(keys[i++ % keys.size()]));
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+
+/** Iterates over all entries of a map of `state.range(0)` entries. */
+template <typename Map>
+void BM_SortedMapIterate(benchmark::State& state) {
+  Map map = BuildMap<Map>(ShuffledEvenKeys(state.range(0)));
+
+  for (auto _ : state) {
+    int64_t sum = 0;
+    for (const auto& entry : map) {
+      sum += entry.second;
+    }
+    benchmark::DoNotOptimize(sum);
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+#define SORTED_MAP_BENCHMARK(name, map_type) \
+  BENCHMARK_TEMPLATE(name, map_type)->Arg(1000)->Arg(100000)->Arg(1000000)
+
+SORTED_MAP_BENCHMARK(BM_SortedMapInsert, LlrbMap);
+SORTED_MAP_BENCHMARK(BM_SortedMapInsert, BTreeMap);
+SORTED_MAP_BENCHMARK(BM_SortedMapErase, LlrbMap);
+SORTED_MAP_BENCHMARK(BM_SortedMapErase, BTreeMap);
+SORTED_MAP_BENCHMARK(BM_SortedMapFind, LlrbMap);
+SORTED_MAP_BENCHMARK(BM_SortedMapFind, BTreeMap);
+SORTED_MAP_BENCHMARK(BM_SortedMapIterate, LlrbMap);
+SORTED_MAP_BENCHMARK(BM_SortedMapIterate, BTreeMap);
+
+}  // namespace
+}  // namespace impl
+}  // namespace immutable
+}  // namespace firestore
+}  // namespace firebase
@@ -30,6 +30,7 @@
 #include <utility>
 
 #include "Firestore/core/src/immutable/array_sorted_map.h"
+#include "Firestore/core/src/immutable/btree_sorted_map.h"
 #include "Firestore/core/src/immutable/tree_sorted_map.h"
 #include "Firestore/core/src/util/secure_random.h"
 #include "Firestore/core/test/unit/immutable/testing.h"
@@ -52,6 +53,12 @@ struct TestPolicy<impl::ArraySortedMap<int, int>> {
   static const SizeType kLargeSize = SortedMapBase::kFixedSize;
 };
 
+template <>
+struct TestPolicy<impl::BTreeSortedMap<int, int>> {
+  // Large enough for a tree with three levels.
+  static const SizeType kLargeSize = 2000;
+};
+
 template <typename IntMap>
 class SortedMapTest : public ::testing::Test {
  public:
@@ -67,7 +74,8 @@ class SortedMapTest : public ::testing::Test {
 // NOLINTNEXTLINE: must be a typedef for the gtest macros
 typedef ::testing::Types<SortedMap<int, int>,
                          impl::ArraySortedMap<int, int>,
-                         impl::TreeSortedMap<int, int>>
+                         impl::TreeSortedMap<int, int>,
+                         impl::BTreeSortedMap<int, int>>
     TestedTypes;
 TYPED_TEST_SUITE(SortedMapTest, TestedTypes);
 
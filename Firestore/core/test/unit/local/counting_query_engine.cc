@@ -193,6 +193,16 @@ model::MutableDocumentMap WrappedRemoteDocumentCache::GetAll(
   return result;
 }
 
+std::vector<model::MutableDocumentMap> WrappedRemoteDocumentCache::GetAll(
+    const std::vector<model::ResourcePath>& collections,
+    const model::IndexOffset& offset) const {
+  auto results = subject_->GetAll(collections, offset);
+  for (const auto& result : results) {
+    query_engine_->documents_read_by_query_ += result.size();
+  }
+  return results;
+}
+
 // MARK: - WrappedDocumentOverlayCache
 
 absl::optional<model::Overlay> WrappedDocumentOverlayCache::GetOverlay(
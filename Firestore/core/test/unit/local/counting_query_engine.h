@@ -187,6 +187,10 @@ class WrappedRemoteDocumentCache : public RemoteDocumentCache {
                                    const model::IndexOffset& offset,
                                    absl::optional<size_t>) const override;
 
+  std::vector<model::MutableDocumentMap> GetAll(
+      const std::vector<model::ResourcePath>& collections,
+      const model::IndexOffset& offset) const override;
+
   void SetIndexManager(IndexManager* manager) override {
     index_manager_ = NOT_NULL(manager);
   }
@@ -13,6 +13,10 @@
 // limitations under the License.
 
 #include "Firestore/core/src/local/index_backfiller.h"
+
+#include <chrono>  // NOLINT(build/c++11)
+#include <string>
+
 #include "Firestore/core/src/core/filter.h"
 #include "Firestore/core/src/core/target.h"
 #include "Firestore/core/src/credentials/user.h"
@@ -112,6 +116,17 @@ class IndexBackfillerTest : public ::testing::Test {
     index_backfiller_->SetMaxDocumentsToProcess(new_max);
   }
 
+  int MaxDocumentsToProcess() const {
+    return index_backfiller_->max_documents_to_process();
+  }
+
+  /** Writes index entries without adjusting the batch size afterwards. */
+  int WriteIndexEntries() const {
+    return persistence_->Run("WriteIndexEntries in BackfillerTests", [&] {
+      return index_backfiller_->WriteIndexEntries(&local_store_);
+    });
+  }
+
   void VerifyQueryResults(
       const core::Query& query,
       const std::unordered_set<std::string>& expected_keys) const {
@@ -341,6 +356,48 @@ TEST_F(IndexBackfillerTest, WritesUntilCap) {
   VerifyQueryResults("coll2", {"coll2/docA"});
 }
 
+TEST_F(IndexBackfillerTest, ReportsProgress) {
+  SetMaxDocumentsToProcess(2);
+
+  AddFieldIndex("coll1", "foo");
+  AddDoc("coll1/docA", Version(10), "foo", 1);
+  AddDoc("coll1/docB", Version(20), "foo", 1);
+  AddDoc("coll1/docC", Version(30), "foo", 1);
+
+  ASSERT_EQ(2, local_store_.Backfill());
+  EXPECT_EQ(2, local_store_.index_backfill_progress().documents_processed);
+  EXPECT_FALSE(local_store_.index_backfill_progress().caught_up);
+
+  ASSERT_EQ(1, local_store_.Backfill());
+  EXPECT_EQ(1, local_store_.index_backfill_progress().documents_processed);
+  EXPECT_TRUE(local_store_.index_backfill_progress().caught_up);
+}
+
+TEST_F(IndexBackfillerTest, AdjustsBatchSizeToDuration) {
+  AddFieldIndex("coll1", "foo");
+  for (int i = 0; i < 60; ++i) {
+    AddDoc("coll1/doc" + std::to_string(i), Version(10), "foo", i);
+  }
+
+  int initial_batch_size = MaxDocumentsToProcess();
+  ASSERT_EQ(initial_batch_size, WriteIndexEntries());
+
+  // Fast batches that hit the cap grow.
+  index_backfiller_->AdjustBatchSize(std::chrono::milliseconds(1));
+  EXPECT_EQ(2 * initial_batch_size, MaxDocumentsToProcess());
+
+  // Slow batches shrink, but not below the initial size.
+  index_backfiller_->AdjustBatchSize(std::chrono::milliseconds(30));
+  EXPECT_LT(MaxDocumentsToProcess(), 2 * initial_batch_size);
+  index_backfiller_->AdjustBatchSize(std::chrono::milliseconds(1000));
+  EXPECT_EQ(initial_batch_size, MaxDocumentsToProcess());
+
+  // Batches that did not hit the cap don't grow.
+  ASSERT_EQ(60 - initial_batch_size, WriteIndexEntries());
+  index_backfiller_->AdjustBatchSize(std::chrono::milliseconds(1));
+  EXPECT_EQ(initial_batch_size, MaxDocumentsToProcess());
+}
+
 TEST_F(IndexBackfillerTest, UsesLatestReadTimeForEmptyCollections) {
   AddFieldIndex("coll", "foo", Version(1));
   AddDoc("readtime/doc", Version(1), "foo", 1);
@@ -0,0 +1,230 @@
+/*
+ * Copyright 2022 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Firestore/core/src/local/leveldb_byte_sizes.h"
+
+#include <memory>
+#include <string>
+
+#include "Firestore/core/src/local/leveldb_key.h"
+#include "Firestore/core/src/local/leveldb_persistence.h"
+#include "Firestore/core/src/local/leveldb_transaction.h"
+#include "Firestore/core/src/util/path.h"
+#include "Firestore/core/test/unit/local/persistence_testing.h"
+#include "Firestore/core/test/unit/testutil/status_testing.h"
+#include "Firestore/core/test/unit/testutil/testutil.h"
+#include "gtest/gtest.h"
+#include "leveldb/db.h"
+
+namespace firebase {
+namespace firestore {
+namespace local {
+namespace {
+
+using leveldb::DB;
+using leveldb::Options;
+using leveldb::Status;
+using testutil::Key;
+using util::Path;
+
+class LevelDbByteSizesTest : public testing::Test {
+ protected:
+  void SetUp() override {
+    Options options;
+    options.error_if_exists = true;
+    options.create_if_missing = true;
+
+    Path dir = LevelDbDir();
+    DB* db = nullptr;
+    Status status = DB::Open(options, dir.ToUtf8String(), &db);
+    ASSERT_TRUE(status.ok()) << "Failed to create db: "
+                             << status.ToString().c_str();
+    db_.reset(db);
+  }
+
+  /** Starts tracking the byte sizes of the database. */
+  void TrackByteSizes() {
+    LevelDbTransaction transaction(db_.get(), "TrackByteSizes");
+    transaction.Put(LevelDbByteSizeKey::Key(),
+                    LevelDbByteSizes::Calculate(
+                        db_.get(), LevelDbTransaction::DefaultReadOptions())
+                        .Encode());
+    transaction.Commit();
+  }
+
+  LevelDbByteSizes ReadByteSizes() {
+    std::string encoded;
+    Status status = db_->Get(LevelDbTransaction::DefaultReadOptions(),
+                             LevelDbByteSizeKey::Key(), &encoded);
+    EXPECT_TRUE(status.ok());
+    absl::optional<LevelDbByteSizes> sizes = LevelDbByteSizes::Decode(encoded);
+    EXPECT_TRUE(sizes.has_value());
+    return sizes.value_or(LevelDbByteSizes());
+  }
+
+  LevelDbByteSizes CalculateByteSizes() {
+    return LevelDbByteSizes::Calculate(
+        db_.get(), LevelDbTransaction::DefaultReadOptions());
+  }
+
+  std::unique_ptr<DB> db_;
+};
+
+TEST_F(LevelDbByteSizesTest, EncodeRoundTrips) {
+  LevelDbByteSizes sizes;
+  sizes.Add(LevelDbRemoteDocumentKey::Key(Key("coll/doc")), 1000);
+  sizes.Add(LevelDbTargetKey::Key(1), 20);
+  sizes.Add(LevelDbMutationKey::Key("user", 1), 300);
+
+  absl::optional<LevelDbByteSizes> decoded =
+      LevelDbByteSizes::Decode(sizes.Encode());
+  ASSERT_TRUE(decoded.has_value());
+  ASSERT_EQ(sizes, *decoded);
+  ASSERT_EQ(1000, decoded->bytes(LevelDbSubsystem::kDocuments));
+  ASSERT_EQ(20, decoded->bytes(LevelDbSubsystem::kTargets));
+  ASSERT_EQ(300, decoded->bytes(LevelDbSubsystem::kMutations));
+  ASSERT_EQ(1320, decoded->total_bytes());
+}
+
+TEST_F(LevelDbByteSizesTest, DecodeRejectsGarbage) {
+  ASSERT_FALSE(LevelDbByteSizes::Decode("").has_value());
+  ASSERT_FALSE(LevelDbByteSizes::Decode("garbage").has_value());
+}
+
+TEST_F(LevelDbByteSizesTest, ClassifiesKeysBySubsystem) {
+  ASSERT_EQ(LevelDbSubsystem::kDocuments,
+            SubsystemForKey(LevelDbRemoteDocumentKey::Key(Key("coll/doc"))));
+  ASSERT_EQ(LevelDbSubsystem::kTargets,
+            SubsystemForKey(LevelDbTargetKey::Key(1)));
+  ASSERT_EQ(LevelDbSubsystem::kMutations,
+            SubsystemForKey(LevelDbMutationKey::Key("user", 1)));
+  ASSERT_EQ(LevelDbSubsystem::kIndexes,
+            SubsystemForKey(LevelDbIndexConfigurationKey::Key(1, "coll")));
+  ASSERT_EQ(LevelDbSubsystem::kOther,
+            SubsystemForKey(LevelDbVersionKey::Key()));
+  ASSERT_EQ(LevelDbSubsystem::kOther, SubsystemForKey("not a key"));
+}
+
+TEST_F(LevelDbByteSizesTest, CommitsWithoutTrackingDoNotWriteSizes) {
+  LevelDbTransaction transaction(db_.get(), "Untracked");
+  transaction.Put(LevelDbTargetKey::Key(1), "target");
+  transaction.Commit();
+
+  std::string encoded;
+  Status status = db_->Get(LevelDbTransaction::DefaultReadOptions(),
+                           LevelDbByteSizeKey::Key(), &encoded);
+  ASSERT_TRUE(status.IsNotFound());
+}
+
+TEST_F(LevelDbByteSizesTest, CommitsMaintainRunningTotal) {
+  std::string doc_key = LevelDbRemoteDocumentKey::Key(Key("coll/doc"));
+  std::string target_key = LevelDbTargetKey::Key(1);
+  std::string mutation_key = LevelDbMutationKey::Key("user", 1);
+
+  {
+    LevelDbTransaction transaction(db_.get(), "Before tracking");
+    transaction.Put(doc_key, std::string(100, 'a'));
+    transaction.Commit();
+  }
+
+  TrackByteSizes();
+  ASSERT_EQ(CalculateByteSizes(), ReadByteSizes());
+
+  {
+    LevelDbTransaction transaction(db_.get(), "Insert");
+    transaction.Put(target_key, "target");
+    transaction.Put(mutation_key, std::string(50, 'm'));
+    transaction.Commit();
+  }
+  ASSERT_EQ(CalculateByteSizes(), ReadByteSizes());
+
+  {
+    LevelDbTransaction transaction(db_.get(), "Update and delete");
+    transaction.Put(doc_key, std::string(10, 'b'));
+    transaction.Delete(mutation_key);
+    transaction.Delete(LevelDbMutationKey::Key("user", 2));
+    transaction.Commit();
+  }
+  LevelDbByteSizes sizes = ReadByteSizes();
+  ASSERT_EQ(CalculateByteSizes(), sizes);
+  ASSERT_EQ(0, sizes.bytes(LevelDbSubsystem::kMutations));
+  ASSERT_EQ(static_cast<int64_t>(doc_key.size() + 10),
+            sizes.bytes(LevelDbSubsystem::kDocuments));
+}
+
+TEST(LevelDbPersistenceByteSizesTest, TracksSizeOfNewDatabase) {
+  std::unique_ptr<LevelDbPersistence> persistence =
+      LevelDbPersistenceForTesting();
+
+  persistence->Run("Write", [&] {
+    persistence->current_transaction()->Put(
+        LevelDbRemoteDocumentKey::Key(Key("coll/doc")), std::string(100, 'a'));
+  });
+
+  auto maybe_sizes = persistence->CalculateByteSizes();
+  ASSERT_OK(maybe_sizes.status());
+  LevelDbByteSizes sizes = maybe_sizes.ValueOrDie();
+  ASSERT_EQ(LevelDbByteSizes::Calculate(
+                persistence->ptr(), LevelDbTransaction::DefaultReadOptions()),
+            sizes);
+  ASSERT_GT(sizes.bytes(LevelDbSubsystem::kDocuments), 100);
+
+  auto maybe_size = persistence->CalculateByteSize();
+  ASSERT_OK(maybe_size.status());
+  ASSERT_EQ(sizes.total_bytes(), maybe_size.ValueOrDie());
+}
+
+TEST(LevelDbPersistenceByteSizesTest, ShrinksOnDeletesAndSurvivesRestarts) {
+  Path dir = LevelDbDir();
+  std::string kept_key = LevelDbRemoteDocumentKey::Key(Key("coll/kept"));
+  std::string deleted_key = LevelDbRemoteDocumentKey::Key(Key("coll/deleted"));
+
+  LevelDbByteSizes sizes;
+  {
+    auto persistence = LevelDbPersistenceForTesting(dir);
+    auto maybe_initial_sizes = persistence->CalculateByteSizes();
+    ASSERT_OK(maybe_initial_sizes.status());
+    int64_t initial_bytes =
+        maybe_initial_sizes.ValueOrDie().bytes(LevelDbSubsystem::kDocuments);
+
+    persistence->Run("Write", [&] {
+      persistence->current_transaction()->Put(kept_key, std::string(100, 'a'));
+      persistence->current_transaction()->Put(deleted_key,
+                                              std::string(100, 'b'));
+    });
+    persistence->Run("Delete", [&] {
+      persistence->current_transaction()->Delete(deleted_key);
+    });
+
+    auto maybe_sizes = persistence->CalculateByteSizes();
+    ASSERT_OK(maybe_sizes.status());
+    sizes = maybe_sizes.ValueOrDie();
+    ASSERT_EQ(initial_bytes + static_cast<int64_t>(kept_key.size() + 100),
+              sizes.bytes(LevelDbSubsystem::kDocuments));
+
+    persistence->Shutdown();
+  }
+
+  auto persistence = LevelDbPersistenceForTesting(dir);
+  auto maybe_sizes = persistence->CalculateByteSizes();
+  ASSERT_OK(maybe_sizes.status());
+  ASSERT_EQ(sizes, maybe_sizes.ValueOrDie());
+}
+
+}  // namespace
+}  // namespace local
+}  // namespace firestore
+}  // namespace firebase
@@ -0,0 +1,144 @@
+/*
+ * Copyright 2022 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <cstdint>
+#include <memory>
+#include <set>
+#include <string>
+
+#include "Firestore/core/src/credentials/user.h"
+#include "Firestore/core/src/local/leveldb_document_overlay_cache.h"
+#include "Firestore/core/src/local/leveldb_persistence.h"
+#include "Firestore/core/src/model/document_key.h"
+#include "Firestore/core/src/model/model_fwd.h"
+#include "Firestore/core/src/model/mutation.h"
+#include "Firestore/core/src/model/overlay.h"
+#include "Firestore/core/src/model/patch_mutation.h"
+#include "Firestore/core/src/model/resource_path.h"
+#include "Firestore/core/src/model/set_mutation.h"
+#include "Firestore/core/test/unit/local/persistence_testing.h"
+#include "Firestore/core/test/unit/testutil/testutil.h"
+#include "absl/strings/str_cat.h"
+#include "benchmark/benchmark.h"
+
+namespace firebase {
+namespace firestore {
+namespace local {
+namespace {
+
+using model::DocumentKey;
+using model::MutationByDocumentKeyMap;
+using model::OverlayByDocumentKeyMap;
+
+/**
+ * A LevelDB overlay cache holding one overlay for each of `overlay_count`
+ * documents in the "rooms" collection, saved across ten batches. Each document
+ * also has an overlay in a subcollection, so that the overlays of "rooms" are
+ * not all adjacent.
+ */
+class OverlayCacheFixture {
+ public:
+  explicit OverlayCacheFixture(int64_t overlay_count)
+      : persistence_(LevelDbPersistenceForTesting()),
+        cache_(persistence_->GetDocumentOverlayCache(
+            credentials::User::Unauthenticated())) {
+    persistence_->Run("Populate", [&] {
+      for (int batch_id = 1; batch_id <= 10; ++batch_id) {
+        MutationByDocumentKeyMap mutations;
+        for (int64_t i = batch_id - 1; i < overlay_count; i += 10) {
+          std::string path = absl::StrCat("rooms/", i);
+          keys_.insert(testutil::Key(path));
+          mutations.emplace(
+              testutil::Key(path),
+              testutil::PatchMutation(path, testutil::Map("id", i)));
+          std::string nested = absl::StrCat(path, "/messages/1");
+          mutations.emplace(
+              testutil::Key(nested),
+              testutil::SetMutation(nested, testutil::Map("id", i)));
+        }
+        cache_->SaveOverlays(batch_id, mutations);
+      }
+    });
+  }
+
+  LevelDbPersistence* persistence() {
+    return persistence_.get();
+  }
+
+  LevelDbDocumentOverlayCache* cache() {
+    return cache_;
+  }
+
+  const std::set<DocumentKey>& keys() const {
+    return keys_;
+  }
+
+ private:
+  std::unique_ptr<LevelDbPersistence> persistence_;
+  LevelDbDocumentOverlayCache* cache_ = nullptr;
+  std::set<DocumentKey> keys_;
+};
+
+/** Reads all overlays of a collection, as a query against it does. */
+void BM_GetOverlaysForCollection(benchmark::State& state) {
+  OverlayCacheFixture fixture(state.range(0));
+  model::ResourcePath collection = testutil::Resource("rooms");
+
+  for (auto _ : state) {
+    fixture.persistence()->Run("GetOverlays", [&] {
+      OverlayByDocumentKeyMap overlays =
+          fixture.cache()->GetOverlays(collection, -1);
+      benchmark::DoNotOptimize(overlays);
+    });
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_GetOverlaysForCollection)->Arg(100)->Arg(1000)->Arg(5000);
+
+/** Reads all overlays of a collection group. */
+void BM_GetOverlaysForCollectionGroup(benchmark::State& state) {
+  OverlayCacheFixture fixture(state.range(0));
+
+  for (auto _ : state) {
+    fixture.persistence()->Run("GetOverlays", [&] {
+      OverlayByDocumentKeyMap overlays = fixture.cache()->GetOverlays(
+          "rooms", -1, static_cast<size_t>(state.range(0)));
+      benchmark::DoNotOptimize(overlays);
+    });
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_GetOverlaysForCollectionGroup)->Arg(100)->Arg(1000)->Arg(5000);
+
+/** Reads the overlays of a set of documents, as `LocalDocumentsView` does. */
+void BM_GetOverlaysForKeys(benchmark::State& state) {
+  OverlayCacheFixture fixture(state.range(0));
+
+  for (auto _ : state) {
+    fixture.persistence()->Run("GetOverlays", [&] {
+      OverlayByDocumentKeyMap overlays;
+      fixture.cache()->GetOverlays(overlays, fixture.keys());
+      benchmark::DoNotOptimize(overlays);
+    });
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_GetOverlaysForKeys)->Arg(100)->Arg(1000)->Arg(5000);
+
+}  // namespace
+}  // namespace local
+}  // namespace firestore
+}  // namespace firebase
@@ -15,13 +15,22 @@
  */
 
 #include "Firestore/core/src/local/leveldb_index_manager.h"
+
+#include <set>
+#include <string>
+#include <utility>
+#include <vector>
+
 #include "Firestore/core/src/core/bound.h"
+#include "Firestore/core/src/local/leveldb_key.h"
 #include "Firestore/core/src/local/leveldb_persistence.h"
 #include "Firestore/core/src/model/field_index.h"
 #include "Firestore/core/test/unit/local/index_manager_test.h"
 #include "Firestore/core/test/unit/local/persistence_testing.h"
 #include "Firestore/core/test/unit/testutil/testutil.h"
 #include "absl/memory/memory.h"
+#include "absl/strings/match.h"
+#include "absl/strings/str_cat.h"
 #include "gtest/gtest.h"
 
 namespace firebase {
@@ -132,6 +141,20 @@ class LevelDbIndexManagerTest : public ::testing::Test {
         << "Query returned unexpected documents.";
   }
 
+  /** Returns the keys and values of all rows in the index entry table. */
+  std::vector<std::pair<std::string, std::string>> ReadIndexEntries() {
+    auto leveldb_persistence =
+        static_cast<LevelDbPersistence*>(persistence.get());
+    auto iter = leveldb_persistence->current_transaction()->NewIterator();
+    std::string prefix = LevelDbIndexEntryKey::KeyPrefix();
+    std::vector<std::pair<std::string, std::string>> entries;
+    for (iter->Seek(prefix);
+         iter->Valid() && absl::StartsWith(iter->key(), prefix); iter->Next()) {
+      entries.emplace_back(iter->key(), iter->value());
+    }
+    return entries;
+  }
+
   std::unique_ptr<Persistence> persistence;
   IndexManager* index_manager;
 };
@@ -824,6 +847,147 @@ TEST_F(LevelDbIndexManagerTest, LimitAppliesOrdering) {
   });
 }
 
+TEST_F(LevelDbIndexManagerTest, ScansDocumentsInQueryOrder) {
+  persistence->Run("TestScansDocumentsInQueryOrder", [&]() {
+    index_manager->Start();
+    index_manager->AddFieldIndex(
+        MakeFieldIndex("coll", "value", model::Segment::kAscending));
+    index_manager->AddFieldIndex(
+        MakeFieldIndex("coll", "value", model::Segment::kDescending));
+    AddDoc("coll/a", Map("value", 3));
+    AddDoc("coll/b", Map("value", 1));
+    AddDoc("coll/c", Map("value", 2));
+    AddDoc("coll/d", Map("value", 2));
+
+    auto scan = [&](const core::Query& query, size_t max_results) {
+      std::vector<std::string> keys;
+      bool scanned = index_manager->ScanDocumentsMatchingTarget(
+          query.ToTarget(), [&](const model::DocumentKey& key) {
+            keys.push_back(key.ToString());
+            return keys.size() < max_results;
+          });
+      EXPECT_TRUE(scanned);
+      return keys;
+    };
+
+    auto query = Query("coll").AddingOrderBy(OrderBy("value"));
+    EXPECT_EQ(scan(query, 10),
+              (std::vector<std::string>{"coll/b", "coll/c", "coll/d",
+                                        "coll/a"}));
+    EXPECT_EQ(scan(query, 2), (std::vector<std::string>{"coll/b", "coll/c"}));
+
+    query = Query("coll").AddingOrderBy(OrderBy("value", "desc"));
+    EXPECT_EQ(scan(query, 10),
+              (std::vector<std::string>{"coll/a", "coll/d", "coll/c",
+                                        "coll/b"}));
+
+    query = Query("coll")
+                .AddingFilter(Filter("value", ">=", 2))
+                .AddingOrderBy(OrderBy("value"));
+    EXPECT_EQ(scan(query, 10),
+              (std::vector<std::string>{"coll/c", "coll/d", "coll/a"}));
+
+    // Documents from several ranges are not returned in query order.
+    query = Query("coll")
+                .AddingFilter(Filter("value", "in", Array(1, 3)))
+                .AddingOrderBy(OrderBy("value"));
+    EXPECT_FALSE(index_manager->ScanDocumentsMatchingTarget(
+        query.ToTarget(), [](const model::DocumentKey&) { return true; }));
+  });
+}
+
+TEST_F(LevelDbIndexManagerTest, IntersectsSingleFieldIndexes) {
+  persistence->Run("TestIntersectsSingleFieldIndexes", [&]() {
+    index_manager->Start();
+    index_manager->AddFieldIndex(
+        MakeFieldIndex("coll", "a", model::Segment::kAscending));
+    index_manager->AddFieldIndex(
+        MakeFieldIndex("coll", "b", model::Segment::kAscending));
+    AddDoc("coll/val1", Map("a", 1, "b", 1));
+    AddDoc("coll/val2", Map("a", 1, "b", 2));
+    AddDoc("coll/val3", Map("a", 2, "b", 1));
+    AddDoc("coll/val4", Map("a", 2, "b", 2));
+
+    auto query = Query("coll")
+                     .AddingFilter(Filter("a", "==", 1))
+                     .AddingFilter(Filter("b", "==", 2));
+    EXPECT_EQ(index_manager->GetIndexType(query.ToTarget()),
+              IndexManager::IndexType::PARTIAL);
+    VerifyResults(query, {"coll/val2"});
+
+    query = Query("coll")
+                .AddingFilter(Filter("a", "==", 2))
+                .AddingFilter(Filter("b", ">", 1));
+    VerifyResults(query, {"coll/val4"});
+  });
+}
+
+TEST_F(LevelDbIndexManagerTest, IndexIntersectionMatchesCollectionScan) {
+  persistence->Run("TestIndexIntersectionMatchesCollectionScan", [&]() {
+    index_manager->Start();
+    index_manager->AddFieldIndex(
+        MakeFieldIndex("coll", "a", model::Segment::kAscending));
+    index_manager->AddFieldIndex(
+        MakeFieldIndex("coll", "b", model::Segment::kDescending));
+    index_manager->AddFieldIndex(
+        MakeFieldIndex("coll", "c", model::Segment::kAscending));
+    index_manager->AddFieldIndex(
+        MakeFieldIndex("coll", "tags", model::Segment::kContains));
+
+    std::vector<model::MutableDocument> docs;
+    for (int i = 0; i < 200; ++i) {
+      docs.push_back(Doc(absl::StrCat("coll/doc", i), 1,
+                         Map("a", i % 3, "b", i % 5, "c", i % 7, "tags",
+                             Array(i % 2, 2 + i % 4))));
+    }
+    AddDocs(docs);
+
+    auto q = Query("coll");
+    std::vector<core::Query> queries = {
+        q.AddingFilter(Filter("a", "==", 1)).AddingFilter(Filter("b", "==", 2)),
+        q.AddingFilter(Filter("a", "==", 0))
+            .AddingFilter(Filter("b", "==", 4))
+            .AddingFilter(Filter("c", "==", 6)),
+        q.AddingFilter(Filter("a", "==", 2)).AddingFilter(Filter("c", ">", 3)),
+        q.AddingFilter(Filter("a", "in", Array(0, 2)))
+            .AddingFilter(Filter("b", "!=", 1)),
+        q.AddingFilter(Filter("b", "<=", 1))
+            .AddingFilter(Filter("c", "not-in", Array(0, 1, 2))),
+        q.AddingFilter(Filter("tags", "array-contains", 1))
+            .AddingFilter(Filter("a", "==", 1)),
+        q.AddingFilter(Filter("tags", "array-contains-any", Array(2, 5)))
+            .AddingFilter(Filter("c", "==", 3))
+            .AddingFilter(Filter("b", "==", 3)),
+        q.AddingFilter(Filter("a", "==", 1))
+            .AddingFilter(Filter("b", "==", 9))};
+
+    for (const core::Query& query : queries) {
+      SCOPED_TRACE(query.CanonicalId());
+
+      std::set<model::DocumentKey> expected;
+      for (const auto& doc : docs) {
+        if (query.Matches(doc)) expected.insert(doc.key());
+      }
+
+      absl::optional<std::vector<model::DocumentKey>> results =
+          index_manager->GetDocumentsMatchingTarget(query.ToTarget());
+      ASSERT_TRUE(results.has_value());
+      std::set<model::DocumentKey> actual(results->begin(), results->end());
+      EXPECT_EQ(actual.size(), results->size()) << "Duplicate results.";
+
+      // Indexes that only cover some of the filters may return extra documents,
+      // which the query engine filters out, but never miss any.
+      std::set<model::DocumentKey> actual_matches;
+      for (const auto& doc : docs) {
+        if (actual.count(doc.key()) != 0 && query.Matches(doc)) {
+          actual_matches.insert(doc.key());
+        }
+      }
+      EXPECT_EQ(expected, actual_matches);
+    }
+  });
+}
+
 TEST_F(LevelDbIndexManagerTest, IndexEntriesAreUpdated) {
   persistence->Run("TestIndexEntriesAreUpdated", [&]() {
     index_manager->Start();
@@ -1311,6 +1475,39 @@ TEST_F(LevelDbIndexManagerTest, CanChangeUser) {
   });
 }
 
+TEST_F(LevelDbIndexManagerTest, IndexesManyDocumentsLikeSingleDocuments) {
+  persistence->Run("IndexesManyDocumentsLikeSingleDocuments", [&]() {
+    index_manager->Start();
+    index_manager->AddFieldIndex(
+        MakeFieldIndex("coll", "count", model::Segment::kAscending));
+    index_manager->AddFieldIndex(
+        MakeFieldIndex("coll", "values", model::Segment::kContains));
+
+    // Enough documents for their entries to be computed concurrently when
+    // they are indexed together. Every tenth has none of the indexed fields.
+    std::vector<model::MutableDocument> docs;
+    for (int i = 0; i < 100; ++i) {
+      std::string key = absl::StrCat("coll/doc", i);
+      if (i % 10 == 0) {
+        docs.push_back(Doc(key, 1, Map("other", i)));
+      } else {
+        docs.push_back(Doc(key, 1, Map("count", i % 7, "values",
+                                       Array(i, absl::StrCat("value", i)))));
+      }
+    }
+
+    for (const auto& doc : docs) {
+      AddDocs({doc});
+    }
+    auto entries = ReadIndexEntries();
+    EXPECT_EQ(entries.size(), 90u * 3);
+
+    // Entries that differ from the existing ones would replace them.
+    AddDocs(docs);
+    EXPECT_EQ(ReadIndexEntries(), entries);
+  });
+}
+
 }  // namespace local
 }  // namespace firestore
 }  // namespace firebase
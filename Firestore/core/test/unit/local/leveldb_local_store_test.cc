@@ -87,6 +87,10 @@ INSTANTIATE_TEST_SUITE_P(LevelDbLocalStoreTest,
                          LocalStoreTest,
                          ::testing::Values(Factory));
 
+INSTANTIATE_TEST_SUITE_P(LevelDbLocalStoreTest,
+                         LocalStoreQueryResultCacheTest,
+                         ::testing::Values(Factory));
+
 class LevelDbLocalStoreTest : public LocalStoreTestBase {
  public:
   LevelDbLocalStoreTest() : LocalStoreTestBase(Factory()) {
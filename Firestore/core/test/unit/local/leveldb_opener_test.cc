@@ -219,6 +219,38 @@ class MockFilesystem : public Filesystem {
   MOCK_METHOD1(AppDataDir, StatusOr<Path>(absl::string_view));
 };
 
+TEST(LevelDbOpenerTest, CanReopenWithDifferentParams) {
+  TestTempDir root_dir;
+  OtherFilesystem fs(root_dir.path());
+  DatabaseInfo db_info = FakeDatabaseInfo();
+
+  LevelDbParams tuned;
+  tuned.block_cache_size_bytes = 1024 * 1024;
+  tuned.bloom_filter_bits_per_key = 10;
+  tuned.write_buffer_size_bytes = 64 * 1024;
+  tuned.max_open_files = 100;
+  tuned.verify_checksums = false;
+
+  {
+    LevelDbOpener opener(db_info, &fs);
+    auto created = opener.Create(LruParams::Disabled(), tuned);
+    ASSERT_OK(created.status());
+    auto persistence = std::move(created).ValueOrDie();
+    EXPECT_FALSE(persistence->read_options().verify_checksums);
+    persistence->Shutdown();
+  }
+
+  {
+    // Tables written with a bloom filter remain readable without one.
+    LevelDbOpener opener(db_info, &fs);
+    auto created = opener.Create(LruParams::Disabled());
+    ASSERT_OK(created.status());
+    auto persistence = std::move(created).ValueOrDie();
+    EXPECT_TRUE(persistence->read_options().verify_checksums);
+    persistence->Shutdown();
+  }
+}
+
 TEST(LevelDbOpenerTest, HandlesAppDataDirFailure) {
   NiceMock<MockFilesystem> fs;
 
@@ -19,6 +19,7 @@
 #include "Firestore/core/src/core/query.h"
 #include "Firestore/core/src/local/leveldb_persistence.h"
 #include "Firestore/core/src/local/query_engine.h"
+#include "Firestore/core/src/model/delete_mutation.h"
 #include "Firestore/core/src/model/document_set.h"
 #include "Firestore/core/src/model/field_index.h"
 #include "Firestore/core/src/model/patch_mutation.h"
@@ -36,6 +37,7 @@ namespace {
 using model::DocumentMap;
 using model::DocumentSet;
 using model::SnapshotVersion;
+using testutil::DeleteMutation;
 using testutil::Doc;
 using testutil::DocSet;
 using testutil::Filter;
@@ -161,6 +163,81 @@ TEST_F(LevelDbQueryEngineTest, RefillsIndexedLimitQueries) {
   });
 }
 
+TEST_F(LevelDbQueryEngineTest, ReadsIndexedLimitQueriesInIndexOrder) {
+  persistence_->Run("ReadsIndexedLimitQueriesInIndexOrder", [&] {
+    mutation_queue_->Start();
+    index_manager_->Start();
+
+    auto doc1 = Doc("coll/1", 1, Map("a", 1));
+    auto doc2 = Doc("coll/2", 1, Map("a", 2));
+    auto doc3 = Doc("coll/3", 1, Map("a", 3));
+    auto doc4 = Doc("coll/4", 1, Map("a", 4));
+    AddDocuments({doc1, doc2, doc3, doc4});
+
+    index_manager_->AddFieldIndex(
+        MakeFieldIndex("coll", "a", model::Segment::kAscending));
+
+    DocumentMap doc_map;
+    doc_map = doc_map.insert(doc1.key(), doc1);
+    doc_map = doc_map.insert(doc2.key(), doc2);
+    doc_map = doc_map.insert(doc3.key(), doc3);
+    doc_map = doc_map.insert(doc4.key(), doc4);
+    index_manager_->UpdateIndexEntries(doc_map);
+    index_manager_->UpdateCollectionGroup(
+        "coll", model::IndexOffset::FromDocument(doc4));
+
+    // Neither change is reflected in the index.
+    AddMutation(DeleteMutation("coll/2"));
+    auto doc5 = Doc("coll/5", 2, Map("a", 0));
+    AddDocuments({doc5});
+
+    core::Query query =
+        Query("coll").AddingOrderBy(OrderBy("a")).WithLimitToFirst(2);
+    DocumentSet docs = ExpectOptimizedCollectionScan(
+        [&] { return RunQuery(query, SnapshotVersion::None()); });
+    EXPECT_EQ(docs, DocSet(query.Comparator(), {doc5, doc1}));
+
+    query = Query("coll").AddingOrderBy(OrderBy("a")).WithLimitToFirst(3);
+    docs = ExpectOptimizedCollectionScan(
+        [&] { return RunQuery(query, SnapshotVersion::None()); });
+    EXPECT_EQ(docs, DocSet(query.Comparator(), {doc5, doc1, doc3}));
+  });
+}
+
+TEST_F(LevelDbQueryEngineTest, DoesNotSettleDocumentsReadAfterIndexOffset) {
+  persistence_->Run("DoesNotSettleDocumentsReadAfterIndexOffset", [&] {
+    mutation_queue_->Start();
+    index_manager_->Start();
+
+    auto doc1 = Doc("coll/1", 1, Map("a", 1));
+    auto doc2 = Doc("coll/2", 1, Map("a", 2));
+    auto doc3 = Doc("coll/3", 1, Map("a", 3));
+    AddDocuments({doc1, doc2, doc3});
+
+    index_manager_->AddFieldIndex(
+        MakeFieldIndex("coll", "a", model::Segment::kAscending));
+
+    DocumentMap doc_map;
+    doc_map = doc_map.insert(doc1.key(), doc1);
+    doc_map = doc_map.insert(doc2.key(), doc2);
+    doc_map = doc_map.insert(doc3.key(), doc3);
+    index_manager_->UpdateIndexEntries(doc_map);
+    index_manager_->UpdateCollectionGroup(
+        "coll", model::IndexOffset::FromDocument(doc3));
+
+    // The update keeps the document's version, which is no newer than the
+    // index offset, but is read after it, so its index entry is stale.
+    auto updated_doc1 = Doc("coll/1", 1, Map("a", 10));
+    AddDocumentWithEventVersion(Version(2), {updated_doc1});
+
+    core::Query query =
+        Query("coll").AddingOrderBy(OrderBy("a")).WithLimitToFirst(2);
+    DocumentSet docs = ExpectOptimizedCollectionScan(
+        [&] { return RunQuery(query, SnapshotVersion::None()); });
+    EXPECT_EQ(docs, DocSet(query.Comparator(), {doc2, doc3}));
+  });
+}
+
 }  // namespace local
 }  // namespace firestore
 }  // namespace firebase
@@ -0,0 +1,253 @@
+/*
+ * Copyright 2022 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <atomic>
+#include <cstdint>
+#include <cstdlib>
+#include <memory>
+#include <string>
+
+#include "Firestore/Protos/nanopb/firestore/local/maybe_document.nanopb.h"
+#include "Firestore/core/src/core/query.h"
+#include "Firestore/core/src/credentials/user.h"
+#include "Firestore/core/src/local/leveldb_persistence.h"
+#include "Firestore/core/src/local/local_serializer.h"
+#include "Firestore/core/src/local/remote_document_cache.h"
+#include "Firestore/core/src/model/field_index.h"
+#include "Firestore/core/src/model/field_path.h"
+#include "Firestore/core/src/model/mutable_document.h"
+#include "Firestore/core/src/model/resource_path.h"
+#include "Firestore/core/src/nanopb/byte_string.h"
+#include "Firestore/core/src/nanopb/message.h"
+#include "Firestore/core/src/nanopb/reader.h"
+#include "Firestore/core/src/nanopb/writer.h"
+#include "Firestore/core/test/unit/local/persistence_testing.h"
+#include "Firestore/core/test/unit/testutil/testutil.h"
+#include "absl/strings/str_cat.h"
+#include "benchmark/benchmark.h"
+
+namespace {
+
+// Counts calls to malloc, calloc and realloc, which both Nanopb and
+// `operator new` go through. Counting relies on glibc, so on other platforms
+// the count stays at zero.
+std::atomic<int64_t> allocation_count{0};
+
+}  // namespace
+
+#if defined(__GLIBC__)
+extern "C" {
+
+void* __libc_malloc(size_t size);
+void* __libc_calloc(size_t count, size_t size);
+void* __libc_realloc(void* ptr, size_t size);
+
+void* malloc(size_t size) {
+  allocation_count.fetch_add(1, std::memory_order_relaxed);
+  return __libc_malloc(size);
+}
+
+void* calloc(size_t count, size_t size) {
+  allocation_count.fetch_add(1, std::memory_order_relaxed);
+  return __libc_calloc(count, size);
+}
+
+void* realloc(void* ptr, size_t size) {
+  allocation_count.fetch_add(1, std::memory_order_relaxed);
+  return __libc_realloc(ptr, size);
+}
+
+}  // extern "C"
+#endif  // defined(__GLIBC__)
+
+namespace firebase {
+namespace firestore {
+namespace local {
+namespace {
+
+using model::MutableDocument;
+using model::MutableDocumentMap;
+using nanopb::ByteString;
+using nanopb::ByteStringWriter;
+using nanopb::Message;
+using nanopb::StringReader;
+using testutil::Array;
+using testutil::Doc;
+using testutil::Map;
+using testutil::Version;
+
+constexpr int kFieldsPerDocument = 20;
+
+/** Returns a document of about 1KB with strings, numbers and nested maps. */
+MutableDocument MakeDocument(int64_t id) {
+  MutableDocument document = Doc(absl::StrCat("rooms/", id), 1);
+  for (int i = 0; i < kFieldsPerDocument; ++i) {
+    document.data().Set(
+        testutil::Field(absl::StrCat("field", i)),
+        Map("name", absl::StrCat("name of field ", i), "count", i, "tags",
+            Array("a", "b", "c")));
+  }
+  return document;
+}
+
+/** Reports the allocations since `start` per processed document. */
+void ReportAllocations(benchmark::State& state,
+                       int64_t start,
+                       int64_t documents_per_iteration) {
+  int64_t allocations = allocation_count.load() - start;
+  state.counters["allocs_per_doc"] = benchmark::Counter(
+      static_cast<double>(allocations) /
+      static_cast<double>(state.iterations() * documents_per_iteration));
+}
+
+/**
+ * Scans a collection of `state.range(0)` documents, as executing a query
+ * against the remote document cache does.
+ */
+void BM_LevelDbRemoteDocumentCacheGetAll(benchmark::State& state) {
+  int64_t document_count = state.range(0);
+  std::unique_ptr<LevelDbPersistence> persistence =
+      LevelDbPersistenceForTesting();
+  RemoteDocumentCache* cache = persistence->remote_document_cache();
+  cache->SetIndexManager(
+      persistence->GetIndexManager(credentials::User::Unauthenticated()));
+
+  persistence->Run("Populate", [&] {
+    for (int64_t i = 0; i < document_count; ++i) {
+      cache->Add(MakeDocument(i), Version(1));
+    }
+  });
+
+  model::ResourcePath path = testutil::Resource("rooms");
+  int64_t start = allocation_count.load();
+  for (auto _ : state) {
+    persistence->Run("GetAll", [&] {
+      MutableDocumentMap documents =
+          cache->GetAll(path, model::IndexOffset::None());
+      benchmark::DoNotOptimize(documents);
+    });
+  }
+  ReportAllocations(state, start, document_count);
+}
+BENCHMARK(BM_LevelDbRemoteDocumentCacheGetAll)->Arg(100)->Arg(1000);
+
+/**
+ * Scans a collection of `state.range(0)` documents and matches them against a
+ * query that only one document satisfies, as `LocalDocumentsView` does.
+ */
+void BM_LevelDbRemoteDocumentCacheQuery(benchmark::State& state) {
+  int64_t document_count = state.range(0);
+  std::unique_ptr<LevelDbPersistence> persistence =
+      LevelDbPersistenceForTesting();
+  RemoteDocumentCache* cache = persistence->remote_document_cache();
+  cache->SetIndexManager(
+      persistence->GetIndexManager(credentials::User::Unauthenticated()));
+
+  persistence->Run("Populate", [&] {
+    for (int64_t i = 0; i < document_count; ++i) {
+      MutableDocument document = MakeDocument(i);
+      document.data().Set(testutil::Field("id"), testutil::Value(i));
+      cache->Add(document, Version(1));
+    }
+  });
+
+  core::Query query =
+      testutil::Query("rooms").AddingFilter(testutil::Filter("id", "==", 42));
+  int64_t start = allocation_count.load();
+  for (auto _ : state) {
+    persistence->Run("Query", [&] {
+      MutableDocumentMap documents =
+          cache->GetAll(query.path(), model::IndexOffset::None());
+      int matches = 0;
+      for (const auto& entry : documents) {
+        if (query.Matches(entry.second)) ++matches;
+      }
+      benchmark::DoNotOptimize(matches);
+    });
+  }
+  ReportAllocations(state, start, document_count);
+}
+BENCHMARK(BM_LevelDbRemoteDocumentCacheQuery)->Arg(100)->Arg(1000);
+
+ByteString EncodeDocument(const LocalSerializer& serializer) {
+  Message<firestore_client_MaybeDocument> message =
+      serializer.EncodeMaybeDocument(MakeDocument(1));
+  ByteStringWriter writer;
+  writer.Write(message.fields(), message.get());
+  return writer.Release();
+}
+
+/** Decodes a document with `pb_decode`, as the cache used to. */
+void BM_DecodeMaybeDocumentNanopb(benchmark::State& state) {
+  LocalSerializer serializer = MakeLocalSerializer();
+  ByteString encoded = EncodeDocument(serializer);
+
+  int64_t start = allocation_count.load();
+  for (auto _ : state) {
+    StringReader reader{encoded};
+    auto message = Message<firestore_client_MaybeDocument>::TryParse(&reader);
+    MutableDocument document =
+        serializer.DecodeMaybeDocument(&reader, *message);
+    benchmark::DoNotOptimize(document);
+  }
+  ReportAllocations(state, start, 1);
+}
+BENCHMARK(BM_DecodeMaybeDocumentNanopb);
+
+/**
+ * Decodes a document lazily, as the cache does, and reads one field, as
+ * matching it against a query with a single filter does.
+ */
+void BM_DecodeMaybeDocumentLazily(benchmark::State& state) {
+  LocalSerializer serializer = MakeLocalSerializer();
+  ByteString encoded = EncodeDocument(serializer);
+  absl::string_view bytes(reinterpret_cast<const char*>(encoded.data()),
+                          encoded.size());
+  model::FieldPath path = testutil::Field("field7.count");
+
+  int64_t start = allocation_count.load();
+  for (auto _ : state) {
+    StringReader reader;
+    MutableDocument document =
+        serializer.DecodeMaybeDocumentLazily(&reader, bytes);
+    benchmark::DoNotOptimize(document.field(path));
+  }
+  ReportAllocations(state, start, 1);
+}
+BENCHMARK(BM_DecodeMaybeDocumentLazily);
+
+/** Decodes a document lazily and then reads all of its fields. */
+void BM_DecodeMaybeDocumentLazilyAndMaterialize(benchmark::State& state) {
+  LocalSerializer serializer = MakeLocalSerializer();
+  ByteString encoded = EncodeDocument(serializer);
+  absl::string_view bytes(reinterpret_cast<const char*>(encoded.data()),
+                          encoded.size());
+
+  int64_t start = allocation_count.load();
+  for (auto _ : state) {
+    StringReader reader;
+    MutableDocument document =
+        serializer.DecodeMaybeDocumentLazily(&reader, bytes);
+    benchmark::DoNotOptimize(document.value());
+  }
+  ReportAllocations(state, start, 1);
+}
+BENCHMARK(BM_DecodeMaybeDocumentLazilyAndMaterialize);
+
+}  // namespace
+}  // namespace local
+}  // namespace firestore
+}  // namespace firebase
@@ -237,6 +237,36 @@ TEST_F(LevelDbTransactionTest, CanIterateAndDelete) {
   }
 }
 
+TEST_F(LevelDbTransactionTest, ViewsSurviveChangesToCurrentMutation) {
+  Status status = db_->Put(LevelDbTransaction::DefaultWriteOptions(), "key_1",
+                           "value_1");
+  ASSERT_TRUE(status.ok());
+
+  LevelDbTransaction transaction(db_.get(),
+                                 "ViewsSurviveChangesToCurrentMutation");
+  transaction.Put("key_0", "value_0");
+
+  auto it = transaction.NewIterator();
+  it->Seek("key_0");
+  ASSERT_TRUE(it->Valid());
+  absl::string_view key = it->key();
+  absl::string_view value = it->value();
+
+  // Overwriting and then deleting the pending entry must not affect the views
+  // returned for it.
+  transaction.Put("key_0", "changed");
+  transaction.Delete("key_0");
+  ASSERT_EQ("key_0", key);
+  ASSERT_EQ("value_0", value);
+
+  it->Next();
+  ASSERT_TRUE(it->Valid());
+  ASSERT_EQ("key_1", it->key());
+  ASSERT_EQ("value_1", it->value());
+  it->Next();
+  ASSERT_FALSE(it->Valid());
+}
+
 TEST_F(LevelDbTransactionTest, CanIterateFromDeletionToCommitted) {
   // Write keys key_0 and key_1
   for (int i = 0; i < 2; ++i) {
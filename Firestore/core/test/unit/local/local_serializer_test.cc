@@ -458,6 +458,52 @@ TEST_F(LocalSerializerTest, EncodesUnknownDocumentAsMaybeDocument) {
   ExpectRoundTrip(unknown_doc, maybe_doc_proto);
 }
 
+TEST_F(LocalSerializerTest, DecodesMaybeDocumentsLazily) {
+  MutableDocument doc =
+      Doc("some/path", /*version=*/42,
+          Map("a", Map("b", 1, "c", "d"), "e", true, "f", Map()))
+          .SetHasCommittedMutations();
+  ByteString bytes = EncodeMaybeDocument(&serializer, doc);
+  absl::string_view encoded(reinterpret_cast<const char*>(bytes.data()),
+                            bytes.size());
+
+  StringReader reader;
+  MutableDocument actual =
+      serializer.DecodeMaybeDocumentLazily(&reader, encoded);
+  EXPECT_OK(reader.status());
+  EXPECT_EQ(actual.key(), doc.key());
+  EXPECT_EQ(actual.version(), doc.version());
+  EXPECT_TRUE(actual.has_committed_mutations());
+
+  EXPECT_EQ(actual.field(Field("a.b")), *Value(1));
+  EXPECT_EQ(actual.field(Field("e")), *Value(true));
+  EXPECT_EQ(actual.field(Field("a.x")), absl::nullopt);
+  EXPECT_EQ(actual.field(Field("x")), absl::nullopt);
+
+  MutableDocument copy = actual.Clone();
+  copy.data().Set(Field("a.b"), Value(2));
+  EXPECT_EQ(copy.field(Field("a.b")), *Value(2));
+  EXPECT_EQ(actual.field(Field("a.b")), *Value(1));
+
+  EXPECT_EQ(actual, doc);
+}
+
+TEST_F(LocalSerializerTest, DecodesMissingDocumentsLazily) {
+  for (const MutableDocument& doc :
+       {DeletedDoc("some/path", /*version=*/42),
+        UnknownDoc("some/path", /*version=*/42)}) {
+    ByteString bytes = EncodeMaybeDocument(&serializer, doc);
+    absl::string_view encoded(reinterpret_cast<const char*>(bytes.data()),
+                              bytes.size());
+
+    StringReader reader;
+    MutableDocument actual =
+        serializer.DecodeMaybeDocumentLazily(&reader, encoded);
+    EXPECT_OK(reader.status());
+    EXPECT_EQ(actual, doc);
+  }
+}
+
 TEST_F(LocalSerializerTest, EncodesTargetData) {
   core::Query query = Query("room");
   TargetId target_id = 42;
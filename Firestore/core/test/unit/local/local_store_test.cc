@@ -28,6 +28,7 @@
 #include "Firestore/core/src/local/local_write_result.h"
 #include "Firestore/core/src/local/persistence.h"
 #include "Firestore/core/src/local/query_result.h"
+#include "Firestore/core/src/local/query_result_cache.h"
 #include "Firestore/core/src/local/target_data.h"
 #include "Firestore/core/src/model/delete_mutation.h"
 #include "Firestore/core/src/model/document.h"
@@ -169,11 +170,14 @@ LocalViewChanges TestViewChanges(TargetId target_id,
 }  // namespace
 
 LocalStoreTestBase::LocalStoreTestBase(
-    std::unique_ptr<LocalStoreTestHelper>&& test_helper)
+    std::unique_ptr<LocalStoreTestHelper>&& test_helper,
+    size_t max_cached_query_results)
     : test_helper_(std::move(test_helper)),
       persistence_(test_helper_->MakePersistence()),
-      local_store_(
-          persistence_.get(), &query_engine_, User::Unauthenticated()) {
+      local_store_(persistence_.get(),
+                   &query_engine_,
+                   User::Unauthenticated(),
+                   max_cached_query_results) {
   local_store_.Start();
 }
 
@@ -1364,6 +1368,20 @@ TEST_P(LocalStoreTest, HandlesSavingBundledDocuments) {
   FSTAssertQueryDocumentMapping(2, expected_keys);
 }
 
+TEST_P(LocalStoreTest, ReloadingBundleReplacesItsDocumentKeys) {
+  local_store_.ResetBundleTarget("");
+  // A large bundle is applied in several chunks.
+  ApplyBundledDocuments({Doc("foo/bar", 1, Map("sum", 1))});
+  ApplyBundledDocuments({Doc("foo/baz", 1, Map("sum", 2))});
+  FSTAssertQueryDocumentMapping(
+      2, DocumentKeySet({Key("foo/bar"), Key("foo/baz")}));
+
+  // Loading the bundle again with fewer documents no longer pins the others.
+  local_store_.ResetBundleTarget("");
+  ApplyBundledDocuments({Doc("foo/bar", 2, Map("sum", 3))});
+  FSTAssertQueryDocumentMapping(2, DocumentKeySet({Key("foo/bar")}));
+}
+
 TEST_P(LocalStoreTest, HandlesSavingBundledDocumentsWithNewerExistingVersion) {
   core::Query query = Query("foo");
   AllocateQuery(query);
@@ -1663,6 +1681,87 @@ TEST_P(LocalStoreTest, MultipleFieldPatchesOnLocalDocs) {
       Doc("foo/bar", 0, Map("likes", 1, "stars", 2)).SetHasLocalMutations());
 }
 
+LocalStoreQueryResultCacheTest::LocalStoreQueryResultCacheTest()
+    : LocalStoreTestBase(GetParam()(), /* max_cached_query_results= */ 10) {
+}
+
+TEST_P(LocalStoreQueryResultCacheTest, ReturnsCachedResultsWhileUnchanged) {
+  core::Query query = Query("foo");
+  TargetId target_id = AllocateQuery(query);
+  ApplyRemoteEvent(
+      AddedRemoteEvent(Doc("foo/bar", 10, Map("it", "base")), {target_id}));
+
+  ExecuteQuery(query);
+  FSTAssertQueryReturned("foo/bar");
+  EXPECT_EQ(local_store_.query_result_cache().misses(), 1);
+  EXPECT_EQ(local_store_.query_result_cache().hits(), 0);
+
+  ExecuteQuery(query);
+  FSTAssertQueryReturned("foo/bar");
+  EXPECT_EQ(local_store_.query_result_cache().misses(), 1);
+  EXPECT_EQ(local_store_.query_result_cache().hits(), 1);
+}
+
+TEST_P(LocalStoreQueryResultCacheTest, RemoteEventsInvalidateResults) {
+  core::Query foo_query = Query("foo");
+  core::Query baz_query = Query("baz");
+  TargetId foo_target_id = AllocateQuery(foo_query);
+  TargetId baz_target_id = AllocateQuery(baz_query);
+  ApplyRemoteEvent(AddedRemoteEvent(Doc("foo/bar", 10, Map("it", "base")),
+                                    {foo_target_id}));
+  ApplyRemoteEvent(AddedRemoteEvent(Doc("baz/qux", 10, Map("it", "base")),
+                                    {baz_target_id}));
+  ExecuteQuery(foo_query);
+  ExecuteQuery(baz_query);
+  EXPECT_EQ(local_store_.query_result_cache().misses(), 2);
+
+  ApplyRemoteEvent(UpdateRemoteEvent(Doc("foo/bar", 11, Map("it", "changed")),
+                                     {foo_target_id}, {}));
+
+  // Results of queries that cannot contain the document survive the event.
+  ExecuteQuery(baz_query);
+  FSTAssertQueryReturned("baz/qux");
+  EXPECT_EQ(local_store_.query_result_cache().hits(), 1);
+
+  QueryResult query_result = ExecuteQuery(foo_query);
+  EXPECT_EQ(local_store_.query_result_cache().hits(), 1);
+  EXPECT_EQ(local_store_.query_result_cache().misses(), 3);
+  ASSERT_EQ(DocMapToVector(query_result.documents()),
+            Vector(Document{Doc("foo/bar", 11, Map("it", "changed"))}));
+}
+
+TEST_P(LocalStoreQueryResultCacheTest, LocalWritesInvalidateResults) {
+  core::Query query = Query("foo");
+  TargetId target_id = AllocateQuery(query);
+  ApplyRemoteEvent(
+      AddedRemoteEvent(Doc("foo/bar", 10, Map("it", "base")), {target_id}));
+  ExecuteQuery(query);
+
+  WriteMutation(testutil::SetMutation("foo/bar", Map("it", "written")));
+
+  QueryResult query_result = ExecuteQuery(query);
+  EXPECT_EQ(local_store_.query_result_cache().hits(), 0);
+  EXPECT_EQ(local_store_.query_result_cache().misses(), 2);
+  ASSERT_EQ(DocMapToVector(query_result.documents()),
+            Vector(Document{Doc("foo/bar", 10, Map("it", "written"))
+                                .SetHasLocalMutations()}));
+}
+
+TEST_P(LocalStoreQueryResultCacheTest, BundleLoadsInvalidateResults) {
+  core::Query query = Query("foo");
+  ApplyBundledDocuments({Doc("foo/bar", 1, Map("sum", 1))});
+  ExecuteQuery(query);
+  FSTAssertQueryReturned("foo/bar");
+
+  ApplyBundledDocuments({Doc("foo/bar", 2, Map("sum", 2))});
+
+  QueryResult query_result = ExecuteQuery(query);
+  EXPECT_EQ(local_store_.query_result_cache().hits(), 0);
+  EXPECT_EQ(local_store_.query_result_cache().misses(), 2);
+  ASSERT_EQ(DocMapToVector(query_result.documents()),
+            Vector(Document{Doc("foo/bar", 2, Map("sum", 2))}));
+}
+
 }  // namespace local
 }  // namespace firestore
 }  // namespace firebase
@@ -62,7 +62,8 @@ using FactoryFunc = std::unique_ptr<LocalStoreTestHelper> (*)();
 class LocalStoreTestBase : public testing::Test {
  protected:
   explicit LocalStoreTestBase(
-      std::unique_ptr<LocalStoreTestHelper>&& test_helper);
+      std::unique_ptr<LocalStoreTestHelper>&& test_helper,
+      size_t max_cached_query_results = 0);
 
   bool IsGcEager() const {
     return test_helper_->IsGcEager();
@@ -128,6 +129,18 @@ class LocalStoreTest : public LocalStoreTestBase,
   LocalStoreTest();
 };
 
+/**
+ * Tests of the LocalStore with its cache of `ExecuteQuery` results enabled.
+ * Instantiated for each configuration of the LocalStore like LocalStoreTest.
+ */
+class LocalStoreQueryResultCacheTest
+    : public LocalStoreTestBase,
+      public testing::WithParamInterface<FactoryFunc> {
+ public:
+  // `GetParam()` must return a factory function.
+  LocalStoreQueryResultCacheTest();
+};
+
 /** Asserts that the last target ID is the given number. */
 #define FSTAssertTargetID(target_id)       \
   do {                                     \
@@ -47,6 +47,10 @@ INSTANTIATE_TEST_SUITE_P(MemoryLocalStoreTest,
                          LocalStoreTest,
                          ::testing::Values(Factory));
 
+INSTANTIATE_TEST_SUITE_P(MemoryLocalStoreTest,
+                         LocalStoreQueryResultCacheTest,
+                         ::testing::Values(Factory));
+
 }  // namespace local
 }  // namespace firestore
 }  // namespace firebase
@@ -64,9 +64,11 @@ Path LevelDbDir() {
 }
 
 std::unique_ptr<LevelDbPersistence> LevelDbPersistenceForTesting(
-    Path dir, LruParams lru_params) {
-  auto created =
-      LevelDbPersistence::Create(dir, MakeLocalSerializer(), lru_params);
+    Path dir,
+    LruParams lru_params,
+    const LevelDbParams& leveldb_params = LevelDbParams()) {
+  auto created = LevelDbPersistence::Create(dir, MakeLocalSerializer(),
+                                            lru_params, leveldb_params);
   if (!created.ok()) {
     util::ThrowIllegalState("Failed to open leveldb in dir %s: %s",
                             dir.ToUtf8String(), created.status().ToString());
@@ -83,6 +85,12 @@ std::unique_ptr<LevelDbPersistence> LevelDbPersistenceForTesting(
   return LevelDbPersistenceForTesting(LevelDbDir(), lru_params);
 }
 
+std::unique_ptr<LevelDbPersistence> LevelDbPersistenceForTesting(
+    const LevelDbParams& leveldb_params) {
+  return LevelDbPersistenceForTesting(LevelDbDir(), LruParams::Default(),
+                                      leveldb_params);
+}
+
 std::unique_ptr<LevelDbPersistence> LevelDbPersistenceForTesting() {
   return LevelDbPersistenceForTesting(LevelDbDir());
 }
@@ -32,6 +32,7 @@ class Path;
 namespace local {
 
 class LevelDbPersistence;
+struct LevelDbParams;
 struct LruParams;
 class MemoryPersistence;
 
@@ -75,6 +76,15 @@ std::unique_ptr<LevelDbPersistence> LevelDbPersistenceForTesting(
 std::unique_ptr<LevelDbPersistence> LevelDbPersistenceForTesting(
     LruParams lru_params);
 
+/**
+ * Creates and starts a new LevelDbPersistence instance for testing, destroying
+ * any previous contents if they existed.
+ *
+ * Opens the LevelDB database with the provided params.
+ */
+std::unique_ptr<LevelDbPersistence> LevelDbPersistenceForTesting(
+    const LevelDbParams& leveldb_params);
+
 /** Creates and starts a new MemoryPersistence instance for testing. */
 std::unique_ptr<MemoryPersistence> MemoryPersistenceWithEagerGcForTesting();
 
@@ -0,0 +1,154 @@
+/*
+ * Copyright 2022 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Firestore/core/src/local/query_result_cache.h"
+
+#include "Firestore/core/src/core/query.h"
+#include "Firestore/core/src/model/document.h"
+#include "Firestore/core/test/unit/testutil/testutil.h"
+#include "gtest/gtest.h"
+
+namespace firebase {
+namespace firestore {
+namespace local {
+namespace {
+
+using core::Target;
+using model::Document;
+using model::DocumentKeySet;
+using model::DocumentMap;
+using model::SnapshotVersion;
+using testutil::CollectionGroupQuery;
+using testutil::Doc;
+using testutil::Key;
+using testutil::Map;
+using testutil::Query;
+using testutil::Version;
+
+const SnapshotVersion kVersion = Version(10);
+const model::BatchId kBatchId = 3;
+
+QueryResult ResultWith(const char* path) {
+  DocumentMap documents;
+  documents = documents.insert(Key(path), Document(Doc(path, 1, Map())));
+  return QueryResult(documents, DocumentKeySet{Key(path)});
+}
+
+TEST(QueryResultCacheTest, DisabledCacheStoresNothing) {
+  QueryResultCache cache;
+  Target target = Query("coll").ToTarget();
+  cache.Put(target, kVersion, kBatchId, ResultWith("coll/a"));
+
+  EXPECT_FALSE(cache.enabled());
+  EXPECT_FALSE(cache.Get(target, kVersion, kBatchId));
+  EXPECT_EQ(cache.size(), 0u);
+  EXPECT_EQ(cache.misses(), 0);
+}
+
+TEST(QueryResultCacheTest, ReturnsResultAtSameStamp) {
+  QueryResultCache cache(10);
+  Target target = Query("coll").ToTarget();
+  cache.Put(target, kVersion, kBatchId, ResultWith("coll/a"));
+
+  absl::optional<QueryResult> result = cache.Get(target, kVersion, kBatchId);
+  ASSERT_TRUE(result);
+  EXPECT_EQ(result->documents().size(), 1u);
+  EXPECT_TRUE(result->remote_keys().contains(Key("coll/a")));
+  EXPECT_EQ(cache.hits(), 1);
+
+  EXPECT_FALSE(cache.Get(Query("other").ToTarget(), kVersion, kBatchId));
+  EXPECT_EQ(cache.misses(), 1);
+}
+
+TEST(QueryResultCacheTest, MissesAtDifferentStamp) {
+  QueryResultCache cache(10);
+  Target target = Query("coll").ToTarget();
+  cache.Put(target, kVersion, kBatchId, ResultWith("coll/a"));
+
+  EXPECT_FALSE(cache.Get(target, Version(11), kBatchId));
+  EXPECT_FALSE(cache.Get(target, kVersion, kBatchId));
+  EXPECT_EQ(cache.size(), 0u);
+  EXPECT_EQ(cache.misses(), 2);
+}
+
+TEST(QueryResultCacheTest, AdvancingKeepsResults) {
+  QueryResultCache cache(10);
+  Target target = Query("coll").ToTarget();
+  cache.Put(target, kVersion, kBatchId, ResultWith("coll/a"));
+
+  cache.AdvanceTo(Version(11), kBatchId + 1);
+  EXPECT_TRUE(cache.Get(target, Version(11), kBatchId + 1));
+}
+
+TEST(QueryResultCacheTest, InvalidatesQueriesThatMayContainChangedDocuments) {
+  QueryResultCache cache(10);
+  Target collection = Query("coll").ToTarget();
+  Target subcollection = Query("coll/a/sub").ToTarget();
+  Target document = Query("coll/b").ToTarget();
+  Target group = CollectionGroupQuery("sub").ToTarget();
+  for (const Target& target : {collection, subcollection, document, group}) {
+    cache.Put(target, kVersion, kBatchId, QueryResult());
+  }
+
+  cache.InvalidateDocuments(DocumentKeySet{Key("coll/c")});
+  EXPECT_FALSE(cache.Get(collection, kVersion, kBatchId));
+  EXPECT_TRUE(cache.Get(subcollection, kVersion, kBatchId));
+  EXPECT_TRUE(cache.Get(document, kVersion, kBatchId));
+  EXPECT_TRUE(cache.Get(group, kVersion, kBatchId));
+
+  cache.InvalidateDocuments(DocumentKeySet{Key("other/x/sub/y")});
+  EXPECT_TRUE(cache.Get(subcollection, kVersion, kBatchId));
+  EXPECT_FALSE(cache.Get(group, kVersion, kBatchId));
+
+  cache.InvalidateDocuments(DocumentKeySet{Key("coll/b")});
+  EXPECT_FALSE(cache.Get(document, kVersion, kBatchId));
+  EXPECT_TRUE(cache.Get(subcollection, kVersion, kBatchId));
+}
+
+TEST(QueryResultCacheTest, InvalidatesSingleTarget) {
+  QueryResultCache cache(10);
+  Target target = Query("coll").ToTarget();
+  Target other = Query("other").ToTarget();
+  cache.Put(target, kVersion, kBatchId, QueryResult());
+  cache.Put(other, kVersion, kBatchId, QueryResult());
+
+  cache.InvalidateTarget(target);
+  EXPECT_FALSE(cache.Get(target, kVersion, kBatchId));
+  EXPECT_TRUE(cache.Get(other, kVersion, kBatchId));
+}
+
+TEST(QueryResultCacheTest, EvictsLeastRecentlyUsedResult) {
+  QueryResultCache cache(2);
+  Target a = Query("a").ToTarget();
+  Target b = Query("b").ToTarget();
+  Target c = Query("c").ToTarget();
+  cache.Put(a, kVersion, kBatchId, QueryResult());
+  cache.Put(b, kVersion, kBatchId, QueryResult());
+
+  // Using `a` makes `b` the least recently used result.
+  EXPECT_TRUE(cache.Get(a, kVersion, kBatchId));
+  cache.Put(c, kVersion, kBatchId, QueryResult());
+
+  EXPECT_EQ(cache.size(), 2u);
+  EXPECT_TRUE(cache.Get(a, kVersion, kBatchId));
+  EXPECT_FALSE(cache.Get(b, kVersion, kBatchId));
+  EXPECT_TRUE(cache.Get(c, kVersion, kBatchId));
+}
+
+}  // namespace
+}  // namespace local
+}  // namespace firestore
+}  // namespace firebase
@@ -17,6 +17,7 @@
 #include "Firestore/core/test/unit/local/remote_document_cache_test.h"
 
 #include <memory>
+#include <string>
 #include <vector>
 
 #include "Firestore/core/src/core/query.h"
@@ -47,6 +48,7 @@ using model::DocumentMap;
 using model::MutableDocument;
 using model::MutableDocumentMap;
 using model::ObjectValue;
+using model::ResourcePath;
 using model::SnapshotVersion;
 using nanopb::Message;
 
@@ -246,6 +248,44 @@ TEST_P(RemoteDocumentCacheTest, DocumentsMatchingUsesReadTimeNotUpdateTime) {
       });
 }
 
+TEST_P(RemoteDocumentCacheTest, DocumentsMatchingSeveralCollections) {
+  persistence_->Run("test_documents_matching_several_collections", [&] {
+    SetTestDocument("a/1/c/1", /* updateTime= */ 1, /* readTime= */ 11);
+    SetTestDocument("a/1/c/2", /* updateTime= */ 2, /* readTime= */ 12);
+    SetTestDocument("a/2/c/1", /* updateTime= */ 3, /* readTime= */ 13);
+    SetTestDocument("a/3/c/1", /* updateTime= */ 4, /* readTime= */ 14);
+
+    std::vector<ResourcePath> collections = {
+        ResourcePath::FromString("a/1/c"), ResourcePath::FromString("a/2/c"),
+        ResourcePath::FromString("a/4/c")};
+    std::vector<MutableDocumentMap> results = cache_->GetAll(
+        collections, model::IndexOffset::CreateSuccessor(Version(11)));
+    ASSERT_EQ(results.size(), 3u);
+    EXPECT_THAT(results[0], HasExactlyDocs(std::vector<MutableDocument>{
+                                Doc("a/1/c/2", 2, Map("a", 1, "b", 2))}));
+    EXPECT_THAT(results[1], HasExactlyDocs(std::vector<MutableDocument>{
+                                Doc("a/2/c/1", 3, Map("a", 1, "b", 2))}));
+    EXPECT_TRUE(results[2].empty());
+  });
+}
+
+TEST_P(RemoteDocumentCacheTest, DocumentsMatchingCollectionGroupWithLimit) {
+  persistence_->Run("test_documents_matching_collection_group_with_limit", [&] {
+    for (const char* path :
+         {"a/1/c/1", "a/1/c/2", "a/2/c/1", "a/2/c/2", "a/3/c/1"}) {
+      SetTestDocument(path);
+    }
+
+    MutableDocumentMap results =
+        cache_->GetAll(std::string("c"), model::IndexOffset::None(), 3);
+    EXPECT_EQ(results.size(), 3u);
+
+    results =
+        cache_->GetAll(std::string("c"), model::IndexOffset::None(), 10);
+    EXPECT_EQ(results.size(), 5u);
+  });
+}
+
 TEST_P(RemoteDocumentCacheTest, DoesNotApplyDocumentModificationsToCache) {
   // This test verifies that the MemoryMutationCache returns copies of all
   // data to ensure that the documents in the cache cannot be modified.
@@ -0,0 +1,240 @@
+/*
+ * Copyright 2022 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstdlib>
+#include <memory>
+#include <new>
+#include <string>
+#include <vector>
+
+#include "Firestore/core/src/local/leveldb_key.h"
+#include "Firestore/core/src/model/database_id.h"
+#include "Firestore/core/src/model/document_key.h"
+#include "Firestore/core/src/model/document_key_set.h"
+#include "Firestore/core/src/model/resource_path.h"
+#include "Firestore/core/src/remote/serializer.h"
+#include "absl/strings/str_cat.h"
+#include "benchmark/benchmark.h"
+
+namespace {
+
+// Tracks the bytes currently allocated through the global `operator new`, so
+// that the benchmarks can report the memory held by a set of keys.
+std::atomic<int64_t> allocated_bytes{0};
+
+// Enough room in front of each allocation to remember its size while keeping
+// the returned pointer suitably aligned.
+constexpr size_t kHeaderSize = alignof(std::max_align_t);
+
+}  // namespace
+
+void* operator new(size_t size) {
+  auto* memory = static_cast<char*>(std::malloc(size + kHeaderSize));
+  if (!memory) throw std::bad_alloc();
+  *reinterpret_cast<size_t*>(memory) = size;
+  allocated_bytes += static_cast<int64_t>(size);
+  return memory + kHeaderSize;
+}
+
+void operator delete(void* ptr) noexcept {
+  if (!ptr) return;
+  // Round-trip through an integer so that the compiler doesn't mistake the
+  // header for memory returned by `operator new`.
+  auto* memory =
+      reinterpret_cast<char*>(reinterpret_cast<uintptr_t>(ptr) - kHeaderSize);
+  allocated_bytes -= static_cast<int64_t>(*reinterpret_cast<size_t*>(memory));
+  std::free(memory);
+}
+
+void operator delete(void* ptr, size_t) noexcept {
+  operator delete(ptr);
+}
+
+namespace firebase {
+namespace firestore {
+namespace model {
+namespace {
+
+/**
+ * Returns `count` document paths shaped like real ones: a few collections
+ * with subcollections, and a random-looking ID for every document.
+ */
+std::vector<ResourcePath> MakePaths(int64_t count) {
+  std::vector<ResourcePath> paths;
+  paths.reserve(count);
+  for (int64_t i = 0; i < count; ++i) {
+    paths.push_back(ResourcePath{"rooms", absl::StrCat("room", i % 100),
+                                 "messages",
+                                 absl::StrCat("Xq7bK2pLm9", i * 7919)});
+  }
+  return paths;
+}
+
+/** Reports the heap bytes held by each of `count` keys built by `build`. */
+template <typename Build>
+void ReportMemory(benchmark::State& state, Build build) {
+  int64_t count = state.range(0);
+  std::vector<ResourcePath> paths = MakePaths(count);
+
+  for (auto _ : state) {
+    int64_t before = allocated_bytes.load();
+    auto keys = build(paths);
+    int64_t held = allocated_bytes.load() - before;
+    benchmark::DoNotOptimize(keys);
+    state.counters["bytes_per_key"] =
+        static_cast<double>(held) / static_cast<double>(count);
+  }
+  state.SetItemsProcessed(state.iterations() * count);
+}
+
+/** The keys on their own. */
+void BM_DocumentKeyMemory(benchmark::State& state) {
+  ReportMemory(state, [](const std::vector<ResourcePath>& paths) {
+    return std::vector<DocumentKey>(paths.begin(), paths.end());
+  });
+}
+BENCHMARK(BM_DocumentKeyMemory)->Unit(benchmark::kMillisecond)->Arg(1000000);
+
+/**
+ * The same keys in the previous representation of `DocumentKey`, a shared
+ * `ResourcePath`, for comparison.
+ */
+void BM_SharedPathMemory(benchmark::State& state) {
+  ReportMemory(state, [](const std::vector<ResourcePath>& paths) {
+    std::vector<std::shared_ptr<const ResourcePath>> keys;
+    keys.reserve(paths.size());
+    for (const ResourcePath& path : paths) {
+      keys.push_back(std::make_shared<const ResourcePath>(path));
+    }
+    return keys;
+  });
+}
+BENCHMARK(BM_SharedPathMemory)->Unit(benchmark::kMillisecond)->Arg(1000000);
+
+/** The keys in a `DocumentKeySet`, including the nodes of the set. */
+void BM_DocumentKeySetMemory(benchmark::State& state) {
+  ReportMemory(state, [](const std::vector<ResourcePath>& paths) {
+    DocumentKeySet keys;
+    for (const ResourcePath& path : paths) {
+      keys = keys.insert(DocumentKey{path});
+    }
+    return keys;
+  });
+}
+BENCHMARK(BM_DocumentKeySetMemory)
+    ->Unit(benchmark::kMillisecond)
+    ->Arg(1000000);
+
+/** Sorts keys that only differ in their last few segments. */
+void BM_DocumentKeySort(benchmark::State& state) {
+  std::vector<ResourcePath> paths = MakePaths(state.range(0));
+  std::vector<DocumentKey> keys(paths.begin(), paths.end());
+
+  for (auto _ : state) {
+    state.PauseTiming();
+    std::vector<DocumentKey> sorted = keys;
+    state.ResumeTiming();
+    std::sort(sorted.begin(), sorted.end());
+    benchmark::DoNotOptimize(sorted);
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_DocumentKeySort)->Unit(benchmark::kMillisecond)->Arg(1000000);
+
+/** Looks up every key of a 1M key set in it. */
+void BM_DocumentKeySetContains(benchmark::State& state) {
+  std::vector<ResourcePath> paths = MakePaths(state.range(0));
+  std::vector<DocumentKey> keys(paths.begin(), paths.end());
+  DocumentKeySet set;
+  for (const DocumentKey& key : keys) {
+    set = set.insert(key);
+  }
+
+  for (auto _ : state) {
+    for (const DocumentKey& key : keys) {
+      benchmark::DoNotOptimize(set.contains(key));
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_DocumentKeySetContains)
+    ->Unit(benchmark::kMillisecond)
+    ->Arg(1000000);
+
+/** Checks which keys are immediate children of a collection. */
+void BM_DocumentKeyHasPrefix(benchmark::State& state) {
+  std::vector<ResourcePath> paths = MakePaths(state.range(0));
+  std::vector<DocumentKey> keys(paths.begin(), paths.end());
+  ResourcePath collection{"rooms", "room42", "messages"};
+
+  for (auto _ : state) {
+    int64_t matches = 0;
+    for (const DocumentKey& key : keys) {
+      if (key.path_size() == collection.size() + 1 &&
+          key.HasPrefix(collection)) {
+        ++matches;
+      }
+    }
+    benchmark::DoNotOptimize(matches);
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_DocumentKeyHasPrefix)
+    ->Unit(benchmark::kMillisecond)
+    ->Arg(1000000);
+
+/** Encodes each key as the key of its row in the remote document cache. */
+void BM_DocumentKeyEncodeLevelDbKey(benchmark::State& state) {
+  std::vector<ResourcePath> paths = MakePaths(state.range(0));
+  std::vector<DocumentKey> keys(paths.begin(), paths.end());
+
+  for (auto _ : state) {
+    for (const DocumentKey& key : keys) {
+      benchmark::DoNotOptimize(local::LevelDbRemoteDocumentKey::Key(key));
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_DocumentKeyEncodeLevelDbKey)
+    ->Unit(benchmark::kMillisecond)
+    ->Arg(1000000);
+
+/** Encodes each key as the resource name sent to the backend. */
+void BM_DocumentKeyEncodeResourceName(benchmark::State& state) {
+  std::vector<ResourcePath> paths = MakePaths(state.range(0));
+  std::vector<DocumentKey> keys(paths.begin(), paths.end());
+  remote::Serializer serializer(DatabaseId("p", "d"));
+
+  for (auto _ : state) {
+    for (const DocumentKey& key : keys) {
+      pb_bytes_array_t* name = serializer.EncodeKey(key);
+      benchmark::DoNotOptimize(name);
+      std::free(name);
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_DocumentKeyEncodeResourceName)
+    ->Unit(benchmark::kMillisecond)
+    ->Arg(1000000);
+
+}  // namespace
+}  // namespace model
+}  // namespace firestore
+}  // namespace firebase
@@ -162,6 +162,71 @@ TEST(DocumentKey, Comparator) {
   EXPECT_EQ(comparator.Compare(abcd, xyzw), util::ComparisonResult::Ascending);
 }
 
+TEST(DocumentKey, ComparesSegmentWise) {
+  // Segment boundaries take precedence over the bytes in them, so "a/b" sorts
+  // before "a-/b" even though '/' sorts after '-'.
+  EXPECT_TRUE(Key("a/b") < Key("a-/b"));
+  EXPECT_TRUE(Key("a/b") < Key("ab/b"));
+  EXPECT_TRUE(Key("a/b") < Key("a/bb"));
+  EXPECT_TRUE(Key("a/b/c/d") < Key("a/bb"));
+
+  DocumentKey with_nul{ResourcePath{"a", std::string("b\0c", 3)}};
+  EXPECT_TRUE(Key("a/b") < with_nul);
+  EXPECT_TRUE(with_nul < Key("a/bc"));
+  EXPECT_EQ(with_nul.path()[1], std::string("b\0c", 3));
+
+  for (const char* lhs : {"a/b", "a/b/c/d", "a-/b", "b/a"}) {
+    for (const char* rhs : {"a/b", "a/b/c/d", "a-/b", "b/a"}) {
+      EXPECT_EQ(Key(lhs).CompareTo(Key(rhs)),
+                Key(lhs).path().CompareTo(Key(rhs).path()));
+    }
+  }
+}
+
+TEST(DocumentKey, HashMatchesPath) {
+  DocumentKey key = Key("rooms/firestore/messages/1");
+  EXPECT_EQ(key.Hash(), key.path().Hash());
+  EXPECT_EQ(DocumentKeyHash()(key), key.Hash());
+  EXPECT_EQ(DocumentKey().Hash(), ResourcePath().Hash());
+}
+
+TEST(DocumentKey, PathSize) {
+  EXPECT_EQ(DocumentKey().path_size(), 0u);
+  EXPECT_EQ(Key("a/b").path_size(), 2u);
+  EXPECT_EQ(Key("a/b/c/d").path_size(), 4u);
+}
+
+TEST(DocumentKey, SegmentsMatchPath) {
+  DocumentKey key = Key("rooms/firestore/messages/1");
+  ResourcePath path = key.path();
+  ASSERT_EQ(key.path_size(), path.size());
+  for (size_t i = 0; i < path.size(); ++i) {
+    EXPECT_EQ(key.segment(i), path[i]);
+  }
+  EXPECT_EQ(key.ToString(), path.CanonicalString());
+  EXPECT_EQ(DocumentKey().ToString(), "");
+}
+
+TEST(DocumentKey, HasPrefix) {
+  DocumentKey key = Key("a/b/c/d");
+  EXPECT_TRUE(key.HasPrefix(ResourcePath{}));
+  EXPECT_TRUE(key.HasPrefix(ResourcePath{"a"}));
+  EXPECT_TRUE(key.HasPrefix(ResourcePath{"a", "b", "c"}));
+  EXPECT_TRUE(key.HasPrefix(ResourcePath{"a", "b", "c", "d"}));
+  EXPECT_FALSE(key.HasPrefix(ResourcePath{"a", "b", "c", "d", "e"}));
+  EXPECT_FALSE(key.HasPrefix(ResourcePath{"a", "bc"}));
+  EXPECT_FALSE(key.HasPrefix(ResourcePath{"b"}));
+  EXPECT_FALSE(DocumentKey().HasPrefix(ResourcePath{"a"}));
+}
+
+TEST(DocumentKey, CollectionGroup) {
+  EXPECT_EQ(Key("a/b/c/d").GetCollectionGroup(), "c");
+  EXPECT_TRUE(Key("a/b/c/d").HasCollectionGroup("c"));
+  EXPECT_FALSE(Key("a/b/c/d").HasCollectionGroup("a"));
+  EXPECT_FALSE(DocumentKey().GetCollectionGroup());
+  EXPECT_FALSE(DocumentKey().HasCollectionGroup(""));
+}
+
 }  // namespace model
 }  // namespace firestore
 }  // namespace firebase
@@ -0,0 +1,126 @@
+/*
+ * Copyright 2022 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "Firestore/core/include/firebase/firestore/timestamp.h"
+#include "Firestore/core/src/model/field_mask.h"
+#include "Firestore/core/src/model/mutable_document.h"
+#include "Firestore/core/src/model/object_value.h"
+#include "Firestore/core/src/model/patch_mutation.h"
+#include "Firestore/core/src/model/value_util.h"
+#include "Firestore/core/test/unit/testutil/testutil.h"
+#include "absl/strings/str_cat.h"
+#include "benchmark/benchmark.h"
+
+namespace firebase {
+namespace firestore {
+namespace model {
+namespace {
+
+using testutil::Field;
+using testutil::Map;
+using testutil::Value;
+
+/**
+ * Returns a document with `sections` nested maps of `fields` fields each. Each
+ * field holds a 100 byte string, so 20 sections of 100 fields are ~200KB.
+ *
+ * The document is backed by a single Protobuf, like a decoded document.
+ */
+ObjectValue MakeDocument(int64_t sections, int64_t fields) {
+  ObjectValue builder;
+  std::string payload(100, 'x');
+  for (int64_t i = 0; i < sections; ++i) {
+    for (int64_t j = 0; j < fields; ++j) {
+      builder.Set(Field(absl::StrCat("section", i, ".field", j)),
+                  Value(payload));
+    }
+  }
+  return ObjectValue{DeepClone(builder.Get())};
+}
+
+void ApplySizes(benchmark::internal::Benchmark* benchmark) {
+  benchmark->ArgNames({"sections", "fields"})
+      ->Args({1, 100})
+      ->Args({20, 100})
+      ->Args({100, 100});
+}
+
+/** Copies a document, as `MutableDocument::Clone` and mutations do. */
+void BM_ObjectValueCopy(benchmark::State& state) {
+  ObjectValue document = MakeDocument(state.range(0), state.range(1));
+
+  for (auto _ : state) {
+    ObjectValue copy{document};
+    benchmark::DoNotOptimize(copy);
+  }
+}
+BENCHMARK(BM_ObjectValueCopy)->Apply(ApplySizes);
+
+/** Copies a document and sets a single nested field in the copy. */
+void BM_ObjectValueCopyAndSet(benchmark::State& state) {
+  ObjectValue document = MakeDocument(state.range(0), state.range(1));
+  FieldPath path = Field("section0.field42");
+
+  for (auto _ : state) {
+    ObjectValue copy{document};
+    copy.Set(path, Value("updated"));
+    benchmark::DoNotOptimize(copy);
+  }
+}
+BENCHMARK(BM_ObjectValueCopyAndSet)->Apply(ApplySizes);
+
+/**
+ * The same as `BM_ObjectValueCopyAndSet`, but deep-cloning the document first,
+ * which is what copying an `ObjectValue` used to cost.
+ */
+void BM_ObjectValueDeepCloneAndSet(benchmark::State& state) {
+  ObjectValue document = MakeDocument(state.range(0), state.range(1));
+  FieldPath path = Field("section0.field42");
+
+  for (auto _ : state) {
+    ObjectValue copy{DeepClone(document.Get())};
+    copy.Set(path, Value("updated"));
+    benchmark::DoNotOptimize(copy);
+  }
+}
+BENCHMARK(BM_ObjectValueDeepCloneAndSet)->Apply(ApplySizes);
+
+/** Applies a one-field patch to a clone of a document, as overlays do. */
+void BM_PatchMutationApplyToLocalView(benchmark::State& state) {
+  ObjectValue data = MakeDocument(state.range(0), state.range(1));
+  MutableDocument document =
+      testutil::Doc("rooms/eros", 1, DeepClone(data.Get()));
+  PatchMutation mutation = testutil::PatchMutation(
+      "rooms/eros", Map("section0", Map("field42", "updated")),
+      {Field("section0.field42")});
+  Timestamp now = Timestamp::Now();
+
+  for (auto _ : state) {
+    MutableDocument copy = document.Clone();
+    mutation.ApplyToLocalView(copy, FieldMask(), now);
+    benchmark::DoNotOptimize(copy);
+  }
+}
+BENCHMARK(BM_PatchMutationApplyToLocalView)->Apply(ApplySizes);
+
+}  // namespace
+}  // namespace model
+}  // namespace firestore
+}  // namespace firebase
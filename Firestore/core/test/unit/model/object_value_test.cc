@@ -16,9 +16,16 @@
 
 #include "Firestore/core/src/model/object_value.h"
 
+#include <cstdlib>
+#include <string>
+
 #include "Firestore/core/src/model/value_util.h"
+#include "Firestore/core/src/nanopb/message.h"
+#include "Firestore/core/src/nanopb/nanopb_util.h"
+#include "Firestore/core/src/nanopb/writer.h"
 #include "Firestore/core/src/remote/serializer.h"
 #include "Firestore/core/test/unit/testutil/testutil.h"
+#include "absl/memory/memory.h"
 #include "gtest/gtest.h"
 
 namespace firebase {
@@ -31,6 +38,7 @@ const char kBarString[] = "bar";
 namespace {
 
 using absl::nullopt;
+using nanopb::Message;
 using testutil::DbId;
 using testutil::Field;
 using testutil::Map;
@@ -42,6 +50,23 @@ class ObjectValueTest : public ::testing::Test {
   remote::Serializer serializer{DbId()};
 };
 
+/** Encodes a `google_firestore_v1_Document` with the single field `key`. */
+std::string EncodeDocumentField(const std::string& key,
+                                Message<google_firestore_v1_Value> value) {
+  google_firestore_v1_Document_FieldsEntry entry{};
+  entry.key = nanopb::MakeBytesArray(key);
+  entry.value = *value;
+
+  google_firestore_v1_Document document{};
+  document.fields_count = 1;
+  document.fields = &entry;
+
+  nanopb::StringWriter writer;
+  writer.Write(google_firestore_v1_Document_fields, &document);
+  free(entry.key);
+  return writer.Release();
+}
+
 TEST_F(ObjectValueTest, ExtractsFields) {
   ObjectValue value = WrapObject("foo", Map("a", 1, "b", true, "c", "string"));
 
@@ -335,6 +360,52 @@ TEST_F(ObjectValueTest, DoesNotRequireSortedInserts) {
   EXPECT_EQ(*Value(2), *object_value.Get(Field("nested.nested.c")));
 }
 
+TEST_F(ObjectValueTest, KeepsTheLastOfRepeatedEncodedFields) {
+  // Concatenated documents have the fields of both, so "a" is repeated.
+  std::string document = EncodeDocumentField("a", Value("first")) +
+                         EncodeDocumentField("b", Value(1)) +
+                         EncodeDocumentField("a", Value("last"));
+
+  ObjectValue lazy = ObjectValue::FromEncodedDocument(document);
+  EXPECT_EQ(*Value("last"), *lazy.Get(Field("a")));
+  EXPECT_EQ(nullopt, lazy.Get(Field("c")));
+
+  ObjectValue full = ObjectValue::FromEncodedDocument(document);
+  EXPECT_EQ(FieldMask({Field("a"), Field("b")}), full.ToFieldMask());
+  EXPECT_EQ(*Value("last"), *full.Get(Field("a")));
+  EXPECT_EQ(WrapObject("a", "last", "b", 1), full);
+}
+
+TEST_F(ObjectValueTest, ModifyingCopiesDoesNotAffectTheOriginal) {
+  ObjectValue original =
+      WrapObject("a", Map("b", kFooString, "c", kFooString), "d", kFooString);
+  ObjectValue copy{original};
+  copy.Set(Field("a.b"), Value(kBarString));
+  copy.Delete(Field("d"));
+
+  ObjectValue second_copy{copy};
+  second_copy.Set(Field("a.c"), Value(kBarString));
+
+  EXPECT_EQ(WrapObject("a", Map("b", kFooString, "c", kFooString), "d",
+                       kFooString),
+            original);
+  EXPECT_EQ(WrapObject("a", Map("b", kBarString, "c", kFooString)), copy);
+  EXPECT_EQ(WrapObject("a", Map("b", kBarString, "c", kBarString)),
+            second_copy);
+}
+
+TEST_F(ObjectValueTest, CopiesOutliveTheOriginal) {
+  auto original = absl::make_unique<ObjectValue>(
+      WrapObject("a", Map("b", kFooString), "c", kFooString));
+  ObjectValue copy{*original};
+  copy.Set(Field("a.d"), Value(kBarString));
+  original.reset();
+
+  EXPECT_EQ(WrapObject("a", Map("b", kFooString, "d", kBarString), "c",
+                       kFooString),
+            copy);
+}
+
 }  // namespace
 
 }  // namespace model
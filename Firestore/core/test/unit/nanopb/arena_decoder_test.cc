@@ -0,0 +1,304 @@
+/*
+ * Copyright 2022 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Firestore/core/src/nanopb/arena_decoder.h"
+
+#include <cstdint>
+#include <string>
+
+#include "Firestore/Protos/nanopb/firestore/local/maybe_document.nanopb.h"
+#include "Firestore/core/include/firebase/firestore/geo_point.h"
+#include "Firestore/core/include/firebase/firestore/timestamp.h"
+#include "Firestore/core/src/local/local_serializer.h"
+#include "Firestore/core/src/model/database_id.h"
+#include "Firestore/core/src/model/mutable_document.h"
+#include "Firestore/core/src/nanopb/arena.h"
+#include "Firestore/core/src/nanopb/byte_string.h"
+#include "Firestore/core/src/nanopb/message.h"
+#include "Firestore/core/src/nanopb/nanopb_util.h"
+#include "Firestore/core/src/nanopb/reader.h"
+#include "Firestore/core/src/nanopb/writer.h"
+#include "Firestore/core/src/remote/serializer.h"
+#include "Firestore/core/src/util/read_context.h"
+#include "Firestore/core/test/unit/testutil/testutil.h"
+#include "gtest/gtest.h"
+
+namespace firebase {
+namespace firestore {
+namespace nanopb {
+namespace {
+
+using model::DatabaseId;
+using model::MutableDocument;
+using testutil::Array;
+using testutil::BlobValue;
+using testutil::Doc;
+using testutil::Map;
+using testutil::Value;
+
+class ArenaDecoderTest : public testing::Test {
+ public:
+  ArenaDecoderTest()
+      : remote_serializer_(DatabaseId("p", "d")),
+        serializer_(remote_serializer_) {
+  }
+
+  ByteString Encode(const MutableDocument& document) const {
+    Message<firestore_client_MaybeDocument> message =
+        serializer_.EncodeMaybeDocument(document);
+    ByteStringWriter writer;
+    writer.Write(message.fields(), message.get());
+    return writer.Release();
+  }
+
+  /**
+   * Decodes `bytes` with both Nanopb and `ArenaDecoder`, and verifies that
+   * both succeed or fail alike and produce the same proto. `ArenaDecoder`
+   * decodes the fields of a document separately, so they are compared one by
+   * one.
+   */
+  void ExpectDecodesLikeNanopb(absl::string_view bytes) {
+    StringReader reader{bytes};
+    auto expected = Message<firestore_client_MaybeDocument>::TryParse(&reader);
+
+    Arena arena;
+    util::ReadContext context;
+    ArenaDecoder decoder(&context, &arena);
+    absl::string_view encoded_document;
+    firestore_client_MaybeDocument actual =
+        decoder.DecodeMaybeDocumentWithoutFields(bytes, &encoded_document);
+    google_firestore_v1_MapValue fields{};
+    if (actual.which_document_type ==
+        firestore_client_MaybeDocument_document_tag) {
+      fields = decoder.DecodeDocumentFields(encoded_document);
+    }
+
+    ASSERT_EQ(reader.ok(), context.ok());
+    if (!context.ok()) return;
+
+    ASSERT_EQ(expected->which_document_type, actual.which_document_type);
+    if (actual.which_document_type !=
+        firestore_client_MaybeDocument_document_tag) {
+      EXPECT_EQ(expected->ToString(), actual.ToString());
+      return;
+    }
+
+    google_firestore_v1_Document& expected_document = expected->document;
+    ASSERT_EQ(fields.fields_count, expected_document.fields_count);
+    for (pb_size_t i = 0; i != fields.fields_count; ++i) {
+      EXPECT_EQ(MakeStringView(fields.fields[i].key),
+                MakeStringView(expected_document.fields[i].key));
+      EXPECT_EQ(fields.fields[i].value.ToString(),
+                expected_document.fields[i].value.ToString());
+    }
+
+    // Compare everything else with the fields hidden from the expected proto.
+    pb_size_t fields_count = expected_document.fields_count;
+    expected_document.fields_count = 0;
+    EXPECT_EQ(expected->ToString(), actual.ToString());
+    expected_document.fields_count = fields_count;
+  }
+
+ private:
+  remote::Serializer remote_serializer_;
+  local::LocalSerializer serializer_;
+};
+
+absl::string_view AsStringView(const ByteString& bytes) {
+  return absl::string_view(reinterpret_cast<const char*>(bytes.data()),
+                           bytes.size());
+}
+
+TEST_F(ArenaDecoderTest, DecodesDocuments) {
+  MutableDocument document = Doc(
+      "rooms/eros", 42,
+      Map("null", nullptr, "bool", true, "int", -5, "double", 1.5, "string",
+          "", "timestamp", Timestamp(1234, 567), "geo", GeoPoint(1.25, -2.5),
+          "blob", BlobValue(1, 2, 3), "ref", testutil::Ref("p/d", "a/b"),
+          "array", Array(1, "two", Array(3)), "map",
+          Map("nested", Map("deeper", "value"), "empty", Map())));
+  document.SetHasCommittedMutations();
+
+  ExpectDecodesLikeNanopb(AsStringView(Encode(document)));
+}
+
+TEST_F(ArenaDecoderTest, DecodesDocumentsWithoutFields) {
+  ExpectDecodesLikeNanopb(AsStringView(Encode(Doc("rooms/eros", 42, Map()))));
+}
+
+TEST_F(ArenaDecoderTest, DecodesNoDocuments) {
+  ExpectDecodesLikeNanopb(
+      AsStringView(Encode(testutil::DeletedDoc("rooms/eros", 42))));
+}
+
+TEST_F(ArenaDecoderTest, DecodesUnknownDocuments) {
+  ExpectDecodesLikeNanopb(
+      AsStringView(Encode(testutil::UnknownDoc("rooms/eros", 42))));
+}
+
+TEST_F(ArenaDecoderTest, DecodesDocumentsLeavingFieldsEncoded) {
+  ByteString bytes = Encode(
+      Doc("rooms/eros", 42, Map("a", Map("b", Array(1.5, "c")), "d", "value")));
+
+  Arena arena;
+  util::ReadContext context;
+  ArenaDecoder decoder(&context, &arena);
+  absl::string_view encoded_document;
+  firestore_client_MaybeDocument actual =
+      decoder.DecodeMaybeDocumentWithoutFields(AsStringView(bytes),
+                                               &encoded_document);
+  ASSERT_TRUE(context.ok());
+  EXPECT_EQ(actual.document.fields_count, 0u);
+  EXPECT_FALSE(encoded_document.empty());
+
+  ExpectDecodesLikeNanopb(AsStringView(bytes));
+}
+
+TEST_F(ArenaDecoderTest, DecodesSingleDocumentFields) {
+  ByteString bytes = Encode(
+      Doc("rooms/eros", 42, Map("a", Map("b", Array(1.5, "c")), "d", "value")));
+
+  StringReader reader{AsStringView(bytes)};
+  auto expected = Message<firestore_client_MaybeDocument>::TryParse(&reader);
+  ASSERT_TRUE(reader.ok());
+
+  Arena arena;
+  util::ReadContext context;
+  ArenaDecoder decoder(&context, &arena);
+  absl::string_view encoded_document;
+  decoder.DecodeMaybeDocumentWithoutFields(AsStringView(bytes),
+                                           &encoded_document);
+
+  google_firestore_v1_Value value{};
+  ASSERT_TRUE(decoder.DecodeDocumentField(encoded_document, "d", &value));
+  EXPECT_EQ(value.ToString(), expected->document.fields[1].value.ToString());
+
+  value = {};
+  ASSERT_TRUE(decoder.DecodeDocumentField(encoded_document, "a", &value));
+  EXPECT_EQ(value.ToString(), expected->document.fields[0].value.ToString());
+
+  EXPECT_FALSE(decoder.DecodeDocumentField(encoded_document, "b", &value));
+  EXPECT_TRUE(context.ok());
+}
+
+TEST_F(ArenaDecoderTest, DecodesTheLastOfRepeatedDocumentFields) {
+  ByteString first = Encode(Doc("rooms/eros", 42, Map("a", "first", "b", 1)));
+  ByteString last = Encode(Doc("rooms/eros", 42, Map("a", "last")));
+
+  Arena arena;
+  util::ReadContext context;
+  ArenaDecoder decoder(&context, &arena);
+  absl::string_view encoded_first;
+  absl::string_view encoded_last;
+  decoder.DecodeMaybeDocumentWithoutFields(AsStringView(first),
+                                           &encoded_first);
+  decoder.DecodeMaybeDocumentWithoutFields(AsStringView(last), &encoded_last);
+
+  // Repeated fields of concatenated messages are merged, so "a" is repeated.
+  std::string encoded_document =
+      std::string(encoded_first) + std::string(encoded_last);
+
+  absl::string_view encoded_value;
+  ASSERT_TRUE(ArenaDecoder(&context, nullptr)
+                  .FindDocumentField(encoded_document, "a", &encoded_value));
+
+  google_firestore_v1_Value value{};
+  ASSERT_TRUE(decoder.DecodeDocumentField(encoded_document, "a", &value));
+  EXPECT_EQ(value.ToString(), Value("last")->ToString());
+
+  value = {};
+  ASSERT_TRUE(decoder.DecodeValue(encoded_value, &value));
+  EXPECT_EQ(value.ToString(), Value("last")->ToString());
+  EXPECT_TRUE(context.ok());
+}
+
+TEST_F(ArenaDecoderTest, FailsLikeNanopbOnTruncatedInput) {
+  ByteString bytes = Encode(Doc(
+      "rooms/eros", 42, Map("a", Map("b", Array(1.5, "c")), "d", "value")));
+  absl::string_view encoded = AsStringView(bytes);
+
+  for (size_t size = 0; size < encoded.size(); ++size) {
+    SCOPED_TRACE(size);
+    ExpectDecodesLikeNanopb(encoded.substr(0, size));
+  }
+}
+
+TEST_F(ArenaDecoderTest, FailsOnInvalidWireType) {
+  // Field 2 (`document`) with wire type 0 (varint) instead of 2 (bytes).
+  ExpectDecodesLikeNanopb(absl::string_view("\x10\x01", 2));
+}
+
+TEST_F(ArenaDecoderTest, EstimatedArenaSizeFitsInOneBlock) {
+  ByteString bytes = Encode(Doc(
+      "rooms/eros", 42,
+      Map("a", Map("b", Array(1, 2, 3), "c", "some string"), "d", true)));
+
+  Arena arena{ArenaDecoder::EstimateArenaSize(bytes.size())};
+  util::ReadContext context;
+  ArenaDecoder decoder(&context, &arena);
+  absl::string_view encoded_document;
+  decoder.DecodeMaybeDocumentWithoutFields(AsStringView(bytes),
+                                           &encoded_document);
+  decoder.DecodeDocumentFields(encoded_document);
+
+  ASSERT_TRUE(context.ok());
+  EXPECT_EQ(arena.block_count(), 1u);
+}
+
+TEST(ArenaTest, AllocatesZeroedAlignedMemory) {
+  Arena arena;
+  for (size_t size = 1; size < 100; ++size) {
+    auto* bytes = static_cast<uint8_t*>(arena.Allocate(size));
+    EXPECT_EQ(reinterpret_cast<uintptr_t>(bytes) % alignof(double), 0u);
+    for (size_t i = 0; i < size; ++i) {
+      EXPECT_EQ(bytes[i], 0);
+    }
+  }
+}
+
+TEST(ArenaTest, GrowsByAddingBlocks) {
+  Arena arena;
+  arena.Allocate(100);
+  EXPECT_EQ(arena.block_count(), 1u);
+
+  arena.Allocate(1024 * 1024);
+  EXPECT_EQ(arena.block_count(), 2u);
+}
+
+TEST(ArenaTest, FirstBlockCanBeSmall) {
+  Arena arena(64);
+  arena.Allocate(64);
+  EXPECT_EQ(arena.block_count(), 1u);
+
+  arena.Allocate(8);
+  EXPECT_EQ(arena.block_count(), 2u);
+}
+
+TEST(ArenaTest, MakesNullTerminatedBytesArrays) {
+  Arena arena;
+  pb_bytes_array_t* bytes = arena.MakeBytesArray("abc", 3);
+  EXPECT_EQ(bytes->size, 3u);
+  EXPECT_EQ(std::string(reinterpret_cast<char*>(bytes->bytes)), "abc");
+
+  pb_bytes_array_t* empty = arena.MakeBytesArray(nullptr, 0);
+  ASSERT_NE(empty, nullptr);
+  EXPECT_EQ(empty->size, 0u);
+}
+
+}  // namespace
+}  // namespace nanopb
+}  // namespace firestore
+}  // namespace firebase
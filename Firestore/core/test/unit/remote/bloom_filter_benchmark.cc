@@ -0,0 +1,157 @@
+/*
+ * Copyright 2022 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <cmath>
+#include <string>
+#include <vector>
+
+#include "Firestore/core/src/core/query.h"
+#include "Firestore/core/src/local/target_data.h"
+#include "Firestore/core/src/model/document_key.h"
+#include "Firestore/core/src/model/document_key_set.h"
+#include "Firestore/core/src/model/resource_path.h"
+#include "Firestore/core/src/remote/bloom_filter.h"
+#include "Firestore/core/src/remote/existence_filter.h"
+#include "Firestore/core/src/remote/remote_event.h"
+#include "Firestore/core/src/remote/watch_change.h"
+#include "Firestore/core/test/unit/remote/fake_target_metadata_provider.h"
+#include "absl/strings/str_cat.h"
+#include "benchmark/benchmark.h"
+
+namespace firebase {
+namespace firestore {
+namespace remote {
+namespace {
+
+using local::QueryPurpose;
+using local::TargetData;
+using model::DocumentKey;
+using model::DocumentKeySet;
+using model::ResourcePath;
+
+constexpr const char* kDocumentsPrefix =
+    "projects/test-project/databases/(default)/documents/";
+
+std::string DocumentPath(int64_t i) {
+  return absl::StrCat("coll/doc", i);
+}
+
+/**
+ * Returns a bloom filter sized for the given false positive rate over `count`
+ * entries, containing the documents `[0, count)` except every `skip`th one.
+ */
+BloomFilter MakeBloomFilter(int64_t count,
+                            int64_t skip,
+                            double false_positive_rate) {
+  double ln2 = std::log(2.0);
+  double bits = std::ceil(-static_cast<double>(count) *
+                          std::log(false_positive_rate) / (ln2 * ln2));
+  auto hash_count = static_cast<int32_t>(std::ceil(bits / count * ln2));
+  auto bytes = static_cast<size_t>(std::ceil(bits / 8));
+
+  BloomFilter bloom_filter(std::vector<uint8_t>(bytes), 0, hash_count);
+  for (int64_t i = 0; i < count; ++i) {
+    if (i % skip != 0) {
+      bloom_filter.Insert(absl::StrCat(kDocumentsPrefix, DocumentPath(i)));
+    }
+  }
+  return bloom_filter;
+}
+
+void BM_BloomFilterMightContain(benchmark::State& state) {
+  int64_t count = state.range(0);
+  BloomFilter bloom_filter = MakeBloomFilter(count, count + 1, 0.01);
+
+  std::vector<std::string> names;
+  names.reserve(count);
+  for (int64_t i = 0; i < count; ++i) {
+    names.push_back(absl::StrCat(kDocumentsPrefix, DocumentPath(i)));
+  }
+
+  for (auto _ : state) {
+    for (const std::string& name : names) {
+      benchmark::DoNotOptimize(bloom_filter.MightContain(name));
+    }
+  }
+
+  state.SetItemsProcessed(state.iterations() * count);
+  state.counters["bytes"] = static_cast<double>(bloom_filter.bitmap().size());
+  state.counters["hash_count"] = bloom_filter.hash_count();
+}
+BENCHMARK(BM_BloomFilterMightContain)
+    ->Unit(benchmark::kMicrosecond)
+    ->Arg(1000)
+    ->Arg(10000)
+    ->Arg(100000)
+    ->Arg(1000000);
+
+/**
+ * Measures resolving an existence filter mismatch for a target with `count`
+ * synced documents, one in a hundred of which were deleted on the server. The
+ * second argument selects whether the server sent a bloom filter; without one
+ * (or if a deleted document is a false positive) the target is reset and every
+ * document has to be downloaded again. The `resets` counter reports how often
+ * that happened.
+ */
+void BM_ExistenceFilterMismatch(benchmark::State& state) {
+  int64_t count = state.range(0);
+  bool with_bloom_filter = state.range(1) != 0;
+  constexpr int64_t kSkip = 100;
+
+  DocumentKeySet keys;
+  for (int64_t i = 0; i < count; ++i) {
+    keys = keys.insert(DocumentKey::FromPathString(DocumentPath(i)));
+  }
+
+  FakeTargetMetadataProvider metadata_provider;
+  core::Query query(ResourcePath::FromString("coll"));
+  metadata_provider.SetSyncedKeys(
+      keys, TargetData(query.ToTarget(), 1, 0, QueryPurpose::Listen));
+
+  int expected_count = static_cast<int>(count - (count + kSkip - 1) / kSkip);
+  ExistenceFilter filter =
+      with_bloom_filter
+          ? ExistenceFilter(expected_count,
+                            MakeBloomFilter(count, kSkip, 0.0001))
+          : ExistenceFilter(expected_count);
+  ExistenceFilterWatchChange change(filter, 1);
+
+  int64_t resets = 0;
+  for (auto _ : state) {
+    WatchChangeAggregator aggregator(&metadata_provider);
+    aggregator.HandleExistenceFilter(change);
+    RemoteEvent event = aggregator.CreateRemoteEvent(model::SnapshotVersion());
+    resets += static_cast<int64_t>(event.target_mismatches().size());
+  }
+
+  state.SetItemsProcessed(state.iterations() * count);
+  state.counters["resets"] = benchmark::Counter(
+      static_cast<double>(resets), benchmark::Counter::kAvgIterations);
+}
+BENCHMARK(BM_ExistenceFilterMismatch)
+    ->Unit(benchmark::kMicrosecond)
+    ->ArgNames({"docs", "bloom"})
+    ->Args({1000, 0})
+    ->Args({1000, 1})
+    ->Args({10000, 0})
+    ->Args({10000, 1})
+    ->Args({100000, 0})
+    ->Args({100000, 1});
+
+}  // namespace
+}  // namespace remote
+}  // namespace firestore
+}  // namespace firebase
@@ -0,0 +1,132 @@
+/*
+ * Copyright 2022 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Firestore/core/src/remote/bloom_filter.h"
+
+#include <string>
+#include <vector>
+
+#include "Firestore/core/test/unit/testutil/status_testing.h"
+#include "absl/strings/str_cat.h"
+#include "gtest/gtest.h"
+
+namespace firebase {
+namespace firestore {
+namespace remote {
+namespace {
+
+using util::StatusOr;
+
+TEST(BloomFilterTest, CanInstantiateEmptyBloomFilter) {
+  BloomFilter bloom_filter({}, 0, 0);
+  EXPECT_EQ(bloom_filter.bit_count(), 0);
+  EXPECT_FALSE(bloom_filter.MightContain(""));
+  EXPECT_FALSE(bloom_filter.MightContain("a"));
+}
+
+TEST(BloomFilterTest, CanInstantiateNonEmptyBloomFilter) {
+  BloomFilter bloom_filter({1}, 1, 1);
+  EXPECT_EQ(bloom_filter.bit_count(), 7);
+
+  BloomFilter full_bytes({1, 2, 3}, 0, 1);
+  EXPECT_EQ(full_bytes.bit_count(), 24);
+}
+
+TEST(BloomFilterTest, CreateRejectsNegativePadding) {
+  StatusOr<BloomFilter> maybe_filter = BloomFilter::Create({1}, -1, 1);
+  ASSERT_NOT_OK(maybe_filter);
+  EXPECT_EQ(maybe_filter.status().code(), Error::kErrorInvalidArgument);
+}
+
+TEST(BloomFilterTest, CreateRejectsPaddingOfEightOrMore) {
+  EXPECT_NOT_OK(BloomFilter::Create({1}, 8, 1));
+  EXPECT_OK(BloomFilter::Create({1}, 7, 1));
+}
+
+TEST(BloomFilterTest, CreateRejectsNegativeHashCount) {
+  EXPECT_NOT_OK(BloomFilter::Create({}, 0, -1));
+  EXPECT_NOT_OK(BloomFilter::Create({1}, 1, -1));
+}
+
+TEST(BloomFilterTest, CreateRejectsZeroHashCountForNonEmptyBitmap) {
+  EXPECT_NOT_OK(BloomFilter::Create({1}, 1, 0));
+  EXPECT_OK(BloomFilter::Create({}, 0, 0));
+}
+
+TEST(BloomFilterTest, CreateRejectsPaddingForEmptyBitmap) {
+  EXPECT_NOT_OK(BloomFilter::Create({}, 1, 1));
+}
+
+// The bitmap below was produced by hashing "coll/doc1" and "coll/doc2" as the
+// backend does: MD5 split into two little-endian 64-bit halves, probing bit
+// `(h1 + i * h2) % 29` for `i` in [0, 3).
+TEST(BloomFilterTest, MatchesBackendHashing) {
+  BloomFilter bloom_filter({0x04, 0x10, 0x34, 0x08}, 3, 3);
+  EXPECT_TRUE(bloom_filter.MightContain("coll/doc1"));
+  EXPECT_TRUE(bloom_filter.MightContain("coll/doc2"));
+  EXPECT_FALSE(bloom_filter.MightContain("coll/doc3"));
+  EXPECT_FALSE(bloom_filter.MightContain("coll/doc4"));
+  EXPECT_FALSE(bloom_filter.MightContain("coll/doc5"));
+  EXPECT_FALSE(bloom_filter.MightContain("coll/doc6"));
+}
+
+TEST(BloomFilterTest, IgnoresPaddingBits) {
+  // Same as above, with all three padding bits of the last byte set.
+  BloomFilter bloom_filter({0x04, 0x10, 0x34, 0xe8}, 3, 3);
+  EXPECT_TRUE(bloom_filter.MightContain("coll/doc1"));
+  EXPECT_TRUE(bloom_filter.MightContain("coll/doc2"));
+  EXPECT_FALSE(bloom_filter.MightContain("coll/doc3"));
+  EXPECT_FALSE(bloom_filter.MightContain("coll/doc4"));
+}
+
+TEST(BloomFilterTest, InsertMatchesBackendHashing) {
+  BloomFilter bloom_filter(std::vector<uint8_t>(4), 3, 3);
+  bloom_filter.Insert("coll/doc1");
+  bloom_filter.Insert("coll/doc2");
+  EXPECT_EQ(bloom_filter, BloomFilter({0x04, 0x10, 0x34, 0x08}, 3, 3));
+}
+
+TEST(BloomFilterTest, HasNoFalseNegatives) {
+  BloomFilter bloom_filter(std::vector<uint8_t>(1200), 0, 7);
+  for (int i = 0; i < 1000; ++i) {
+    bloom_filter.Insert(absl::StrCat("coll/doc", i));
+  }
+  for (int i = 0; i < 1000; ++i) {
+    EXPECT_TRUE(bloom_filter.MightContain(absl::StrCat("coll/doc", i)));
+  }
+}
+
+TEST(BloomFilterTest, FalsePositiveRateIsBounded) {
+  // 9600 bits and 7 hashes for 1000 entries gives a false positive rate of
+  // about 1%.
+  BloomFilter bloom_filter(std::vector<uint8_t>(1200), 0, 7);
+  for (int i = 0; i < 1000; ++i) {
+    bloom_filter.Insert(absl::StrCat("coll/doc", i));
+  }
+
+  int false_positives = 0;
+  for (int i = 0; i < 10000; ++i) {
+    if (bloom_filter.MightContain(absl::StrCat("other/doc", i))) {
+      ++false_positives;
+    }
+  }
+  EXPECT_LT(false_positives, 200);
+}
+
+}  // namespace
+}  // namespace remote
+}  // namespace firestore
+}  // namespace firebase
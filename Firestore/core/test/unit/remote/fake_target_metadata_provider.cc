@@ -31,6 +31,7 @@ namespace remote {
 
 using local::QueryPurpose;
 using local::TargetData;
+using model::DatabaseId;
 using model::DocumentKey;
 using model::DocumentKeySet;
 using model::ResourcePath;
@@ -102,6 +103,10 @@ absl::optional<TargetData> FakeTargetMetadataProvider::GetTargetDataForTarget(
   return it->second;
 }
 
+const DatabaseId& FakeTargetMetadataProvider::GetDatabaseId() const {
+  return database_id_;
+}
+
 }  // namespace remote
 }  // namespace firestore
 }  // namespace firebase
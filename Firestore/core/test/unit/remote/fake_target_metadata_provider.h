@@ -21,6 +21,7 @@
 #include <vector>
 
 #include "Firestore/core/src/local/target_data.h"
+#include "Firestore/core/src/model/database_id.h"
 #include "Firestore/core/src/remote/remote_event.h"
 
 namespace firebase {
@@ -73,10 +74,12 @@ class FakeTargetMetadataProvider : public TargetMetadataProvider {
       model::TargetId target_id) const override;
   absl::optional<local::TargetData> GetTargetDataForTarget(
       model::TargetId target_id) const override;
+  const model::DatabaseId& GetDatabaseId() const override;
 
  private:
   std::unordered_map<model::TargetId, model::DocumentKeySet> synced_keys_;
   std::unordered_map<model::TargetId, local::TargetData> target_data_;
+  model::DatabaseId database_id_{"test-project"};
 };
 
 }  // namespace remote
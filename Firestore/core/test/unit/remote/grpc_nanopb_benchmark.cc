@@ -0,0 +1,144 @@
+/*
+ * Copyright 2022 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <cstdint>
+#include <vector>
+
+#include "Firestore/Protos/nanopb/google/firestore/v1/firestore.nanopb.h"
+#include "Firestore/core/src/core/database_info.h"
+#include "Firestore/core/src/model/database_id.h"
+#include "Firestore/core/src/model/mutation.h"
+#include "Firestore/core/src/model/set_mutation.h"
+#include "Firestore/core/src/nanopb/message.h"
+#include "Firestore/core/src/nanopb/writer.h"
+#include "Firestore/core/src/remote/grpc_nanopb.h"
+#include "Firestore/core/src/remote/remote_objc_bridge.h"
+#include "Firestore/core/test/unit/testutil/testutil.h"
+#include "absl/strings/str_cat.h"
+#include "benchmark/benchmark.h"
+#include "grpcpp/impl/codegen/grpc_library.h"
+#include "grpcpp/support/byte_buffer.h"
+#include "grpcpp/support/slice.h"
+
+namespace firebase {
+namespace firestore {
+namespace remote {
+namespace {
+
+using core::DatabaseInfo;
+using model::DatabaseId;
+using model::Mutation;
+using nanopb::Message;
+using testutil::Array;
+using testutil::Map;
+
+/**
+ * A `Writer` that emplaces a separate `grpc::Slice` for every write Nanopb
+ * makes, as `ByteBufferWriter` used to.
+ */
+class SlicePerWriteWriter : public nanopb::Writer {
+ public:
+  SlicePerWriteWriter() {
+    stream_.callback = AppendSlice;
+    stream_.state = &slices_;
+    stream_.max_size = SIZE_MAX;
+  }
+
+  grpc::ByteBuffer Release() {
+    grpc::ByteBuffer result{slices_.data(), slices_.size()};
+    slices_.clear();
+    return result;
+  }
+
+ private:
+  static bool AppendSlice(pb_ostream_t* stream,
+                          const pb_byte_t* buf,
+                          size_t count) {
+    auto slices = static_cast<std::vector<grpc::Slice>*>(stream->state);
+    slices->emplace_back(buf, count);
+    return true;
+  }
+
+  std::vector<grpc::Slice> slices_;
+};
+
+/** Returns a commit request of `write_count` set mutations. */
+Message<google_firestore_v1_CommitRequest> MakeCommitRequest(
+    int64_t write_count) {
+  std::vector<Mutation> mutations;
+  for (int64_t i = 0; i < write_count; ++i) {
+    mutations.push_back(testutil::SetMutation(
+        absl::StrCat("rooms/doc", i),
+        Map("name", absl::StrCat("room ", i), "count", i, "open", true,
+            "tags", Array("a", "b", "c"), "owner",
+            Map("name", "owner name", "id", i))));
+  }
+
+  DatastoreSerializer serializer{
+      DatabaseInfo(DatabaseId("p", "d"), "", "localhost", false)};
+  return serializer.EncodeCommitRequest(mutations);
+}
+
+/** Reports the number of slices of `buffer` and its size. */
+void ReportBuffer(benchmark::State& state, const grpc::ByteBuffer& buffer) {
+  std::vector<grpc::Slice> slices;
+  buffer.Dump(&slices);
+  state.counters["slices"] = static_cast<double>(slices.size());
+  state.counters["bytes"] = static_cast<double>(buffer.Length());
+}
+
+/**
+ * Encodes a commit of `state.range(0)` writes into a `grpc::ByteBuffer` with a
+ * slice per Nanopb write.
+ */
+void BM_EncodeCommitSlicePerWrite(benchmark::State& state) {
+  grpc::GrpcLibraryCodegen grpc_initializer;
+  Message<google_firestore_v1_CommitRequest> request =
+      MakeCommitRequest(state.range(0));
+
+  grpc::ByteBuffer buffer;
+  for (auto _ : state) {
+    SlicePerWriteWriter writer;
+    writer.Write(request.fields(), request.get());
+    buffer = writer.Release();
+    benchmark::DoNotOptimize(buffer);
+  }
+  ReportBuffer(state, buffer);
+}
+BENCHMARK(BM_EncodeCommitSlicePerWrite)->Arg(1)->Arg(500);
+
+/**
+ * Encodes a commit of `state.range(0)` writes with `MakeByteBuffer`, as
+ * `Datastore` does.
+ */
+void BM_EncodeCommitMakeByteBuffer(benchmark::State& state) {
+  grpc::GrpcLibraryCodegen grpc_initializer;
+  Message<google_firestore_v1_CommitRequest> request =
+      MakeCommitRequest(state.range(0));
+
+  grpc::ByteBuffer buffer;
+  for (auto _ : state) {
+    buffer = MakeByteBuffer(request);
+    benchmark::DoNotOptimize(buffer);
+  }
+  ReportBuffer(state, buffer);
+}
+BENCHMARK(BM_EncodeCommitMakeByteBuffer)->Arg(1)->Arg(500);
+
+}  // namespace
+}  // namespace remote
+}  // namespace firestore
+}  // namespace firebase
@@ -0,0 +1,136 @@
+/*
+ * Copyright 2022 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Firestore/core/src/remote/grpc_nanopb.h"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "Firestore/Protos/nanopb/google/firestore/v1/firestore.nanopb.h"
+#include "Firestore/core/src/nanopb/message.h"
+#include "Firestore/core/src/nanopb/nanopb_util.h"
+#include "grpcpp/impl/codegen/grpc_library.h"
+#include "grpcpp/support/byte_buffer.h"
+#include "grpcpp/support/slice.h"
+#include "gtest/gtest.h"
+
+namespace firebase {
+namespace firestore {
+namespace remote {
+namespace {
+
+using nanopb::MakeBytesArray;
+using nanopb::MakeString;
+using nanopb::Message;
+
+class GrpcNanopbTest : public testing::Test {
+ private:
+  // gRPC slices can only be created once the gRPC library is initialized.
+  grpc::GrpcLibraryCodegen grpc_initializer_;
+};
+
+std::vector<grpc::Slice> Slices(const grpc::ByteBuffer& buffer) {
+  std::vector<grpc::Slice> slices;
+  EXPECT_TRUE(buffer.Dump(&slices).ok());
+  return slices;
+}
+
+TEST_F(GrpcNanopbTest, WritesMessageIntoSingleSlice) {
+  Message<google_firestore_v1_WriteRequest> request;
+  request->stream_id = MakeBytesArray("stream_id");
+  request->stream_token = MakeBytesArray(std::string(10000, 'x'));
+
+  grpc::ByteBuffer buffer = MakeByteBuffer(request);
+  EXPECT_EQ(Slices(buffer).size(), 1u);
+
+  ByteBufferReader reader{buffer};
+  auto decoded = Message<google_firestore_v1_WriteRequest>::TryParse(&reader);
+  ASSERT_TRUE(reader.ok());
+  EXPECT_EQ(MakeString(decoded->stream_id), "stream_id");
+  EXPECT_EQ(MakeString(decoded->stream_token), std::string(10000, 'x'));
+}
+
+TEST_F(GrpcNanopbTest, ReadsMessageSpreadAcrossSlices) {
+  Message<google_firestore_v1_WriteRequest> request;
+  request->stream_id = MakeBytesArray("stream_id");
+  request->stream_token = MakeBytesArray("stream_token");
+
+  std::vector<grpc::Slice> encoded = Slices(MakeByteBuffer(request));
+  ASSERT_EQ(encoded.size(), 1u);
+  const uint8_t* bytes = encoded[0].begin();
+  size_t size = encoded[0].size();
+
+  // Split the message in three at every possible position, including into
+  // empty slices.
+  for (size_t first = 0; first <= size; ++first) {
+    for (size_t second = first; second <= size; ++second) {
+      SCOPED_TRACE(first);
+      SCOPED_TRACE(second);
+      std::vector<grpc::Slice> slices{
+          grpc::Slice(bytes, first), grpc::Slice(bytes + first, second - first),
+          grpc::Slice(bytes + second, size - second)};
+      grpc::ByteBuffer buffer{slices.data(), slices.size()};
+
+      ByteBufferReader reader{buffer};
+      auto decoded =
+          Message<google_firestore_v1_WriteRequest>::TryParse(&reader);
+      ASSERT_TRUE(reader.ok());
+      EXPECT_EQ(MakeString(decoded->stream_id), "stream_id");
+      EXPECT_EQ(MakeString(decoded->stream_token), "stream_token");
+    }
+  }
+}
+
+TEST_F(GrpcNanopbTest, FailsOnTruncatedSlices) {
+  Message<google_firestore_v1_WriteRequest> request;
+  request->stream_id = MakeBytesArray("stream_id");
+
+  std::vector<grpc::Slice> encoded = Slices(MakeByteBuffer(request));
+  ASSERT_EQ(encoded.size(), 1u);
+  std::vector<grpc::Slice> slices{
+      grpc::Slice(encoded[0].begin(), 2),
+      grpc::Slice(encoded[0].begin() + 2, encoded[0].size() - 3)};
+  grpc::ByteBuffer buffer{slices.data(), slices.size()};
+
+  ByteBufferReader reader{buffer};
+  Message<google_firestore_v1_WriteRequest>::TryParse(&reader);
+  EXPECT_FALSE(reader.ok());
+}
+
+TEST_F(GrpcNanopbTest, WritesEmptyMessage) {
+  Message<google_firestore_v1_WriteRequest> request;
+
+  grpc::ByteBuffer buffer = MakeByteBuffer(request);
+  EXPECT_TRUE(buffer.Valid());
+  EXPECT_EQ(buffer.Length(), 0u);
+}
+
+TEST_F(GrpcNanopbTest, ReleaseResetsWriter) {
+  ByteBufferWriter writer;
+  writer.Append("abc", 3);
+  EXPECT_EQ(writer.size(), 3u);
+  EXPECT_EQ(writer.Release().Length(), 3u);
+
+  EXPECT_EQ(writer.size(), 0u);
+  writer.Append("de", 2);
+  EXPECT_EQ(writer.Release().Length(), 2u);
+}
+
+}  // namespace
+}  // namespace remote
+}  // namespace firestore
+}  // namespace firebase
@@ -17,6 +17,7 @@
 #include "Firestore/core/src/remote/remote_event.h"
 
 #include <memory>
+#include <string>
 #include <unordered_map>
 #include <utility>
 #include <vector>
@@ -24,6 +25,7 @@
 #include "Firestore/core/src/local/target_data.h"
 #include "Firestore/core/src/model/document_key.h"
 #include "Firestore/core/src/model/types.h"
+#include "Firestore/core/src/remote/bloom_filter.h"
 #include "Firestore/core/src/remote/existence_filter.h"
 #include "Firestore/core/src/remote/watch_change.h"
 #include "Firestore/core/test/unit/remote/fake_target_metadata_provider.h"
@@ -71,6 +73,20 @@ std::unique_ptr<DocumentWatchChange> MakeDocChange(
       std::move(updated), std::move(removed), std::move(key), doc);
 }
 
+/**
+ * Returns a bloom filter containing the full resource names of the documents
+ * at the given paths in the database of `FakeTargetMetadataProvider`.
+ */
+BloomFilter BloomFilterOf(const std::vector<std::string>& paths) {
+  BloomFilter bloom_filter(std::vector<uint8_t>(128), /*padding=*/0,
+                           /*hash_count=*/7);
+  for (const std::string& path : paths) {
+    bloom_filter.Insert(
+        "projects/test-project/databases/(default)/documents/" + path);
+  }
+  return bloom_filter;
+}
+
 std::unique_ptr<WatchTargetChange> MakeTargetChange(
     WatchTargetChangeState state, std::vector<TargetId> target_ids) {
   return absl::make_unique<WatchTargetChange>(state, std::move(target_ids));
@@ -595,6 +611,102 @@ TEST_F(RemoteEventTest, ExistenceFilterMismatchRemovesCurrentChanges) {
   ASSERT_TRUE(event.target_changes().at(1) == target_change1);
 }
 
+TEST_F(RemoteEventTest, BloomFilterRemovesDeletedDocuments) {
+  std::unordered_map<TargetId, TargetData> target_map = ActiveQueries({1});
+  DocumentKeySet existing_keys{Key("docs/1"), Key("docs/2"), Key("docs/3")};
+
+  WatchChangeAggregator aggregator = CreateAggregator(
+      target_map, no_outstanding_responses_, existing_keys, {});
+  aggregator.CreateRemoteEvent(testutil::Version(3));
+
+  // Only the documents missing from the bloom filter are removed; the target
+  // keeps its resume token and isn't reset.
+  ExistenceFilterWatchChange existence_filter{
+      ExistenceFilter{2, BloomFilterOf({"docs/1", "docs/2"})}, 1};
+  aggregator.HandleExistenceFilter(existence_filter);
+
+  RemoteEvent event = aggregator.CreateRemoteEvent(testutil::Version(4));
+
+  ASSERT_EQ(event.target_mismatches().size(), 0);
+  ASSERT_EQ(event.document_updates().size(), 0);
+  ASSERT_EQ(event.target_changes().size(), 1);
+
+  TargetChange target_change{resume_token1_, false, DocumentKeySet{},
+                             DocumentKeySet{}, DocumentKeySet{Key("docs/3")}};
+  ASSERT_TRUE(event.target_changes().at(1) == target_change);
+}
+
+TEST_F(RemoteEventTest, BloomFilterKeepsChangedDocuments) {
+  std::unordered_map<TargetId, TargetData> target_map = ActiveQueries({1});
+  DocumentKeySet existing_keys{Key("docs/1"), Key("docs/2"), Key("docs/3"),
+                               Key("docs/4")};
+
+  WatchChangeAggregator aggregator = CreateAggregator(
+      target_map, no_outstanding_responses_, existing_keys, {});
+  aggregator.CreateRemoteEvent(testutil::Version(3));
+
+  // "docs/3" changed since the resume token, so it isn't in the bloom filter,
+  // but it still matches the target.
+  MutableDocument doc3 = Doc("docs/3", 4, Map("value", 3));
+  DocumentWatchChange update_doc{{1}, {}, doc3.key(), doc3};
+  aggregator.HandleDocumentChange(update_doc);
+
+  ExistenceFilterWatchChange existence_filter{
+      ExistenceFilter{3, BloomFilterOf({"docs/1", "docs/2"})}, 1};
+  aggregator.HandleExistenceFilter(existence_filter);
+
+  RemoteEvent event = aggregator.CreateRemoteEvent(testutil::Version(4));
+
+  ASSERT_EQ(event.target_mismatches().size(), 0);
+  ASSERT_EQ(event.document_updates().size(), 1);
+  ASSERT_EQ(event.document_updates().at(doc3.key()), doc3);
+
+  TargetChange target_change{resume_token1_, false, DocumentKeySet{},
+                             DocumentKeySet{doc3.key()},
+                             DocumentKeySet{Key("docs/4")}};
+  ASSERT_TRUE(event.target_changes().at(1) == target_change);
+}
+
+TEST_F(RemoteEventTest, BloomFilterFalsePositiveResetsTarget) {
+  std::unordered_map<TargetId, TargetData> target_map = ActiveQueries({1});
+  DocumentKeySet existing_keys{Key("docs/1"), Key("docs/2"), Key("docs/3")};
+
+  WatchChangeAggregator aggregator = CreateAggregator(
+      target_map, no_outstanding_responses_, existing_keys, {});
+  aggregator.CreateRemoteEvent(testutil::Version(3));
+
+  // The bloom filter claims to contain all three documents, so it can't
+  // explain the mismatch and the target has to be reset.
+  ExistenceFilterWatchChange existence_filter{
+      ExistenceFilter{2, BloomFilterOf({"docs/1", "docs/2", "docs/3"})}, 1};
+  aggregator.HandleExistenceFilter(existence_filter);
+
+  RemoteEvent event = aggregator.CreateRemoteEvent(testutil::Version(4));
+
+  ASSERT_EQ(event.target_mismatches().size(), 1);
+
+  TargetChange target_change{ByteString(), false, DocumentKeySet{},
+                             DocumentKeySet{}, existing_keys};
+  ASSERT_TRUE(event.target_changes().at(1) == target_change);
+}
+
+TEST_F(RemoteEventTest, EmptyBloomFilterResetsTarget) {
+  std::unordered_map<TargetId, TargetData> target_map = ActiveQueries({1});
+  DocumentKeySet existing_keys{Key("docs/1"), Key("docs/2")};
+
+  WatchChangeAggregator aggregator = CreateAggregator(
+      target_map, no_outstanding_responses_, existing_keys, {});
+  aggregator.CreateRemoteEvent(testutil::Version(3));
+
+  ExistenceFilterWatchChange existence_filter{
+      ExistenceFilter{1, BloomFilter({}, 0, 0)}, 1};
+  aggregator.HandleExistenceFilter(existence_filter);
+
+  RemoteEvent event = aggregator.CreateRemoteEvent(testutil::Version(4));
+
+  ASSERT_EQ(event.target_mismatches().size(), 1);
+}
+
 TEST_F(RemoteEventTest, DocumentUpdate) {
   std::unordered_map<TargetId, TargetData> target_map = ActiveQueries({1});
 
@@ -0,0 +1,451 @@
+/*
+ * Copyright 2022 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Firestore/core/src/remote/remote_store.h"
+
+#include <functional>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "Firestore/core/include/firebase/firestore/firestore_errors.h"
+#include "Firestore/core/src/core/database_info.h"
+#include "Firestore/core/src/credentials/empty_credentials_provider.h"
+#include "Firestore/core/src/credentials/user.h"
+#include "Firestore/core/src/local/local_store.h"
+#include "Firestore/core/src/local/local_write_result.h"
+#include "Firestore/core/src/local/memory_persistence.h"
+#include "Firestore/core/src/local/query_engine.h"
+#include "Firestore/core/src/model/database_id.h"
+#include "Firestore/core/src/model/mutation.h"
+#include "Firestore/core/src/model/mutation_batch_result.h"
+#include "Firestore/core/src/model/set_mutation.h"
+#include "Firestore/core/src/remote/datastore.h"
+#include "Firestore/core/src/remote/firebase_metadata_provider.h"
+#include "Firestore/core/src/remote/firebase_metadata_provider_noop.h"
+#include "Firestore/core/src/remote/remote_event.h"
+#include "Firestore/core/src/remote/serializer.h"
+#include "Firestore/core/src/remote/write_pipeline_window.h"
+#include "Firestore/core/src/remote/write_stream.h"
+#include "Firestore/core/src/util/async_queue.h"
+#include "Firestore/core/src/util/status.h"
+#include "Firestore/core/test/unit/remote/create_noop_connectivity_monitor.h"
+#include "Firestore/core/test/unit/testutil/async_testing.h"
+#include "Firestore/core/test/unit/testutil/testutil.h"
+#include "absl/memory/memory.h"
+#include "absl/strings/str_cat.h"
+#include "gtest/gtest.h"
+
+namespace firebase {
+namespace firestore {
+namespace remote {
+namespace {
+
+using core::DatabaseInfo;
+using credentials::EmptyAppCheckCredentialsProvider;
+using credentials::EmptyAuthCredentialsProvider;
+using credentials::User;
+using local::LocalStore;
+using local::MemoryPersistence;
+using local::QueryEngine;
+using model::BatchId;
+using model::DatabaseId;
+using model::DocumentKeySet;
+using model::Mutation;
+using model::MutationBatchResult;
+using model::MutationResult;
+using model::OnlineState;
+using model::TargetId;
+using testutil::Map;
+using testutil::SetMutation;
+using testutil::Version;
+using util::AsyncQueue;
+using util::Status;
+
+/**
+ * A `WriteStream` that never touches the network. It opens and completes the
+ * handshake as soon as it's started and records the requests written to it.
+ */
+class FakeWriteStream : public WriteStream {
+ public:
+  FakeWriteStream(const std::shared_ptr<AsyncQueue>& worker_queue,
+                  GrpcConnection* grpc_connection,
+                  WriteStreamCallback* callback)
+      : WriteStream{worker_queue,
+                    std::make_shared<EmptyAuthCredentialsProvider>(),
+                    std::make_shared<EmptyAppCheckCredentialsProvider>(),
+                    Serializer{DatabaseId{"p", "d"}},
+                    grpc_connection,
+                    callback},
+        callback_{callback} {
+  }
+
+  void Start() override {
+    open_ = true;
+    SetHandshakeComplete(false);
+    callback_->OnWriteStreamOpen();
+  }
+
+  void Stop() override {
+    WriteStream::Stop();
+    open_ = false;
+    SetHandshakeComplete(false);
+  }
+
+  bool IsStarted() const override {
+    return open_;
+  }
+  bool IsOpen() const override {
+    return open_;
+  }
+
+  void WriteHandshake() override {
+    SetHandshakeComplete();
+    callback_->OnWriteStreamHandshakeComplete();
+  }
+
+  void WriteMutations(const std::vector<Mutation>& mutations) override {
+    requests.push_back(mutations);
+  }
+
+  /** Acknowledges the oldest write request with one result per write. */
+  void AckOldestRequest(int64_t version) {
+    std::vector<MutationResult> results;
+    for (size_t i = 0; i != requests[acked_requests_].size(); ++i) {
+      results.push_back(testutil::MutationResult(version));
+    }
+    ++acked_requests_;
+    callback_->OnWriteStreamMutationResult(Version(version),
+                                           std::move(results));
+  }
+
+  /** Closes the stream as though the backend failed with `error`. */
+  void Fail(const Status& error) {
+    open_ = false;
+    acked_requests_ = requests.size();
+    callback_->OnWriteStreamClose(error);
+  }
+
+  /** The mutations of each write request, in the order they were written. */
+  std::vector<std::vector<Mutation>> requests;
+
+ private:
+  WriteStreamCallback* callback_ = nullptr;
+  bool open_ = false;
+  size_t acked_requests_ = 0;
+};
+
+class FakeDatastore : public Datastore {
+ public:
+  FakeDatastore(const DatabaseInfo& database_info,
+                const std::shared_ptr<AsyncQueue>& worker_queue,
+                ConnectivityMonitor* connectivity_monitor,
+                FirebaseMetadataProvider* firebase_metadata_provider)
+      : Datastore{database_info,
+                  worker_queue,
+                  std::make_shared<EmptyAuthCredentialsProvider>(),
+                  std::make_shared<EmptyAppCheckCredentialsProvider>(),
+                  connectivity_monitor,
+                  firebase_metadata_provider},
+        worker_queue_{worker_queue} {
+  }
+
+  std::shared_ptr<WriteStream> CreateWriteStream(
+      WriteStreamCallback* callback) override {
+    write_stream = std::make_shared<FakeWriteStream>(
+        worker_queue_, grpc_connection(), callback);
+    return write_stream;
+  }
+
+  std::shared_ptr<FakeWriteStream> write_stream;
+
+ private:
+  std::shared_ptr<AsyncQueue> worker_queue_;
+};
+
+/** Records the write results `RemoteStore` hands back. */
+class RecordingRemoteStoreCallback : public RemoteStoreCallback {
+ public:
+  void ApplyRemoteEvent(const RemoteEvent&) override {
+  }
+  void HandleRejectedListen(TargetId, Status) override {
+  }
+  void HandleSuccessfulWrite(MutationBatchResult batch_result) override {
+    acknowledged.push_back(std::move(batch_result));
+  }
+  void HandleRejectedWrite(BatchId batch_id, Status) override {
+    rejected.push_back(batch_id);
+  }
+  void HandleOnlineStateChange(OnlineState) override {
+  }
+  DocumentKeySet GetRemoteKeys(TargetId) const override {
+    return {};
+  }
+
+  std::vector<MutationBatchResult> acknowledged;
+  std::vector<BatchId> rejected;
+};
+
+class RemoteStoreTest : public testing::Test {
+ public:
+  RemoteStoreTest()
+      : worker_queue_{testutil::AsyncQueueForTesting()},
+        database_info_{DatabaseId{"p", "d"}, "", "localhost", false},
+        persistence_{MemoryPersistence::WithEagerGarbageCollector()},
+        local_store_{persistence_.get(), &query_engine_,
+                     User::Unauthenticated()},
+        connectivity_monitor_{CreateNoOpConnectivityMonitor()},
+        firebase_metadata_provider_{CreateFirebaseMetadataProviderNoOp()} {
+    local_store_.Start();
+  }
+
+  ~RemoteStoreTest() {
+    if (remote_store_) {
+      Run([&] { remote_store_->Shutdown(); });
+    }
+  }
+
+  /**
+   * Creates a `RemoteStore` that coalesces up to `max_batches` batches and
+   * limits the writes in flight with `window`.
+   */
+  void CreateRemoteStore(int max_batches, WritePipelineWindow window = {}) {
+    Run([&] {
+      auto datastore = std::make_shared<FakeDatastore>(
+          database_info_, worker_queue_, connectivity_monitor_.get(),
+          firebase_metadata_provider_.get());
+      datastore_ = datastore.get();
+      remote_store_ = absl::make_unique<RemoteStore>(
+          &local_store_, std::move(datastore), worker_queue_,
+          connectivity_monitor_.get(), [](OnlineState) {},
+          std::move(window), max_batches);
+      remote_store_->set_sync_engine(&callback_);
+    });
+  }
+
+  /** Writes a batch that sets each of the given documents. */
+  BatchId WriteBatch(const std::vector<const char*>& paths) {
+    std::vector<Mutation> mutations;
+    for (const char* path : paths) {
+      mutations.push_back(SetMutation(path, Map("a", 1)));
+    }
+    return local_store_.WriteLocally(std::move(mutations)).batch_id();
+  }
+
+  /** Writes `count` batches that each set a single document. */
+  void WriteBatches(int count) {
+    for (int i = 0; i != count; ++i) {
+      std::string path = absl::StrCat("coll/doc", i);
+      WriteBatch({path.c_str()});
+    }
+  }
+
+  void Run(const std::function<void()>& operation) {
+    worker_queue_->EnqueueBlocking(operation);
+  }
+
+  FakeWriteStream& write_stream() {
+    return *datastore_->write_stream;
+  }
+
+  /** Returns the number of mutations in each write request sent so far. */
+  std::vector<size_t> RequestSizes() {
+    std::vector<size_t> result;
+    for (const auto& request : write_stream().requests) {
+      result.push_back(request.size());
+    }
+    return result;
+  }
+
+  std::vector<BatchId> AcknowledgedBatchIds() const {
+    std::vector<BatchId> result;
+    for (const MutationBatchResult& batch_result : callback_.acknowledged) {
+      result.push_back(batch_result.batch().batch_id());
+    }
+    return result;
+  }
+
+  std::shared_ptr<AsyncQueue> worker_queue_;
+  DatabaseInfo database_info_;
+  std::unique_ptr<MemoryPersistence> persistence_;
+  QueryEngine query_engine_;
+  LocalStore local_store_;
+  std::unique_ptr<ConnectivityMonitor> connectivity_monitor_;
+  std::unique_ptr<FirebaseMetadataProvider> firebase_metadata_provider_;
+  RecordingRemoteStoreCallback callback_;
+  FakeDatastore* datastore_ = nullptr;
+  std::unique_ptr<RemoteStore> remote_store_;
+};
+
+}  // namespace
+
+TEST_F(RemoteStoreTest, SendsEachBatchInItsOwnRequestByDefault) {
+  WriteBatch({"coll/a"});
+  WriteBatch({"coll/b", "coll/c"});
+  CreateRemoteStore(/*max_batches=*/1);
+
+  Run([&] { remote_store_->EnableNetwork(); });
+
+  Run([&] { EXPECT_EQ(RequestSizes(), std::vector<size_t>({1, 2})); });
+}
+
+TEST_F(RemoteStoreTest, CoalescesBatchesIntoOneRequest) {
+  WriteBatch({"coll/a"});
+  WriteBatch({"coll/b", "coll/c"});
+  WriteBatch({"coll/d"});
+  WriteBatch({"coll/e"});
+  CreateRemoteStore(/*max_batches=*/3);
+
+  Run([&] { remote_store_->EnableNetwork(); });
+
+  Run([&] {
+    EXPECT_EQ(RequestSizes(), std::vector<size_t>({4, 1}));
+    std::vector<Mutation> first = write_stream().requests[0];
+    ASSERT_EQ(first.size(), 4u);
+    EXPECT_EQ(first[0].key(), testutil::Key("coll/a"));
+    EXPECT_EQ(first[1].key(), testutil::Key("coll/b"));
+    EXPECT_EQ(first[2].key(), testutil::Key("coll/c"));
+    EXPECT_EQ(first[3].key(), testutil::Key("coll/d"));
+  });
+}
+
+TEST_F(RemoteStoreTest, FansOutResultsOfCoalescedRequestToEachBatch) {
+  BatchId batch1 = WriteBatch({"coll/a"});
+  BatchId batch2 = WriteBatch({"coll/b", "coll/c"});
+  BatchId batch3 = WriteBatch({"coll/d"});
+  CreateRemoteStore(/*max_batches=*/3);
+
+  Run([&] { remote_store_->EnableNetwork(); });
+  Run([&] { write_stream().AckOldestRequest(/*version=*/5); });
+
+  Run([&] {
+    EXPECT_EQ(AcknowledgedBatchIds(),
+              std::vector<BatchId>({batch1, batch2, batch3}));
+    ASSERT_EQ(callback_.acknowledged.size(), 3u);
+    EXPECT_EQ(callback_.acknowledged[0].mutation_results().size(), 1u);
+    EXPECT_EQ(callback_.acknowledged[1].mutation_results().size(), 2u);
+    EXPECT_EQ(callback_.acknowledged[2].mutation_results().size(), 1u);
+    for (const MutationBatchResult& batch_result : callback_.acknowledged) {
+      EXPECT_EQ(batch_result.commit_version(), Version(5));
+    }
+  });
+}
+
+TEST_F(RemoteStoreTest, ResendsCoalescedBatchesOneByOneAfterPermanentError) {
+  BatchId batch1 = WriteBatch({"coll/a"});
+  BatchId batch2 = WriteBatch({"coll/b"});
+  BatchId batch3 = WriteBatch({"coll/c"});
+  CreateRemoteStore(/*max_batches=*/3);
+
+  Run([&] { remote_store_->EnableNetwork(); });
+  Run([&] {
+    ASSERT_EQ(RequestSizes(), std::vector<size_t>({3}));
+    write_stream().Fail(Status{Error::kErrorInvalidArgument, "bad write"});
+  });
+
+  // The failed request isn't rejected as a whole; its batches are resent one
+  // per request.
+  Run([&] {
+    EXPECT_TRUE(callback_.rejected.empty());
+    EXPECT_EQ(RequestSizes(), std::vector<size_t>({3, 1, 1, 1}));
+  });
+
+  // Now only the offending batch is rejected.
+  Run([&] {
+    write_stream().AckOldestRequest(/*version=*/5);
+    write_stream().Fail(Status{Error::kErrorInvalidArgument, "bad write"});
+  });
+  Run([&] {
+    EXPECT_EQ(AcknowledgedBatchIds(), std::vector<BatchId>({batch1}));
+    EXPECT_EQ(callback_.rejected, std::vector<BatchId>({batch2}));
+  });
+
+  // The batch after it is resent and goes through.
+  Run([&] { write_stream().AckOldestRequest(/*version=*/6); });
+  Run([&] {
+    EXPECT_EQ(AcknowledgedBatchIds(), std::vector<BatchId>({batch1, batch3}));
+    EXPECT_EQ(callback_.rejected, std::vector<BatchId>({batch2}));
+  });
+}
+
+TEST_F(RemoteStoreTest, FixedWindowLimitsWritesInFlight) {
+  WriteBatches(4);
+  CreateRemoteStore(/*max_batches=*/1, WritePipelineWindow{2, false});
+
+  Run([&] { remote_store_->EnableNetwork(); });
+  Run([&] {
+    EXPECT_EQ(write_stream().requests.size(), 2u);
+    EXPECT_EQ(remote_store_->write_pipeline_window().in_flight(), 2);
+  });
+
+  // Each ack frees up a slot for the next batch.
+  Run([&] { write_stream().AckOldestRequest(/*version=*/5); });
+  Run([&] {
+    EXPECT_EQ(write_stream().requests.size(), 3u);
+    EXPECT_EQ(remote_store_->write_pipeline_window().in_flight(), 2);
+  });
+}
+
+TEST_F(RemoteStoreTest, AdaptiveWindowGrowsWhileAcksAreFast) {
+  const int default_size = WritePipelineWindow::kDefaultMaxPendingWrites;
+  WriteBatches(default_size + 4);
+  CreateRemoteStore(/*max_batches=*/1,
+                    WritePipelineWindow{default_size + 2, true});
+
+  // The adaptive window starts out at the default size.
+  Run([&] { remote_store_->EnableNetwork(); });
+  Run([&] {
+    EXPECT_EQ(write_stream().requests.size(),
+              static_cast<size_t>(default_size));
+  });
+
+  // The first ack is the fastest seen so far, so it grows the window, which
+  // lets two more batches through.
+  Run([&] { write_stream().AckOldestRequest(/*version=*/5); });
+  Run([&] {
+    const WritePipelineWindow& window = remote_store_->write_pipeline_window();
+    EXPECT_EQ(window.size(), default_size + 1);
+    EXPECT_EQ(window.in_flight(), default_size + 1);
+    EXPECT_EQ(write_stream().requests.size(),
+              static_cast<size_t>(default_size + 2));
+  });
+}
+
+TEST_F(RemoteStoreTest, AdaptiveWindowShrinksWhenStreamFails) {
+  WriteBatches(12);
+  CreateRemoteStore(/*max_batches=*/1, WritePipelineWindow{10, true});
+
+  Run([&] { remote_store_->EnableNetwork(); });
+  Run([&] {
+    EXPECT_EQ(write_stream().requests.size(), 10u);
+    write_stream().Fail(Status{Error::kErrorUnavailable, "overloaded"});
+  });
+
+  // The batches already in the pipeline are resent, but no new ones are added
+  // until the writes in flight fit the smaller window.
+  Run([&] {
+    const WritePipelineWindow& window = remote_store_->write_pipeline_window();
+    EXPECT_EQ(window.size(), 5);
+    EXPECT_EQ(window.in_flight(), 10);
+    EXPECT_EQ(write_stream().requests.size(), 20u);
+    EXPECT_TRUE(callback_.rejected.empty());
+  });
+}
+
+}  // namespace remote
+}  // namespace firestore
+}  // namespace firebase
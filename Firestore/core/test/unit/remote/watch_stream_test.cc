@@ -0,0 +1,336 @@
+/*
+ * Copyright 2022 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Firestore/core/src/remote/watch_stream.h"
+
+#include <chrono>  // NOLINT(build/c++11)
+#include <functional>
+#include <future>  // NOLINT(build/c++11)
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "Firestore/Protos/nanopb/google/firestore/v1/firestore.nanopb.h"
+#include "Firestore/core/src/credentials/empty_credentials_provider.h"
+#include "Firestore/core/src/model/database_id.h"
+#include "Firestore/core/src/nanopb/message.h"
+#include "Firestore/core/src/nanopb/nanopb_util.h"
+#include "Firestore/core/src/remote/grpc_completion.h"
+#include "Firestore/core/src/remote/grpc_nanopb.h"
+#include "Firestore/core/src/remote/serializer.h"
+#include "Firestore/core/src/util/async_queue.h"
+#include "Firestore/core/src/util/executor.h"
+#include "Firestore/core/test/unit/remote/create_noop_connectivity_monitor.h"
+#include "Firestore/core/test/unit/remote/grpc_stream_tester.h"
+#include "Firestore/core/test/unit/testutil/async_testing.h"
+#include "grpcpp/client_context.h"
+#include "grpcpp/support/byte_buffer.h"
+#include "gtest/gtest.h"
+
+namespace firebase {
+namespace firestore {
+namespace remote {
+namespace {
+
+using credentials::AuthToken;
+using credentials::EmptyAppCheckCredentialsProvider;
+using credentials::EmptyAuthCredentialsProvider;
+using model::DatabaseId;
+using model::SnapshotVersion;
+using model::TargetId;
+using nanopb::Message;
+using util::AsyncQueue;
+using util::Executor;
+using util::Status;
+
+using Type = GrpcCompletion::Type;
+
+/** Records the events of a `WatchStream` on the worker queue. */
+class RecordingWatchStreamCallback : public WatchStreamCallback {
+ public:
+  void OnWatchStreamOpen() override {
+  }
+
+  void OnWatchStreamChange(const WatchChange& change,
+                           const SnapshotVersion&) override {
+    const auto& target_change = static_cast<const WatchTargetChange&>(change);
+    target_ids.insert(target_ids.end(), target_change.target_ids().begin(),
+                      target_change.target_ids().end());
+  }
+
+  void OnWatchStreamClose(const Status& status) override {
+    close_statuses.push_back(status);
+  }
+
+  std::vector<TargetId> target_ids;
+  std::vector<Status> close_statuses;
+};
+
+/**
+ * A `WatchStream` that opens its gRPC stream through a `GrpcStreamTester` and
+ * decodes responses on the given executor.
+ */
+class TestWatchStream : public WatchStream {
+ public:
+  TestWatchStream(const std::shared_ptr<AsyncQueue>& worker_queue,
+                  GrpcStreamTester* tester,
+                  WatchStreamCallback* callback,
+                  std::unique_ptr<Executor> decoder)
+      : WatchStream{worker_queue,
+                    std::make_shared<EmptyAuthCredentialsProvider>(),
+                    std::make_shared<EmptyAppCheckCredentialsProvider>(),
+                    Serializer{DatabaseId{"p", "d"}},
+                    tester->grpc_connection(),
+                    callback,
+                    std::move(decoder)},
+        tester_{tester} {
+  }
+
+  grpc::ClientContext* context() {
+    return context_;
+  }
+
+ private:
+  std::unique_ptr<GrpcStream> CreateGrpcStream(GrpcConnection*,
+                                               const AuthToken&,
+                                               const std::string&) override {
+    auto result = tester_->CreateStream(this);
+    context_ = result->context();
+    return result;
+  }
+
+  GrpcStreamTester* tester_ = nullptr;
+  grpc::ClientContext* context_ = nullptr;
+};
+
+/** Encodes a response that adds the target with the given ID. */
+grpc::ByteBuffer AddTargetResponse(TargetId target_id) {
+  Message<google_firestore_v1_ListenResponse> response;
+  response->which_response_type =
+      google_firestore_v1_ListenResponse_target_change_tag;
+  google_firestore_v1_TargetChange& target_change = response->target_change;
+  target_change.target_change_type =
+      google_firestore_v1_TargetChange_TargetChangeType_ADD;
+  target_change.target_ids_count = 1;
+  target_change.target_ids = nanopb::MakeArray<int32_t>(1);
+  target_change.target_ids[0] = target_id;
+  return MakeByteBuffer(response);
+}
+
+class WatchStreamTest : public testing::Test, public testutil::AsyncTest {
+ public:
+  WatchStreamTest()
+      : worker_queue{testutil::AsyncQueueForTesting()},
+        connectivity_monitor{CreateNoOpConnectivityMonitor()},
+        tester{worker_queue, connectivity_monitor.get()} {
+    // Block the decoder until the test resumes it.
+    auto decoder = testutil::ExecutorForTesting("decoder");
+    std::shared_future<void> resumed = resume_decoder.get_future().share();
+    decoder->Execute([resumed] { resumed.wait(); });
+
+    watch_stream = std::make_shared<TestWatchStream>(
+        worker_queue, &tester, &callback, std::move(decoder));
+  }
+
+  ~WatchStreamTest() {
+    ResumeDecoder();
+    worker_queue->EnqueueBlocking([&] {
+      if (watch_stream->IsStarted()) {
+        KeepPollingGrpcQueue();
+        watch_stream->Stop();
+      }
+    });
+    tester.Shutdown();
+  }
+
+  void StartStream() {
+    worker_queue->EnqueueBlocking([&] { watch_stream->Start(); });
+    worker_queue->EnqueueBlocking([] {});
+  }
+
+  void ResumeDecoder() {
+    if (!decoder_resumed) {
+      decoder_resumed = true;
+      resume_decoder.set_value();
+    }
+  }
+
+  void KeepPollingGrpcQueue() {
+    tester.KeepPollingGrpcQueue();
+  }
+
+  /**
+   * Completes the next reads of the stream with the given responses, without
+   * waiting for the worker queue to handle them.
+   */
+  std::future<void> ReadAsync(std::vector<grpc::ByteBuffer> responses) {
+    watch_stream->context()->TryCancel();
+    size_t index = 0;
+    return tester.ForceFinishAsync(
+        [responses, index](GrpcCompletion* completion) mutable {
+          CompletionEndState(Type::Read, responses[index]).Apply(completion);
+          return ++index == responses.size();
+        });
+  }
+
+  /** Waits until `condition` holds on the worker queue. */
+  void WaitUntil(const std::function<bool()>& condition) {
+    auto deadline = std::chrono::steady_clock::now() + testutil::kTimeout;
+    bool done = false;
+    while (!done && std::chrono::steady_clock::now() < deadline) {
+      worker_queue->EnqueueBlocking([&] { done = condition(); });
+      if (!done) SleepFor(1);
+    }
+    ASSERT_TRUE(done);
+  }
+
+  std::vector<TargetId> ReceivedTargetIds() {
+    std::vector<TargetId> result;
+    worker_queue->EnqueueBlocking([&] { result = callback.target_ids; });
+    return result;
+  }
+
+  std::shared_ptr<AsyncQueue> worker_queue;
+  std::unique_ptr<ConnectivityMonitor> connectivity_monitor;
+  GrpcStreamTester tester;
+
+  std::promise<void> resume_decoder;
+  bool decoder_resumed = false;
+
+  RecordingWatchStreamCallback callback;
+  std::shared_ptr<TestWatchStream> watch_stream;
+};
+
+}  // namespace
+
+TEST_F(WatchStreamTest, HandsOffResponsesInOrder) {
+  StartStream();
+  ResumeDecoder();
+
+  tester.ForceFinish(watch_stream->context(),
+                     {{Type::Read, AddTargetResponse(1)},
+                      {Type::Read, AddTargetResponse(2)},
+                      {Type::Read, AddTargetResponse(3)}});
+
+  WaitUntil([&] { return callback.target_ids.size() == 3; });
+  EXPECT_EQ(ReceivedTargetIds(), std::vector<TargetId>({1, 2, 3}));
+}
+
+TEST_F(WatchStreamTest, DropsResponsesReceivedBeforeRestart) {
+  StartStream();
+
+  // The response is received but stays pending in the decoder while the
+  // stream is stopped and started again.
+  Await(ReadAsync({AddTargetResponse(1)}));
+  worker_queue->EnqueueBlocking([&] {
+    std::future<void> finished = tester.ForceFinishAsync(
+        GrpcStreamTester::CreateAnyTypeOrderCallback(
+            {{Type::Read, CompletionResult::Error},
+             {Type::Finish, CompletionResult::Ok}}));
+    watch_stream->Stop();
+    finished.wait();
+    watch_stream->Start();
+  });
+  worker_queue->EnqueueBlocking([] {});
+  ResumeDecoder();
+
+  // Responses are handed off in order, so the stale one has been dropped by
+  // the time the next one arrives.
+  tester.ForceFinish(watch_stream->context(),
+                     {{Type::Read, AddTargetResponse(2)}});
+  WaitUntil([&] { return !callback.target_ids.empty(); });
+  EXPECT_EQ(ReceivedTargetIds(), std::vector<TargetId>({2}));
+  worker_queue->EnqueueBlocking([&] {
+    EXPECT_TRUE(watch_stream->IsStarted());
+    ASSERT_EQ(callback.close_statuses.size(), 1u);
+    EXPECT_TRUE(callback.close_statuses[0].ok());
+  });
+}
+
+TEST_F(WatchStreamTest, ClosesWithErrorOnDecodeError) {
+  StartStream();
+  ResumeDecoder();
+
+  // A response without a response type cannot be decoded.
+  tester.ForceFinish(
+      watch_stream->context(),
+      {{Type::Read,
+        MakeByteBuffer(Message<google_firestore_v1_ListenResponse>{})}});
+  // Finishing the gRPC stream requires polling the completion queue.
+  KeepPollingGrpcQueue();
+
+  WaitUntil([&] { return !callback.close_statuses.empty(); });
+  worker_queue->EnqueueBlocking([&] {
+    EXPECT_FALSE(watch_stream->IsStarted());
+    EXPECT_TRUE(callback.target_ids.empty());
+    ASSERT_EQ(callback.close_statuses.size(), 1u);
+    EXPECT_FALSE(callback.close_statuses[0].ok());
+  });
+}
+
+TEST_F(WatchStreamTest, BlocksWorkerQueueWhenDecoderFallsBehind) {
+  StartStream();
+
+  // One more response than may be pending, so that receiving the last one
+  // blocks the worker queue.
+  std::vector<grpc::ByteBuffer> responses;
+  std::vector<TargetId> expected;
+  for (TargetId id = 1; id <= WatchStream::kMaxPendingResponses + 1; ++id) {
+    responses.push_back(AddTargetResponse(id));
+    expected.push_back(id);
+  }
+  Await(ReadAsync(responses));
+
+  auto deadline = std::chrono::steady_clock::now() + testutil::kTimeout;
+  while (watch_stream->decode_stats().max_pending_responses <
+             WatchStream::kMaxPendingResponses &&
+         std::chrono::steady_clock::now() < deadline) {
+    SleepFor(1);
+  }
+  SleepFor(10);
+  ResumeDecoder();
+
+  WaitUntil([&] { return callback.target_ids.size() == expected.size(); });
+  EXPECT_EQ(ReceivedTargetIds(), expected);
+
+  WatchStreamDecodeStats stats = watch_stream->decode_stats();
+  EXPECT_EQ(stats.responses_decoded, static_cast<int64_t>(expected.size()));
+  EXPECT_EQ(stats.max_pending_responses, WatchStream::kMaxPendingResponses);
+  EXPECT_GT(stats.wait_time.count(), 0);
+}
+
+TEST_F(WatchStreamTest, ReportsDecodeStats) {
+  StartStream();
+  ResumeDecoder();
+
+  tester.ForceFinish(watch_stream->context(),
+                     {{Type::Read, AddTargetResponse(1)},
+                      {Type::Read, AddTargetResponse(2)}});
+  WaitUntil([&] { return callback.target_ids.size() == 2; });
+
+  WatchStreamDecodeStats stats = watch_stream->decode_stats();
+  EXPECT_EQ(stats.responses_decoded, 2);
+  EXPECT_GE(stats.max_pending_responses, 1);
+  EXPECT_LE(stats.max_pending_responses, 2);
+  EXPECT_GE(stats.decode_time.count(), 0);
+  EXPECT_GE(stats.apply_time.count(), 0);
+  EXPECT_EQ(stats.wait_time.count(), 0);
+}
+
+}  // namespace remote
+}  // namespace firestore
+}  // namespace firebase
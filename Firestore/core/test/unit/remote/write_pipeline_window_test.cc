@@ -0,0 +1,182 @@
+/*
+ * Copyright 2022 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Firestore/core/src/remote/write_pipeline_window.h"
+
+#include <chrono>  // NOLINT(build/c++11)
+
+#include "gtest/gtest.h"
+
+namespace firebase {
+namespace firestore {
+namespace remote {
+namespace {
+
+namespace chr = std::chrono;
+
+using Clock = WritePipelineWindow::Clock;
+
+const Clock::time_point kStart = Clock::time_point() + chr::hours(1);
+
+/**
+ * Sends `count` writes at `now` and acks them all `latency` later. Returns the
+ * time of the last ack.
+ */
+Clock::time_point RoundTrip(WritePipelineWindow* window,
+                            int count,
+                            Clock::time_point now,
+                            chr::milliseconds latency) {
+  for (int i = 0; i < count; ++i) {
+    window->OnWriteSent(now);
+  }
+  for (int i = 0; i < count; ++i) {
+    window->OnWriteAcknowledged(now + latency);
+  }
+  return now + latency;
+}
+
+TEST(AckLatencyHistogramTest, BucketsAreExponential) {
+  AckLatencyHistogram histogram;
+  histogram.Record(chr::milliseconds(0));
+  histogram.Record(chr::milliseconds(1));
+  histogram.Record(chr::milliseconds(3));
+  histogram.Record(chr::milliseconds(4));
+  histogram.Record(chr::milliseconds(1000000));
+
+  EXPECT_EQ(histogram.count(), 5);
+  EXPECT_EQ(histogram.bucket(0), 1);
+  EXPECT_EQ(histogram.bucket(1), 1);
+  EXPECT_EQ(histogram.bucket(2), 1);
+  EXPECT_EQ(histogram.bucket(3), 1);
+  EXPECT_EQ(histogram.bucket(AckLatencyHistogram::kBucketCount - 1), 1);
+
+  EXPECT_EQ(AckLatencyHistogram::bucket_upper_bound(0), chr::milliseconds(1));
+  EXPECT_EQ(AckLatencyHistogram::bucket_upper_bound(3), chr::milliseconds(8));
+  EXPECT_EQ(AckLatencyHistogram::bucket_upper_bound(
+                AckLatencyHistogram::kBucketCount - 1),
+            chr::milliseconds::max());
+}
+
+TEST(WritePipelineWindowTest, DefaultsToTenPendingWrites) {
+  WritePipelineWindow window;
+  EXPECT_EQ(window.size(), 10);
+  EXPECT_FALSE(window.adaptive());
+}
+
+TEST(WritePipelineWindowTest, FixedWindowNeverChanges) {
+  WritePipelineWindow window(25, /*adaptive=*/false);
+  EXPECT_EQ(window.size(), 25);
+
+  Clock::time_point now = RoundTrip(&window, 25, kStart, chr::milliseconds(10));
+  EXPECT_EQ(window.size(), 25);
+
+  RoundTrip(&window, 25, now, chr::milliseconds(1000));
+  window.OnWriteStreamError();
+  EXPECT_EQ(window.size(), 25);
+}
+
+TEST(WritePipelineWindowTest, TracksWritesInFlight) {
+  WritePipelineWindow window;
+  window.OnWriteSent(kStart);
+  window.OnWriteSent(kStart);
+  EXPECT_EQ(window.in_flight(), 2);
+
+  window.OnWriteAcknowledged(kStart + chr::milliseconds(5));
+  EXPECT_EQ(window.in_flight(), 1);
+  EXPECT_EQ(window.ack_latency().count(), 1);
+  EXPECT_EQ(window.ack_latency().bucket(3), 1);
+
+  window.ClearInFlight();
+  EXPECT_EQ(window.in_flight(), 0);
+}
+
+TEST(WritePipelineWindowTest, AdaptiveWindowStartsAtDefault) {
+  EXPECT_EQ(WritePipelineWindow(500, /*adaptive=*/true).size(), 10);
+  EXPECT_EQ(WritePipelineWindow(4, /*adaptive=*/true).size(), 4);
+}
+
+TEST(WritePipelineWindowTest, AdaptiveWindowDoublesWhileAcksAreFast) {
+  WritePipelineWindow window(500, /*adaptive=*/true);
+
+  Clock::time_point now = RoundTrip(&window, 10, kStart, chr::milliseconds(50));
+  EXPECT_EQ(window.size(), 20);
+
+  RoundTrip(&window, 20, now, chr::milliseconds(50));
+  EXPECT_EQ(window.size(), 40);
+}
+
+TEST(WritePipelineWindowTest, AdaptiveWindowIsBoundedByMaximum) {
+  WritePipelineWindow window(30, /*adaptive=*/true);
+
+  Clock::time_point now = kStart;
+  for (int i = 0; i < 10; ++i) {
+    now = RoundTrip(&window, window.size(), now, chr::milliseconds(50));
+  }
+  EXPECT_EQ(window.size(), 30);
+}
+
+TEST(WritePipelineWindowTest, AdaptiveWindowHalvesOnStreamError) {
+  WritePipelineWindow window(500, /*adaptive=*/true);
+  RoundTrip(&window, 10, kStart, chr::milliseconds(50));
+  ASSERT_EQ(window.size(), 20);
+
+  window.OnWriteStreamError();
+  EXPECT_EQ(window.size(), 10);
+
+  window.OnWriteStreamError();
+  window.OnWriteStreamError();
+  window.OnWriteStreamError();
+  window.OnWriteStreamError();
+  EXPECT_EQ(window.size(), 1);
+}
+
+TEST(WritePipelineWindowTest, AdaptiveWindowHalvesOncePerSlowRoundTrip) {
+  WritePipelineWindow window(500, /*adaptive=*/true);
+  Clock::time_point now = RoundTrip(&window, 10, kStart, chr::milliseconds(50));
+  ASSERT_EQ(window.size(), 20);
+
+  // All twenty acks are slow, but they were all in flight when the first one
+  // arrived, so the window only shrinks once.
+  RoundTrip(&window, 20, now, chr::milliseconds(500));
+  EXPECT_EQ(window.size(), 10);
+}
+
+TEST(WritePipelineWindowTest, AdaptiveWindowGrowsLinearlyAfterShrinking) {
+  WritePipelineWindow window(500, /*adaptive=*/true);
+  Clock::time_point now = RoundTrip(&window, 10, kStart, chr::milliseconds(50));
+  window.OnWriteStreamError();
+  ASSERT_EQ(window.size(), 10);
+
+  now = RoundTrip(&window, 10, now, chr::milliseconds(50));
+  EXPECT_EQ(window.size(), 11);
+
+  RoundTrip(&window, 11, now, chr::milliseconds(50));
+  EXPECT_EQ(window.size(), 12);
+}
+
+TEST(WritePipelineWindowTest, ModeratelySlowerAcksDoNotShrinkWindow) {
+  WritePipelineWindow window(500, /*adaptive=*/true);
+  Clock::time_point now = RoundTrip(&window, 10, kStart, chr::milliseconds(50));
+  ASSERT_EQ(window.size(), 20);
+
+  RoundTrip(&window, 20, now, chr::milliseconds(150));
+  EXPECT_EQ(window.size(), 40);
+}
+
+}  // namespace
+}  // namespace remote
+}  // namespace firestore
+}  // namespace firebase
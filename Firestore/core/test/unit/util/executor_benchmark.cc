@@ -0,0 +1,157 @@
+/*
+ * Copyright 2022 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <atomic>
+#include <condition_variable>  // NOLINT(build/c++11)
+#include <memory>
+#include <mutex>  // NOLINT(build/c++11)
+
+#include "Firestore/core/src/util/executor_std.h"
+#include "Firestore/core/src/util/executor_work_stealing.h"
+#include "absl/memory/memory.h"
+#include "benchmark/benchmark.h"
+
+namespace firebase {
+namespace firestore {
+namespace util {
+namespace {
+
+constexpr int64_t kOperations = 100000;
+
+enum Kind {
+  kStd,
+  kWorkStealing,
+};
+
+std::unique_ptr<Executor> CreateExecutor(Kind kind, int threads) {
+  if (kind == kStd) {
+    return absl::make_unique<ExecutorStd>(threads);
+  } else {
+    return absl::make_unique<ExecutorWorkStealing>(threads);
+  }
+}
+
+const char* KindName(Kind kind) {
+  return kind == kStd ? "ExecutorStd" : "ExecutorWorkStealing";
+}
+
+/** Blocks until `Done` has been called a given number of times. */
+class Countdown {
+ public:
+  explicit Countdown(int64_t count) : count_(count) {
+  }
+
+  void Done() {
+    if (count_.fetch_sub(1) == 1) {
+      std::lock_guard<std::mutex> lock(mutex_);
+      zero_.notify_all();
+    }
+  }
+
+  void Await() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    zero_.wait(lock, [this] { return count_.load() == 0; });
+  }
+
+ private:
+  std::atomic<int64_t> count_;
+  std::mutex mutex_;
+  std::condition_variable zero_;
+};
+
+/** A small amount of work, similar to decoding a small document. */
+void Work() {
+  int64_t sum = 0;
+  for (int i = 0; i < 200; ++i) {
+    benchmark::DoNotOptimize(sum += i);
+  }
+}
+
+void ApplyExecutors(benchmark::internal::Benchmark* benchmark) {
+  for (int kind = kStd; kind <= kWorkStealing; ++kind) {
+    for (int threads : {1, 2, 4, 8, 16}) {
+      benchmark->Args({kind, threads});
+    }
+  }
+}
+
+/**
+ * Fans out one operation per item from a single thread, like the query
+ * executor does when decoding documents.
+ */
+void BM_ExecutorFanOut(benchmark::State& state) {
+  auto kind = static_cast<Kind>(state.range(0));
+  auto executor = CreateExecutor(kind, static_cast<int>(state.range(1)));
+
+  for (auto _ : state) {
+    Countdown countdown(kOperations);
+    for (int64_t i = 0; i < kOperations; ++i) {
+      executor->Execute([&countdown] {
+        Work();
+        countdown.Done();
+      });
+    }
+    countdown.Await();
+  }
+
+  state.SetItemsProcessed(state.iterations() * kOperations);
+  state.SetLabel(KindName(kind));
+}
+BENCHMARK(BM_ExecutorFanOut)
+    ->Unit(benchmark::kMillisecond)
+    ->UseRealTime()
+    ->ArgNames({"executor", "threads"})
+    ->Apply(ApplyExecutors);
+
+/**
+ * Has every worker submit operations of its own, so that submissions come
+ * from all threads at once.
+ */
+void BM_ExecutorNestedFanOut(benchmark::State& state) {
+  auto kind = static_cast<Kind>(state.range(0));
+  int64_t threads = state.range(1);
+  auto executor = CreateExecutor(kind, static_cast<int>(threads));
+  int64_t per_thread = kOperations / threads;
+
+  for (auto _ : state) {
+    Countdown countdown(per_thread * threads);
+    for (int64_t i = 0; i < threads; ++i) {
+      Executor* raw_executor = executor.get();
+      executor->Execute([raw_executor, per_thread, &countdown] {
+        for (int64_t j = 0; j < per_thread; ++j) {
+          raw_executor->Execute([&countdown] {
+            Work();
+            countdown.Done();
+          });
+        }
+      });
+    }
+    countdown.Await();
+  }
+
+  state.SetItemsProcessed(state.iterations() * per_thread * threads);
+  state.SetLabel(KindName(kind));
+}
+BENCHMARK(BM_ExecutorNestedFanOut)
+    ->Unit(benchmark::kMillisecond)
+    ->UseRealTime()
+    ->ArgNames({"executor", "threads"})
+    ->Apply(ApplyExecutors);
+
+}  // namespace
+}  // namespace util
+}  // namespace firestore
+}  // namespace firebase
@@ -0,0 +1,107 @@
+/*
+ * Copyright 2022 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Firestore/core/src/util/executor_work_stealing.h"
+
+#include <atomic>
+#include <thread>  // NOLINT(build/c++11)
+#include <vector>
+
+#include "Firestore/core/test/unit/testutil/async_testing.h"
+#include "Firestore/core/test/unit/util/executor_test.h"
+#include "absl/memory/memory.h"
+#include "gtest/gtest.h"
+
+namespace firebase {
+namespace firestore {
+namespace util {
+namespace {
+
+using testutil::Expectation;
+
+std::unique_ptr<Executor> ExecutorFactory(int threads) {
+  return absl::make_unique<ExecutorWorkStealing>(threads);
+}
+
+class ExecutorWorkStealingTest : public ::testing::Test,
+                                 public testutil::AsyncTest {};
+
+}  // namespace
+
+INSTANTIATE_TEST_SUITE_P(ExecutorTestWorkStealing,
+                         ExecutorTest,
+                         ::testing::Values(ExecutorFactory));
+
+TEST_F(ExecutorWorkStealingTest, RunsOperationsFromManyThreads) {
+  std::atomic<int> count{0};
+  Expectation done;
+  ExecutorWorkStealing executor(4);
+
+  const int per_thread = 1000;
+  const int threads_count = 4;
+  std::vector<std::thread> threads;
+  for (int i = 0; i < threads_count; ++i) {
+    threads.emplace_back([&] {
+      for (int j = 0; j < per_thread; ++j) {
+        executor.Execute([&] {
+          if (++count == per_thread * threads_count) {
+            done.Fulfill();
+          }
+        });
+      }
+    });
+  }
+  for (std::thread& thread : threads) {
+    thread.join();
+  }
+
+  Await(done);
+  EXPECT_EQ(count, per_thread * threads_count);
+}
+
+TEST_F(ExecutorWorkStealingTest, IdleWorkersStealQueuedOperations) {
+  Expectation stolen;
+  ExecutorWorkStealing executor(2);
+
+  // Operations executed from a worker go to that worker's own queue. Since the
+  // worker is blocked until the operation runs, only another worker stealing
+  // it can unblock it.
+  executor.Execute([&] {
+    EXPECT_TRUE(executor.IsCurrentExecutor());
+    executor.Execute(stolen.AsCallback());
+    Await(stolen);
+  });
+
+  Await(stolen);
+}
+
+TEST_F(ExecutorWorkStealingTest, IsCurrentExecutorOnlyOnItsOwnWorkers) {
+  Expectation checked;
+  ExecutorWorkStealing executor(2);
+  ExecutorWorkStealing other(2);
+  EXPECT_FALSE(executor.IsCurrentExecutor());
+
+  other.Execute([&] {
+    EXPECT_TRUE(other.IsCurrentExecutor());
+    EXPECT_FALSE(executor.IsCurrentExecutor());
+    checked.Fulfill();
+  });
+  Await(checked);
+}
+
+}  // namespace util
+}  // namespace firestore
+}  // namespace firebase